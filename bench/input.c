@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <time.h>
+
+#include <cerver/http/json/json.h>
+
+#include "input.h"
+
+#define BENCH_SECONDS			2.0
+
+#define BENCH_BULK_COUNT		64
+
+#define BENCH_TITLE_SIZE		1024
+#define BENCH_ID_SIZE			32
+
+#define BENCH_TRANSACTION		\
+	"{\"title\": \"Groceries for the week\", \"amount\": 154.35, "	\
+	"\"category\": \"5f8e3c1b9d3e2a0012345678\", "					\
+	"\"place\": \"5f8e3c1b9d3e2a0012345679\", "						\
+	"\"date\": \"2021-03-14T10:30:00.000Z\"}"
+
+#define BENCH_KEY_MAP(XX)					\
+	XX(0,	TITLE, 			title)			\
+	XX(1,	AMOUNT, 		amount)			\
+	XX(2,	CATEGORY, 		category)		\
+	XX(3,	PLACE, 			place)			\
+	XX(4,	DATE, 			date)
+
+typedef enum BenchKey {
+
+	#define XX(num, name, string) BENCH_KEY_##name = num,
+	BENCH_KEY_MAP (XX)
+	#undef XX
+
+} BenchKey;
+
+static PocketInputSchema bench_schema = {
+	.keys = {
+		#define XX(num, name, string) #string,
+		BENCH_KEY_MAP (XX)
+		#undef XX
+		NULL
+	}
+};
+
+// the fields that the transactions controller copies from a body
+typedef struct BenchTransaction {
+
+	char title[BENCH_TITLE_SIZE];
+	double amount;
+	char category[BENCH_ID_SIZE];
+	char place[BENCH_ID_SIZE];
+	char date[BENCH_ID_SIZE];
+
+} BenchTransaction;
+
+typedef unsigned int (*BenchParse) (
+	const char *body, const size_t body_len, BenchTransaction *trans
+);
+
+static double bench_now (void) {
+
+	struct timespec now = { 0 };
+	(void) clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (double) now.tv_sec + ((double) now.tv_nsec / 1e9);
+
+}
+
+static void bench_json_copy (
+	const json_t *value, char *buffer, const size_t buffer_size
+) {
+
+	if (json_is_string (value)) {
+		(void) strncpy (buffer, json_string_value (value), buffer_size - 1);
+	}
+
+}
+
+static void bench_json_object (
+	const json_t *json_body, BenchTransaction *trans
+) {
+
+	const char *key = NULL;
+	json_t *value = NULL;
+	json_object_foreach ((json_t *) json_body, key, value) {
+		if (!strcmp (key, "title")) {
+			bench_json_copy (value, trans->title, BENCH_TITLE_SIZE);
+		}
+
+		else if (!strcmp (key, "amount")) {
+			trans->amount = json_number_value (value);
+		}
+
+		else if (!strcmp (key, "category")) {
+			bench_json_copy (value, trans->category, BENCH_ID_SIZE);
+		}
+
+		else if (!strcmp (key, "place")) {
+			bench_json_copy (value, trans->place, BENCH_ID_SIZE);
+		}
+
+		else if (!strcmp (key, "date")) {
+			bench_json_copy (value, trans->date, BENCH_ID_SIZE);
+		}
+	}
+
+}
+
+// the old path, builds the whole tree & then walks it
+static unsigned int bench_json_parse (
+	const char *body, const size_t body_len, BenchTransaction *trans
+) {
+
+	unsigned int retval = 1;
+
+	json_error_t json_error = { 0 };
+	json_t *json_body = json_loadb (body, body_len, 0, &json_error);
+	if (json_body) {
+		if (json_is_array (json_body)) {
+			size_t idx = 0;
+			json_t *item = NULL;
+			json_array_foreach (json_body, idx, item) {
+				bench_json_object (item, &trans[idx]);
+			}
+
+			retval = 0;
+		}
+
+		else if (json_is_object (json_body)) {
+			bench_json_object (json_body, trans);
+
+			retval = 0;
+		}
+
+		json_decref (json_body);
+	}
+
+	return retval;
+
+}
+
+static void bench_input_object (
+	PocketInput *input, BenchTransaction *trans
+) {
+
+	int key = -1;
+	PocketInputValue value = { 0 };
+	while (pocket_input_object_next (input, &bench_schema, &key, &value)) {
+		switch (key) {
+			case BENCH_KEY_TITLE:
+				(void) pocket_input_string_copy (&value, trans->title, BENCH_TITLE_SIZE);
+				break;
+
+			case BENCH_KEY_AMOUNT:
+				trans->amount = value.number;
+				break;
+
+			case BENCH_KEY_CATEGORY:
+				(void) pocket_input_string_copy (&value, trans->category, BENCH_ID_SIZE);
+				break;
+
+			case BENCH_KEY_PLACE:
+				(void) pocket_input_string_copy (&value, trans->place, BENCH_ID_SIZE);
+				break;
+
+			case BENCH_KEY_DATE:
+				(void) pocket_input_string_copy (&value, trans->date, BENCH_ID_SIZE);
+				break;
+
+			default: break;
+		}
+	}
+
+}
+
+// the new path, copies the values while the body is read
+static unsigned int bench_input_parse (
+	const char *body, const size_t body_len, BenchTransaction *trans
+) {
+
+	PocketInput input = { 0 };
+	pocket_input_init (&input, body, body_len);
+
+	if (pocket_input_array_begin (&input)) {
+		size_t idx = 0;
+		while (pocket_input_array_next (&input)) {
+			if (pocket_input_object_begin (&input)) {
+				bench_input_object (&input, &trans[idx]);
+			}
+
+			else {
+				(void) pocket_input_skip (&input);
+			}
+
+			idx += 1;
+		}
+	}
+
+	else if (pocket_input_object_begin (&input)) {
+		bench_input_object (&input, trans);
+	}
+
+	return pocket_input_end (&input) ? 0 : 1;
+
+}
+
+static void bench_input_run (
+	const char *name, const BenchParse parse,
+	const char *body, const size_t body_len,
+	BenchTransaction *trans
+) {
+
+	unsigned int count = 0;
+	unsigned int errors = 0;
+	double start = bench_now ();
+	double elapsed = 0;
+	do {
+		errors += parse (body, body_len, trans);
+		count += 1;
+		elapsed = bench_now () - start;
+	} while (elapsed < BENCH_SECONDS);
+
+	(void) printf (
+		"%-8s %10.1f %10.1f %8u\n",
+		name,
+		(elapsed * 1e9) / count,
+		((double) body_len * count) / (elapsed * 1e6),
+		errors
+	);
+
+}
+
+static char *bench_input_bulk_body (size_t *body_len) {
+
+	size_t item_len = strlen (BENCH_TRANSACTION);
+	size_t len = 2 + (BENCH_BULK_COUNT * (item_len + 2));
+
+	char *body = (char *) calloc (len, sizeof (char));
+	if (body) {
+		char *end = body;
+		*end++ = '[';
+		for (unsigned int idx = 0; idx < BENCH_BULK_COUNT; idx++) {
+			if (idx) {
+				*end++ = ',';
+				*end++ = ' ';
+			}
+
+			(void) memcpy (end, BENCH_TRANSACTION, item_len);
+			end += item_len;
+		}
+
+		*end++ = ']';
+
+		*body_len = (size_t) (end - body);
+	}
+
+	return body;
+
+}
+
+int main (int argc, char **argv) {
+
+	(void) argc;
+	(void) argv;
+
+	int retval = 1;
+
+	BenchTransaction *trans = (BenchTransaction *) calloc (
+		BENCH_BULK_COUNT, sizeof (BenchTransaction)
+	);
+
+	size_t bulk_len = 0;
+	char *bulk = bench_input_bulk_body (&bulk_len);
+
+	if (trans && bulk && !pocket_input_schema_init (&bench_schema)) {
+		(void) printf ("transaction (%zu bytes)\n", strlen (BENCH_TRANSACTION));
+		(void) printf ("parser        ns/op       MB/s   errors\n");
+		bench_input_run (
+			"jansson", bench_json_parse,
+			BENCH_TRANSACTION, strlen (BENCH_TRANSACTION), trans
+		);
+
+		bench_input_run (
+			"input", bench_input_parse,
+			BENCH_TRANSACTION, strlen (BENCH_TRANSACTION), trans
+		);
+
+		(void) printf ("\nbulk of %u (%zu bytes)\n", BENCH_BULK_COUNT, bulk_len);
+		(void) printf ("parser        ns/op       MB/s   errors\n");
+		bench_input_run ("jansson", bench_json_parse, bulk, bulk_len, trans);
+		bench_input_run ("input", bench_input_parse, bulk, bulk_len, trans);
+
+		retval = 0;
+	}
+
+	free (bulk);
+	free (trans);
+
+	return retval;
+
+}
@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <time.h>
+#include <unistd.h>
+#include <malloc.h>
+
+#include "models/category.h"
+#include "models/place.h"
+#include "models/transaction.h"
+
+#define BENCH_SECONDS			1.0
+
+// objects in each pool, as after a traffic spike
+#define BENCH_POOL_COUNT		4096
+
+// the models as they were before their strings were moved to arenas
+typedef struct BenchFixedTransaction {
+
+	bson_oid_t oid;
+	char id[32];
+	bson_oid_t user_oid;
+	bson_oid_t category_oid;
+	bson_oid_t place_oid;
+	bson_oid_t payment_oid;
+	bson_oid_t currency_oid;
+	char title[1024];
+	double amount;
+	time_t date;
+	TransType type;
+
+} BenchFixedTransaction;
+
+typedef struct BenchFixedCategory {
+
+	bson_oid_t oid;
+	char id[32];
+	bson_oid_t user_oid;
+	char title[1024];
+	char description[2048];
+	char color[128];
+	time_t date;
+
+} BenchFixedCategory;
+
+typedef struct BenchFixedPlace {
+
+	bson_oid_t oid;
+	char id[32];
+	bson_oid_t user_oid;
+	char name[512];
+	char description[1024];
+	PlaceType type;
+	char address[256];
+	char lat[32];
+	char lon[32];
+	char link[256];
+	char logo[256];
+	char color[128];
+	time_t date;
+
+} BenchFixedPlace;
+
+static volatile unsigned char bench_sink = 0;
+
+static double bench_now (void) {
+
+	struct timespec now = { 0 };
+	(void) clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (double) now.tv_sec + ((double) now.tv_nsec / 1e9);
+
+}
+
+// resident memory of the process in KB
+static size_t bench_rss (void) {
+
+	size_t rss = 0;
+
+	FILE *statm = fopen ("/proc/self/statm", "r");
+	if (statm) {
+		size_t pages = 0;
+		if (fscanf (statm, "%*s %zu", &pages) == 1) {
+			rss = (pages * (size_t) sysconf (_SC_PAGESIZE)) / 1024;
+		}
+
+		(void) fclose (statm);
+	}
+
+	return rss;
+
+}
+
+// fills a pool like the model's new method does & measures
+// the resident memory it takes & the memset that returns an object
+static void bench_models_run (const char *name, const size_t size) {
+
+	void **objects = (void **) calloc (BENCH_POOL_COUNT, sizeof (void *));
+	if (objects) {
+		size_t before = bench_rss ();
+
+		for (unsigned int idx = 0; idx < BENCH_POOL_COUNT; idx++) {
+			objects[idx] = malloc (size);
+			if (objects[idx]) (void) memset (objects[idx], 0, size);
+		}
+
+		size_t rss = bench_rss () - before;
+
+		unsigned long count = 0;
+		double start = bench_now ();
+		double elapsed = 0;
+		do {
+			for (unsigned int idx = 0; idx < BENCH_POOL_COUNT; idx++) {
+				if (objects[idx]) {
+					(void) memset (objects[idx], 0, size);
+					bench_sink ^= ((unsigned char *) objects[idx])[size - 1];
+				}
+			}
+
+			count += BENCH_POOL_COUNT;
+			elapsed = bench_now () - start;
+		} while (elapsed < BENCH_SECONDS);
+
+		(void) printf (
+			"%-22s %8zu %10zu %10.1f\n",
+			name, size, rss, (elapsed * 1e9) / (double) count
+		);
+
+		for (unsigned int idx = 0; idx < BENCH_POOL_COUNT; idx++) {
+			free (objects[idx]);
+		}
+
+		free (objects);
+
+		// so the next model does not reuse these pages
+		(void) malloc_trim (0);
+	}
+
+}
+
+int main (int argc, char **argv) {
+
+	(void) argc;
+	(void) argv;
+
+	(void) printf ("pool of %u objects\n", BENCH_POOL_COUNT);
+	(void) printf ("model                     bytes    rss (KB)  memset ns\n");
+
+	bench_models_run ("transaction (fixed)", sizeof (BenchFixedTransaction));
+	bench_models_run ("transaction", sizeof (Transaction));
+
+	bench_models_run ("category (fixed)", sizeof (BenchFixedCategory));
+	bench_models_run ("category", sizeof (Category));
+
+	bench_models_run ("place (fixed)", sizeof (BenchFixedPlace));
+	bench_models_run ("place", sizeof (Place));
+
+	return 0;
+
+}
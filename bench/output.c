@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <time.h>
+
+#include <bson/bson.h>
+
+#include "output.h"
+
+#define BENCH_SECONDS			2.0
+
+#define BENCH_LIST_COUNT		64
+
+typedef size_t (*BenchSerialize) (
+	const PocketOutputShape *shape, const bson_t *doc
+);
+
+static double bench_now (void) {
+
+	struct timespec now = { 0 };
+	(void) clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (double) now.tv_sec + ((double) now.tv_nsec / 1e9);
+
+}
+
+// a transaction as it is stored, with the fields
+// that the projection removes from the responses
+static bson_t *bench_output_transaction (void) {
+
+	bson_oid_t oid = { 0 };
+	bson_oid_init (&oid, NULL);
+
+	bson_t *doc = bson_new ();
+	(void) bson_append_oid (doc, "_id", -1, &oid);
+	(void) bson_append_oid (doc, "user", -1, &oid);
+	(void) bson_append_utf8 (doc, "title", -1, "Groceries for the \"week\"", -1);
+	(void) bson_append_double (doc, "amount", -1, 154.35);
+	(void) bson_append_oid (doc, "category", -1, &oid);
+	(void) bson_append_oid (doc, "place", -1, &oid);
+	(void) bson_append_date_time (doc, "date", -1, 1615717800123);
+	(void) bson_append_date_time (doc, "updated", -1, 1615717800123);
+
+	return doc;
+
+}
+
+// the old path, libbson's generic extended json
+static size_t bench_output_relaxed (
+	const PocketOutputShape *shape, const bson_t *doc
+) {
+
+	(void) shape;
+
+	size_t json_len = 0;
+	char *json = bson_as_relaxed_extended_json (doc, &json_len);
+	bson_free (json);
+
+	return json_len;
+
+}
+
+// the new path, only the shape's fields into the thread's buffer
+static size_t bench_output_shape (
+	const PocketOutputShape *shape, const bson_t *doc
+) {
+
+	size_t json_len = 0;
+	(void) pocket_output_doc (shape, doc, &json_len);
+
+	return json_len;
+
+}
+
+static void bench_output_run (
+	const char *name, const BenchSerialize serialize,
+	const PocketOutputShape *shape, const bson_t *doc, const unsigned int docs
+) {
+
+	unsigned int count = 0;
+	size_t bytes = 0;
+	double start = bench_now ();
+	double elapsed = 0;
+	do {
+		for (unsigned int idx = 0; idx < docs; idx++) {
+			bytes += serialize (shape, doc);
+		}
+
+		count += 1;
+		elapsed = bench_now () - start;
+	} while (elapsed < BENCH_SECONDS);
+
+	(void) printf (
+		"%-8s %10.1f %10.1f %8zu\n",
+		name,
+		(elapsed * 1e9) / count,
+		(double) bytes / (elapsed * 1e6),
+		bytes / ((size_t) count * docs)
+	);
+
+}
+
+int main (int argc, char **argv) {
+
+	(void) argc;
+	(void) argv;
+
+	int retval = 1;
+
+	// the same projection as the transactions controller
+	bson_t *opts = BCON_NEW (
+		"projection", "{",
+			"title", BCON_BOOL (true),
+			"amount", BCON_BOOL (true),
+			"date", BCON_BOOL (true),
+			"category", BCON_BOOL (true),
+		"}"
+	);
+
+	bson_t *doc = bench_output_transaction ();
+
+	PocketOutputShape shape = { 0 };
+	if (!pocket_output_init () && !pocket_output_shape_init (&shape, opts)) {
+		(void) printf ("transaction\n");
+		(void) printf ("output        ns/op       MB/s    bytes\n");
+		bench_output_run ("relaxed", bench_output_relaxed, &shape, doc, 1);
+		bench_output_run ("shape", bench_output_shape, &shape, doc, 1);
+
+		(void) printf ("\nlist of %u\n", BENCH_LIST_COUNT);
+		(void) printf ("output        ns/op       MB/s    bytes\n");
+		bench_output_run ("relaxed", bench_output_relaxed, &shape, doc, BENCH_LIST_COUNT);
+		bench_output_run ("shape", bench_output_shape, &shape, doc, BENCH_LIST_COUNT);
+
+		retval = 0;
+	}
+
+	pocket_output_end ();
+
+	bson_destroy (doc);
+	bson_destroy (opts);
+
+	return retval;
+
+}
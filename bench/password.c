@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <time.h>
+#include <pthread.h>
+
+#include "password.h"
+
+#define BENCH_PASSWORD			"correct-horse-battery-staple"
+
+#define BENCH_SECONDS			2.0
+
+#define BENCH_CLIENTS			16
+
+typedef struct BenchClient {
+
+	const char *stored;
+
+	unsigned int ok;
+	unsigned int busy;
+
+} BenchClient;
+
+static volatile int bench_running = 0;
+
+static double bench_now (void) {
+
+	struct timespec now = { 0 };
+	(void) clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (double) now.tv_sec + ((double) now.tv_nsec / 1e9);
+
+}
+
+// hashes in the caller's thread to get the cost of a single login
+static double bench_password_single (const unsigned int cost) {
+
+	char hashed[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+
+	unsigned int count = 0;
+	double start = bench_now ();
+	double elapsed = 0;
+	do {
+		(void) pocket_password_hash_sync (BENCH_PASSWORD, cost, hashed);
+		count += 1;
+		elapsed = bench_now () - start;
+	} while (elapsed < BENCH_SECONDS);
+
+	return (elapsed * 1000) / count;
+
+}
+
+static void *bench_password_client (void *args) {
+
+	BenchClient *client = (BenchClient *) args;
+
+	bool upgrade = false;
+	char rehashed[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+	while (bench_running) {
+		switch (pocket_password_verify (
+			BENCH_PASSWORD, client->stored, &upgrade, rehashed
+		)) {
+			case POCKET_PASSWORD_RESULT_OK: client->ok += 1; break;
+			case POCKET_PASSWORD_RESULT_BUSY: client->busy += 1; break;
+			default: break;
+		}
+	}
+
+	return NULL;
+
+}
+
+// logins per second through the workers with many clients
+static void bench_password_pool (
+	const unsigned int cost,
+	const unsigned int workers, const unsigned int queue
+) {
+
+	char stored[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+	(void) pocket_password_hash_sync (BENCH_PASSWORD, cost, stored);
+
+	if (!pocket_password_init (workers, queue, cost)) {
+		pthread_t threads[BENCH_CLIENTS] = { 0 };
+		BenchClient clients[BENCH_CLIENTS] = { 0 };
+
+		bench_running = 1;
+		for (unsigned int idx = 0; idx < BENCH_CLIENTS; idx++) {
+			clients[idx].stored = stored;
+			(void) pthread_create (
+				&threads[idx], NULL, bench_password_client, &clients[idx]
+			);
+		}
+
+		struct timespec duration = { .tv_sec = (time_t) BENCH_SECONDS };
+		(void) nanosleep (&duration, NULL);
+		bench_running = 0;
+
+		unsigned int ok = 0;
+		unsigned int busy = 0;
+		for (unsigned int idx = 0; idx < BENCH_CLIENTS; idx++) {
+			(void) pthread_join (threads[idx], NULL);
+			ok += clients[idx].ok;
+			busy += clients[idx].busy;
+		}
+
+		(void) printf (
+			"%4u %8u %6u %12.1f %12.1f\n",
+			cost, workers, queue,
+			ok / BENCH_SECONDS, busy / BENCH_SECONDS
+		);
+	}
+
+	pocket_password_end ();
+
+}
+
+int main (int argc, char **argv) {
+
+	unsigned int min_cost = 12;
+	unsigned int max_cost = 16;
+	if (argc > 1) min_cost = (unsigned int) atoi (argv[1]);
+	if (argc > 2) max_cost = (unsigned int) atoi (argv[2]);
+
+	(void) printf ("cost  ms/hash  (memory %u * 2^cost bytes)\n", 128 * POCKET_PASSWORD_BLOCK_SIZE);
+	for (unsigned int cost = min_cost; cost <= max_cost; cost++) {
+		(void) printf ("%4u %8.2f\n", cost, bench_password_single (cost));
+	}
+
+	(void) printf ("\n%u clients\n", BENCH_CLIENTS);
+	(void) printf ("cost  workers  queue     logins/s       429s/s\n");
+	for (unsigned int cost = min_cost; cost <= max_cost; cost++) {
+		for (unsigned int workers = 1; workers <= 4; workers *= 2) {
+			bench_password_pool (cost, workers, pocket_password_queue_default (BENCH_CLIENTS));
+		}
+	}
+
+	return 0;
+
+}
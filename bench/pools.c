@@ -0,0 +1,308 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <cerver/collections/pool.h>
+
+#include "pool.h"
+
+#define BENCH_SECONDS			1.0
+
+// about the size of a pooled transaction
+#define BENCH_OBJECT_SIZE		128
+
+// objects that a request takes before it returns them
+#define BENCH_REQUEST_OBJECTS	4
+
+#define BENCH_POOL_INIT			32
+
+#define BENCH_THREADS_MAX		64
+
+// objects that each thread holds at the same time during a burst
+#define BENCH_BURST_OBJECTS		64
+
+#define BENCH_BURST_TRIMS		10
+
+static const unsigned int bench_threads[] = { 1, 4, 16, 64 };
+
+typedef void *(*BenchPop) (void *pool);
+typedef void (*BenchPush) (void *pool, void *object);
+
+typedef struct BenchWorker {
+
+	pthread_t thread;
+
+	void *pool;
+	BenchPop pop;
+	BenchPush push;
+
+	unsigned long ops;
+
+} BenchWorker;
+
+static pthread_barrier_t bench_barrier;
+static atomic_bool bench_running = false;
+
+static double bench_now (void) {
+
+	struct timespec now = { 0 };
+	(void) clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (double) now.tv_sec + ((double) now.tv_nsec / 1e9);
+
+}
+
+static void *bench_object_new (void) {
+
+	return calloc (1, BENCH_OBJECT_SIZE);
+
+}
+
+static void bench_object_delete (void *object) {
+
+	free (object);
+
+}
+
+// the old path, every pop & push locks the shared pool
+static void *bench_pool_pop (void *pool) {
+
+	return pool_pop ((Pool *) pool);
+
+}
+
+static void bench_pool_push (void *pool, void *object) {
+
+	(void) pool_push ((Pool *) pool, object);
+
+}
+
+// the new path, through the thread's magazine
+static void *bench_magazine_pop (void *pool) {
+
+	return pocket_pool_pop ((PocketPool *) pool);
+
+}
+
+static void bench_magazine_push (void *pool, void *object) {
+
+	pocket_pool_push ((PocketPool *) pool, object);
+
+}
+
+// takes a few objects like a request does & clears them on return
+static void *bench_worker (void *worker_ptr) {
+
+	BenchWorker *worker = (BenchWorker *) worker_ptr;
+
+	void *objects[BENCH_REQUEST_OBJECTS] = { 0 };
+	unsigned long ops = 0;
+
+	(void) pthread_barrier_wait (&bench_barrier);
+
+	while (atomic_load_explicit (&bench_running, memory_order_relaxed)) {
+		for (unsigned int idx = 0; idx < BENCH_REQUEST_OBJECTS; idx++) {
+			objects[idx] = worker->pop (worker->pool);
+		}
+
+		for (unsigned int idx = 0; idx < BENCH_REQUEST_OBJECTS; idx++) {
+			if (objects[idx]) {
+				(void) memset (objects[idx], 0, BENCH_OBJECT_SIZE);
+				worker->push (worker->pool, objects[idx]);
+			}
+		}
+
+		ops += BENCH_REQUEST_OBJECTS;
+	}
+
+	worker->ops = ops;
+
+	return NULL;
+
+}
+
+// holds a lot of objects at the same time as the other threads,
+// so the pool grows to its burst size
+static void *bench_burst_worker (void *pool_ptr) {
+
+	PocketPool *pool = (PocketPool *) pool_ptr;
+
+	void *objects[BENCH_BURST_OBJECTS] = { 0 };
+	for (unsigned int idx = 0; idx < BENCH_BURST_OBJECTS; idx++) {
+		objects[idx] = pocket_pool_pop (pool);
+	}
+
+	(void) pthread_barrier_wait (&bench_barrier);
+
+	for (unsigned int idx = 0; idx < BENCH_BURST_OBJECTS; idx++) {
+		if (objects[idx]) pocket_pool_push (pool, objects[idx]);
+	}
+
+	return NULL;
+
+}
+
+// prints the pool's objects after each trim that follows a burst
+static void bench_pools_burst (void) {
+
+	PocketPool *pool = pocket_pool_create (
+		bench_object_new, bench_object_delete, BENCH_POOL_INIT
+	);
+
+	if (pool) {
+		pthread_t threads[BENCH_THREADS_MAX] = { 0 };
+
+		(void) pthread_barrier_init (&bench_barrier, NULL, BENCH_THREADS_MAX);
+		for (unsigned int idx = 0; idx < BENCH_THREADS_MAX; idx++) {
+			if (pthread_create (&threads[idx], NULL, bench_burst_worker, pool)) {
+				(void) fprintf (stderr, "Failed to start burst threads!\n");
+				exit (1);
+			}
+		}
+
+		for (unsigned int idx = 0; idx < BENCH_THREADS_MAX; idx++) {
+			(void) pthread_join (threads[idx], NULL);
+		}
+
+		(void) pthread_barrier_destroy (&bench_barrier);
+
+		PocketPoolStats stats = { 0 };
+		pocket_pool_get_stats (pool, &stats);
+
+		(void) printf (
+			"\nburst of %u threads holding %u objects each, then idle trims\n",
+			BENCH_THREADS_MAX, BENCH_BURST_OBJECTS
+		);
+
+		(void) printf ("trim   objects  high water   trimmed\n");
+		(void) printf ("%4u %9zu %11zu %9zu\n", 0, stats.objects, stats.high_water, stats.trimmed);
+
+		for (unsigned int idx = 1; idx <= BENCH_BURST_TRIMS; idx++) {
+			(void) pocket_pool_trim (pool);
+
+			pocket_pool_get_stats (pool, &stats);
+			(void) printf (
+				"%4u %9zu %11zu %9zu\n",
+				idx, stats.objects, stats.high_water, stats.trimmed
+			);
+		}
+
+		pocket_pool_delete (pool);
+	}
+
+}
+
+// returns the pops & pushes pairs per second of all the threads
+static double bench_pools_run (
+	void *pool, const BenchPop pop, const BenchPush push,
+	const unsigned int n_threads
+) {
+
+	BenchWorker workers[BENCH_THREADS_MAX] = { 0 };
+
+	(void) pthread_barrier_init (&bench_barrier, NULL, n_threads + 1);
+	atomic_store (&bench_running, true);
+
+	unsigned int started = 0;
+	for (unsigned int idx = 0; idx < n_threads; idx++) {
+		workers[idx].pool = pool;
+		workers[idx].pop = pop;
+		workers[idx].push = push;
+
+		if (!pthread_create (&workers[idx].thread, NULL, bench_worker, &workers[idx])) {
+			started += 1;
+		}
+	}
+
+	double elapsed = 0;
+	unsigned long ops = 0;
+	if (started == n_threads) {
+		(void) pthread_barrier_wait (&bench_barrier);
+
+		double start = bench_now ();
+		struct timespec wait = { .tv_sec = (time_t) BENCH_SECONDS, .tv_nsec = 0 };
+		(void) nanosleep (&wait, NULL);
+
+		atomic_store (&bench_running, false);
+
+		for (unsigned int idx = 0; idx < n_threads; idx++) {
+			(void) pthread_join (workers[idx].thread, NULL);
+			ops += workers[idx].ops;
+		}
+
+		elapsed = bench_now () - start;
+	}
+
+	else {
+		(void) fprintf (stderr, "Failed to start %u threads!\n", n_threads);
+		exit (1);
+	}
+
+	(void) pthread_barrier_destroy (&bench_barrier);
+
+	return (double) ops / elapsed;
+
+}
+
+int main (int argc, char **argv) {
+
+	(void) argc;
+	(void) argv;
+
+	(void) printf (
+		"%u objects of %u bytes taken & returned by each request\n",
+		BENCH_REQUEST_OBJECTS, BENCH_OBJECT_SIZE
+	);
+
+	(void) printf ("threads   shared Mops  magazine Mops  refills    spills  contended\n");
+
+	for (unsigned int idx = 0; idx < sizeof (bench_threads) / sizeof (unsigned int); idx++) {
+		const unsigned int n_threads = bench_threads[idx];
+
+		Pool *shared = pool_create (bench_object_delete);
+		pool_set_create (shared, bench_object_new);
+		pool_set_produce_if_empty (shared, true);
+		(void) pool_init (shared, bench_object_new, BENCH_POOL_INIT);
+
+		double shared_ops = bench_pools_run (
+			shared, bench_pool_pop, bench_pool_push, n_threads
+		);
+
+		pool_delete (shared);
+
+		PocketPool *magazines = pocket_pool_create (
+			bench_object_new, bench_object_delete, BENCH_POOL_INIT
+		);
+
+		if (!magazines) {
+			(void) fprintf (stderr, "Failed to create pool!\n");
+			return 1;
+		}
+
+		double magazine_ops = bench_pools_run (
+			magazines, bench_magazine_pop, bench_magazine_push, n_threads
+		);
+
+		PocketPoolStats stats = { 0 };
+		pocket_pool_get_stats (magazines, &stats);
+
+		pocket_pool_delete (magazines);
+
+		(void) printf (
+			"%7u %13.1f %14.1f %8zu %9zu %10zu\n",
+			n_threads, shared_ops / 1e6, magazine_ops / 1e6,
+			stats.refills, stats.spills, stats.contended
+		);
+	}
+
+	bench_pools_burst ();
+
+	return 0;
+
+}
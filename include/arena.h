@@ -0,0 +1,100 @@
+#ifndef _POCKET_ARENA_H_
+#define _POCKET_ARENA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// bytes inside the arena itself, so most requests never allocate
+#define POCKET_ARENA_INLINE_SIZE			2048
+
+// min size of the blocks that are added when the arena is full
+#define POCKET_ARENA_BLOCK_SIZE				16384
+
+#define POCKET_ARENA_ALIGN					8
+
+// a string that is not owned, it points to an arena
+// or to the request's body & is not always NUL terminated
+typedef struct PocketStr {
+
+	const char *str;
+	size_t len;
+
+} PocketStr;
+
+// printf ("%.*s", POCKET_STR_FORMAT (str))
+#define POCKET_STR_FORMAT(s)				(int) (s).len, ((s).str ? (s).str : "")
+
+typedef struct PocketArenaBlock {
+
+	struct PocketArenaBlock *next;
+
+	size_t size;
+
+	_Alignas (POCKET_ARENA_ALIGN) char data[];
+
+} PocketArenaBlock;
+
+// a bump allocator that frees everything at once
+// pos & end point inside the arena, so it must not be copied
+typedef struct PocketArena {
+
+	char *pos;
+	char *end;
+
+	// extra blocks from the heap, the newest first
+	PocketArenaBlock *blocks;
+
+	// a block that was kept by the last reset
+	PocketArenaBlock *spare;
+
+	// bytes that have been allocated since the last reset
+	size_t used;
+
+	_Alignas (POCKET_ARENA_ALIGN) char initial[POCKET_ARENA_INLINE_SIZE];
+
+} PocketArena;
+
+extern void pocket_arena_init (PocketArena *arena);
+
+// returns memory aligned to align, that must be a power of two,
+// or NULL on error
+extern void *pocket_arena_alloc_aligned (
+	PocketArena *arena, const size_t size, const size_t align
+);
+
+// returns memory aligned to POCKET_ARENA_ALIGN or NULL on error
+extern void *pocket_arena_alloc (PocketArena *arena, const size_t size);
+
+// returns zeroed memory for count values or NULL on error
+extern void *pocket_arena_calloc (
+	PocketArena *arena, const size_t count, const size_t size
+);
+
+// copies the string with a NUL at the end
+// returns false & leaves the view empty on error
+extern bool pocket_arena_str (
+	PocketArena *arena, const char *str, const size_t len, PocketStr *view
+);
+
+// releases the extra blocks & makes the inline memory available again
+// the biggest block is kept as the spare one for the next use
+extern void pocket_arena_reset (PocketArena *arena);
+
+extern void pocket_arena_end (PocketArena *arena);
+
+// returns 0 on success, 1 on error
+extern unsigned int pocket_arena_request_init (void);
+
+extern void pocket_arena_request_end (void);
+
+// the current thread starts handling a request
+extern void pocket_arena_request_begin (void);
+
+// everything that was allocated for the request is released
+extern void pocket_arena_request_finish (void);
+
+// the arena of the request that the current thread is handling,
+// NULL outside of a request
+extern PocketArena *pocket_arena_request (void);
+
+#endif
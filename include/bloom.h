@@ -0,0 +1,42 @@
+#ifndef _POCKET_BLOOM_H_
+#define _POCKET_BLOOM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include <cerver/types/types.h>
+
+// around 1% of false positives with these values
+#define POCKET_BLOOM_BITS_PER_ITEM			10
+#define POCKET_BLOOM_HASHES					7
+
+// a set that can only report false positives
+// bits are set atomically, so items can be added & checked
+// by many threads without locks, but never removed
+typedef struct PocketBloom {
+
+	size_t n_bits;
+	size_t mask;
+
+	_Atomic u64 words[];
+
+} PocketBloom;
+
+// creates a filter that keeps its false positives rate
+// for up to n_items, it is rounded up to a power of two bits
+extern PocketBloom *pocket_bloom_create (const size_t n_items);
+
+extern void pocket_bloom_delete (PocketBloom *bloom);
+
+extern void pocket_bloom_add (
+	PocketBloom *bloom, const char *data, const size_t data_len
+);
+
+// returns false if the data was never added
+// returns true if it might have been added
+extern bool pocket_bloom_check (
+	const PocketBloom *bloom, const char *data, const size_t data_len
+);
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef _POCKET_CACHE_H_
+#define _POCKET_CACHE_H_
+
+#include <stdbool.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+
+#define POCKET_CACHE_SHARDS					16
+#define POCKET_CACHE_BUCKETS				64
+
+#define POCKET_CACHE_DEFAULT_SIZE			(8 * 1024 * 1024)
+
+// seconds that an entry is kept, so writes made by other
+// instances are seen by this one after at most this time
+#define POCKET_CACHE_DEFAULT_TTL			60
+
+// bigger responses are never cached
+#define POCKET_CACHE_ENTRY_MAX_SIZE			(256 * 1024)
+
+// longer tags are never cached
+#define POCKET_CACHE_TAG_SIZE				64
+
+// a serialized response that belongs to a user
+typedef struct PocketCacheEntry {
+
+	bson_oid_t key;
+
+	// next entry in the same bucket
+	struct PocketCacheEntry *bucket_next;
+
+	// position in the shard's lru list
+	struct PocketCacheEntry *prev;
+	struct PocketCacheEntry *next;
+
+	// 0 if the entry never expires
+	time_t expires;
+
+	// the version of the values the entry was made from,
+	// like the response's etag
+	char tag[POCKET_CACHE_TAG_SIZE];
+
+	size_t len;
+	char data[];
+
+} PocketCacheEntry;
+
+typedef struct PocketCacheShard {
+
+	pthread_mutex_t mutex;
+
+	// changes every time an entry is invalidated
+	u64 generation;
+
+	size_t size;
+	size_t max_size;
+
+	PocketCacheEntry *buckets[POCKET_CACHE_BUCKETS];
+
+	// most recently used entry is at the head
+	PocketCacheEntry *head;
+	PocketCacheEntry *tail;
+
+	size_t entries;
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t expired;
+
+} PocketCacheShard;
+
+// a bounded lru cache of serialized responses keyed by user
+// keys are distributed between shards to reduce lock contention
+// and each shard evicts its least recently used entries
+// when it goes over its part of the max size
+typedef struct PocketCache {
+
+	// seconds that each entry is kept, 0 to keep them until evicted
+	unsigned int ttl;
+
+	PocketCacheShard shards[POCKET_CACHE_SHARDS];
+
+} PocketCache;
+
+typedef struct PocketCacheStats {
+
+	size_t entries;
+	size_t size;
+
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t expired;
+
+} PocketCacheStats;
+
+// entries are kept for ttl seconds, 0 to keep them until evicted
+extern PocketCache *pocket_cache_create (
+	const size_t max_size, const unsigned int ttl
+);
+
+extern void pocket_cache_delete (PocketCache *cache);
+
+// returns true if the key is in the cache with the same tag
+// & has not expired, an entry with another tag is removed
+// data is set with a copy of the entry that must be freed by the caller
+// on a miss, ticket is set with the value that must be used
+// to store the response with pocket_cache_set ()
+extern bool pocket_cache_get (
+	PocketCache *cache, const bson_oid_t *key, const char *tag,
+	char **data, size_t *data_len,
+	u64 *ticket
+);
+
+// stores a copy of the data in the cache with its tag
+// it is discarded if the key's shard had an invalidation
+// since the ticket was taken to avoid storing stale values
+// nothing is stored without a tag
+extern void pocket_cache_set (
+	PocketCache *cache, const bson_oid_t *key, const u64 ticket,
+	const char *tag, const char *data, const size_t data_len
+);
+
+// removes the key's entry if it exists
+extern void pocket_cache_invalidate (
+	PocketCache *cache, const bson_oid_t *key
+);
+
+extern void pocket_cache_get_stats (
+	PocketCache *cache, PocketCacheStats *stats
+);
+
+#endif
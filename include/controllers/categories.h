@@ -3,20 +3,21 @@
 
 #include <bson/bson.h>
 
-#include <cerver/collections/pool.h>
-
 #include "errors.h"
+#include "output.h"
+#include "pool.h"
+#include "stream.h"
 
 #include "models/category.h"
 #include "models/user.h"
 
-#define DEFAULT_CATEGORIES_POOL_INIT			32
-
+struct _HttpReceive;
 struct _HttpResponse;
 
-extern Pool *categories_pool;
+extern PocketPool *categories_pool;
 
 extern const bson_t *category_no_user_query_opts;
+extern PocketOutputShape category_no_user_shape;
 
 extern struct _HttpResponse *no_user_categories;
 extern struct _HttpResponse *no_user_category;
@@ -30,11 +31,13 @@ extern unsigned int pocket_categories_init (void);
 
 extern void pocket_categories_end (void);
 
-extern unsigned int pocket_categories_get_all_by_user (
-	const bson_oid_t *user_oid,
-	char **json, size_t *json_len
+// streams all the user's categories as {"categories": [ ... ]}
+extern PocketStreamResult pocket_categories_send_all_by_user (
+	const struct _HttpReceive *http_receive, const char *etag,
+	const bson_oid_t *user_oid
 );
 
+// the category's strings are copied into the request's arena
 extern Category *pocket_category_get_by_id_and_user (
 	const String *category_id, const bson_oid_t *user_oid
 );
@@ -42,7 +45,8 @@ extern Category *pocket_category_get_by_id_and_user (
 extern u8 pocket_category_get_by_id_and_user_to_json (
 	const char *category_id, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 );
 
 extern PocketError pocket_category_create (
@@ -5,20 +5,21 @@
 
 #include <cerver/types/string.h>
 
-#include <cerver/collections/pool.h>
-
 #include "errors.h"
+#include "output.h"
+#include "pool.h"
+#include "stream.h"
 
 #include "models/place.h"
 #include "models/user.h"
 
-#define DEFAULT_PLACES_POOL_INIT			32
-
+struct _HttpReceive;
 struct _HttpResponse;
 
-extern Pool *places_pool;
+extern PocketPool *places_pool;
 
 extern const bson_t *place_no_user_query_opts;
+extern PocketOutputShape place_no_user_shape;
 
 extern struct _HttpResponse *no_user_places;
 extern struct _HttpResponse *no_user_place;
@@ -32,11 +33,13 @@ extern unsigned int pocket_places_init (void);
 
 extern void pocket_places_end (void);
 
-extern unsigned int pocket_places_get_all_by_user (
-	const bson_oid_t *user_oid,
-	char **json, size_t *json_len
+// streams all the user's places as {"places": [ ... ]}
+extern PocketStreamResult pocket_places_send_all_by_user (
+	const struct _HttpReceive *http_receive, const char *etag,
+	const bson_oid_t *user_oid
 );
 
+// the place's strings are copied into the request's arena
 extern Place *pocket_place_get_by_id_and_user (
 	const String *place_id, const bson_oid_t *user_oid
 );
@@ -44,7 +47,8 @@ extern Place *pocket_place_get_by_id_and_user (
 extern u8 pocket_place_get_by_id_and_user_to_json (
 	const char *place_id, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 );
 
 extern PocketError pocket_place_create (
@@ -1,16 +1,72 @@
 #ifndef _POCKET_ROLES_H_
 #define _POCKET_ROLES_H_
 
+#include <stdbool.h>
+#include <time.h>
+
 #include <bson/bson.h>
 
+#include <cerver/types/types.h>
+
 #include "models/role.h"
 
-extern const Role *common_role;
+// max number of different actions that can be assigned to roles
+#define POCKET_ROLES_ACTIONS_MAX			64
+
+// seconds that a swapped table is kept before it is released,
+// must be longer than any request that could be reading it,
+// it is not enforced, readers hold no reference to the table
+#define POCKET_ROLES_GRACE_PERIOD			60
+
+#define POCKET_ROLES_DEFAULT_REFRESH		300
+
+// an immutable set of roles that is indexed by oid & by name
+// using open addressing, readers get the current table
+// without locks & a new table is swapped in to reload the roles
+typedef struct PocketRolesTable {
+
+	size_t n_roles;
+	Role *roles;
+
+	// power of two number of slots in each index
+	size_t size;
+	const Role **by_oid;
+	const Role **by_name;
+
+	// the role that is given to new users
+	const Role *common;
+
+	// set when the table is swapped out & waits to be released
+	time_t retired;
+	struct PocketRolesTable *next_retired;
+
+} PocketRolesTable;
 
 extern unsigned int pocket_roles_init (void);
 
 extern void pocket_roles_end (void);
 
+// gets the roles & actions from the db & swaps the current table
+// returns 0 on success, 1 on error
+extern unsigned int pocket_roles_reload (void);
+
+// starts a thread that reloads the roles every interval seconds
+// or when it is requested, 0 to only reload on requests
+// returns 0 on success, 1 on error
+extern unsigned int pocket_roles_refresher_start (
+	const unsigned int interval
+);
+
+extern void pocket_roles_refresher_stop (void);
+
+// wakes up the refresher to reload the roles
+// safe to be called from a signal handler
+extern void pocket_roles_refresh_request (void);
+
+// the returned roles belong to the current table & are only valid
+// for POCKET_ROLES_GRACE_PERIOD seconds after a reload swaps it,
+// so they must not be kept after the request that got them
+// returns NULL if there is no role with the oid
 extern const Role *pocket_role_get_by_oid (
 	const bson_oid_t *role_oid
 );
@@ -23,4 +79,24 @@ extern const char *pocket_role_name_get_by_oid (
 	const bson_oid_t *role_oid
 );
 
-#endif
\ No newline at end of file
+// copies the oid of the role that is given to new users
+// returns 0 on success, 1 if the roles have not been loaded
+extern unsigned int pocket_role_common_get_oid (bson_oid_t *role_oid);
+
+// returns the action's bit to be used with pocket_role_can ()
+// bits never change once they are assigned
+// returns 0 if no role has the action
+extern u64 pocket_role_action_get (const char *action);
+
+// returns the bit of POCKET_METRICS_ACTION from the last table build
+// returns 0 if no role has the action
+extern u64 pocket_role_metrics_action_get (void);
+
+// returns true if the role has all of the actions
+static inline bool pocket_role_can (const Role *role, const u64 actions) {
+
+	return actions && ((role->actions_mask & actions) == actions);
+
+}
+
+#endif
@@ -4,6 +4,8 @@
 struct _HttpResponse;
 
 extern struct _HttpResponse *missing_values;
+extern struct _HttpResponse *too_many_requests;
+extern struct _HttpResponse *not_allowed;
 
 extern struct _HttpResponse *pocket_works;
 extern struct _HttpResponse *current_version;
@@ -0,0 +1,36 @@
+#ifndef _POCKET_SYNC_H_
+#define _POCKET_SYNC_H_
+
+#include <bson/bson.h>
+
+#include <cerver/collections/dlist.h>
+
+#include "errors.h"
+#include "stream.h"
+
+// documents that are written while a sync is running might
+// have an older updated value than the sync's start,
+// so the next sync starts a bit before to include them
+#define POCKET_SYNC_WINDOW					(5 * 1000)
+
+struct _HttpReceive;
+
+// parses the request's since query value (millis)
+// a missing value means that a full sync is requested
+// returns POCKET_ERROR_BAD_REQUEST on malformed values
+extern PocketError pocket_sync_query_init (
+	int64_t *since, const DoubleList *query_params
+);
+
+// streams the user's values created, updated or deleted after since
+// {
+//   "transactions": [ ... ], "categories": [ ... ], "places": [ ... ],
+//   "deleted": [ { type, ref, date } ],
+//   "full": false, "next": 1620000000000
+// }
+extern PocketStreamResult pocket_sync_send_by_user (
+	const struct _HttpReceive *http_receive,
+	const bson_oid_t *user_oid, const int64_t since
+);
+
+#endif
@@ -3,20 +3,28 @@
 
 #include <bson/bson.h>
 
-#include <cerver/collections/pool.h>
+#include <cerver/collections/dlist.h>
 
 #include "errors.h"
+#include "output.h"
+#include "pool.h"
+#include "stream.h"
 
 #include "models/transaction.h"
 #include "models/user.h"
 
-#define DEFAULT_TRANS_POOL_INIT			32
+#define TRANS_PAGE_DEFAULT_LIMIT		50
+#define TRANS_PAGE_MAX_LIMIT			500
 
+#define TRANS_BULK_MAX					500
+
+struct _HttpReceive;
 struct _HttpResponse;
 
-extern Pool *trans_pool;
+extern PocketPool *trans_pool;
 
 extern const bson_t *trans_no_user_query_opts;
+extern PocketOutputShape trans_no_user_shape;
 
 extern struct _HttpResponse *no_user_trans;
 
@@ -29,11 +37,29 @@ extern unsigned int pocket_trans_init (void);
 
 extern void pocket_trans_end (void);
 
-extern unsigned int pocket_trans_get_all_by_user (
-	const bson_oid_t *user_oid,
-	char **json, size_t *json_len
+// parses the request's query values into a transactions query
+// limit, after, from, to, category, place, min_amount & max_amount
+// limit is clamped to TRANS_PAGE_MAX_LIMIT
+// & without limit & after values every transaction is returned
+// returns POCKET_ERROR_BAD_REQUEST on malformed values
+extern PocketError pocket_trans_query_init (
+	TransactionsQuery *query, const DoubleList *query_params
+);
+
+// streams the user's transactions, or a page of them
+// {"transactions": [ ... ], "next": "cursor" | null}
+extern PocketStreamResult pocket_trans_send_all_by_user (
+	const struct _HttpReceive *http_receive, const char *etag,
+	const bson_oid_t *user_oid, const TransactionsQuery *query
 );
 
+// returns the user's transactions totals by category & by month
+extern unsigned int pocket_trans_get_summary_by_user (
+	const bson_oid_t *user_oid, const TransactionsQuery *query,
+	const char **json, size_t *json_len
+);
+
+// the transaction's strings are copied into the request's arena
 extern Transaction *pocket_trans_get_by_id_and_user (
 	const String *trans_id, const bson_oid_t *user_oid
 );
@@ -41,13 +67,23 @@ extern Transaction *pocket_trans_get_by_id_and_user (
 extern u8 pocket_trans_get_by_id_and_user_to_json (
 	const char *trans_id, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 );
 
 extern PocketError pocket_trans_create (
 	const User *user, const String *request_body
 );
 
+// creates all the transactions in the request's json array
+// using a single batch insert, returns a json with the result
+// {"inserted": 10, "errors": [{"index": 2, "error": "Missing Values"}]}
+// each item after the first one takes a token from the user's write limiter
+extern PocketError pocket_trans_create_bulk (
+	const User *user, const String *request_body,
+	const char **json, size_t *json_len
+);
+
 extern PocketError pocket_trans_update (
 	const User *user, const String *trans_id,
 	const String *request_body
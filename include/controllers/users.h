@@ -7,7 +7,14 @@
 
 #include "models/user.h"
 
-#define DEFAULT_USERS_POOL_INIT			16
+#define POCKET_USERS_CACHE_SLOTS		1024
+#define POCKET_USERS_CACHE_LOCKS		16
+
+// how many seconds a decoded token is kept at most
+#define POCKET_USERS_CACHE_TTL			300
+
+// min number of emails the registered emails filter is sized for
+#define POCKET_USERS_EMAILS_MIN			65536
 
 struct _HttpReceive;
 struct _HttpResponse;
@@ -31,7 +38,8 @@ typedef enum PocketUserInput {
 	XX(3,	REPEATED, 			Existing Email)		\
 	XX(4,	NOT_FOUND, 			Not found)			\
 	XX(5,	WRONG_PSWD, 		Wrong password)		\
-	XX(6,	SERVER_ERROR, 		Server Error)
+	XX(6,	SERVER_ERROR, 		Server Error)		\
+	XX(7,	BUSY, 				Too Many Requests)
 
 typedef enum PocketUserError {
 
@@ -45,12 +53,14 @@ extern const bson_t *user_login_query_opts;
 extern const bson_t *user_transactions_query_opts;
 extern const bson_t *user_categories_query_opts;
 extern const bson_t *user_places_query_opts;
+extern const bson_t *user_sync_query_opts;
 
 extern struct _HttpResponse *users_works;
 extern struct _HttpResponse *missing_user_values;
 extern struct _HttpResponse *wrong_password;
 extern struct _HttpResponse *user_not_found;
 extern struct _HttpResponse *repeated_email;
+extern struct _HttpResponse *users_busy;
 
 extern unsigned int pocket_users_init (void);
 
@@ -68,6 +78,8 @@ extern User *pocket_user_get (void);
 
 extern User *pocket_user_get_by_email (const char *email);
 
+// returns true if a user with the email exists
+// the db is only queried if the email might have been registered
 extern u8 pocket_user_check_by_email (
 	const char *email
 );
@@ -80,6 +92,10 @@ extern u8 pocket_user_check_by_email (
 //   "role": "god",
 //   "username": "erick"
 // }
+// users are taken from the pool & must be released with pocket_user_delete ()
+// decoded tokens are cached by their id & iat values until
+// POCKET_USERS_CACHE_TTL or their TOKEN_LIFETIME, the one that ends first
+// returns NULL if the token is invalid or has expired
 extern void *pocket_user_parse_from_json (void *user_json_ptr);
 
 extern unsigned int pocket_user_generate_token (
@@ -0,0 +1,274 @@
+#ifndef _POCKET_DB_H_
+#define _POCKET_DB_H_
+
+#include <stdbool.h>
+
+#include <bson/bson.h>
+#include <mongoc/mongoc.h>
+
+#include <cmongo/model.h>
+#include <cmongo/select.h>
+
+#include "arena.h"
+#include "output.h"
+
+// operations that take longer are logged with their filter's shape
+#define DB_DEFAULT_SLOW_THRESHOLD		100
+
+#define DB_FILTER_SHAPE_SIZE			256
+#define DB_FILTER_SHAPE_DEPTH			8
+
+// cursors that can be timed at the same time in a thread
+#define DB_CURSORS_MAX					8
+
+#define DB_COLLECTION_MAP(XX)					\
+	XX(0,	ACTIONS, 			actions)		\
+	XX(1,	CATEGORIES, 		categories)		\
+	XX(2,	PLACES, 			places)			\
+	XX(3,	ROLES, 				roles)			\
+	XX(4,	TOMBSTONES, 		tombstones)		\
+	XX(5,	TRANSACTIONS, 		transactions)	\
+	XX(6,	USERS, 				users)
+
+typedef enum DbCollection {
+
+	#define XX(num, name, string) DB_COLLECTION_##name = num,
+	DB_COLLECTION_MAP (XX)
+	#undef XX
+
+	DB_COLLECTIONS
+
+} DbCollection;
+
+extern const char *db_collection_to_string (const DbCollection collection);
+
+#define DB_OPERATION_MAP(XX)					\
+	XX(0,	FIND_ONE, 			find_one)		\
+	XX(1,	FIND, 				find)			\
+	XX(2,	FIND_JSON, 			find_json)		\
+	XX(3,	CHECK, 				check)			\
+	XX(4,	INSERT_ONE, 		insert_one)		\
+	XX(5,	INSERT_MANY, 		insert_many)	\
+	XX(6,	UPDATE_ONE, 		update_one)		\
+	XX(7,	DELETE_ONE, 		delete_one)		\
+	XX(8,	AGGREGATE, 			aggregate)
+
+typedef enum DbOperation {
+
+	#define XX(num, name, string) DB_OPERATION_##name = num,
+	DB_OPERATION_MAP (XX)
+	#undef XX
+
+	DB_OPERATIONS
+
+} DbOperation;
+
+extern const char *db_operation_to_string (const DbOperation operation);
+
+// times a single operation in a collection
+// the filter's shape is only kept if the slow log is enabled
+typedef struct DbTimer {
+
+	DbCollection collection;
+	DbOperation operation;
+
+	// nanos
+	int64_t start;
+
+	char filter[DB_FILTER_SHAPE_SIZE];
+
+} DbTimer;
+
+// max fields in an index or in a query shape
+#define DB_INDEX_FIELDS_MAX				4
+
+typedef struct DbIndexField {
+
+	const char *name;
+
+	// 1 for ascending, -1 for descending
+	int order;
+
+} DbIndexField;
+
+// an index required by a model, the fields end with a NULL name
+// & the arrays of indexes end with a NULL index name
+typedef struct DbIndex {
+
+	const char *name;
+
+	DbIndexField fields[DB_INDEX_FIELDS_MAX + 1];
+
+	bool unique;
+
+	// documents are removed after these seconds, 0 to keep them
+	int64_t expire_seconds;
+
+} DbIndex;
+
+// the fields that a model's query filters & sorts by,
+// the arrays of shapes end with a NULL shape name
+typedef struct DbQueryShape {
+
+	const char *name;
+
+	const char *filter[DB_INDEX_FIELDS_MAX + 1];
+
+	DbIndexField sort[DB_INDEX_FIELDS_MAX + 1];
+
+} DbQueryShape;
+
+// cmongo only reports success or failure for its operations,
+// so we keep a small client pool of our own for the commands
+// that need to inspect the server's reply
+extern unsigned int db_init (
+	const char *uri, const char *app_name, const char *db_name
+);
+
+extern void db_end (void);
+
+// gets a client from the pool, must be returned with db_client_push ()
+extern mongoc_client_t *db_client_pop (void);
+
+extern void db_client_push (mongoc_client_t *client);
+
+// returns a new collection handle that must be destroyed by the caller
+extern mongoc_collection_t *db_collection_get (
+	mongoc_client_t *client, const char *coll_name
+);
+
+// returns the current time in millis, as used in date fields
+extern int64_t db_now (void);
+
+// returns an empty document for a query that lives in the request's arena,
+// or in the heap outside of a request, bson_destroy () works with both
+extern bson_t *db_query_new (void);
+
+// appends the string view, an empty view is stored as ""
+extern void db_append_str (
+	bson_t *doc, const char *key, const PocketStr *str
+);
+
+// copies a utf8 value into the arena, truncated to max_len bytes
+// returns false if the value is not a string or on error
+extern bool db_iter_str (
+	const bson_iter_t *iter, PocketArena *arena,
+	const size_t max_len, PocketStr *str
+);
+
+// operations that take more millis are logged, 0 to disable the log
+extern void db_set_slow_threshold (const unsigned int millis);
+
+// writes the filter with every value replaced by ?
+// like {user: ?, date: {$gte: ?}}
+extern void db_filter_shape (
+	const bson_t *filter, char *shape, const size_t shape_size
+);
+
+// must be called before the operation,
+// because the filter is destroyed by most of them
+extern void db_timer_start (
+	DbTimer *timer,
+	const DbCollection collection, const DbOperation operation,
+	const bson_t *filter
+);
+
+// records the operation's time & logs it if it was slow
+extern void db_timer_end (DbTimer *timer);
+
+// when set, a model fails to init if any of its queries
+// would need to scan the whole collection
+extern void db_set_indexes_required (const bool required);
+
+// creates the model's indexes, doing nothing for the ones that
+// already exist, & then checks that every one of its query shapes
+// uses an index with mongo's query planner
+// returns 0 on success, 1 on error
+extern unsigned int db_indexes_init (
+	const DbCollection collection,
+	const DbIndex *indexes, const DbQueryShape *queries
+);
+
+// runs an insert_one with the doc, that is destroyed after the operation
+// duplicated is set if the doc breaks a unique index
+// returns 0 on success, 1 on error
+extern unsigned int db_insert_one (
+	const DbCollection coll, bson_t *doc, bool *duplicated
+);
+
+// runs an update_one using the query & update documents,
+// that are destroyed after the operation
+// matched is set with the number of documents that matched the query
+// returns 0 on success, 1 on error
+extern unsigned int db_update_one (
+	const DbCollection coll,
+	bson_t *query, bson_t *update,
+	int64_t *matched
+);
+
+// runs a delete_one using the query, that is destroyed after the operation
+// deleted is set with the number of documents that were removed
+// returns 0 on success, 1 on error
+extern unsigned int db_delete_one (
+	const DbCollection coll, bson_t *query, int64_t *deleted
+);
+
+// timed versions of the cmongo operations used by the models,
+// they take ownership of the query & docs like the originals
+
+extern unsigned int db_model_find_one (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const CMongoSelect *select, void *output
+);
+
+extern unsigned int db_model_find_one_with_opts (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const bson_t *opts, void *output
+);
+
+// finds the first document that matches the query & writes it
+// with the shape into the current thread's output buffer
+extern unsigned int db_model_find_one_with_opts_to_output (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const bson_t *opts, const PocketOutputShape *shape,
+	const char **json, size_t *json_len
+);
+
+extern unsigned int db_model_find_all_to_json (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const bson_t *opts, const char *array_name,
+	char **json, size_t *json_len
+);
+
+extern bool db_model_check (
+	const DbCollection collection, CMongoModel *model, bson_t *query
+);
+
+extern unsigned int db_model_insert_one (
+	const DbCollection collection, CMongoModel *model, bson_t *doc
+);
+
+extern unsigned int db_model_update_one (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, bson_t *update
+);
+
+// the cursor is timed while it is iterated with db_cursor_next ()
+// and the operation is recorded by db_cursor_destroy ()
+extern mongoc_cursor_t *db_model_find_all_cursor (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const CMongoSelect *select, uint64_t *n_docs
+);
+
+extern mongoc_cursor_t *db_model_find_all_cursor_with_opts (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const bson_t *opts
+);
+
+// gets the next document from a cursor, timing it if it was tracked
+extern bool db_cursor_next (mongoc_cursor_t *cursor, const bson_t **doc);
+
+// records the cursor's operation, if it was tracked, & destroys it
+extern void db_cursor_destroy (mongoc_cursor_t *cursor);
+
+#endif
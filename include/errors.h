@@ -7,7 +7,8 @@
 	XX(2,	MISSING_VALUES, 	Missing Values)		\
 	XX(3,	BAD_USER, 			Bad User)			\
 	XX(4,	NOT_FOUND, 			Not found)			\
-	XX(5,	SERVER_ERROR, 		Server Error)
+	XX(5,	SERVER_ERROR, 		Server Error)		\
+	XX(6,	LIMITED, 			Too Many Requests)
 
 typedef enum PocketError {
 
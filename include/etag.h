@@ -0,0 +1,94 @@
+#ifndef _POCKET_ETAG_H_
+#define _POCKET_ETAG_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+
+// "epoch-version-variant" with every value in hex
+#define POCKET_ETAG_SIZE					48
+
+#define POCKET_ETAG_SHARDS					16
+#define POCKET_ETAG_SLOTS					1024
+
+#define POCKET_ETAG_KIND_MAP(XX)					\
+	XX(0,	TRANSACTIONS, 	Transactions)			\
+	XX(1,	CATEGORIES, 	Categories)				\
+	XX(2,	PLACES, 		Places)
+
+typedef enum PocketEtagKind {
+
+	#define XX(num, name, string) POCKET_ETAG_KIND_##name = num,
+	POCKET_ETAG_KIND_MAP (XX)
+	#undef XX
+
+} PocketEtagKind;
+
+#define POCKET_ETAG_KINDS					3
+
+struct _HttpRequest;
+
+// the versions of a user's values, every version is taken
+// from a single clock so no two values ever get the same one
+typedef struct PocketEtagSlot {
+
+	bson_oid_t user_oid;
+
+	bool used;
+
+	// 0 if the slot never expires
+	time_t expires;
+
+	u64 versions[POCKET_ETAG_KINDS];
+
+} PocketEtagSlot;
+
+// each user is mapped to a single slot, a collision
+// replaces the slot's user & gives the new one new versions
+typedef struct PocketEtagShard {
+
+	pthread_mutex_t mutex;
+
+	PocketEtagSlot slots[POCKET_ETAG_SLOTS];
+
+} PocketEtagShard;
+
+// the versions are kept for ttl seconds, so writes made by other
+// instances are seen by this one after at most this time,
+// like the cached lists, 0 to keep them until replaced
+// returns 0 on success, 1 on error
+extern unsigned int pocket_etag_init (const unsigned int ttl);
+
+extern void pocket_etag_end (void);
+
+// every user's values have a version that is kept by this process
+// & that is changed by every write to them, a user without one
+// gets a new version, the variant is what the response
+// was made from, like the parsed query values or the requested id,
+// so each response of the same values gets its own etag
+// returns the etag written to the buffer, or NULL if the versions
+// were not started & the response must be sent without an etag
+// the buffer must be at least POCKET_ETAG_SIZE bytes
+extern const char *pocket_etag_get (
+	const PocketEtagKind kind, const bson_oid_t *user_oid,
+	const void *variant, const size_t variant_len,
+	char *etag
+);
+
+// must be called after every write to the user's values of the kind
+extern void pocket_etag_changed (
+	const PocketEtagKind kind, const bson_oid_t *user_oid
+);
+
+// returns true if the request's If-None-Match header matches the etag
+extern bool pocket_etag_match (
+	const struct _HttpRequest *request, const char *etag
+);
+
+#endif
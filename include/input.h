@@ -0,0 +1,152 @@
+#ifndef _POCKET_INPUT_H_
+#define _POCKET_INPUT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+
+#include "arena.h"
+
+// max keys in a schema, the table has 4 slots for every key
+// so a seed without collisions is found after a few tries
+#define POCKET_INPUT_KEYS_MAX				8
+#define POCKET_INPUT_TABLE_SIZE				32
+
+#define POCKET_INPUT_SEEDS_MAX				4096
+
+// values nested deeper are rejected
+#define POCKET_INPUT_DEPTH_MAX				32
+
+// longest number that is accepted
+#define POCKET_INPUT_NUMBER_SIZE			64
+
+#define POCKET_INPUT_TYPE_MAP(XX)				\
+	XX(0,	NONE, 		None)					\
+	XX(1,	STRING, 	String)					\
+	XX(2,	NUMBER, 	Number)					\
+	XX(3,	TRUE, 		True)					\
+	XX(4,	FALSE, 		False)					\
+	XX(5,	NULL, 		Null)					\
+	XX(6,	OBJECT, 	Object)					\
+	XX(7,	ARRAY, 		Array)
+
+typedef enum PocketInputType {
+
+	#define XX(num, name, string) POCKET_INPUT_TYPE_##name = num,
+	POCKET_INPUT_TYPE_MAP (XX)
+	#undef XX
+
+} PocketInputType;
+
+extern const char *pocket_input_type_to_string (const PocketInputType type);
+
+// the keys that a request body is expected to have
+// every key is found with a single hash & compare,
+// using a seed that gives each key its own slot
+typedef struct PocketInputSchema {
+
+	// ends with a NULL key, a key's index is its position
+	const char *keys[POCKET_INPUT_KEYS_MAX + 1];
+
+	size_t lens[POCKET_INPUT_KEYS_MAX];
+
+	u32 seed;
+
+	// key's index + 1, 0 for an empty slot
+	u8 table[POCKET_INPUT_TABLE_SIZE];
+
+} PocketInputSchema;
+
+// a value in the body, strings point to the body's data without
+// the quotes & must be copied with pocket_input_string_copy ()
+// nested objects & arrays are skipped & only their type is set
+typedef struct PocketInputValue {
+
+	PocketInputType type;
+
+	const char *str;
+	size_t len;
+
+	// the string has escape sequences
+	bool escaped;
+
+	double number;
+
+} PocketInputValue;
+
+// a single pass reader of a json body that never allocates memory
+// objects & arrays are iterated in place, from the outside in
+typedef struct PocketInput {
+
+	const char *pos;
+	const char *end;
+
+	// the current object or array has no values yet
+	bool first;
+
+	bool error;
+
+} PocketInput;
+
+// finds a seed that gives each of the schema's keys its own slot
+// returns 0 on success, 1 on error
+extern unsigned int pocket_input_schema_init (PocketInputSchema *schema);
+
+// returns the key's index or -1 if it is not in the schema
+extern int pocket_input_schema_find (
+	const PocketInputSchema *schema, const char *key, const size_t key_len
+);
+
+extern void pocket_input_init (
+	PocketInput *input, const char *data, const size_t data_len
+);
+
+// returns true if the next value is an object & enters it
+extern bool pocket_input_object_begin (PocketInput *input);
+
+// reads the object's next member & returns true,
+// or returns false when the object ends or on error
+// key is the index of the member's key in the schema or -1
+extern bool pocket_input_object_next (
+	PocketInput *input, const PocketInputSchema *schema,
+	int *key, PocketInputValue *value
+);
+
+// returns true if the next value is an array & enters it
+extern bool pocket_input_array_begin (PocketInput *input);
+
+// returns true if the array has another value, that must be read
+// next with pocket_input_object_begin () or pocket_input_skip ()
+// returns false when the array ends or on error
+extern bool pocket_input_array_next (PocketInput *input);
+
+// reads the next value without keeping it
+// returns 0 on success, 1 on error
+extern unsigned int pocket_input_skip (PocketInput *input);
+
+// returns true if the whole body was read without errors
+extern bool pocket_input_end (PocketInput *input);
+
+// copies the unescaped string, truncated to fit in the buffer
+// returns the number of bytes that were copied
+extern size_t pocket_input_string_copy (
+	const PocketInputValue *value, char *buffer, const size_t buffer_size
+);
+
+// sets the view to the string in the body if it has no escapes,
+// or to an unescaped copy in the arena, truncated to max_len bytes
+// returns false if the value is not a string or on error
+extern bool pocket_input_string_view (
+	const PocketInputValue *value, PocketArena *arena,
+	const size_t max_len, PocketStr *view
+);
+
+// returns true if the value is a valid oid string & sets the oid
+extern bool pocket_input_oid (
+	const PocketInputValue *value, bson_oid_t *oid
+);
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef _POCKET_LIMITER_H_
+#define _POCKET_LIMITER_H_
+
+#include <stdbool.h>
+
+#include <pthread.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+
+#define POCKET_LIMITER_SHARDS				16
+#define POCKET_LIMITER_BUCKETS				1024
+
+// buckets that each key can use, the least recently used is replaced
+#define POCKET_LIMITER_WAYS					4
+#define POCKET_LIMITER_SETS					(POCKET_LIMITER_BUCKETS / POCKET_LIMITER_WAYS)
+
+// bytes of an ipv6 address that are used as its key, its /64 prefix
+#define POCKET_LIMITER_IPV6_PREFIX			8
+
+// requests per minute & max burst
+#define POCKET_LIMITER_DEFAULT_AUTH_RATE	20
+#define POCKET_LIMITER_DEFAULT_AUTH_BURST	10
+
+#define POCKET_LIMITER_DEFAULT_WRITE_RATE	120
+#define POCKET_LIMITER_DEFAULT_WRITE_BURST	60
+
+struct _HttpReceive;
+
+// tokens are refilled based on the time of the last request
+typedef struct PocketLimiterBucket {
+
+	u64 key;
+
+	// millis when the tokens were last refilled
+	int64_t updated;
+	double tokens;
+
+} PocketLimiterBucket;
+
+// each key is mapped to a set of POCKET_LIMITER_WAYS buckets,
+// when the set is full the newest key takes the least recently used
+// bucket with its tokens, so a collision never gives a full burst
+typedef struct PocketLimiterShard {
+
+	pthread_mutex_t mutex;
+
+	PocketLimiterBucket buckets[POCKET_LIMITER_BUCKETS];
+
+	size_t allowed;
+	size_t limited;
+
+} PocketLimiterShard;
+
+// a token bucket rate limiter with sharded locks
+typedef struct PocketLimiter {
+
+	// tokens per milli
+	double rate;
+	double burst;
+
+	PocketLimiterShard shards[POCKET_LIMITER_SHARDS];
+
+} PocketLimiter;
+
+typedef struct PocketLimiterStats {
+
+	size_t allowed;
+	size_t limited;
+
+} PocketLimiterStats;
+
+// rate is in requests per minute, burst is the max tokens of a bucket
+extern PocketLimiter *pocket_limiter_create (
+	const unsigned int rate, const unsigned int burst
+);
+
+extern void pocket_limiter_delete (PocketLimiter *limiter);
+
+extern void pocket_limiter_get_stats (
+	PocketLimiter *limiter, PocketLimiterStats *stats
+);
+
+// takes cost tokens from the key's bucket, a cost bigger
+// than the limiter's burst is never allowed
+// returns true if the request is allowed
+extern bool pocket_limiter_take (
+	PocketLimiter *limiter, const u64 key, const unsigned int cost
+);
+
+extern u64 pocket_limiter_key_oid (const bson_oid_t *oid);
+
+// uses the connection's peer address, ipv6 addresses
+// are grouped by their /64 prefix
+extern u64 pocket_limiter_key_address (
+	const struct _HttpReceive *http_receive
+);
+
+// creates the auth & write limiters, a rate of 0 disables them
+// returns 0 on success, 1 on error
+extern unsigned int pocket_limits_init (
+	const unsigned int auth_rate, const unsigned int auth_burst,
+	const unsigned int write_rate, const unsigned int write_burst
+);
+
+extern void pocket_limits_end (void);
+
+// checks the client's address before a login or register
+// sends back a 429 & returns true if the request is limited
+extern bool pocket_limit_auth (
+	const struct _HttpReceive *http_receive
+);
+
+// checks the user before a write to its values
+// sends back a 429 & returns true if the request is limited
+extern bool pocket_limit_write (
+	const struct _HttpReceive *http_receive,
+	const bson_oid_t *user_oid
+);
+
+// takes the tokens of the items after the first one, that was taken
+// by pocket_limit_write () before the request's body was read
+// the whole cost is capped at the burst, so any bulk can be written
+// with a full bucket
+// returns true if the request is limited
+extern bool pocket_limit_write_items (
+	const bson_oid_t *user_oid, const unsigned int n_items
+);
+
+#endif
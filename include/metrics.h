@@ -0,0 +1,175 @@
+#ifndef _POCKET_METRICS_H_
+#define _POCKET_METRICS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <cerver/types/types.h>
+
+#include "cache.h"
+#include "db.h"
+#include "limiter.h"
+#include "pool.h"
+
+// values under 2^SUB_BITS micros have their own bucket,
+// bigger ones use 2^SUB_BITS buckets for every power of two,
+// so the relative error is at most 1 / 2^SUB_BITS
+#define POCKET_METRICS_SUB_BITS				2
+#define POCKET_METRICS_SUB_BUCKETS			(1 << POCKET_METRICS_SUB_BITS)
+
+// slower requests are counted in the last bucket (~67 seconds)
+#define POCKET_METRICS_MAX_EXPONENT			26
+
+#define POCKET_METRICS_BUCKETS				\
+	((POCKET_METRICS_MAX_EXPONENT - POCKET_METRICS_SUB_BITS + 2) * POCKET_METRICS_SUB_BUCKETS)
+
+// smallest power of two in micros that is exported as a bucket
+#define POCKET_METRICS_EXPORT_MIN_EXPONENT	4
+
+#define POCKET_METRICS_CONTENT_TYPE			"text/plain; version=0.0.4"
+
+// the role action that is needed to get the metrics
+#define POCKET_METRICS_ACTION				"metrics"
+
+#define POCKET_METRICS_LABELS_SIZE			256
+
+#define POCKET_METRICS_CACHES_MAX			8
+#define POCKET_METRICS_LIMITERS_MAX			4
+#define POCKET_METRICS_POOLS_MAX			4
+
+#define POCKET_METRICS_ROUTE_MAP(XX)													\
+	XX(0,	POCKET, 				GET,		/api/pocket)							\
+	XX(1,	VERSION, 				GET,		/api/pocket/version)					\
+	XX(2,	AUTH, 					GET,		/api/pocket/auth)						\
+	XX(3,	METRICS, 				GET,		/api/pocket/metrics)					\
+	XX(4,	TRANSACTIONS, 			GET,		/api/pocket/transactions)				\
+	XX(5,	TRANSACTION_CREATE, 	POST,		/api/pocket/transactions)				\
+	XX(6,	TRANSACTIONS_SUMMARY, 	GET,		/api/pocket/transactions/summary)		\
+	XX(7,	TRANSACTIONS_BULK, 		POST,		/api/pocket/transactions/bulk)			\
+	XX(8,	TRANSACTION_INFO, 		GET,		/api/pocket/transactions/:id/info)		\
+	XX(9,	TRANSACTION_UPDATE, 	PUT,		/api/pocket/transactions/:id/update)	\
+	XX(10,	TRANSACTION_REMOVE, 	DELETE,		/api/pocket/transactions/:id/remove)	\
+	XX(11,	CATEGORIES, 			GET,		/api/pocket/categories)					\
+	XX(12,	CATEGORY_CREATE, 		POST,		/api/pocket/categories)					\
+	XX(13,	CATEGORY_INFO, 			GET,		/api/pocket/categories/:id/info)		\
+	XX(14,	CATEGORY_UPDATE, 		PUT,		/api/pocket/categories/:id/update)		\
+	XX(15,	CATEGORY_REMOVE, 		DELETE,		/api/pocket/categories/:id/remove)		\
+	XX(16,	PLACES, 				GET,		/api/pocket/places)						\
+	XX(17,	PLACE_CREATE, 			POST,		/api/pocket/places)						\
+	XX(18,	PLACE_INFO, 			GET,		/api/pocket/places/:id/info)			\
+	XX(19,	PLACE_UPDATE, 			PUT,		/api/pocket/places/:id/update)			\
+	XX(20,	PLACE_REMOVE, 			DELETE,		/api/pocket/places/:id/remove)			\
+	XX(21,	SYNC, 					GET,		/api/pocket/sync)						\
+	XX(22,	USERS, 					GET,		/api/users)								\
+	XX(23,	USERS_LOGIN, 			POST,		/api/users/login)						\
+	XX(24,	USERS_REGISTER, 		POST,		/api/users/register)					\
+	XX(25,	CATCH_ALL, 				GET,		*)
+
+typedef enum PocketMetricsRoute {
+
+	#define XX(num, name, method, path) POCKET_METRICS_ROUTE_##name = num,
+	POCKET_METRICS_ROUTE_MAP (XX)
+	#undef XX
+
+	POCKET_METRICS_ROUTES
+
+} PocketMetricsRoute;
+
+// parse is the time until the first mongo operation,
+// mongo is the time spent waiting for the database
+// & serialize is everything else after the first operation
+#define POCKET_METRICS_PHASE_MAP(XX)			\
+	XX(0,	TOTAL, 			total)				\
+	XX(1,	PARSE, 			parse)				\
+	XX(2,	MONGO, 			mongo)				\
+	XX(3,	SERIALIZE, 		serialize)
+
+typedef enum PocketMetricsPhase {
+
+	#define XX(num, name, string) POCKET_METRICS_PHASE_##name = num,
+	POCKET_METRICS_PHASE_MAP (XX)
+	#undef XX
+
+	POCKET_METRICS_PHASES
+
+} PocketMetricsPhase;
+
+// a latency histogram in micros that is only written by a single thread
+typedef struct PocketMetricsHistogram {
+
+	_Atomic u64 count;
+	_Atomic u64 sum;
+
+	_Atomic u64 buckets[POCKET_METRICS_BUCKETS];
+
+} PocketMetricsHistogram;
+
+// the histograms of a single thread, when the thread exits
+// they are kept to be used by the next new thread
+typedef struct PocketMetricsThread {
+
+	struct PocketMetricsThread *next;
+	struct PocketMetricsThread *free_next;
+
+	PocketMetricsHistogram histograms[POCKET_METRICS_ROUTES][POCKET_METRICS_PHASES];
+
+	PocketMetricsHistogram db[DB_COLLECTIONS][DB_OPERATIONS];
+
+} PocketMetricsThread;
+
+// the timings of the request that is being handled by the current thread
+typedef struct PocketMetricsRequest {
+
+	PocketMetricsRoute route;
+
+	// nanos
+	int64_t start;
+	int64_t first_mongo;
+	int64_t mongo;
+
+} PocketMetricsRequest;
+
+// returns a monotonic time in nanos
+extern int64_t pocket_metrics_now (void);
+
+// returns 0 on success, 1 on error
+extern unsigned int pocket_metrics_init (void);
+
+extern void pocket_metrics_end (void);
+
+// adds the cache's stats to the metrics with the name as a label
+extern void pocket_metrics_register_cache (
+	const char *name, PocketCache *cache
+);
+
+// adds the limiter's counters to the metrics with the name as a label
+extern void pocket_metrics_register_limiter (
+	const char *name, PocketLimiter *limiter
+);
+
+// adds the pool's occupancy & lock counters to the metrics
+// with the name as a label
+extern void pocket_metrics_register_pool (
+	const char *name, PocketPool *pool
+);
+
+// starts timing a request in the current thread
+extern void pocket_metrics_request_start (
+	PocketMetricsRequest *request, const PocketMetricsRoute route
+);
+
+// records the request's phases in the current thread's histograms
+extern void pocket_metrics_request_end (PocketMetricsRequest *request);
+
+// records a db operation in the current thread's histograms
+// & adds its time to the current request, if any
+extern void pocket_metrics_db_record (
+	const DbCollection collection, const DbOperation operation,
+	const int64_t start, const int64_t elapsed
+);
+
+// writes every metric in prometheus text format
+// returns a new string that must be freed by the caller
+extern char *pocket_metrics_export (size_t *len);
+
+#endif
@@ -4,6 +4,8 @@
 #include <bson/bson.h>
 #include <mongoc/mongoc.h>
 
+#include <cmongo/select.h>
+
 #define ACTIONS_COLL_NAME  			"actions"
 
 #define ACTION_NAME_SIZE				128
@@ -56,4 +58,8 @@ extern bson_t *action_bson_create_update (
 	const char *name, const char *description
 );
 
+extern mongoc_cursor_t *action_find_all (
+	const CMongoSelect *select, uint64_t *n_docs
+);
+
 #endif
\ No newline at end of file
@@ -8,40 +8,53 @@
 
 #include <cerver/types/types.h>
 
+#include "arena.h"
+#include "output.h"
+
 #define CATEGORIES_COLL_NAME        "categories"
 
 #define CATEGORY_ID_SIZE			32
-#define CATEGORY_TITLE_SIZE			1024
-#define CATEGORY_DESCRIPTION_SIZE	2048
-#define CATEGORY_COLOR_SIZE			128
+
+// max bytes in each string, longer values are truncated
+#define CATEGORY_TITLE_MAX			1023
+#define CATEGORY_DESCRIPTION_MAX	2047
+#define CATEGORY_COLOR_MAX			127
 
 extern unsigned int categories_model_init (void);
 
 extern void categories_model_end (void);
 
+// the fields that can be set in a category's update
+#define CATEGORY_FIELD_TITLE			(1 << 0)
+#define CATEGORY_FIELD_DESCRIPTION		(1 << 1)
+#define CATEGORY_FIELD_COLOR			(1 << 2)
+
 typedef struct Category {
 
 	// category's unique id
 	bson_oid_t oid;
-	char id[CATEGORY_ID_SIZE];
 
 	// reference to the owner of this category
 	bson_oid_t user_oid;
 
 	// how the user defined this transaction
-	char title[CATEGORY_TITLE_SIZE];
+	PocketStr title;
 
 	// a description added by the user to give extra information
-	char description[CATEGORY_DESCRIPTION_SIZE];
+	PocketStr description;
 
 	// the user can select a color
 	// that will be used to display all matching transactions
 	// in the mobile app
-	char color[CATEGORY_COLOR_SIZE];
+	PocketStr color;
 
 	// the date when the category was created
 	time_t date;
 
+	// where the strings are copied when the category is read
+	// from the db, it belongs to the request & must be set before
+	PocketArena *arena;
+
 } Category;
 
 extern void *category_new (void);
@@ -69,7 +82,8 @@ extern u8 category_get_by_oid_and_user (
 extern u8 category_get_by_oid_and_user_to_json (
 	const bson_oid_t *oid, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 );
 
 // get all the categories that are related to a user
@@ -77,6 +91,12 @@ extern mongoc_cursor_t *categories_get_all_by_user (
 	const bson_oid_t *user_oid, const bson_t *opts
 );
 
+// get all the user's categories created or updated after since (millis)
+// a since value of 0 returns all the user's categories
+extern mongoc_cursor_t *categories_get_all_by_user_since (
+	const bson_oid_t *user_oid, const int64_t since, const bson_t *opts
+);
+
 extern unsigned int categories_get_all_by_user_to_json (
 	const bson_oid_t *user_oid, const bson_t *opts,
 	char **json, size_t *json_len
@@ -84,10 +104,19 @@ extern unsigned int categories_get_all_by_user_to_json (
 
 extern unsigned int category_insert_one (const Category *category);
 
-extern unsigned int category_update_one (const Category *category);
+// updates only the selected fields of the user's category
+// matched is set with the number of categories that matched
+// returns 0 on success, 1 on error
+extern unsigned int category_update_one (
+	const Category *category, const u8 fields,
+	int64_t *matched
+);
 
+// deleted is set with the number of categories that were removed
+// returns 0 on success, 1 on error
 extern unsigned int category_delete_one_by_oid_and_user (
-	const bson_oid_t *oid, const bson_oid_t *user_oid
+	const bson_oid_t *oid, const bson_oid_t *user_oid,
+	int64_t *deleted
 );
 
 #endif
\ No newline at end of file
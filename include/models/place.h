@@ -11,20 +11,25 @@
 
 #include <cerver/cerver.h>
 
+#include "arena.h"
+#include "output.h"
+
 #define PLACES_COLL_NAME         	"places"
 
 #define PLACE_ID_SIZE				32
-#define PLACE_NAME_SIZE			    512
-#define PLACE_DESCRIPTION_SIZE	    1024
 
-#define PLACE_COLOR_SIZE			128
+// max bytes in each string, longer values are truncated
+#define PLACE_NAME_MAX			    511
+#define PLACE_DESCRIPTION_MAX	    1023
+
+#define PLACE_COLOR_MAX				127
 
-#define LOCATION_ADDRESS_SIZE		256
-#define LOCATION_LAT_SIZE			32
-#define LOCATION_LON_SIZE			32
+#define LOCATION_ADDRESS_MAX		255
+#define LOCATION_LAT_MAX			31
+#define LOCATION_LON_MAX			31
 
-#define SITE_LINK_SIZE				256
-#define SITE_LOGO_SIZE				256
+#define SITE_LINK_MAX				255
+#define SITE_LOGO_MAX				255
 
 extern unsigned int places_model_init (void);
 
@@ -59,32 +64,35 @@ extern PlaceType place_type_from_value_string (
 
 typedef struct Location {
 
-	char address[LOCATION_ADDRESS_SIZE];
-	char lat[LOCATION_LAT_SIZE];
-	char lon[LOCATION_LON_SIZE];
+	PocketStr address;
+	PocketStr lat;
+	PocketStr lon;
 
 } Location;
 
 typedef struct Site {
 
-	char link[SITE_LINK_SIZE];
-	char logo[SITE_LOGO_SIZE];
+	PocketStr link;
+	PocketStr logo;
 
 } Site;
 
+// the fields that can be set in a place's update
+#define PLACE_FIELD_NAME				(1 << 0)
+#define PLACE_FIELD_DESCRIPTION			(1 << 1)
+
 typedef struct Place {
 
 	// place's unique id
 	bson_oid_t oid;
-	char id[PLACE_ID_SIZE];
 
 	// reference to the user that registered this place
 	bson_oid_t user_oid;
 
 	// the name of the place
-	char name[PLACE_NAME_SIZE];
+	PocketStr name;
 	// a text providing additional information about the place
-	char description[PLACE_DESCRIPTION_SIZE];
+	PocketStr description;
 
 	// the place's type
 	// location -> reference to a physicial place
@@ -94,11 +102,15 @@ typedef struct Place {
 	Location location;
 	Site site;
 
-	char color[PLACE_COLOR_SIZE];
+	PocketStr color;
 
 	// the date when the place was created
 	time_t date;
 
+	// where the strings are copied when the place is read
+	// from the db, it belongs to the request & must be set before
+	PocketArena *arena;
+
 } Place;
 
 extern void *place_new (void);
@@ -126,7 +138,8 @@ extern u8 place_get_by_oid_and_user (
 extern u8 place_get_by_oid_and_user_to_json (
 	const bson_oid_t *oid, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 );
 
 // get all the places that are related to a user
@@ -134,6 +147,12 @@ extern mongoc_cursor_t *places_get_all_by_user (
 	const bson_oid_t *user_oid, const bson_t *opts
 );
 
+// get all the user's places created or updated after since (millis)
+// a since value of 0 returns all the user's places
+extern mongoc_cursor_t *places_get_all_by_user_since (
+	const bson_oid_t *user_oid, const int64_t since, const bson_t *opts
+);
+
 extern unsigned int places_get_all_by_user_to_json (
 	const bson_oid_t *user_oid, const bson_t *opts,
 	char **json, size_t *json_len
@@ -141,10 +160,19 @@ extern unsigned int places_get_all_by_user_to_json (
 
 extern unsigned int place_insert_one (const Place *place);
 
-extern unsigned int place_update_one (const Place *place);
+// updates only the selected fields of the user's place
+// matched is set with the number of places that matched
+// returns 0 on success, 1 on error
+extern unsigned int place_update_one (
+	const Place *place, const u8 fields,
+	int64_t *matched
+);
 
+// deleted is set with the number of places that were removed
+// returns 0 on success, 1 on error
 extern unsigned int place_delete_one_by_oid_and_user (
-	const bson_oid_t *oid, const bson_oid_t *user_oid
+	const bson_oid_t *oid, const bson_oid_t *user_oid,
+	int64_t *deleted
 );
 
 #endif
\ No newline at end of file
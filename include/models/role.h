@@ -25,6 +25,9 @@ struct _Role {
 	unsigned int n_actions;
 	char actions[ROLE_ACTIONS_SIZE][ROLE_ACTION_SIZE];
 
+	// actions bits, see pocket_role_action_get ()
+	uint64_t actions_mask;
+
 };
 
 typedef struct _Role Role;
@@ -0,0 +1,63 @@
+#ifndef _MODELS_TOMBSTONE_H_
+#define _MODELS_TOMBSTONE_H_
+
+#include <bson/bson.h>
+#include <mongoc/mongoc.h>
+
+#include "output.h"
+
+#define TOMBSTONES_COLL_NAME         	"tombstones"
+
+#define TOMBSTONE_ID_SIZE				32
+
+// tombstones are removed by mongo after this time,
+// clients that have not synced for longer need a full sync
+#define TOMBSTONES_TTL					(90 * 24 * 60 * 60)
+
+// times a tombstone is inserted before giving up
+// & asking for a full sync of the user's values
+#define TOMBSTONE_INSERT_TRIES			3
+
+#define TOMBSTONE_TYPE_MAP(XX)					\
+	XX(0,	NONE, 			None)				\
+	XX(1,	TRANSACTION, 	Transaction)		\
+	XX(2,	CATEGORY, 		Category)			\
+	XX(3,	PLACE, 			Place)
+
+typedef enum TombstoneType {
+
+	#define XX(num, name, string) TOMBSTONE_TYPE_##name = num,
+	TOMBSTONE_TYPE_MAP (XX)
+	#undef XX
+
+} TombstoneType;
+
+// the { type, ref, date } fields that are returned
+extern PocketOutputShape tombstones_shape;
+
+extern unsigned int tombstones_model_init (void);
+
+extern void tombstones_model_end (void);
+
+// records that the user's document was deleted
+// { user, type, ref, date }
+extern unsigned int tombstone_insert_one (
+	const TombstoneType type,
+	const bson_oid_t *ref_oid, const bson_oid_t *user_oid
+);
+
+// stores the document's tombstone after it was deleted
+// if it can not be stored, the user's next syncs since before now
+// are full syncs, so its clients never keep the deleted document
+extern void tombstone_record (
+	const TombstoneType type,
+	const bson_oid_t *ref_oid, const bson_oid_t *user_oid
+);
+
+// get all the user's tombstones created after since (millis)
+// as { type, ref, date }
+extern mongoc_cursor_t *tombstones_get_all_by_user_since (
+	const bson_oid_t *user_oid, const int64_t since
+);
+
+#endif
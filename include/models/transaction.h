@@ -8,10 +8,18 @@
 
 #include <cerver/types/types.h>
 
+#include "arena.h"
+#include "output.h"
+
 #define TRANSACTIONS_COLL_NAME         	"transactions"
 
 #define	TRANSACTION_ID_SIZE				32
-#define TRANSACTION_TITLE_SIZE			1024
+
+// max bytes in a title, longer titles are truncated
+#define TRANSACTION_TITLE_MAX			1023
+
+// 8 bytes date + 12 bytes oid as hex
+#define TRANSACTIONS_CURSOR_SIZE		48
 
 extern unsigned int transactions_model_init (void);
 
@@ -32,11 +40,16 @@ typedef enum TransType {
 
 extern const char *trans_type_to_string (TransType type);
 
+// the fields that can be set in a transaction's update
+#define TRANSACTION_FIELD_TITLE			(1 << 0)
+#define TRANSACTION_FIELD_AMOUNT		(1 << 1)
+#define TRANSACTION_FIELD_CATEGORY		(1 << 2)
+#define TRANSACTION_FIELD_PLACE			(1 << 3)
+
 typedef struct Transaction {
 
 	// transaction's unique id
 	bson_oid_t oid;
-	char id[TRANSACTION_ID_SIZE];
 
 	// reference to the owner of this transaction
 	bson_oid_t user_oid;
@@ -56,7 +69,7 @@ typedef struct Transaction {
 
 	// the name of the transaction
 	// is given by the user and displayed in the app
-	char title[TRANSACTION_TITLE_SIZE];
+	PocketStr title;
 
 	// the actual value of the transaction
 	double amount;
@@ -69,6 +82,10 @@ typedef struct Transaction {
 	// recurrent -> made every x amount of time, like a subscription
 	TransType type;
 
+	// where the strings are copied when the transaction is read
+	// from the db, it belongs to the request & must be set before
+	PocketArena *arena;
+
 } Transaction;
 
 extern void *transaction_new (void);
@@ -77,6 +94,50 @@ extern void transaction_delete (void *transaction_ptr);
 
 extern void transaction_print (Transaction *transaction);
 
+// used to select a page of a user's transactions
+// transactions are returned from the newest to the oldest
+typedef struct TransactionsQuery {
+
+	// max number of transactions to return, 0 for no limit
+	unsigned int limit;
+
+	// keyset cursor - only returns transactions
+	// that come after the one with these values
+	bool after;
+	int64_t after_date;
+	bson_oid_t after_oid;
+
+	// date range in millis, from is inclusive & to is exclusive
+	bool from;
+	int64_t from_date;
+	bool to;
+	int64_t to_date;
+
+	bool category;
+	bson_oid_t category_oid;
+
+	bool place;
+	bson_oid_t place_oid;
+
+	bool min;
+	double min_amount;
+	bool max;
+	double max_amount;
+
+} TransactionsQuery;
+
+// encodes the transaction's sort values into an opaque cursor string
+// that can be used to request the next page
+extern void transactions_cursor_encode (
+	char *cursor, const int64_t date, const bson_oid_t *oid
+);
+
+// decodes a cursor string into the query's after values
+// returns 0 on success, 1 on invalid cursor
+extern unsigned int transactions_cursor_decode (
+	TransactionsQuery *query, const char *cursor
+);
+
 extern bson_t *transaction_query_oid (const bson_oid_t *oid);
 
 extern bson_t *transaction_query_by_oid_and_user (
@@ -96,12 +157,21 @@ extern u8 transaction_get_by_oid_and_user (
 extern u8 transaction_get_by_oid_and_user_to_json (
 	const bson_oid_t *oid, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 );
 
 // get all the transactions that are related to a user
+// if a query is set, only the matching page is returned
 extern mongoc_cursor_t *transactions_get_all_by_user (
-	const bson_oid_t *user_oid, const bson_t *opts
+	const bson_oid_t *user_oid,
+	const TransactionsQuery *query, const bson_t *opts
+);
+
+// get all the user's transactions created or updated after since (millis)
+// a since value of 0 returns all the user's transactions
+extern mongoc_cursor_t *transactions_get_all_by_user_since (
+	const bson_oid_t *user_oid, const int64_t since, const bson_t *opts
 );
 
 extern unsigned int transactions_get_all_by_user_to_json (
@@ -109,16 +179,39 @@ extern unsigned int transactions_get_all_by_user_to_json (
 	char **json, size_t *json_len
 );
 
+// sums the user's transactions amounts by category & by month
+// {"categories": [ { _id, total, count } ], "months": [ { _id: { year, month }, total, count } ]}
+// only the query's date range, category & place filters are used
+extern unsigned int transactions_get_summary_by_user_to_json (
+	const bson_oid_t *user_oid, const TransactionsQuery *query,
+	const char **json, size_t *json_len
+);
+
 extern unsigned int transaction_insert_one (
 	const Transaction *transaction
 );
 
+// inserts all the transactions using a single unordered batch
+// the errors array is set to 1 for every transaction that failed
+// returns the number of inserted transactions
+extern size_t transactions_insert_many (
+	const Transaction **transactions, const size_t n_transactions,
+	u8 *errors
+);
+
+// updates only the selected fields of the user's transaction
+// matched is set with the number of transactions that matched
+// returns 0 on success, 1 on error
 extern unsigned int transaction_update_one (
-	const Transaction *transaction
+	const Transaction *transaction, const u8 fields,
+	int64_t *matched
 );
 
+// deleted is set with the number of transactions that were removed
+// returns 0 on success, 1 on error
 extern unsigned int transaction_delete_one_by_oid_and_user (
-	const bson_oid_t *oid, const bson_oid_t *user_oid
+	const bson_oid_t *oid, const bson_oid_t *user_oid,
+	int64_t *deleted
 );
 
 #endif
\ No newline at end of file
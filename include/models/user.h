@@ -32,6 +32,7 @@ typedef struct User {
 	char email[USER_EMAIL_SIZE];
 	char name[USER_NAME_SIZE];
 	char username[USER_USERNAME_SIZE];
+	// scrypt hash, see pocket_password_hash ()
 	char password[USER_PASSWORD_SIZE];
 
 	// the role this user belongs to
@@ -49,6 +50,10 @@ typedef struct User {
 	// how many places the user has registered
 	int places_count;
 
+	// syncs since before this date (millis) must be full syncs,
+	// set when a deleted document's tombstone could not be stored
+	int64_t sync_reset;
+
 } User;
 
 extern void *user_new (void);
@@ -65,8 +70,15 @@ extern u8 user_get_by_id (
 	User *user, const char *id, const bson_t *query_opts
 );
 
+extern u8 user_get_by_oid (
+	User *user, const bson_oid_t *oid, const bson_t *query_opts
+);
+
 extern u8 user_check_by_email (const char *email);
 
+// returns a cursor with every user's { _id, email }
+extern mongoc_cursor_t *users_get_all_emails (uint64_t *n_docs);
+
 // gets a user from the db by its email
 extern u8 user_get_by_email (
 	User *user, const char *email, const bson_t *query_opts
@@ -82,18 +94,59 @@ extern bson_t *user_bson_create (const User *user);
 // adds one to user's transactions count
 extern bson_t *user_create_update_pocket_transactions (void);
 
+// adds count to user's transactions count
+extern bson_t *user_create_update_pocket_transactions_count (const int count);
+
 // adds one to user's categories count
 extern bson_t *user_create_update_pocket_categories (void);
 
+// adds count to user's categories count
+extern bson_t *user_create_update_pocket_categories_count (const int count);
+
 // adds one to user's places count
 extern bson_t *user_create_update_pocket_places (void);
 
-extern unsigned int user_insert_one (const User *user);
+// adds count to user's places count
+extern bson_t *user_create_update_pocket_places_count (const int count);
+
+// duplicated is set if the email was already registered
+extern unsigned int user_insert_one (const User *user, bool *duplicated);
 
 extern unsigned int user_add_transactions (const User *user);
 
+extern unsigned int user_add_transactions_count (
+	const User *user, const int count
+);
+
+// removes one from user's transactions count
+extern unsigned int user_remove_transaction (const User *user);
+
 extern unsigned int user_add_category (const User *user);
 
+extern unsigned int user_add_categories_count (
+	const User *user, const int count
+);
+
+// removes one from user's categories count
+extern unsigned int user_remove_category (const User *user);
+
 extern unsigned int user_add_place (const User *user);
 
+extern unsigned int user_add_places_count (
+	const User *user, const int count
+);
+
+// removes one from user's places count
+extern unsigned int user_remove_place (const User *user);
+
+// makes the user's syncs since before date (millis) full syncs
+extern unsigned int user_update_sync_reset (
+	const bson_oid_t *user_oid, const int64_t date
+);
+
+// replaces the user's stored password hash
+extern unsigned int user_update_password (
+	const User *user, const char *password
+);
+
 #endif
\ No newline at end of file
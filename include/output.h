@@ -0,0 +1,68 @@
+#ifndef _POCKET_OUTPUT_H_
+#define _POCKET_OUTPUT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <bson/bson.h>
+
+#include "input.h"
+
+// longest projected key that is written
+#define POCKET_OUTPUT_KEY_SIZE				32
+
+// "YYYY-MM-DDTHH:MM:SS.mmmZ"
+#define POCKET_OUTPUT_DATE_SIZE				32
+
+// enough for the shortest representation of any double
+#define POCKET_OUTPUT_NUMBER_SIZE			32
+
+// the fields of a model that are written in a response,
+// taken from the projection that is used to query them
+// keys are found with the same perfect hash as request bodies,
+// so a shape must not be copied after it has been initialized
+typedef struct PocketOutputShape {
+
+	PocketInputSchema schema;
+
+	char keys[POCKET_INPUT_KEYS_MAX][POCKET_OUTPUT_KEY_SIZE];
+
+	// the keys are the fields that are not written
+	bool exclude;
+
+} PocketOutputShape;
+
+// returns 0 on success, 1 on error
+extern unsigned int pocket_output_init (void);
+
+extern void pocket_output_end (void);
+
+// takes the fields from the opts' projection, _id is added
+// unless it is excluded like mongo does
+// returns 0 on success, 1 on error
+extern unsigned int pocket_output_shape_init (
+	PocketOutputShape *shape, const bson_t *opts
+);
+
+// returns the exact size of the document as json
+// only the shape's fields are written, oids as hex strings
+// & dates as ISO 8601 strings in UTC
+extern size_t pocket_output_doc_size (
+	const PocketOutputShape *shape, const bson_t *doc
+);
+
+// writes the document as json into a buffer
+// that has at least pocket_output_doc_size () bytes
+// returns the number of bytes that were written
+extern size_t pocket_output_doc_write (
+	const PocketOutputShape *shape, const bson_t *doc, char *buffer
+);
+
+// writes the document as json into the current thread's buffer,
+// that is reused by every call in the thread & must not be freed
+// returns NULL on error
+extern const char *pocket_output_doc (
+	const PocketOutputShape *shape, const bson_t *doc, size_t *json_len
+);
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef _POCKET_PASSWORD_H_
+#define _POCKET_PASSWORD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define POCKET_PASSWORD_PREFIX				"$scrypt$"
+
+#define POCKET_PASSWORD_SALT_SIZE			16
+#define POCKET_PASSWORD_KEY_SIZE			32
+
+// $scrypt$cost$r$p$salt$key with salt & key in hex
+#define POCKET_PASSWORD_HASH_SIZE			128
+
+// log2 of scrypt's N, each hash uses 128 * r * N bytes
+#define POCKET_PASSWORD_DEFAULT_COST		15
+#define POCKET_PASSWORD_MIN_COST			10
+#define POCKET_PASSWORD_MAX_COST			20
+
+#define POCKET_PASSWORD_BLOCK_SIZE			8
+#define POCKET_PASSWORD_PARALLEL			1
+
+#define POCKET_PASSWORD_DEFAULT_WORKERS		2
+
+#define POCKET_PASSWORD_RESULT_MAP(XX)						\
+	XX(0,	OK, 		Ok)										\
+	XX(1,	WRONG, 		Wrong password)							\
+	XX(2,	BUSY, 		Too many pending passwords)				\
+	XX(3,	ERROR, 		Failed to hash password)
+
+typedef enum PocketPasswordResult {
+
+	#define XX(num, name, string) POCKET_PASSWORD_RESULT_##name = num,
+	POCKET_PASSWORD_RESULT_MAP (XX)
+	#undef XX
+
+} PocketPasswordResult;
+
+typedef struct PocketPasswordStats {
+
+	unsigned int workers;
+	unsigned int pending;
+	unsigned int queue_max;
+
+	size_t done;
+	size_t rejected;
+
+} PocketPasswordStats;
+
+extern const char *pocket_password_result_to_string (
+	const PocketPasswordResult result
+);
+
+// hashes the password in the caller's thread
+// hashed must be at least POCKET_PASSWORD_HASH_SIZE bytes
+// returns 0 on success, 1 on error
+extern unsigned int pocket_password_hash_sync (
+	const char *password, const unsigned int cost, char *hashed
+);
+
+// checks the password against a stored hash in the caller's thread
+// legacy plain text values are also accepted
+// upgrade is set if the stored value should be replaced
+// with a new hash that uses the current cost
+extern PocketPasswordResult pocket_password_verify_sync (
+	const char *password, const char *stored,
+	const unsigned int cost, bool *upgrade
+);
+
+// returns the max requests that can wait for a password with threads
+// handling requests, one less than the threads so at least one
+// of them is always free to answer 429 instead of waiting
+extern unsigned int pocket_password_queue_default (
+	const unsigned int threads
+);
+
+// starts the workers that hash & verify passwords
+// requests are rejected when queue_max are already waiting
+// for a password, including the ones that are being hashed
+// returns 0 on success, 1 on error
+extern unsigned int pocket_password_init (
+	const unsigned int workers, const unsigned int queue_max,
+	const unsigned int cost
+);
+
+extern void pocket_password_end (void);
+
+extern void pocket_password_get_stats (PocketPasswordStats *stats);
+
+// hashes the password using the workers
+// the caller waits until its request is done
+// returns POCKET_PASSWORD_RESULT_BUSY if the queue is full
+extern PocketPasswordResult pocket_password_hash (
+	const char *password, char *hashed
+);
+
+// verifies the password using the workers
+// if the stored value needs to be upgraded,
+// upgrade is set & rehashed is set with a new hash
+extern PocketPasswordResult pocket_password_verify (
+	const char *password, const char *stored,
+	bool *upgrade, char *rehashed
+);
+
+#endif
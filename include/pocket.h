@@ -2,6 +2,7 @@
 #define _POCKET_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "runtime.h"
 
@@ -23,8 +24,47 @@ extern unsigned int CERVER_CONNECTION_QUEUE;
 extern const String *PRIV_KEY;
 extern const String *PUB_KEY;
 
+// seconds that each auth token is valid after its iat, 0 to never expire them
+extern unsigned int TOKEN_LIFETIME;
+
 extern bool ENABLE_USERS_ROUTES;
 
+// max size in bytes of each of the lists caches, 0 to disable them
+extern size_t CACHE_SIZE;
+
+// seconds that each cached list is kept, 0 to keep them until evicted
+extern unsigned int CACHE_TTL;
+
+// seconds between roles reloads, 0 to only reload on SIGHUP
+extern unsigned int ROLES_REFRESH_INTERVAL;
+
+// threads that hash & verify passwords
+extern unsigned int PASSWORD_WORKERS;
+// max requests waiting for a password before answering 429,
+// must be less than CERVER_TH_THREADS & defaults to one less
+extern unsigned int PASSWORD_QUEUE;
+// log2 of scrypt's N parameter
+extern unsigned int PASSWORD_COST;
+
+// login & register requests per minute by client address, 0 to disable
+extern unsigned int RATE_LIMIT_AUTH;
+extern unsigned int RATE_LIMIT_AUTH_BURST;
+// create & update requests per minute by user, 0 to disable
+extern unsigned int RATE_LIMIT_WRITE;
+extern unsigned int RATE_LIMIT_WRITE_BURST;
+
+// db operations that take more millis are logged, 0 to disable
+extern unsigned int DB_SLOW_THRESHOLD;
+
+// objects made at the start, the pools are never trimmed below them
+extern unsigned int TRANS_POOL_SIZE;
+extern unsigned int CATEGORIES_POOL_SIZE;
+extern unsigned int PLACES_POOL_SIZE;
+extern unsigned int USERS_POOL_SIZE;
+
+// seconds between the pools trims, 0 to never trim them
+extern unsigned int POOL_TRIM_INTERVAL;
+
 // inits pocket main values
 extern unsigned int pocket_init (void);
 
@@ -0,0 +1,144 @@
+#ifndef _POCKET_POOL_H_
+#define _POCKET_POOL_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <pthread.h>
+
+#include <cerver/collections/pool.h>
+
+// objects that each thread keeps for itself
+#define POCKET_POOL_MAGAZINE_SIZE			16
+
+// objects that are moved at once between a magazine & the shared pool
+#define POCKET_POOL_BATCH					(POCKET_POOL_MAGAZINE_SIZE / 2)
+
+#define POCKET_POOL_CACHE_LINE				64
+
+// objects made at the start for each worker thread,
+// when the pool's size is not configured
+#define POCKET_POOL_THREAD_OBJECTS			POCKET_POOL_BATCH
+
+// seconds between trims, 0 to never trim the pools
+#define POCKET_POOL_DEFAULT_TRIM_INTERVAL	30
+
+// the high water mark is multiplied by it on every trim
+#define POCKET_POOL_TRIM_DECAY				0.5
+
+// objects that are destroyed with each lock while trimming
+#define POCKET_POOL_TRIM_BATCH				64
+
+// the objects of a single thread, only its owner touches them,
+// count is also read by the stats
+typedef struct PocketPoolMagazine {
+
+	_Alignas (POCKET_POOL_CACHE_LINE) void *objects[POCKET_POOL_MAGAZINE_SIZE];
+
+	_Atomic unsigned int count;
+
+	// false when its thread has exited & it can be taken by a new one
+	bool active;
+
+	struct PocketPool *pool;
+	struct PocketPoolMagazine *next;
+
+} PocketPoolMagazine;
+
+// per thread magazines in front of a shared cerver pool,
+// so most pops & pushes never take the lock
+typedef struct PocketPool {
+
+	Pool *pool;
+	void (*destroy) (void *);
+
+	pthread_key_t key;
+
+	// protects the shared pool, the magazines list & the counters
+	pthread_mutex_t mutex;
+
+	PocketPoolMagazine *magazines;
+
+	// objects in the shared pool & objects made by the pool
+	size_t available;
+	size_t total;
+
+	// objects made at the start, the pool is never trimmed below it
+	size_t min;
+
+	// most objects that were out of the shared pool since the last trim
+	size_t peak;
+
+	// decays on every trim, unless a new peak is over it
+	double high_water;
+
+	size_t refills;
+	size_t spills;
+	size_t trimmed;
+
+	size_t locks;
+	size_t contended;
+
+	// next pool that is checked by the trimmer
+	struct PocketPool *next;
+
+} PocketPool;
+
+typedef struct PocketPoolStats {
+
+	size_t objects;
+	size_t available;
+	size_t cached;
+	size_t in_use;
+
+	size_t high_water;
+
+	unsigned int magazines;
+
+	size_t refills;
+	size_t spills;
+	size_t trimmed;
+
+	size_t locks;
+	size_t contended;
+
+} PocketPoolStats;
+
+// returns a new pool with n objects or NULL on error,
+// more objects are made with create when it is empty
+// & the extra ones are destroyed by the trims
+extern PocketPool *pocket_pool_create (
+	void *(*create) (void), void (*destroy) (void *),
+	const unsigned int n
+);
+
+// must be called after every thread has stopped using the pool
+extern void pocket_pool_delete (PocketPool *pool);
+
+// returns an object from the thread's magazine,
+// refilled from the shared pool when it is empty
+extern void *pocket_pool_pop (PocketPool *pool);
+
+// returns the object to the thread's magazine,
+// half of it is moved to the shared pool when it is full
+extern void pocket_pool_push (PocketPool *pool, void *object);
+
+extern void pocket_pool_get_stats (
+	PocketPool *pool, PocketPoolStats *stats
+);
+
+// destroys the shared objects that are over the decayed high water mark
+// & over the pool's start size, returns the number of destroyed objects
+extern size_t pocket_pool_trim (PocketPool *pool);
+
+// starts a thread that trims every pool each interval seconds,
+// 0 to never trim them
+// returns 0 on success, 1 on error
+extern unsigned int pocket_pool_trimmer_start (
+	const unsigned int interval
+);
+
+extern void pocket_pool_trimmer_stop (void);
+
+#endif
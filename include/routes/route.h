@@ -0,0 +1,28 @@
+#ifndef _POCKET_ROUTES_ROUTE_H_
+#define _POCKET_ROUTES_ROUTE_H_
+
+#include "arena.h"
+#include "metrics.h"
+
+struct _HttpReceive;
+struct _HttpRequest;
+
+// defines handler##_route that runs the handler inside a request,
+// with its own arena that is released when the handler returns,
+// & records its time in the route's metrics
+#define POCKET_ROUTE_HANDLER(route, handler)							\
+	static void handler##_route (										\
+		const struct _HttpReceive *http_receive,						\
+		const struct _HttpRequest *request								\
+	) {																	\
+		PocketMetricsRequest metrics_request = { 0 };					\
+		pocket_metrics_request_start (									\
+			&metrics_request, POCKET_METRICS_ROUTE_##route				\
+		);																\
+		pocket_arena_request_begin ();									\
+		handler (http_receive, request);								\
+		pocket_arena_request_finish ();									\
+		pocket_metrics_request_end (&metrics_request);					\
+	}
+
+#endif
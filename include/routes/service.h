@@ -17,6 +17,12 @@ extern void pocket_version_handler (
 	const struct _HttpRequest *request
 );
 
+// GET /api/pocket/metrics
+extern void pocket_metrics_handler (
+	const struct _HttpReceive *http_receive,
+	const struct _HttpRequest *request
+);
+
 // GET /api/pocket/auth
 extern void pocket_auth_handler (
 	const struct _HttpReceive *http_receive,
@@ -0,0 +1,14 @@
+#ifndef _POCKET_ROUTES_SYNC_H_
+#define _POCKET_ROUTES_SYNC_H_
+
+struct _HttpReceive;
+struct _HttpRequest;
+
+// GET /api/pocket/sync?since=1620000000000
+// returns the user's values that changed after since
+extern void pocket_sync_handler (
+	const struct _HttpReceive *http_receive,
+	const struct _HttpRequest *request
+);
+
+#endif
@@ -4,13 +4,20 @@
 struct _HttpReceive;
 struct _HttpResponse;
 
-// GET /api/pocket/transactions
-// get all the authenticated user's transactions
+// GET /api/pocket/transactions?limit=50&after=cursor&from=2021-05-01&to=2021-06-01
+// get a page of the authenticated user's transactions
 extern void pocket_transactions_handler (
 	const struct _HttpReceive *http_receive,
 	const struct _HttpRequest *request
 );
 
+// GET /api/pocket/transactions/summary?from=2021-01-01&to=2022-01-01
+// returns the user's transactions totals by category & by month
+extern void pocket_transactions_summary_handler (
+	const struct _HttpReceive *http_receive,
+	const struct _HttpRequest *request
+);
+
 // POST /api/pocket/transactions
 // a user has requested to create a new transaction
 extern void pocket_transaction_create_handler (
@@ -18,6 +25,13 @@ extern void pocket_transaction_create_handler (
 	const struct _HttpRequest *request
 );
 
+// POST /api/pocket/transactions/bulk
+// a user has requested to create multiple transactions at once
+extern void pocket_transactions_bulk_handler (
+	const struct _HttpReceive *http_receive,
+	const struct _HttpRequest *request
+);
+
 // GET /api/pocket/transactions/:id/info
 // returns information about an existing transaction that belongs to a user
 extern void pocket_transaction_get_handler (
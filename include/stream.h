@@ -0,0 +1,154 @@
+#ifndef _POCKET_STREAM_H_
+#define _POCKET_STREAM_H_
+
+#include <stdbool.h>
+
+#include <bson/bson.h>
+#include <mongoc/mongoc.h>
+
+#include <cerver/types/types.h>
+
+#include "cache.h"
+#include "output.h"
+
+#define POCKET_STREAM_BUFFER_SIZE			4096
+
+#define POCKET_STREAM_RESULT_MAP(XX)							\
+	XX(0,	OK, 		Stream was sent)						\
+	XX(1,	NONE, 		Nothing was sent)						\
+	XX(2,	BROKEN, 	Stream was interrupted after headers)
+
+typedef enum PocketStreamResult {
+
+	#define XX(num, name, string) POCKET_STREAM_RESULT_##name = num,
+	POCKET_STREAM_RESULT_MAP (XX)
+	#undef XX
+
+} PocketStreamResult;
+
+struct _HttpReceive;
+
+// a chunked HTTP response that is written while it is generated
+// data is coalesced in a fixed buffer and sent as a chunk
+// every time it fills up, so memory usage is constant
+typedef struct PocketStream {
+
+	int sock_fd;
+
+	// optional etag to send with the headers
+	const char *etag;
+
+	bool started;
+	bool error;
+
+	size_t len;
+	char buffer[POCKET_STREAM_BUFFER_SIZE];
+
+	// an optional copy of the whole body
+	// that is discarded if it grows over its max size
+	bool capture;
+	char *capture_data;
+	size_t capture_len;
+	size_t capture_size;
+	size_t capture_max;
+
+} PocketStream;
+
+// called with every document that was written to the stream
+typedef void (*pocket_stream_doc_cb)(const bson_t *doc, void *args);
+
+// sends a complete body with its content type & etag if it is set
+// returns 0 on success, 1 on error
+extern unsigned int pocket_stream_send_body (
+	const struct _HttpReceive *http_receive,
+	const char *content_type, const char *etag,
+	const char *body, const size_t body_len
+);
+
+// sends a complete json body, with its etag if it is set
+// returns 0 on success, 1 on error
+extern unsigned int pocket_stream_send_json (
+	const struct _HttpReceive *http_receive, const char *etag,
+	const char *json, const size_t json_len
+);
+
+// lets the client know that its copy matches the etag
+// returns 0 on success, 1 on error
+extern unsigned int pocket_stream_send_not_modified (
+	const struct _HttpReceive *http_receive, const char *etag
+);
+
+// sends the key's cached json response if it exists with the same etag
+// returns true if the response was sent,
+// if not, ticket is set like in pocket_cache_get ()
+extern bool pocket_stream_cache_send (
+	PocketCache *cache, const struct _HttpReceive *http_receive,
+	const bson_oid_t *key, const char *etag, u64 *ticket
+);
+
+// sends the response headers with a chunked body
+// returns 0 on success, 1 on error
+extern unsigned int pocket_stream_start (
+	PocketStream *stream, const struct _HttpReceive *http_receive
+);
+
+// keeps a copy of the body, up to max size, as it is written
+// must be released with pocket_stream_capture_free ()
+extern void pocket_stream_capture (
+	PocketStream *stream, const size_t max_size
+);
+
+extern void pocket_stream_capture_free (PocketStream *stream);
+
+// stores the captured body in the cache with the stream's etag
+// if the stream was sent and releases the captured data
+extern void pocket_stream_capture_store (
+	PocketStream *stream, const PocketStreamResult result,
+	PocketCache *cache, const bson_oid_t *key, const u64 ticket
+);
+
+// adds data to the stream, sends chunks as the buffer fills up
+extern void pocket_stream_write (
+	PocketStream *stream, const char *data, size_t data_len
+);
+
+extern void pocket_stream_write_string (
+	PocketStream *stream, const char *string
+);
+
+// sends any pending data & terminates the chunked body
+// if the stream had an error, the connection is aborted instead
+// to let the client know that the response is incomplete
+extern PocketStreamResult pocket_stream_end (PocketStream *stream);
+
+// starts a stream with every document in the cursor as {"key": [ ... ]
+// documents are written with the shape's fields
+// the first document is requested before sending any headers,
+// so nothing is written if the query fails
+// the json object is left open for the caller to end it
+extern PocketStreamResult pocket_stream_cursor (
+	PocketStream *stream, const struct _HttpReceive *http_receive,
+	mongoc_cursor_t *cursor, const char *key,
+	const PocketOutputShape *shape,
+	pocket_stream_doc_cb doc_cb, void *doc_cb_args
+);
+
+// adds , "key": [ ... ] with every document in the cursor
+// to a stream that was started with pocket_stream_cursor ()
+extern void pocket_stream_cursor_append (
+	PocketStream *stream,
+	mongoc_cursor_t *cursor, const char *key,
+	const PocketOutputShape *shape
+);
+
+// streams every document in the cursor as {"key": [ ... ]}
+// and ends the stream
+// if a cache is set, the body is stored using the cache key & ticket
+extern PocketStreamResult pocket_stream_cursor_send (
+	const struct _HttpReceive *http_receive, const char *etag,
+	mongoc_cursor_t *cursor, const char *key,
+	const PocketOutputShape *shape,
+	PocketCache *cache, const bson_oid_t *cache_key, const u64 ticket
+);
+
+#endif
@@ -0,0 +1,273 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include <cerver/utils/log.h>
+
+#include "arena.h"
+
+static pthread_key_t request_arena_key;
+static bool request_arena_key_created = false;
+
+// created by the first request that the thread handles
+static _Thread_local PocketArena *request_arena = NULL;
+static _Thread_local bool request_active = false;
+
+void pocket_arena_init (PocketArena *arena) {
+
+	arena->pos = arena->initial;
+	arena->end = arena->initial + POCKET_ARENA_INLINE_SIZE;
+
+	arena->blocks = NULL;
+	arena->spare = NULL;
+
+	arena->used = 0;
+
+}
+
+// the bytes to skip from pos to be aligned, align must be a power of two
+static inline size_t pocket_arena_padding (
+	const char *pos, const size_t align
+) {
+
+	return (size_t) (-(uintptr_t) pos) & (align - 1);
+
+}
+
+// adds a block that fits at least size bytes & makes it the current one
+// the spare block is used if it is big enough
+static bool pocket_arena_grow (PocketArena *arena, const size_t size) {
+
+	bool retval = false;
+
+	PocketArenaBlock *block = NULL;
+	if (arena->spare && (arena->spare->size >= size)) {
+		block = arena->spare;
+		arena->spare = NULL;
+	}
+
+	else {
+		size_t block_size = POCKET_ARENA_BLOCK_SIZE;
+		if (size > block_size) block_size = size;
+
+		block = (PocketArenaBlock *) malloc (
+			sizeof (PocketArenaBlock) + block_size
+		);
+
+		if (block) block->size = block_size;
+	}
+
+	if (block) {
+		block->next = arena->blocks;
+		arena->blocks = block;
+
+		arena->pos = block->data;
+		arena->end = block->data + block->size;
+
+		retval = true;
+	}
+
+	return retval;
+
+}
+
+// returns memory aligned to align, that must be a power of two,
+// or NULL on error
+void *pocket_arena_alloc_aligned (
+	PocketArena *arena, const size_t size, const size_t align
+) {
+
+	void *retval = NULL;
+
+	if (arena) {
+		size_t padding = pocket_arena_padding (arena->pos, align);
+		if (
+			((size + padding) > (size_t) (arena->end - arena->pos))
+			&& pocket_arena_grow (arena, size + align)
+		) {
+			padding = pocket_arena_padding (arena->pos, align);
+		}
+
+		if ((size + padding) <= (size_t) (arena->end - arena->pos)) {
+			retval = arena->pos + padding;
+			arena->pos += size + padding;
+			arena->used += size + padding;
+		}
+	}
+
+	return retval;
+
+}
+
+// returns memory aligned to POCKET_ARENA_ALIGN or NULL on error
+void *pocket_arena_alloc (PocketArena *arena, const size_t size) {
+
+	return pocket_arena_alloc_aligned (
+		arena, size ? size : 1, POCKET_ARENA_ALIGN
+	);
+
+}
+
+// returns zeroed memory for count values or NULL on error
+void *pocket_arena_calloc (
+	PocketArena *arena, const size_t count, const size_t size
+) {
+
+	void *retval = NULL;
+
+	if (!size || (count <= (SIZE_MAX / size))) {
+		retval = pocket_arena_alloc (arena, count * size);
+		if (retval) (void) memset (retval, 0, count * size);
+	}
+
+	return retval;
+
+}
+
+// copies the string with a NUL at the end
+// returns false & leaves the view empty on error
+bool pocket_arena_str (
+	PocketArena *arena, const char *str, const size_t len, PocketStr *view
+) {
+
+	bool retval = false;
+
+	char *copy = (char *) pocket_arena_alloc (arena, len + 1);
+	if (copy) {
+		(void) memcpy (copy, str, len);
+		copy[len] = '\0';
+
+		view->str = copy;
+		view->len = len;
+
+		retval = true;
+	}
+
+	else {
+		view->str = NULL;
+		view->len = 0;
+	}
+
+	return retval;
+
+}
+
+// releases the extra blocks & makes the inline memory available again
+// the biggest block is kept as the spare one for the next use
+void pocket_arena_reset (PocketArena *arena) {
+
+	PocketArenaBlock *spare = arena->spare;
+
+	PocketArenaBlock *block = arena->blocks;
+	PocketArenaBlock *next = NULL;
+	while (block) {
+		next = block->next;
+
+		if (!spare || (block->size > spare->size)) {
+			free (spare);
+			spare = block;
+		}
+
+		else {
+			free (block);
+		}
+
+		block = next;
+	}
+
+	pocket_arena_init (arena);
+
+	arena->spare = spare;
+
+}
+
+void pocket_arena_end (PocketArena *arena) {
+
+	pocket_arena_reset (arena);
+
+	free (arena->spare);
+	arena->spare = NULL;
+
+}
+
+static void pocket_arena_request_release (void *arena_ptr) {
+
+	PocketArena *arena = (PocketArena *) arena_ptr;
+
+	pocket_arena_end (arena);
+	free (arena);
+
+}
+
+// returns 0 on success, 1 on error
+unsigned int pocket_arena_request_init (void) {
+
+	unsigned int retval = 1;
+
+	if (!pthread_key_create (
+		&request_arena_key, pocket_arena_request_release
+	)) {
+		request_arena_key_created = true;
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error ("Failed to create request arena key!");
+	}
+
+	return retval;
+
+}
+
+void pocket_arena_request_end (void) {
+
+	if (request_arena_key_created) {
+		(void) pthread_setspecific (request_arena_key, NULL);
+		(void) pthread_key_delete (request_arena_key);
+		request_arena_key_created = false;
+	}
+
+	if (request_arena) {
+		pocket_arena_request_release (request_arena);
+		request_arena = NULL;
+	}
+
+}
+
+// the current thread starts handling a request
+void pocket_arena_request_begin (void) {
+
+	if (!request_arena) {
+		request_arena = (PocketArena *) malloc (sizeof (PocketArena));
+		if (request_arena) {
+			pocket_arena_init (request_arena);
+
+			if (request_arena_key_created) {
+				(void) pthread_setspecific (request_arena_key, request_arena);
+			}
+		}
+	}
+
+	request_active = (request_arena != NULL);
+
+}
+
+// everything that was allocated for the request is released
+void pocket_arena_request_finish (void) {
+
+	if (request_active) {
+		pocket_arena_reset (request_arena);
+		request_active = false;
+	}
+
+}
+
+// the arena of the request that the current thread is handling,
+// NULL outside of a request
+PocketArena *pocket_arena_request (void) {
+
+	return request_active ? request_arena : NULL;
+
+}
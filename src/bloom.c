@@ -0,0 +1,101 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <stdatomic.h>
+
+#include <cerver/types/types.h>
+
+#include "bloom.h"
+
+// fnv-1a with a final mix, so both halves can be used as hashes
+static u64 pocket_bloom_hash (const char *data, const size_t data_len) {
+
+	u64 hash = 14695981039346656037ULL;
+	for (size_t idx = 0; idx < data_len; idx++) {
+		hash ^= (unsigned char) data[idx];
+		hash *= 1099511628211ULL;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+
+	return hash;
+
+}
+
+// creates a filter that keeps its false positives rate
+// for up to n_items, it is rounded up to a power of two bits
+PocketBloom *pocket_bloom_create (const size_t n_items) {
+
+	size_t n_bits = 64;
+	while (n_bits < (n_items * POCKET_BLOOM_BITS_PER_ITEM)) n_bits *= 2;
+
+	PocketBloom *bloom = (PocketBloom *) calloc (
+		1, sizeof (PocketBloom) + ((n_bits / 64) * sizeof (u64))
+	);
+
+	if (bloom) {
+		bloom->n_bits = n_bits;
+		bloom->mask = n_bits - 1;
+	}
+
+	return bloom;
+
+}
+
+void pocket_bloom_delete (PocketBloom *bloom) {
+
+	free (bloom);
+
+}
+
+void pocket_bloom_add (
+	PocketBloom *bloom, const char *data, const size_t data_len
+) {
+
+	const u64 hash = pocket_bloom_hash (data, data_len);
+	const u64 h1 = hash & 0xffffffff;
+	const u64 h2 = (hash >> 32) | 1;
+
+	size_t bit = 0;
+	for (unsigned int idx = 0; idx < POCKET_BLOOM_HASHES; idx++) {
+		bit = (size_t) (h1 + (idx * h2)) & bloom->mask;
+
+		(void) atomic_fetch_or_explicit (
+			&bloom->words[bit / 64], (u64) 1 << (bit % 64),
+			memory_order_relaxed
+		);
+	}
+
+}
+
+// returns false if the data was never added
+// returns true if it might have been added
+bool pocket_bloom_check (
+	const PocketBloom *bloom, const char *data, const size_t data_len
+) {
+
+	bool retval = true;
+
+	const u64 hash = pocket_bloom_hash (data, data_len);
+	const u64 h1 = hash & 0xffffffff;
+	const u64 h2 = (hash >> 32) | 1;
+
+	size_t bit = 0;
+	for (unsigned int idx = 0; idx < POCKET_BLOOM_HASHES; idx++) {
+		bit = (size_t) (h1 + (idx * h2)) & bloom->mask;
+
+		if (!(atomic_load_explicit (
+			&((PocketBloom *) bloom)->words[bit / 64], memory_order_relaxed
+		) & ((u64) 1 << (bit % 64)))) {
+			retval = false;
+			break;
+		}
+	}
+
+	return retval;
+
+}
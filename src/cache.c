@@ -0,0 +1,324 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+
+#include <cerver/utils/log.h>
+
+#include "cache.h"
+
+static inline PocketCacheShard *pocket_cache_shard_get (
+	PocketCache *cache, const u32 hash
+) {
+
+	return &cache->shards[hash % POCKET_CACHE_SHARDS];
+
+}
+
+static inline PocketCacheEntry **pocket_cache_bucket_get (
+	PocketCacheShard *shard, const u32 hash
+) {
+
+	return &shard->buckets[(hash / POCKET_CACHE_SHARDS) % POCKET_CACHE_BUCKETS];
+
+}
+
+static inline size_t pocket_cache_entry_size (const PocketCacheEntry *entry) {
+
+	return sizeof (PocketCacheEntry) + entry->len;
+
+}
+
+static void pocket_cache_lru_remove (
+	PocketCacheShard *shard, PocketCacheEntry *entry
+) {
+
+	if (entry->prev) entry->prev->next = entry->next;
+	else shard->head = entry->next;
+
+	if (entry->next) entry->next->prev = entry->prev;
+	else shard->tail = entry->prev;
+
+	entry->prev = NULL;
+	entry->next = NULL;
+
+}
+
+static void pocket_cache_lru_push (
+	PocketCacheShard *shard, PocketCacheEntry *entry
+) {
+
+	entry->prev = NULL;
+	entry->next = shard->head;
+
+	if (shard->head) shard->head->prev = entry;
+	else shard->tail = entry;
+
+	shard->head = entry;
+
+}
+
+// removes the entry from its bucket & from the lru list
+static void pocket_cache_entry_remove (
+	PocketCacheShard *shard, PocketCacheEntry **bucket, PocketCacheEntry *entry
+) {
+
+	PocketCacheEntry **ptr = bucket;
+	while (*ptr && (*ptr != entry)) ptr = &(*ptr)->bucket_next;
+	if (*ptr) *ptr = entry->bucket_next;
+
+	pocket_cache_lru_remove (shard, entry);
+
+	shard->size -= pocket_cache_entry_size (entry);
+	shard->entries -= 1;
+
+	free (entry);
+
+}
+
+static PocketCacheEntry *pocket_cache_entry_find (
+	PocketCacheEntry *bucket, const bson_oid_t *key
+) {
+
+	PocketCacheEntry *entry = bucket;
+	while (entry && !bson_oid_equal (&entry->key, key)) {
+		entry = entry->bucket_next;
+	}
+
+	return entry;
+
+}
+
+// removes the least recently used entries
+// until there is enough space for the new one
+static void pocket_cache_shard_evict (
+	PocketCacheShard *shard, const size_t needed
+) {
+
+	PocketCacheEntry *entry = NULL;
+	while (shard->tail && ((shard->size + needed) > shard->max_size)) {
+		entry = shard->tail;
+
+		pocket_cache_entry_remove (
+			shard,
+			pocket_cache_bucket_get (shard, bson_oid_hash (&entry->key)),
+			entry
+		);
+
+		shard->evictions += 1;
+	}
+
+}
+
+// entries are kept for ttl seconds, 0 to keep them until evicted
+PocketCache *pocket_cache_create (
+	const size_t max_size, const unsigned int ttl
+) {
+
+	PocketCache *cache = (PocketCache *) calloc (1, sizeof (PocketCache));
+	if (cache) {
+		cache->ttl = ttl;
+
+		for (unsigned int idx = 0; idx < POCKET_CACHE_SHARDS; idx++) {
+			(void) pthread_mutex_init (&cache->shards[idx].mutex, NULL);
+			cache->shards[idx].max_size = max_size / POCKET_CACHE_SHARDS;
+		}
+	}
+
+	return cache;
+
+}
+
+void pocket_cache_delete (PocketCache *cache) {
+
+	if (cache) {
+		PocketCacheShard *shard = NULL;
+		PocketCacheEntry *entry = NULL;
+		PocketCacheEntry *next = NULL;
+		for (unsigned int idx = 0; idx < POCKET_CACHE_SHARDS; idx++) {
+			shard = &cache->shards[idx];
+
+			entry = shard->head;
+			while (entry) {
+				next = entry->next;
+				free (entry);
+				entry = next;
+			}
+
+			(void) pthread_mutex_destroy (&shard->mutex);
+		}
+
+		free (cache);
+	}
+
+}
+
+// returns true if the key is in the cache with the same tag
+// & has not expired, an entry with another tag is removed
+// data is set with a copy of the entry that must be freed by the caller
+// on a miss, ticket is set with the value that must be used
+// to store the response with pocket_cache_set ()
+bool pocket_cache_get (
+	PocketCache *cache, const bson_oid_t *key, const char *tag,
+	char **data, size_t *data_len,
+	u64 *ticket
+) {
+
+	bool found = false;
+
+	const u32 hash = bson_oid_hash (key);
+	PocketCacheShard *shard = pocket_cache_shard_get (cache, hash);
+
+	(void) pthread_mutex_lock (&shard->mutex);
+
+	PocketCacheEntry **bucket = pocket_cache_bucket_get (shard, hash);
+	PocketCacheEntry *entry = pocket_cache_entry_find (*bucket, key);
+
+	// expired entries are removed when they are requested
+	if (entry && entry->expires && (entry->expires <= time (NULL))) {
+		pocket_cache_entry_remove (shard, bucket, entry);
+		shard->expired += 1;
+
+		entry = NULL;
+	}
+
+	// the values were changed since the entry was stored
+	if (entry && (!tag || strcmp (entry->tag, tag))) {
+		pocket_cache_entry_remove (shard, bucket, entry);
+
+		entry = NULL;
+	}
+
+	if (entry) {
+		*data = (char *) malloc (entry->len);
+		if (*data) {
+			(void) memcpy (*data, entry->data, entry->len);
+			*data_len = entry->len;
+
+			pocket_cache_lru_remove (shard, entry);
+			pocket_cache_lru_push (shard, entry);
+
+			found = true;
+		}
+	}
+
+	if (found) shard->hits += 1;
+	else shard->misses += 1;
+
+	*ticket = shard->generation;
+
+	(void) pthread_mutex_unlock (&shard->mutex);
+
+	return found;
+
+}
+
+// stores a copy of the data in the cache with its tag
+// it is discarded if the key's shard had an invalidation
+// since the ticket was taken to avoid storing stale values
+// nothing is stored without a tag
+void pocket_cache_set (
+	PocketCache *cache, const bson_oid_t *key, const u64 ticket,
+	const char *tag, const char *data, const size_t data_len
+) {
+
+	if (
+		!tag || (strlen (tag) >= POCKET_CACHE_TAG_SIZE)
+		|| (data_len > POCKET_CACHE_ENTRY_MAX_SIZE)
+	) return;
+
+	PocketCacheEntry *new_entry = (PocketCacheEntry *) malloc (
+		sizeof (PocketCacheEntry) + data_len
+	);
+
+	if (new_entry) {
+		bson_oid_copy (key, &new_entry->key);
+		new_entry->bucket_next = NULL;
+		new_entry->prev = NULL;
+		new_entry->next = NULL;
+		new_entry->expires = cache->ttl ? (time (NULL) + cache->ttl) : 0;
+		(void) strncpy (new_entry->tag, tag, POCKET_CACHE_TAG_SIZE - 1);
+		new_entry->tag[POCKET_CACHE_TAG_SIZE - 1] = '\0';
+		new_entry->len = data_len;
+		(void) memcpy (new_entry->data, data, data_len);
+
+		const u32 hash = bson_oid_hash (key);
+		PocketCacheShard *shard = pocket_cache_shard_get (cache, hash);
+		PocketCacheEntry **bucket = pocket_cache_bucket_get (shard, hash);
+
+		const size_t needed = pocket_cache_entry_size (new_entry);
+
+		(void) pthread_mutex_lock (&shard->mutex);
+
+		if ((shard->generation == ticket) && (needed <= shard->max_size)) {
+			PocketCacheEntry *entry = pocket_cache_entry_find (*bucket, key);
+			if (entry) pocket_cache_entry_remove (shard, bucket, entry);
+
+			pocket_cache_shard_evict (shard, needed);
+
+			new_entry->bucket_next = *bucket;
+			*bucket = new_entry;
+			pocket_cache_lru_push (shard, new_entry);
+
+			shard->size += needed;
+			shard->entries += 1;
+
+			new_entry = NULL;
+		}
+
+		(void) pthread_mutex_unlock (&shard->mutex);
+
+		// the entry was not stored
+		free (new_entry);
+	}
+
+}
+
+// removes the key's entry if it exists
+void pocket_cache_invalidate (
+	PocketCache *cache, const bson_oid_t *key
+) {
+
+	const u32 hash = bson_oid_hash (key);
+	PocketCacheShard *shard = pocket_cache_shard_get (cache, hash);
+	PocketCacheEntry **bucket = pocket_cache_bucket_get (shard, hash);
+
+	(void) pthread_mutex_lock (&shard->mutex);
+
+	PocketCacheEntry *entry = pocket_cache_entry_find (*bucket, key);
+	if (entry) pocket_cache_entry_remove (shard, bucket, entry);
+
+	shard->generation += 1;
+
+	(void) pthread_mutex_unlock (&shard->mutex);
+
+}
+
+void pocket_cache_get_stats (
+	PocketCache *cache, PocketCacheStats *stats
+) {
+
+	(void) memset (stats, 0, sizeof (PocketCacheStats));
+
+	PocketCacheShard *shard = NULL;
+	for (unsigned int idx = 0; idx < POCKET_CACHE_SHARDS; idx++) {
+		shard = &cache->shards[idx];
+
+		(void) pthread_mutex_lock (&shard->mutex);
+
+		stats->entries += shard->entries;
+		stats->size += shard->size;
+		stats->hits += shard->hits;
+		stats->misses += shard->misses;
+		stats->evictions += shard->evictions;
+		stats->expired += shard->expired;
+
+		(void) pthread_mutex_unlock (&shard->mutex);
+	}
+
+}
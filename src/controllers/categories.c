@@ -1,29 +1,63 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include <time.h>
 
 #include <cerver/types/string.h>
 
+#include <cerver/http/http.h>
 #include <cerver/http/response.h>
 #include <cerver/http/json/json.h>
 
-#include <cerver/collections/pool.h>
 
 #include <cerver/utils/log.h>
 
 #include <cmongo/crud.h>
 #include <cmongo/select.h>
 
+#include "arena.h"
+#include "cache.h"
+#include "db.h"
 #include "errors.h"
+#include "etag.h"
+#include "input.h"
+#include "metrics.h"
+#include "pocket.h"
+#include "pool.h"
+#include "stream.h"
 
 #include "models/category.h"
 #include "models/user.h"
 
 #include "controllers/categories.h"
 
-Pool *categories_pool = NULL;
+#define POCKET_CATEGORY_KEY_MAP(XX)				\
+	XX(0,	TITLE, 			title)				\
+	XX(1,	DESCRIPTION, 	description)		\
+	XX(2,	COLOR, 			color)
+
+typedef enum PocketCategoryKey {
+
+	#define XX(num, name, string) POCKET_CATEGORY_KEY_##name = num,
+	POCKET_CATEGORY_KEY_MAP (XX)
+	#undef XX
+
+} PocketCategoryKey;
+
+// the keys of the create & update bodies
+static PocketInputSchema category_schema = {
+	.keys = {
+		#define XX(num, name, string) #string,
+		POCKET_CATEGORY_KEY_MAP (XX)
+		#undef XX
+		NULL
+	}
+};
+
+PocketPool *categories_pool = NULL;
 
 const bson_t *category_no_user_query_opts = NULL;
+PocketOutputShape category_no_user_shape = { 0 };
 static CMongoSelect *category_no_user_select = NULL;
 
 HttpResponse *no_user_categories = NULL;
@@ -36,21 +70,68 @@ HttpResponse *category_deleted_bad = NULL;
 
 void pocket_category_return (void *category_ptr);
 
-static unsigned int pocket_categories_init_pool (void) {
+static PocketCache *categories_cache = NULL;
+
+static unsigned int pocket_categories_init_cache (void) {
 
 	unsigned int retval = 1;
 
-	categories_pool = pool_create (category_delete);
-	if (categories_pool) {
-		pool_set_create (categories_pool, category_new);
-		pool_set_produce_if_empty (categories_pool, true);
-		if (!pool_init (categories_pool, category_new, DEFAULT_CATEGORIES_POOL_INIT)) {
+	// a size of 0 disables the cache
+	if (CACHE_SIZE) {
+		categories_cache = pocket_cache_create (CACHE_SIZE, CACHE_TTL);
+		if (categories_cache) {
+			pocket_metrics_register_cache ("categories", categories_cache);
 			retval = 0;
 		}
+	}
 
-		else {
-			cerver_log_error ("Failed to init categories pool!");
-		}
+	else {
+		retval = 0;
+	}
+
+	return retval;
+
+}
+
+static void pocket_categories_end_cache (void) {
+
+	if (categories_cache) {
+		#ifdef POCKET_DEBUG
+		PocketCacheStats stats = { 0 };
+		pocket_cache_get_stats (categories_cache, &stats);
+		cerver_log_debug (
+			"categories cache - entries: %zu - size: %zu - hits: %zu - misses: %zu - evictions: %zu - expired: %zu",
+			stats.entries, stats.size, stats.hits, stats.misses, stats.evictions, stats.expired
+		);
+		#endif
+
+		pocket_cache_delete (categories_cache);
+		categories_cache = NULL;
+	}
+
+}
+
+// must be called after every write to the user's categories
+// to drop the cached list & change the lists etags
+static inline void pocket_categories_user_changed (const bson_oid_t *user_oid) {
+
+	if (categories_cache) pocket_cache_invalidate (categories_cache, user_oid);
+
+	pocket_etag_changed (POCKET_ETAG_KIND_CATEGORIES, user_oid);
+
+}
+
+static unsigned int pocket_categories_init_pool (void) {
+
+	unsigned int retval = 1;
+
+	categories_pool = pocket_pool_create (
+		category_new, category_delete, CATEGORIES_POOL_SIZE
+	);
+
+	if (categories_pool) {
+		pocket_metrics_register_pool ("categories", categories_pool);
+		retval = 0;
 	}
 
 	else {
@@ -73,7 +154,11 @@ static unsigned int pocket_categories_init_query_opts (void) {
 
 	category_no_user_query_opts = mongo_find_generate_opts (category_no_user_select);
 
-	if (category_no_user_query_opts) retval = 0;
+	if (category_no_user_query_opts) {
+		retval = pocket_output_shape_init (
+			&category_no_user_shape, category_no_user_query_opts
+		);
+	}
 
 	return retval;
 
@@ -127,6 +212,10 @@ unsigned int pocket_categories_init (void) {
 
 	errors |= pocket_categories_init_responses ();
 
+	errors |= pocket_categories_init_cache ();
+
+	errors |= pocket_input_schema_init (&category_schema);
+
 	return errors;
 
 }
@@ -136,7 +225,7 @@ void pocket_categories_end (void) {
 	cmongo_select_delete (category_no_user_select);
 	bson_destroy ((bson_t *) category_no_user_query_opts);
 
-	pool_delete (categories_pool);
+	pocket_pool_delete (categories_pool);
 	categories_pool = NULL;
 
 	http_response_delete (no_user_categories);
@@ -147,17 +236,42 @@ void pocket_categories_end (void) {
 	http_response_delete (category_deleted_success);
 	http_response_delete (category_deleted_bad);
 
+	pocket_categories_end_cache ();
+
 }
 
-unsigned int pocket_categories_get_all_by_user (
-	const bson_oid_t *user_oid,
-	char **json, size_t *json_len
+// streams all the user's categories as {"categories": [ ... ]}
+PocketStreamResult pocket_categories_send_all_by_user (
+	const HttpReceive *http_receive, const char *etag,
+	const bson_oid_t *user_oid
 ) {
 
-	return categories_get_all_by_user_to_json (
-		user_oid, category_no_user_query_opts,
-		json, json_len
-	);
+	PocketStreamResult result = POCKET_STREAM_RESULT_NONE;
+
+	u64 ticket = 0;
+	if (categories_cache && pocket_stream_cache_send (
+		categories_cache, http_receive, user_oid, etag, &ticket
+	)) {
+		result = POCKET_STREAM_RESULT_OK;
+	}
+
+	else {
+		mongoc_cursor_t *cursor = categories_get_all_by_user (
+			user_oid, category_no_user_query_opts
+		);
+
+		if (cursor) {
+			result = pocket_stream_cursor_send (
+				http_receive, etag, cursor, "categories",
+				&category_no_user_shape,
+				categories_cache, user_oid, ticket
+			);
+
+			db_cursor_destroy (cursor);
+		}
+	}
+
+	return result;
 
 }
 
@@ -168,9 +282,10 @@ Category *pocket_category_get_by_id_and_user (
 	Category *category = NULL;
 
 	if (category_id) {
-		category = (Category *) pool_pop (categories_pool);
+		category = (Category *) pocket_pool_pop (categories_pool);
 		if (category) {
 			bson_oid_init_from_string (&category->oid, category_id->str);
+			category->arena = pocket_arena_request ();
 
 			if (category_get_by_oid_and_user (
 				category,
@@ -190,7 +305,8 @@ Category *pocket_category_get_by_id_and_user (
 u8 pocket_category_get_by_id_and_user_to_json (
 	const char *category_id, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 ) {
 
 	u8 retval = 1;
@@ -202,6 +318,7 @@ u8 pocket_category_get_by_id_and_user_to_json (
 		retval = category_get_by_oid_and_user_to_json (
 			&category_oid, user_oid,
 			query_opts,
+			shape,
 			json, json_len
 		);
 	}
@@ -210,104 +327,85 @@ u8 pocket_category_get_by_id_and_user_to_json (
 
 }
 
-static Category *pocket_category_create_actual (
-	const char *user_id,
-	const char *title, const char *description,
-	const char *color
+// sets the category's values from the object's members,
+// values with unexpected types are ignored like unknown keys
+// strings point to the body or to the arena if they had escapes
+static void pocket_category_parse_input (
+	PocketInput *input, PocketArena *arena,
+	Category *category, u8 *fields
 ) {
 
-	Category *category = (Category *) pool_pop (categories_pool);
-	if (category) {
-		bson_oid_init (&category->oid, NULL);
+	int key = -1;
+	PocketInputValue value = { 0 };
+	while (pocket_input_object_next (input, &category_schema, &key, &value)) {
+		switch (key) {
+			case POCKET_CATEGORY_KEY_TITLE:
+				if (pocket_input_string_view (
+					&value, arena, CATEGORY_TITLE_MAX, &category->title
+				)) {
+					*fields |= CATEGORY_FIELD_TITLE;
+				}
+				break;
 
-		bson_oid_init_from_string (&category->user_oid, user_id);
+			case POCKET_CATEGORY_KEY_DESCRIPTION:
+				if (pocket_input_string_view (
+					&value, arena, CATEGORY_DESCRIPTION_MAX, &category->description
+				)) {
+					*fields |= CATEGORY_FIELD_DESCRIPTION;
+				}
+				break;
 
-		if (title) (void) strncpy (category->title, title, CATEGORY_TITLE_SIZE - 1);
-		if (description) (void) strncpy (category->description, description, CATEGORY_DESCRIPTION_SIZE - 1);
+			case POCKET_CATEGORY_KEY_COLOR:
+				if (pocket_input_string_view (
+					&value, arena, CATEGORY_COLOR_MAX, &category->color
+				)) {
+					*fields |= CATEGORY_FIELD_COLOR;
+				}
+				break;
 
-		if (color) (void) strncpy (category->color, color, CATEGORY_COLOR_SIZE - 1);
-		
-		category->date = time (NULL);
+			default: break;
+		}
 	}
 
-	return category;
-
 }
 
-static void pocket_category_parse_json (
-	json_t *json_body,
-	const char **title,
-	const char **description,
-	const char **color
+static PocketError pocket_category_create_parse_json (
+	Category **category, PocketArena *arena,
+	const User *user, const String *request_body
 ) {
 
-	// get values from json to create a new category
-	const char *key = NULL;
-	json_t *value = NULL;
-	if (json_typeof (json_body) == JSON_OBJECT) {
-		json_object_foreach (json_body, key, value) {
-			if (!strcmp (key, "title")) {
-				*title = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("title: \"%s\"\n", *title);
-				#endif
-			}
+	PocketError error = POCKET_ERROR_NONE;
 
-			else if (!strcmp (key, "description")) {
-				*description = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("description: \"%s\"\n", *description);
-				#endif
-			}
+	PocketInput input = { 0 };
+	pocket_input_init (&input, request_body->str, request_body->len);
 
-			else if (!strcmp (key, "color")) {
-				*color = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("color: \"%s\"\n", *color);
-				#endif
-			}
-		}
-	}
+	Category *new_category = (Category *) pocket_pool_pop (categories_pool);
+	if (new_category) {
+		bson_oid_init (&new_category->oid, NULL);
+		bson_oid_copy (&user->oid, &new_category->user_oid);
 
-}
+		new_category->date = time (NULL);
 
-static PocketError pocket_category_create_parse_json (
-	Category **category,
-	const char *user_id, const String *request_body
-) {
+		u8 fields = 0;
+		if (pocket_input_object_begin (&input)) {
+			pocket_category_parse_input (&input, arena, new_category, &fields);
+		}
 
-	PocketError error = POCKET_ERROR_NONE;
+		if (pocket_input_end (&input)) {
+			*category = new_category;
+		}
 
-	const char *title = NULL;
-	const char *description = NULL;
-	const char *color = NULL;
-
-	json_error_t json_error =  { 0 };
-	json_t *json_body = json_loads (request_body->str, 0, &json_error);
-	if (json_body) {
-		pocket_category_parse_json (
-			json_body,
-			&title,
-			&description,
-			&color
-		);
+		else {
+			cerver_log_error ("pocket_category_create () - bad request body!");
 
-		*category = pocket_category_create_actual (
-			user_id,
-			title, description,
-			color
-		);
+			pocket_category_return (new_category);
 
-		json_decref (json_body);
+			error = POCKET_ERROR_BAD_REQUEST;
+		}
 	}
 
 	else {
-		cerver_log_error (
-			"json_loads () - json error on line %d: %s\n", 
-			json_error.line, json_error.text
-		);
-
-		error = POCKET_ERROR_BAD_REQUEST;
+		error = POCKET_ERROR_SERVER_ERROR;
 	}
 
 	return error;
@@ -321,11 +419,13 @@ PocketError pocket_category_create (
 	PocketError error = POCKET_ERROR_NONE;
 
 	if (request_body) {
+		PocketArena *arena = pocket_arena_request ();
+
 		Category *category = NULL;
 
 		error = pocket_category_create_parse_json (
-			&category,
-			user->id, request_body
+			&category, arena,
+			user, request_body
 		);
 
 		if (error == POCKET_ERROR_NONE) {
@@ -338,6 +438,8 @@ PocketError pocket_category_create (
 			)) {
 				// update users values
 				(void) user_add_category (user);
+
+				pocket_categories_user_changed (&user->oid);
 			}
 
 			else {
@@ -361,47 +463,37 @@ PocketError pocket_category_create (
 }
 
 static PocketError pocket_category_update_parse_json (
-	Category *category, const String *request_body
+	Category *category, PocketArena *arena,
+	u8 *fields, const String *request_body
 ) {
 
-	PocketError error = POCKET_ERROR_NONE;
+	PocketError error = POCKET_ERROR_BAD_REQUEST;
 
-	const char *title = NULL;
-	const char *description = NULL;
-	const char *color = NULL;
-
-	json_error_t json_error =  { 0 };
-	json_t *json_body = json_loads (request_body->str, 0, &json_error);
-	if (json_body) {
-		pocket_category_parse_json (
-			json_body,
-			&title,
-			&description,
-			&color
-		);
+	PocketInput input = { 0 };
+	pocket_input_init (&input, request_body->str, request_body->len);
 
-		if (title) (void) strncpy (category->title, title, CATEGORY_TITLE_SIZE - 1);
-		if (description) (void) strncpy (category->description, description, CATEGORY_DESCRIPTION_SIZE - 1);
-		if (color) (void) strncpy (category->color, color, CATEGORY_COLOR_SIZE - 1);
+	// only the values that are present are set
+	if (pocket_input_object_begin (&input)) {
+		pocket_category_parse_input (&input, arena, category, fields);
 
-		json_decref (json_body);
+		if (pocket_input_end (&input)) {
+			error = *fields ?
+				POCKET_ERROR_NONE : POCKET_ERROR_MISSING_VALUES;
+		}
 	}
 
-	else {
-		#ifdef POCKET_DEBUG
-		cerver_log_error (
-			"json_loads () - json error on line %d: %s\n", 
-			json_error.line, json_error.text
-		);
-		#endif
-
-		error = POCKET_ERROR_BAD_REQUEST;
+	#ifdef POCKET_DEBUG
+	if (error == POCKET_ERROR_BAD_REQUEST) {
+		cerver_log_error ("pocket_category_update () - bad request body!");
 	}
+	#endif
 
 	return error;
 
 }
 
+// sets only the fields present in the request
+// in the category that matches both the id & the user
 PocketError pocket_category_update (
 	const User *user, const String *category_id,
 	const String *request_body
@@ -410,29 +502,47 @@ PocketError pocket_category_update (
 	PocketError error = POCKET_ERROR_NONE;
 
 	if (request_body) {
-		Category *category = pocket_category_get_by_id_and_user (
-			category_id, &user->oid
-		);
-
-		if (category) {
-			// get update values
-			if (pocket_category_update_parse_json (
-				category, request_body
-			) == POCKET_ERROR_NONE) {
-				// update the category in the db
-				if (category_update_one (category)) {
-					error = POCKET_ERROR_SERVER_ERROR;
+		if (category_id && bson_oid_is_valid (category_id->str, category_id->len)) {
+			Category *category = (Category *) pocket_pool_pop (categories_pool);
+			if (category) {
+				bson_oid_init_from_string (&category->oid, category_id->str);
+				bson_oid_copy (&user->oid, &category->user_oid);
+
+				PocketArena *arena = pocket_arena_request ();
+
+				u8 fields = 0;
+				error = pocket_category_update_parse_json (
+					category, arena, &fields, request_body
+				);
+
+				if (error == POCKET_ERROR_NONE) {
+					int64_t matched = 0;
+					if (category_update_one (category, fields, &matched)) {
+						error = POCKET_ERROR_SERVER_ERROR;
+					}
+
+					else if (!matched) {
+						#ifdef POCKET_DEBUG
+						cerver_log_error ("Failed to get matching category!");
+						#endif
+
+						error = POCKET_ERROR_NOT_FOUND;
+					}
+
+					else {
+						pocket_categories_user_changed (&user->oid);
+					}
 				}
+
+				pocket_category_return (category);
 			}
 
-			pocket_category_return (category);
+			else {
+				error = POCKET_ERROR_SERVER_ERROR;
+			}
 		}
 
 		else {
-			#ifdef POCKET_DEBUG
-			cerver_log_error ("Failed to get matching category!");
-			#endif
-
 			error = POCKET_ERROR_NOT_FOUND;
 		}
 	}
@@ -456,15 +566,34 @@ PocketError pocket_category_delete (
 
 	PocketError error = POCKET_ERROR_NONE;
 
-	bson_oid_t oid = { 0 };
-	bson_oid_init_from_string (&oid, category_id->str);
+	if (category_id && bson_oid_is_valid (category_id->str, category_id->len)) {
+		bson_oid_t oid = { 0 };
+		bson_oid_init_from_string (&oid, category_id->str);
+
+		int64_t deleted = 0;
+		if (!category_delete_one_by_oid_and_user (
+			&oid, &user->oid, &deleted
+		)) {
+			// the user's count is only updated
+			// if the category was actually removed
+			if (deleted) {
+				#ifdef POCKET_DEBUG
+				cerver_log_debug ("Deleted category %s", category_id->str);
+				#endif
 
-	if (!category_delete_one_by_oid_and_user (
-		&oid, &user->oid
-	)) {
-		#ifdef POCKET_DEBUG
-		cerver_log_debug ("Deleted category %s", category_id->str);
-		#endif
+				(void) user_remove_category (user);
+
+				pocket_categories_user_changed (&user->oid);
+			}
+
+			else {
+				error = POCKET_ERROR_NOT_FOUND;
+			}
+		}
+
+		else {
+			error = POCKET_ERROR_SERVER_ERROR;
+		}
 	}
 
 	else {
@@ -478,6 +607,6 @@ PocketError pocket_category_delete (
 void pocket_category_return (void *category_ptr) {
 
 	(void) memset (category_ptr, 0, sizeof (Category));
-	(void) pool_push (categories_pool, category_ptr);
+	pocket_pool_push (categories_pool, category_ptr);
 
 }
\ No newline at end of file
@@ -1,11 +1,11 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include <time.h>
 
 #include <cerver/types/string.h>
 
-#include <cerver/collections/pool.h>
-
+#include <cerver/http/http.h>
 #include <cerver/http/response.h>
 #include <cerver/http/json/json.h>
 
@@ -14,16 +14,54 @@
 #include <cmongo/crud.h>
 #include <cmongo/select.h>
 
+#include "arena.h"
+#include "cache.h"
+#include "db.h"
 #include "errors.h"
+#include "etag.h"
+#include "input.h"
+#include "metrics.h"
+#include "pocket.h"
+#include "pool.h"
+#include "stream.h"
 
 #include "models/place.h"
 #include "models/user.h"
 
 #include "controllers/places.h"
 
-Pool *places_pool = NULL;
+#define POCKET_PLACE_TYPE_SIZE			16
+
+#define POCKET_PLACE_KEY_MAP(XX)				\
+	XX(0,	NAME, 			name)				\
+	XX(1,	DESCRIPTION, 	description)		\
+	XX(2,	TYPE, 			type)				\
+	XX(3,	LINK, 			link)				\
+	XX(4,	LOGO, 			logo)				\
+	XX(5,	COLOR, 			color)
+
+typedef enum PocketPlaceKey {
+
+	#define XX(num, name, string) POCKET_PLACE_KEY_##name = num,
+	POCKET_PLACE_KEY_MAP (XX)
+	#undef XX
+
+} PocketPlaceKey;
+
+// the keys of the create & update bodies
+static PocketInputSchema place_schema = {
+	.keys = {
+		#define XX(num, name, string) #string,
+		POCKET_PLACE_KEY_MAP (XX)
+		#undef XX
+		NULL
+	}
+};
+
+PocketPool *places_pool = NULL;
 
 const bson_t *place_no_user_query_opts = NULL;
+PocketOutputShape place_no_user_shape = { 0 };
 static CMongoSelect *place_no_user_select = NULL;
 
 HttpResponse *no_user_places = NULL;
@@ -36,21 +74,68 @@ HttpResponse *place_deleted_bad = NULL;
 
 void pocket_place_return (void *place_ptr);
 
-static unsigned int pocket_places_init_pool (void) {
+static PocketCache *places_cache = NULL;
+
+static unsigned int pocket_places_init_cache (void) {
 
 	unsigned int retval = 1;
 
-	places_pool = pool_create (place_delete);
-	if (places_pool) {
-		pool_set_create (places_pool, place_new);
-		pool_set_produce_if_empty (places_pool, true);
-		if (!pool_init (places_pool, place_new, DEFAULT_PLACES_POOL_INIT)) {
+	// a size of 0 disables the cache
+	if (CACHE_SIZE) {
+		places_cache = pocket_cache_create (CACHE_SIZE, CACHE_TTL);
+		if (places_cache) {
+			pocket_metrics_register_cache ("places", places_cache);
 			retval = 0;
 		}
+	}
 
-		else {
-			cerver_log_error ("Failed to init places pool!");
-		}
+	else {
+		retval = 0;
+	}
+
+	return retval;
+
+}
+
+static void pocket_places_end_cache (void) {
+
+	if (places_cache) {
+		#ifdef POCKET_DEBUG
+		PocketCacheStats stats = { 0 };
+		pocket_cache_get_stats (places_cache, &stats);
+		cerver_log_debug (
+			"places cache - entries: %zu - size: %zu - hits: %zu - misses: %zu - evictions: %zu - expired: %zu",
+			stats.entries, stats.size, stats.hits, stats.misses, stats.evictions, stats.expired
+		);
+		#endif
+
+		pocket_cache_delete (places_cache);
+		places_cache = NULL;
+	}
+
+}
+
+// must be called after every write to the user's places
+// to drop the cached list & change the lists etags
+static inline void pocket_places_user_changed (const bson_oid_t *user_oid) {
+
+	if (places_cache) pocket_cache_invalidate (places_cache, user_oid);
+
+	pocket_etag_changed (POCKET_ETAG_KIND_PLACES, user_oid);
+
+}
+
+static unsigned int pocket_places_init_pool (void) {
+
+	unsigned int retval = 1;
+
+	places_pool = pocket_pool_create (
+		place_new, place_delete, PLACES_POOL_SIZE
+	);
+
+	if (places_pool) {
+		pocket_metrics_register_pool ("places", places_pool);
+		retval = 0;
 	}
 
 	else {
@@ -76,7 +161,11 @@ static unsigned int pocket_places_init_query_opts (void) {
 
 	place_no_user_query_opts = mongo_find_generate_opts (place_no_user_select);
 
-	if (place_no_user_query_opts) retval = 0;
+	if (place_no_user_query_opts) {
+		retval = pocket_output_shape_init (
+			&place_no_user_shape, place_no_user_query_opts
+		);
+	}
 
 	return retval;
 
@@ -130,6 +219,10 @@ unsigned int pocket_places_init (void) {
 
 	errors |= pocket_places_init_responses ();
 
+	errors |= pocket_places_init_cache ();
+
+	errors |= pocket_input_schema_init (&place_schema);
+
 	return errors;
 
 }
@@ -139,7 +232,7 @@ void pocket_places_end (void) {
 	cmongo_select_delete (place_no_user_select);
 	bson_destroy ((bson_t *) place_no_user_query_opts);
 
-	pool_delete (places_pool);
+	pocket_pool_delete (places_pool);
 	places_pool = NULL;
 
 	http_response_delete (no_user_places);
@@ -150,17 +243,42 @@ void pocket_places_end (void) {
 	http_response_delete (place_deleted_success);
 	http_response_delete (place_deleted_bad);
 
+	pocket_places_end_cache ();
+
 }
 
-unsigned int pocket_places_get_all_by_user (
-	const bson_oid_t *user_oid,
-	char **json, size_t *json_len
+// streams all the user's places as {"places": [ ... ]}
+PocketStreamResult pocket_places_send_all_by_user (
+	const HttpReceive *http_receive, const char *etag,
+	const bson_oid_t *user_oid
 ) {
 
-	return places_get_all_by_user_to_json (
-		user_oid, place_no_user_query_opts,
-		json, json_len
-	);
+	PocketStreamResult result = POCKET_STREAM_RESULT_NONE;
+
+	u64 ticket = 0;
+	if (places_cache && pocket_stream_cache_send (
+		places_cache, http_receive, user_oid, etag, &ticket
+	)) {
+		result = POCKET_STREAM_RESULT_OK;
+	}
+
+	else {
+		mongoc_cursor_t *cursor = places_get_all_by_user (
+			user_oid, place_no_user_query_opts
+		);
+
+		if (cursor) {
+			result = pocket_stream_cursor_send (
+				http_receive, etag, cursor, "places",
+				&place_no_user_shape,
+				places_cache, user_oid, ticket
+			);
+
+			db_cursor_destroy (cursor);
+		}
+	}
+
+	return result;
 
 }
 
@@ -171,9 +289,10 @@ Place *pocket_place_get_by_id_and_user (
 	Place *place = NULL;
 
 	if (place_id) {
-		place = (Place *) pool_pop (places_pool);
+		place = (Place *) pocket_pool_pop (places_pool);
 		if (place) {
 			bson_oid_init_from_string (&place->oid, place_id->str);
+			place->arena = pocket_arena_request ();
 
 			if (place_get_by_oid_and_user (
 				place,
@@ -193,7 +312,8 @@ Place *pocket_place_get_by_id_and_user (
 u8 pocket_place_get_by_id_and_user_to_json (
 	const char *place_id, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 ) {
 
 	u8 retval = 1;
@@ -205,6 +325,7 @@ u8 pocket_place_get_by_id_and_user_to_json (
 		retval = place_get_by_oid_and_user_to_json (
 			&place_oid, user_oid,
 			query_opts,
+			shape,
 			json, json_len
 		);
 	}
@@ -213,155 +334,112 @@ u8 pocket_place_get_by_id_and_user_to_json (
 
 }
 
-static Place *pocket_place_create_actual (
-	const char *user_id,
-	const char *name, const char *description,
-	const char *type,
-	const char *link,
-	const char *logo,
-	const char *color
+// sets the place's values from the object's members,
+// values with unexpected types are ignored like unknown keys
+// strings point to the body or to the arena if they had escapes
+static void pocket_place_parse_input (
+	PocketInput *input, PocketArena *arena,
+	Place *place, u8 *fields
 ) {
 
-	Place *place = (Place *) pool_pop (places_pool);
-	if (place) {
-		bson_oid_init (&place->oid, NULL);
-
-		bson_oid_init_from_string (&place->user_oid, user_id);
-
-		if (name) (void) strncpy (place->name, name, PLACE_NAME_SIZE - 1);
-		if (description) (void) strncpy (place->description, description, PLACE_DESCRIPTION_SIZE - 1);
-		
-		place->type = place_type_from_value_string (type);
-
-		switch (place->type) {
-			case PLACE_TYPE_NONE: break;
-
-			case PLACE_TYPE_LOCATION: break;
-
-			case PLACE_TYPE_SITE: {
-				if (link) (void) strncpy (place->site.link, link, SITE_LINK_SIZE - 1);
-				if (logo) (void) strncpy (place->site.logo, logo, SITE_LOGO_SIZE - 1);
-			} break;
-			
-			default: break;
+	char type[POCKET_PLACE_TYPE_SIZE] = { 0 };
+
+	int key = -1;
+	PocketInputValue value = { 0 };
+	while (pocket_input_object_next (input, &place_schema, &key, &value)) {
+		if (value.type == POCKET_INPUT_TYPE_STRING) {
+			switch (key) {
+				case POCKET_PLACE_KEY_NAME:
+					(void) pocket_input_string_view (
+						&value, arena, PLACE_NAME_MAX, &place->name
+					);
+
+					*fields |= PLACE_FIELD_NAME;
+					break;
+
+				case POCKET_PLACE_KEY_DESCRIPTION:
+					(void) pocket_input_string_view (
+						&value, arena, PLACE_DESCRIPTION_MAX, &place->description
+					);
+
+					*fields |= PLACE_FIELD_DESCRIPTION;
+					break;
+
+				case POCKET_PLACE_KEY_TYPE:
+					(void) pocket_input_string_copy (
+						&value, type, POCKET_PLACE_TYPE_SIZE
+					);
+
+					place->type = place_type_from_value_string (type);
+					break;
+
+				case POCKET_PLACE_KEY_LINK:
+					(void) pocket_input_string_view (
+						&value, arena, SITE_LINK_MAX, &place->site.link
+					);
+					break;
+
+				case POCKET_PLACE_KEY_LOGO:
+					(void) pocket_input_string_view (
+						&value, arena, SITE_LOGO_MAX, &place->site.logo
+					);
+					break;
+
+				case POCKET_PLACE_KEY_COLOR:
+					(void) pocket_input_string_view (
+						&value, arena, PLACE_COLOR_MAX, &place->color
+					);
+					break;
+
+				default: break;
+			}
 		}
-
-		if (color) (void) strncpy (place->color, color, PLACE_COLOR_SIZE - 1);
-
-		place->date = time (NULL);
 	}
 
-	return place;
-
 }
 
-static void pocket_place_parse_json (
-	json_t *json_body,
-	const char **name,
-	const char **description,
-	const char **type,
-	const char **link,
-	const char **logo,
-	const char **color
+static PocketError pocket_place_create_parse_json (
+	Place **place, PocketArena *arena,
+	const User *user, const String *request_body
 ) {
 
-	// get values from json to create a new place
-	const char *key = NULL;
-	json_t *value = NULL;
-	if (json_typeof (json_body) == JSON_OBJECT) {
-		json_object_foreach (json_body, key, value) {
-			if (!strcmp (key, "name")) {
-				*name = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("name: \"%s\"\n", *name);
-				#endif
-			}
-
-			else if (!strcmp (key, "description")) {
-				*description = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("description: \"%s\"\n", *description);
-				#endif
-			}
+	PocketError error = POCKET_ERROR_NONE;
 
-			else if (!strcmp (key, "type")) {
-				*type = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("type: \"%s\"\n", *type);
-				#endif
-			}
+	PocketInput input = { 0 };
+	pocket_input_init (&input, request_body->str, request_body->len);
 
-			else if (!strcmp (key, "link")) {
-				*link = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("link: \"%s\"\n", *link);
-				#endif
-			}
+	Place *new_place = (Place *) pocket_pool_pop (places_pool);
+	if (new_place) {
+		bson_oid_init (&new_place->oid, NULL);
+		bson_oid_copy (&user->oid, &new_place->user_oid);
 
-			else if (!strcmp (key, "logo")) {
-				*logo = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("logo: \"%s\"\n", *logo);
-				#endif
-			}
+		new_place->date = time (NULL);
 
-			else if (!strcmp (key, "color")) {
-				*color = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("color: \"%s\"\n", *color);
-				#endif
-			}
+		u8 fields = 0;
+		if (pocket_input_object_begin (&input)) {
+			pocket_place_parse_input (&input, arena, new_place, &fields);
 		}
-	}
 
-}
-
-static PocketError pocket_place_create_parse_json (
-	Place **place,
-	const char *user_id, const String *request_body
-) {
+		// only sites keep their link & logo
+		if (new_place->type != PLACE_TYPE_SITE) {
+			(void) memset (&new_place->site, 0, sizeof (Site));
+		}
 
-	PocketError error = POCKET_ERROR_NONE;
+		if (pocket_input_end (&input)) {
+			*place = new_place;
+		}
 
-	const char *name = NULL;
-	const char *description = NULL;
-	const char *type = NULL;
-	const char *link = NULL;
-	const char *logo = NULL;
-	const char *color = NULL;
-
-	json_error_t json_error =  { 0 };
-	json_t *json_body = json_loads (request_body->str, 0, &json_error);
-	if (json_body) {
-		pocket_place_parse_json (
-			json_body,
-			&name,
-			&description,
-			&type,
-			&link,
-			&logo,
-			&color
-		);
+		else {
+			cerver_log_error ("pocket_place_create () - bad request body!");
 
-		*place = pocket_place_create_actual (
-			user_id,
-			name, description,
-			type,
-			link,
-			logo,
-			color
-		);
+			pocket_place_return (new_place);
 
-		json_decref (json_body);
+			error = POCKET_ERROR_BAD_REQUEST;
+		}
 	}
 
 	else {
-		cerver_log_error (
-			"json_loads () - json error on line %d: %s\n", 
-			json_error.line, json_error.text
-		);
-
-		error = POCKET_ERROR_BAD_REQUEST;
+		error = POCKET_ERROR_SERVER_ERROR;
 	}
 
 	return error;
@@ -375,11 +453,13 @@ PocketError pocket_place_create (
 	PocketError error = POCKET_ERROR_NONE;
 
 	if (request_body) {
+		PocketArena *arena = pocket_arena_request ();
+
 		Place *place = NULL;
 
 		error = pocket_place_create_parse_json (
-			&place,
-			user->id, request_body
+			&place, arena,
+			user, request_body
 		);
 
 		if (error == POCKET_ERROR_NONE) {
@@ -390,6 +470,8 @@ PocketError pocket_place_create (
 			if (!place_insert_one (place)) {
 				// update users values
 				(void) user_add_place (user);
+
+				pocket_places_user_changed (&user->oid);
 			}
 
 			else {
@@ -412,53 +494,39 @@ PocketError pocket_place_create (
 
 }
 
+// only the name & the description can be updated
 static PocketError pocket_place_update_parse_json (
-	Place *place, const String *request_body
+	Place *place, PocketArena *arena,
+	u8 *fields, const String *request_body
 ) {
 
-	PocketError error = POCKET_ERROR_NONE;
+	PocketError error = POCKET_ERROR_BAD_REQUEST;
 
-	const char *name = NULL;
-	const char *description = NULL;
-	const char *type = NULL;
-	const char *link = NULL;
-	const char *logo = NULL;
-	const char *color = NULL;
-
-	json_error_t json_error =  { 0 };
-	json_t *json_body = json_loads (request_body->str, 0, &json_error);
-	if (json_body) {
-		pocket_place_parse_json (
-			json_body,
-			&name,
-			&description,
-			&type,
-			&link,
-			&logo,
-			&color
-		);
+	PocketInput input = { 0 };
+	pocket_input_init (&input, request_body->str, request_body->len);
 
-		if (name) (void) strncpy (place->name, name, PLACE_NAME_SIZE - 1);
-		if (description) (void) strncpy (place->description, description, PLACE_DESCRIPTION_SIZE - 1);
+	// only the values that are present are set
+	if (pocket_input_object_begin (&input)) {
+		pocket_place_parse_input (&input, arena, place, fields);
 
-		json_decref (json_body);
+		if (pocket_input_end (&input)) {
+			error = *fields ?
+				POCKET_ERROR_NONE : POCKET_ERROR_MISSING_VALUES;
+		}
 	}
 
-	else {
-		#ifdef POCKET_DEBUG
-		cerver_log_error (
-			"json_loads () - json error on line %d: %s\n", 
-			json_error.line, json_error.text
-		);
-		#endif
-
-		error = POCKET_ERROR_BAD_REQUEST;
+	#ifdef POCKET_DEBUG
+	if (error == POCKET_ERROR_BAD_REQUEST) {
+		cerver_log_error ("pocket_place_update () - bad request body!");
 	}
+	#endif
 
 	return error;
 
 }
 
+// sets only the fields present in the request
+// in the place that matches both the id & the user
 PocketError pocket_place_update (
 	const User *user, const String *place_id,
 	const String *request_body
@@ -467,28 +535,47 @@ PocketError pocket_place_update (
 	PocketError error = POCKET_ERROR_NONE;
 
 	if (request_body) {
-		Place *place = pocket_place_get_by_id_and_user (
-			place_id, &user->oid
-		);
-
-		if (place) {
-			// get update values
-			if (pocket_place_update_parse_json (
-				place, request_body
-			) == POCKET_ERROR_NONE) {
-				if (place_update_one (place)) {
-					error = POCKET_ERROR_SERVER_ERROR;
+		if (place_id && bson_oid_is_valid (place_id->str, place_id->len)) {
+			Place *place = (Place *) pocket_pool_pop (places_pool);
+			if (place) {
+				bson_oid_init_from_string (&place->oid, place_id->str);
+				bson_oid_copy (&user->oid, &place->user_oid);
+
+				PocketArena *arena = pocket_arena_request ();
+
+				u8 fields = 0;
+				error = pocket_place_update_parse_json (
+					place, arena, &fields, request_body
+				);
+
+				if (error == POCKET_ERROR_NONE) {
+					int64_t matched = 0;
+					if (place_update_one (place, fields, &matched)) {
+						error = POCKET_ERROR_SERVER_ERROR;
+					}
+
+					else if (!matched) {
+						#ifdef POCKET_DEBUG
+						cerver_log_error ("Failed to get matching place!");
+						#endif
+
+						error = POCKET_ERROR_NOT_FOUND;
+					}
+
+					else {
+						pocket_places_user_changed (&user->oid);
+					}
 				}
+
+				pocket_place_return (place);
 			}
 
-			pocket_place_return (place);
+			else {
+				error = POCKET_ERROR_SERVER_ERROR;
+			}
 		}
 
 		else {
-			#ifdef POCKET_DEBUG
-			cerver_log_error ("Failed to get matching place!");
-			#endif
-
 			error = POCKET_ERROR_NOT_FOUND;
 		}
 	}
@@ -512,15 +599,34 @@ PocketError pocket_place_delete (
 
 	PocketError error = POCKET_ERROR_NONE;
 
-	bson_oid_t oid = { 0 };
-	bson_oid_init_from_string (&oid, place_id->str);
+	if (place_id && bson_oid_is_valid (place_id->str, place_id->len)) {
+		bson_oid_t oid = { 0 };
+		bson_oid_init_from_string (&oid, place_id->str);
+
+		int64_t deleted = 0;
+		if (!place_delete_one_by_oid_and_user (
+			&oid, &user->oid, &deleted
+		)) {
+			// the user's count is only updated
+			// if the place was actually removed
+			if (deleted) {
+				#ifdef POCKET_DEBUG
+				cerver_log_debug ("Deleted place %s", place_id->str);
+				#endif
 
-	if (!place_delete_one_by_oid_and_user (
-		&oid, &user->oid
-	)) {
-		#ifdef POCKET_DEBUG
-		cerver_log_debug ("Deleted place %s", place_id->str);
-		#endif
+				(void) user_remove_place (user);
+
+				pocket_places_user_changed (&user->oid);
+			}
+
+			else {
+				error = POCKET_ERROR_NOT_FOUND;
+			}
+		}
+
+		else {
+			error = POCKET_ERROR_SERVER_ERROR;
+		}
 	}
 
 	else {
@@ -534,6 +640,6 @@ PocketError pocket_place_delete (
 void pocket_place_return (void *place_ptr) {
 
 	(void) memset (place_ptr, 0, sizeof (Place));
-	(void) pool_push (places_pool, place_ptr);
+	pocket_pool_push (places_pool, place_ptr);
 
 }
\ No newline at end of file
@@ -2,46 +2,233 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <errno.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+
 #include <cmongo/crud.h>
 #include <cmongo/select.h>
 
-#include <cerver/collections/dlist.h>
+#include <cerver/types/types.h>
 
 #include <cerver/utils/log.h>
 
+#include "db.h"
+#include "metrics.h"
+
+#include "controllers/roles.h"
+
+#include "models/action.h"
 #include "models/role.h"
 
-static DoubleList *roles = NULL;
+#define POCKET_ROLES_TABLE_MIN_SIZE			16
 
-const Role *common_role = NULL;
+static _Atomic (PocketRolesTable *) roles_table = NULL;
 
-const Role *pocket_role_get_by_name (
-	const char *role_name
-);
+// the tables that were swapped out, from the newest to the oldest,
+// that are released after the grace period, when no reader can be using them
+// only used by the thread that swaps the tables
+static PocketRolesTable *retired_tables = NULL;
+
+static pthread_t refresher_thread = 0;
+static sem_t refresher_sem;
+static atomic_bool refresher_running = false;
+static unsigned int refresher_interval = 0;
+
+// action names are only appended, so their bits never change
+static char actions_names[POCKET_ROLES_ACTIONS_MAX][ROLE_ACTION_SIZE] = { 0 };
+static _Atomic unsigned int n_actions_names = 0;
+
+// resolved after every table build, so requests never look it up
+static _Atomic u64 metrics_action = 0;
+
+static inline size_t pocket_roles_name_hash (const char *name) {
+
+	// fnv-1a
+	size_t hash = 2166136261u;
+	for (const char *c = name; *c; c++) {
+		hash ^= (unsigned char) *c;
+		hash *= 16777619u;
+	}
+
+	return hash;
+
+}
+
+static void pocket_roles_table_delete (PocketRolesTable *table) {
+
+	if (table) {
+		free (table->roles);
+		free ((void *) table->by_oid);
+		free ((void *) table->by_name);
+
+		free (table);
+	}
+
+}
+
+// returns the action's bit, the action is added if it is new
+// only called while building a table
+static u64 pocket_roles_action_register (const char *action) {
+
+	u64 bit = 0;
+
+	unsigned int n_actions = atomic_load_explicit (
+		&n_actions_names, memory_order_acquire
+	);
+
+	unsigned int idx = 0;
+	while ((idx < n_actions) && strcmp (actions_names[idx], action)) idx++;
+
+	if (idx < n_actions) {
+		bit = (u64) 1 << idx;
+	}
 
-static unsigned int pocket_roles_init_get_roles (void) {
+	else if (n_actions < POCKET_ROLES_ACTIONS_MAX) {
+		(void) strncpy (actions_names[idx], action, ROLE_ACTION_SIZE - 1);
+		atomic_store_explicit (
+			&n_actions_names, n_actions + 1, memory_order_release
+		);
+
+		bit = (u64) 1 << idx;
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to register action %s - max actions reached!", action
+		);
+	}
+
+	return bit;
+
+}
+
+static void pocket_roles_table_index (PocketRolesTable *table) {
+
+	size_t mask = table->size - 1;
+	size_t slot = 0;
+	Role *role = NULL;
+	for (size_t idx = 0; idx < table->n_roles; idx++) {
+		role = &table->roles[idx];
+
+		role->actions_mask = 0;
+		for (unsigned int action = 0; action < role->n_actions; action++) {
+			role->actions_mask |= pocket_roles_action_register (
+				role->actions[action]
+			);
+		}
+
+		slot = bson_oid_hash (&role->oid) & mask;
+		while (table->by_oid[slot]) slot = (slot + 1) & mask;
+		table->by_oid[slot] = role;
+
+		slot = pocket_roles_name_hash (role->name) & mask;
+		while (table->by_name[slot]) slot = (slot + 1) & mask;
+		table->by_name[slot] = role;
+	}
+
+}
+
+// actions in the collection get their bits before the roles are indexed
+// returns 0 on success, 1 on error
+static unsigned int pocket_roles_actions_register (void) {
 
 	unsigned int retval = 1;
 
 	CMongoSelect *select = cmongo_select_new ();
-	cmongo_select_insert_field (select, "name");
+	(void) cmongo_select_insert_field (select, "name");
+
+	uint64_t n_docs = 0;
+	mongoc_cursor_t *actions_cursor = action_find_all (select, &n_docs);
+	if (actions_cursor) {
+		RoleAction action = { 0 };
+		const bson_t *action_doc = NULL;
+		while (db_cursor_next (actions_cursor, &action_doc)) {
+			(void) memset (&action, 0, sizeof (RoleAction));
+			action_doc_parse (&action, action_doc);
+
+			if (action.name[0]) {
+				(void) pocket_roles_action_register (action.name);
+			}
+		}
+
+		bson_error_t error = { 0 };
+		if (!mongoc_cursor_error (actions_cursor, &error)) {
+			retval = 0;
+		}
+
+		else {
+			cerver_log_error ("Failed to get actions: %s", error.message);
+		}
+
+		db_cursor_destroy (actions_cursor);
+	}
+
+	else {
+		cerver_log_error ("Failed to get actions cursor!");
+	}
+
+	cmongo_select_delete (select);
+
+	return retval;
+
+}
+
+// reads all the roles in the db into a new table
+static PocketRolesTable *pocket_roles_table_load (void) {
+
+	PocketRolesTable *table = NULL;
+
+	CMongoSelect *select = cmongo_select_new ();
+	(void) cmongo_select_insert_field (select, "name");
+	(void) cmongo_select_insert_field (select, "actions");
 
 	uint64_t n_docs = 0;
 	mongoc_cursor_t *roles_cursor = role_find_all (select, &n_docs);
 	if (roles_cursor) {
-		Role *role = NULL;
+		table = (PocketRolesTable *) calloc (1, sizeof (PocketRolesTable));
+
+		size_t max_roles = n_docs ? (size_t) n_docs : POCKET_ROLES_TABLE_MIN_SIZE;
+		Role *roles = NULL;
+		unsigned int errors = table ? 0 : 1;
+
 		const bson_t *role_doc = NULL;
-		unsigned int errors = 0;
-		while (mongoc_cursor_next (roles_cursor, &role_doc)) {
-			role = role_new ();
-			if (role) {
-				role_doc_parse (role, role_doc);
-
-				errors |= dlist_insert_after (
-					roles,
-					dlist_end (roles),
-					role
-				);
+		while (!errors && db_cursor_next (roles_cursor, &role_doc)) {
+			if (!table->roles || (table->n_roles == max_roles)) {
+				if (table->roles) max_roles *= 2;
+
+				roles = (Role *) realloc (table->roles, max_roles * sizeof (Role));
+				if (roles) table->roles = roles;
+				else errors |= 1;
+			}
+
+			if (!errors) {
+				(void) memset (&table->roles[table->n_roles], 0, sizeof (Role));
+				role_doc_parse (&table->roles[table->n_roles], role_doc);
+				table->n_roles += 1;
+			}
+		}
+
+		// a missing role would lose its users' actions
+		bson_error_t error = { 0 };
+		if (!errors && mongoc_cursor_error (roles_cursor, &error)) {
+			cerver_log_error ("Failed to get roles: %s", error.message);
+			errors |= 1;
+		}
+
+		db_cursor_destroy (roles_cursor);
+
+		if (!errors) {
+			// keep the load factor under 50%
+			table->size = POCKET_ROLES_TABLE_MIN_SIZE;
+			while (table->size < (table->n_roles * 2)) table->size *= 2;
+
+			table->by_oid = (const Role **) calloc (table->size, sizeof (Role *));
+			table->by_name = (const Role **) calloc (table->size, sizeof (Role *));
+			if (table->by_oid && table->by_name) {
+				pocket_roles_table_index (table);
 			}
 
 			else {
@@ -49,40 +236,241 @@ static unsigned int pocket_roles_init_get_roles (void) {
 			}
 		}
 
-		mongoc_cursor_destroy (roles_cursor);
+		if (errors) {
+			cerver_log_error ("Failed to create roles table!");
 
-		retval = errors;
+			pocket_roles_table_delete (table);
+			table = NULL;
+		}
 	}
 
 	else {
-		(void) fprintf (stderr, "Failed to get roles cursor!");
+		cerver_log_error ("Failed to get roles cursor!");
 	}
 
 	cmongo_select_delete (select);
 
+	return table;
+
+}
+
+// creates a new table with all the roles in the db
+// returns NULL if the actions or the roles could not be read,
+// so the current table is kept
+static PocketRolesTable *pocket_roles_table_create (void) {
+
+	PocketRolesTable *table = NULL;
+
+	if (!pocket_roles_actions_register ()) {
+		table = pocket_roles_table_load ();
+	}
+
+	if (table) {
+		atomic_store_explicit (
+			&metrics_action,
+			pocket_role_action_get (POCKET_METRICS_ACTION),
+			memory_order_release
+		);
+	}
+
+	return table;
+
+}
+
+static const Role *pocket_roles_table_get_by_name (
+	const PocketRolesTable *table, const char *role_name
+) {
+
+	const Role *retval = NULL;
+
+	size_t mask = table->size - 1;
+	size_t slot = pocket_roles_name_hash (role_name) & mask;
+	while (table->by_name[slot]) {
+		if (!strcmp (table->by_name[slot]->name, role_name)) {
+			retval = table->by_name[slot];
+			break;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
 	return retval;
 
 }
 
-unsigned int pocket_roles_init (void) {
+// releases the swapped tables that are older than the grace period
+static void pocket_roles_retired_release (const bool all) {
+
+	const time_t now = time (NULL);
+
+	// every table after the first expired one is older
+	PocketRolesTable **link = &retired_tables;
+	while (
+		*link && !all
+		&& ((now - (*link)->retired) < POCKET_ROLES_GRACE_PERIOD)
+	) {
+		link = &(*link)->next_retired;
+	}
+
+	PocketRolesTable *table = *link;
+	PocketRolesTable *next = NULL;
+	*link = NULL;
+
+	while (table) {
+		next = table->next_retired;
+		pocket_roles_table_delete (table);
+		table = next;
+	}
+
+}
+
+// publishes the new table, the old one is released
+// after the grace period as readers may still be using it
+static unsigned int pocket_roles_table_swap (PocketRolesTable *table) {
+
+	unsigned int retval = 1;
+
+	pocket_roles_retired_release (false);
+
+	table->common = pocket_roles_table_get_by_name (table, "common");
+	if (table->common) {
+		PocketRolesTable *old = atomic_exchange_explicit (
+			&roles_table, table, memory_order_acq_rel
+		);
+
+		if (old) {
+			old->retired = time (NULL);
+			old->next_retired = retired_tables;
+			retired_tables = old;
+		}
+
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error ("Failed to swap roles table - missing common role!");
+	}
+
+	return retval;
+
+}
+
+unsigned int pocket_roles_reload (void) {
+
+	unsigned int retval = 1;
+
+	PocketRolesTable *table = pocket_roles_table_create ();
+	if (table) {
+		retval = pocket_roles_table_swap (table);
+		if (retval) pocket_roles_table_delete (table);
+	}
+
+	return retval;
+
+}
+
+static void *pocket_roles_refresher (void *args) {
+
+	(void) args;
+
+	struct timespec timeout = { 0 };
+	int result = 0;
+	while (atomic_load (&refresher_running)) {
+		if (refresher_interval) {
+			(void) clock_gettime (CLOCK_REALTIME, &timeout);
+			timeout.tv_sec += refresher_interval;
+
+			result = sem_timedwait (&refresher_sem, &timeout);
+		}
+
+		else {
+			result = sem_wait (&refresher_sem);
+		}
+
+		if ((result < 0) && (errno == EINTR)) continue;
+
+		if (atomic_load (&refresher_running)) {
+			if (!pocket_roles_reload ()) {
+				#ifdef POCKET_DEBUG
+				cerver_log_debug ("Roles were reloaded");
+				#endif
+			}
+
+			else {
+				cerver_log_error ("Failed to reload roles - keeping current roles");
+			}
+		}
+	}
+
+	return NULL;
+
+}
+
+// starts a thread that reloads the roles every interval seconds
+// or when it is requested, 0 to only reload on requests
+// returns 0 on success, 1 on error
+unsigned int pocket_roles_refresher_start (
+	const unsigned int interval
+) {
 
 	unsigned int retval = 1;
 
-	roles = dlist_init (role_delete, NULL);
-	if (!pocket_roles_init_get_roles ()) {
-		common_role = pocket_role_get_by_name ("common");
-		if (common_role) {
+	if (!sem_init (&refresher_sem, 0, 0)) {
+		refresher_interval = interval;
+		atomic_store (&refresher_running, true);
+
+		if (!pthread_create (
+			&refresher_thread, NULL, pocket_roles_refresher, NULL
+		)) {
 			retval = 0;
 		}
+
+		else {
+			cerver_log_error ("Failed to create roles refresher thread!");
+
+			atomic_store (&refresher_running, false);
+			(void) sem_destroy (&refresher_sem);
+		}
 	}
 
 	return retval;
 
 }
 
+void pocket_roles_refresher_stop (void) {
+
+	if (atomic_exchange (&refresher_running, false)) {
+		(void) sem_post (&refresher_sem);
+		(void) pthread_join (refresher_thread, NULL);
+
+		(void) sem_destroy (&refresher_sem);
+	}
+
+}
+
+// wakes up the refresher to reload the roles
+// safe to be called from a signal handler
+void pocket_roles_refresh_request (void) {
+
+	if (atomic_load (&refresher_running)) {
+		(void) sem_post (&refresher_sem);
+	}
+
+}
+
+unsigned int pocket_roles_init (void) {
+
+	return pocket_roles_reload ();
+
+}
+
 void pocket_roles_end (void) {
 
-	dlist_delete (roles);
+	pocket_roles_table_delete (
+		atomic_exchange_explicit (&roles_table, NULL, memory_order_acq_rel)
+	);
+
+	pocket_roles_retired_release (true);
 
 }
 
@@ -90,12 +478,20 @@ const Role *pocket_role_get_by_oid (const bson_oid_t *role_oid) {
 
 	const Role *retval = NULL;
 
-	if (role_oid) {
-		for (ListElement *le = dlist_start (roles); le; le = le->next) {
-			if (!bson_oid_compare (&((Role *) le->data)->oid, role_oid)) {
-				retval = ((Role *) le->data);
+	const PocketRolesTable *table = atomic_load_explicit (
+		&roles_table, memory_order_acquire
+	);
+
+	if (role_oid && table) {
+		size_t mask = table->size - 1;
+		size_t slot = bson_oid_hash (role_oid) & mask;
+		while (table->by_oid[slot]) {
+			if (bson_oid_equal (&table->by_oid[slot]->oid, role_oid)) {
+				retval = table->by_oid[slot];
 				break;
 			}
+
+			slot = (slot + 1) & mask;
 		}
 	}
 
@@ -109,13 +505,12 @@ const Role *pocket_role_get_by_name (
 
 	const Role *retval = NULL;
 
-	if (role_name) {
-		for (ListElement *le = dlist_start (roles); le; le = le->next) {
-			if (!strcmp (((Role *) le->data)->name, role_name)) {
-				retval = ((Role *) le->data);
-				break;
-			}
-		}
+	const PocketRolesTable *table = atomic_load_explicit (
+		&roles_table, memory_order_acquire
+	);
+
+	if (role_name && table) {
+		retval = pocket_roles_table_get_by_name (table, role_name);
 	}
 
 	return retval;
@@ -135,4 +530,51 @@ const char *pocket_role_name_get_by_oid (
 
 	return retval;
 
-}
\ No newline at end of file
+}
+
+unsigned int pocket_role_common_get_oid (bson_oid_t *role_oid) {
+
+	unsigned int retval = 1;
+
+	const PocketRolesTable *table = atomic_load_explicit (
+		&roles_table, memory_order_acquire
+	);
+
+	if (table) {
+		bson_oid_copy (&table->common->oid, role_oid);
+		retval = 0;
+	}
+
+	return retval;
+
+}
+
+// returns the action's bit to be used with pocket_role_can ()
+// bits never change once they are assigned
+// returns 0 if no role has the action
+u64 pocket_role_action_get (const char *action) {
+
+	u64 bit = 0;
+
+	if (action) {
+		unsigned int n_actions = atomic_load_explicit (
+			&n_actions_names, memory_order_acquire
+		);
+
+		for (unsigned int idx = 0; idx < n_actions; idx++) {
+			if (!strcmp (actions_names[idx], action)) {
+				bit = (u64) 1 << idx;
+				break;
+			}
+		}
+	}
+
+	return bit;
+
+}
+
+u64 pocket_role_metrics_action_get (void) {
+
+	return atomic_load_explicit (&metrics_action, memory_order_acquire);
+
+}
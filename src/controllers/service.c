@@ -9,6 +9,8 @@
 #include "version.h"
 
 HttpResponse *missing_values = NULL;
+HttpResponse *too_many_requests = NULL;
+HttpResponse *not_allowed = NULL;
 
 HttpResponse *pocket_works = NULL;
 HttpResponse *current_version = NULL;
@@ -23,6 +25,14 @@ unsigned int pocket_service_init (void) {
 		HTTP_STATUS_BAD_REQUEST, "error", "Missing values!"
 	);
 
+	too_many_requests = http_response_json_key_value (
+		HTTP_STATUS_TOO_MANY_REQUESTS, "error", "Too many requests, try again later!"
+	);
+
+	not_allowed = http_response_json_key_value (
+		HTTP_STATUS_FORBIDDEN, "error", "Not allowed!"
+	);
+
 	pocket_works = http_response_json_key_value (
 		HTTP_STATUS_OK, "msg", "Pocket works!"
 	);
@@ -44,7 +54,7 @@ unsigned int pocket_service_init (void) {
 	);
 
 	if (
-		missing_values
+		missing_values && too_many_requests && not_allowed
 		&& pocket_works && current_version
 		&& catch_all
 	) retval = 0;
@@ -56,6 +66,8 @@ unsigned int pocket_service_init (void) {
 void pocket_service_end (void) {
 
 	http_response_delete (missing_values);
+	http_response_delete (too_many_requests);
+	http_response_delete (not_allowed);
 
 	http_response_delete (pocket_works);
 	http_response_delete (current_version);
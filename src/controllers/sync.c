@@ -0,0 +1,185 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <errno.h>
+
+#include <cerver/types/string.h>
+
+#include <cerver/collections/dlist.h>
+
+#include <cerver/http/http.h>
+
+#include <cerver/utils/log.h>
+
+#include "db.h"
+#include "errors.h"
+#include "stream.h"
+
+#include "models/category.h"
+#include "models/place.h"
+#include "models/tombstone.h"
+#include "models/transaction.h"
+#include "models/user.h"
+
+#include "controllers/categories.h"
+#include "controllers/places.h"
+#include "controllers/sync.h"
+#include "controllers/transactions.h"
+#include "controllers/users.h"
+
+#define POCKET_SYNC_NEXT_SIZE				64
+
+// parses the request's since query value (millis)
+// a missing value means that a full sync is requested
+// returns POCKET_ERROR_BAD_REQUEST on malformed values
+PocketError pocket_sync_query_init (
+	int64_t *since, const DoubleList *query_params
+) {
+
+	PocketError error = POCKET_ERROR_NONE;
+
+	*since = 0;
+
+	const String *value = http_query_pairs_get_value (query_params, "since");
+	if (value) {
+		char *end = NULL;
+		errno = 0;
+		long long parsed = strtoll (value->str, &end, 10);
+		if (!errno && (end != value->str) && !*end && (parsed >= 0)) {
+			*since = (int64_t) parsed;
+		}
+
+		else {
+			#ifdef POCKET_DEBUG
+			cerver_log_error ("Invalid sync since value: %s", value->str);
+			#endif
+
+			error = POCKET_ERROR_BAD_REQUEST;
+		}
+	}
+
+	return error;
+
+}
+
+static void pocket_sync_cursors_destroy (
+	mongoc_cursor_t *trans_cursor,
+	mongoc_cursor_t *categories_cursor,
+	mongoc_cursor_t *places_cursor,
+	mongoc_cursor_t *tombstones_cursor
+) {
+
+	if (trans_cursor) db_cursor_destroy (trans_cursor);
+	if (categories_cursor) db_cursor_destroy (categories_cursor);
+	if (places_cursor) db_cursor_destroy (places_cursor);
+	if (tombstones_cursor) db_cursor_destroy (tombstones_cursor);
+
+}
+
+static PocketStreamResult pocket_sync_send_by_user_actual (
+	const HttpReceive *http_receive,
+	const bson_oid_t *user_oid, const int64_t since, const int64_t now
+) {
+
+	PocketStreamResult result = POCKET_STREAM_RESULT_NONE;
+
+	const bool full = (since == 0);
+
+	mongoc_cursor_t *trans_cursor = transactions_get_all_by_user_since (
+		user_oid, since, trans_no_user_query_opts
+	);
+
+	mongoc_cursor_t *categories_cursor = categories_get_all_by_user_since (
+		user_oid, since, category_no_user_query_opts
+	);
+
+	mongoc_cursor_t *places_cursor = places_get_all_by_user_since (
+		user_oid, since, place_no_user_query_opts
+	);
+
+	// a full sync has nothing to delete
+	mongoc_cursor_t *tombstones_cursor = full ?
+		NULL : tombstones_get_all_by_user_since (user_oid, since);
+
+	if (
+		trans_cursor && categories_cursor && places_cursor
+		&& (full || tombstones_cursor)
+	) {
+		PocketStream stream = { 0 };
+
+		result = pocket_stream_cursor (
+			&stream, http_receive,
+			trans_cursor, "transactions", &trans_no_user_shape,
+			NULL, NULL
+		);
+
+		if (result != POCKET_STREAM_RESULT_NONE) {
+			pocket_stream_cursor_append (
+				&stream, categories_cursor, "categories", &category_no_user_shape
+			);
+
+			pocket_stream_cursor_append (
+				&stream, places_cursor, "places", &place_no_user_shape
+			);
+
+			if (tombstones_cursor) {
+				pocket_stream_cursor_append (
+					&stream, tombstones_cursor, "deleted", &tombstones_shape
+				);
+			}
+
+			else {
+				pocket_stream_write_string (&stream, ", \"deleted\": []");
+			}
+
+			char next[POCKET_SYNC_NEXT_SIZE] = { 0 };
+			(void) snprintf (
+				next, POCKET_SYNC_NEXT_SIZE,
+				", \"full\": %s, \"next\": %" PRId64 "}",
+				full ? "true" : "false", now - POCKET_SYNC_WINDOW
+			);
+
+			pocket_stream_write_string (&stream, next);
+
+			result = pocket_stream_end (&stream);
+		}
+	}
+
+	pocket_sync_cursors_destroy (
+		trans_cursor, categories_cursor, places_cursor, tombstones_cursor
+	);
+
+	return result;
+
+}
+
+// streams the user's values created, updated or deleted after since
+PocketStreamResult pocket_sync_send_by_user (
+	const HttpReceive *http_receive,
+	const bson_oid_t *user_oid, const int64_t query_since
+) {
+
+	PocketStreamResult result = POCKET_STREAM_RESULT_NONE;
+
+	const int64_t now = db_now ();
+
+	User user = { 0 };
+	if (!user_get_by_oid (&user, user_oid, user_sync_query_opts)) {
+		// tombstones older than their ttl have already been removed,
+		// & the ones that could not be stored reset the user's syncs,
+		// so the client needs to replace all of its values
+		const int64_t since = (
+			(query_since < (now - ((int64_t) TOMBSTONES_TTL * 1000)))
+			|| (query_since < user.sync_reset)
+		) ? 0 : query_since;
+
+		result = pocket_sync_send_by_user_actual (
+			http_receive, user_oid, since, now
+		);
+	}
+
+	return result;
+
+}
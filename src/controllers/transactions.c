@@ -1,11 +1,14 @@
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <time.h>
 
 #include <cerver/types/string.h>
 
-#include <cerver/collections/pool.h>
+#include <cerver/collections/dlist.h>
 
+#include <cerver/http/http.h>
 #include <cerver/http/response.h>
 #include <cerver/http/json/json.h>
 
@@ -14,16 +17,59 @@
 #include <cmongo/crud.h>
 #include <cmongo/select.h>
 
+#include "arena.h"
+#include "cache.h"
+#include "db.h"
 #include "errors.h"
+#include "etag.h"
+#include "input.h"
+#include "limiter.h"
+#include "metrics.h"
+#include "pocket.h"
+#include "pool.h"
+#include "stream.h"
 
 #include "models/transaction.h"
 #include "models/user.h"
 
 #include "controllers/transactions.h"
 
-Pool *trans_pool = NULL;
+#define POCKET_TRANS_DATE_SIZE			32
+
+// {"inserted": 500, "errors": []}
+#define POCKET_TRANS_BULK_RESULT_SIZE	64
+// , {"index": 499, "error": "Missing Values"}
+#define POCKET_TRANS_BULK_ERROR_SIZE	64
+
+#define POCKET_TRANS_KEY_MAP(XX)				\
+	XX(0,	TITLE, 			title)				\
+	XX(1,	AMOUNT, 		amount)				\
+	XX(2,	CATEGORY, 		category)			\
+	XX(3,	PLACE, 			place)				\
+	XX(4,	DATE, 			date)
+
+typedef enum PocketTransKey {
+
+	#define XX(num, name, string) POCKET_TRANS_KEY_##name = num,
+	POCKET_TRANS_KEY_MAP (XX)
+	#undef XX
+
+} PocketTransKey;
+
+// the keys of the create & update bodies
+static PocketInputSchema trans_schema = {
+	.keys = {
+		#define XX(num, name, string) #string,
+		POCKET_TRANS_KEY_MAP (XX)
+		#undef XX
+		NULL
+	}
+};
+
+PocketPool *trans_pool = NULL;
 
 const bson_t *trans_no_user_query_opts = NULL;
+PocketOutputShape trans_no_user_shape = { 0 };
 static CMongoSelect *trans_no_user_select = NULL;
 
 HttpResponse *no_user_trans = NULL;
@@ -35,21 +81,68 @@ HttpResponse *trans_deleted_bad = NULL;
 
 void pocket_trans_return (void *trans_ptr);
 
-static unsigned int pocket_trans_init_pool (void) {
+static PocketCache *trans_cache = NULL;
+
+static unsigned int pocket_trans_init_cache (void) {
 
 	unsigned int retval = 1;
 
-	trans_pool = pool_create (transaction_delete);
-	if (trans_pool) {
-		pool_set_create (trans_pool, transaction_new);
-		pool_set_produce_if_empty (trans_pool, true);
-		if (!pool_init (trans_pool, transaction_new, DEFAULT_TRANS_POOL_INIT)) {
+	// a size of 0 disables the cache
+	if (CACHE_SIZE) {
+		trans_cache = pocket_cache_create (CACHE_SIZE, CACHE_TTL);
+		if (trans_cache) {
+			pocket_metrics_register_cache ("transactions", trans_cache);
 			retval = 0;
 		}
+	}
 
-		else {
-			cerver_log_error ("Failed to init trans pool!");
-		}
+	else {
+		retval = 0;
+	}
+
+	return retval;
+
+}
+
+static void pocket_trans_end_cache (void) {
+
+	if (trans_cache) {
+		#ifdef POCKET_DEBUG
+		PocketCacheStats stats = { 0 };
+		pocket_cache_get_stats (trans_cache, &stats);
+		cerver_log_debug (
+			"transactions cache - entries: %zu - size: %zu - hits: %zu - misses: %zu - evictions: %zu - expired: %zu",
+			stats.entries, stats.size, stats.hits, stats.misses, stats.evictions, stats.expired
+		);
+		#endif
+
+		pocket_cache_delete (trans_cache);
+		trans_cache = NULL;
+	}
+
+}
+
+// must be called after every write to the user's transactions
+// to drop the cached list & change the lists etags
+static inline void pocket_trans_user_changed (const bson_oid_t *user_oid) {
+
+	if (trans_cache) pocket_cache_invalidate (trans_cache, user_oid);
+
+	pocket_etag_changed (POCKET_ETAG_KIND_TRANSACTIONS, user_oid);
+
+}
+
+static unsigned int pocket_trans_init_pool (void) {
+
+	unsigned int retval = 1;
+
+	trans_pool = pocket_pool_create (
+		transaction_new, transaction_delete, TRANS_POOL_SIZE
+	);
+
+	if (trans_pool) {
+		pocket_metrics_register_pool ("transactions", trans_pool);
+		retval = 0;
 	}
 
 	else {
@@ -72,7 +165,11 @@ static unsigned int pocket_trans_init_query_opts (void) {
 
 	trans_no_user_query_opts = mongo_find_generate_opts (trans_no_user_select);
 
-	if (trans_no_user_query_opts) retval = 0;
+	if (trans_no_user_query_opts) {
+		retval = pocket_output_shape_init (
+			&trans_no_user_shape, trans_no_user_query_opts
+		);
+	}
 
 	return retval;
 
@@ -122,6 +219,10 @@ unsigned int pocket_trans_init (void) {
 
 	errors |= pocket_trans_init_responses ();
 
+	errors |= pocket_trans_init_cache ();
+
+	errors |= pocket_input_schema_init (&trans_schema);
+
 	return errors;
 
 }
@@ -131,7 +232,7 @@ void pocket_trans_end (void) {
 	cmongo_select_delete (trans_no_user_select);
 	bson_destroy ((bson_t *) trans_no_user_query_opts);
 
-	pool_delete (trans_pool);
+	pocket_pool_delete (trans_pool);
 	trans_pool = NULL;
 
 	http_response_delete (no_user_trans);
@@ -141,15 +242,267 @@ void pocket_trans_end (void) {
 	http_response_delete (trans_deleted_success);
 	http_response_delete (trans_deleted_bad);
 
+	pocket_trans_end_cache ();
+
+}
+
+static PocketError pocket_trans_query_parse_limit (
+	TransactionsQuery *query, const String *limit
+) {
+
+	PocketError error = POCKET_ERROR_NONE;
+
+	char *end = NULL;
+	long value = strtol (limit->str, &end, 10);
+	if ((end != limit->str) && (*end == '\0') && (value > 0)) {
+		query->limit = (value > TRANS_PAGE_MAX_LIMIT) ?
+			TRANS_PAGE_MAX_LIMIT : (unsigned int) value;
+	}
+
+	else {
+		error = POCKET_ERROR_BAD_REQUEST;
+	}
+
+	return error;
+
+}
+
+// expects a UTC date as YYYY-MM-DD or YYYY-MM-DDTHH:MM:SS
+static PocketError pocket_trans_query_parse_date (
+	const String *date_string, int64_t *date
+) {
+
+	PocketError error = POCKET_ERROR_BAD_REQUEST;
+
+	struct tm date_tm = { 0 };
+	const char *end = strptime (date_string->str, "%Y-%m-%d", &date_tm);
+	if (end && (*end == 'T')) {
+		end = strptime (end + 1, "%H:%M:%S", &date_tm);
+	}
+
+	if (end && ((*end == '\0') || (*end == 'Z'))) {
+		*date = (int64_t) timegm (&date_tm) * 1000;
+		error = POCKET_ERROR_NONE;
+	}
+
+	return error;
+
+}
+
+static PocketError pocket_trans_query_parse_oid (
+	const String *oid_string, bson_oid_t *oid
+) {
+
+	PocketError error = POCKET_ERROR_BAD_REQUEST;
+
+	if (bson_oid_is_valid (oid_string->str, oid_string->len)) {
+		bson_oid_init_from_string (oid, oid_string->str);
+		error = POCKET_ERROR_NONE;
+	}
+
+	return error;
+
+}
+
+static PocketError pocket_trans_query_parse_amount (
+	const String *amount_string, double *amount
+) {
+
+	PocketError error = POCKET_ERROR_BAD_REQUEST;
+
+	char *end = NULL;
+	double value = strtod (amount_string->str, &end);
+	if ((end != amount_string->str) && (*end == '\0')) {
+		*amount = value;
+		error = POCKET_ERROR_NONE;
+	}
+
+	return error;
+
+}
+
+// parses the request's query values into a transactions query
+// limit is clamped to TRANS_PAGE_MAX_LIMIT
+// without limit & after values every transaction is returned like before,
+// an after cursor without a limit uses TRANS_PAGE_DEFAULT_LIMIT
+// returns POCKET_ERROR_BAD_REQUEST on malformed values
+PocketError pocket_trans_query_init (
+	TransactionsQuery *query, const DoubleList *query_params
+) {
+
+	unsigned int errors = 0;
+
+	(void) memset (query, 0, sizeof (TransactionsQuery));
+
+	const String *value = NULL;
+
+	if ((value = http_query_pairs_get_value (query_params, "limit"))) {
+		errors |= pocket_trans_query_parse_limit (query, value);
+	}
+
+	if ((value = http_query_pairs_get_value (query_params, "after"))) {
+		errors |= transactions_cursor_decode (query, value->str);
+		if (!query->limit) query->limit = TRANS_PAGE_DEFAULT_LIMIT;
+	}
+
+	if ((value = http_query_pairs_get_value (query_params, "from"))) {
+		errors |= pocket_trans_query_parse_date (value, &query->from_date);
+		query->from = true;
+	}
+
+	if ((value = http_query_pairs_get_value (query_params, "to"))) {
+		errors |= pocket_trans_query_parse_date (value, &query->to_date);
+		query->to = true;
+	}
+
+	if ((value = http_query_pairs_get_value (query_params, "category"))) {
+		errors |= pocket_trans_query_parse_oid (value, &query->category_oid);
+		query->category = true;
+	}
+
+	if ((value = http_query_pairs_get_value (query_params, "place"))) {
+		errors |= pocket_trans_query_parse_oid (value, &query->place_oid);
+		query->place = true;
+	}
+
+	if ((value = http_query_pairs_get_value (query_params, "min_amount"))) {
+		errors |= pocket_trans_query_parse_amount (value, &query->min_amount);
+		query->min = true;
+	}
+
+	if ((value = http_query_pairs_get_value (query_params, "max_amount"))) {
+		errors |= pocket_trans_query_parse_amount (value, &query->max_amount);
+		query->max = true;
+	}
+
+	#ifdef POCKET_DEBUG
+	if (errors) cerver_log_error ("Invalid transactions query values!");
+	#endif
+
+	return errors ? POCKET_ERROR_BAD_REQUEST : POCKET_ERROR_NONE;
+
+}
+
+typedef struct TransPage {
+
+	unsigned int count;
+
+	int64_t last_date;
+	bson_oid_t last_oid;
+
+} TransPage;
+
+// keeps track of the last document's sort values
+// to be able to generate the next page's cursor
+static void pocket_trans_page_doc (const bson_t *trans_doc, void *page_ptr) {
+
+	TransPage *page = (TransPage *) page_ptr;
+
+	bson_iter_t iter = { 0 };
+	if (bson_iter_init_find (&iter, trans_doc, "date") && BSON_ITER_HOLDS_DATE_TIME (&iter)) {
+		page->last_date = bson_iter_date_time (&iter);
+	}
+
+	if (bson_iter_init_find (&iter, trans_doc, "_id") && BSON_ITER_HOLDS_OID (&iter)) {
+		bson_oid_copy (bson_iter_oid (&iter), &page->last_oid);
+	}
+
+	page->count += 1;
+
+}
+
+// only the list without any query values is cached,
+// as it is what the app requests every time it is opened
+static bool pocket_trans_query_is_cacheable (
+	const TransactionsQuery *query
+) {
+
+	return !query->limit
+		&& !query->after
+		&& !query->from && !query->to
+		&& !query->category && !query->place
+		&& !query->min && !query->max;
+
 }
 
-unsigned int pocket_trans_get_all_by_user (
-	const bson_oid_t *user_oid,
-	char **json, size_t *json_len
+// streams the user's transactions, or a page of them
+// {"transactions": [ ... ], "next": "cursor" | null}
+PocketStreamResult pocket_trans_send_all_by_user (
+	const HttpReceive *http_receive, const char *etag,
+	const bson_oid_t *user_oid, const TransactionsQuery *query
 ) {
 
-	return transactions_get_all_by_user_to_json (
-		user_oid, trans_no_user_query_opts,
+	PocketStreamResult result = POCKET_STREAM_RESULT_NONE;
+
+	PocketCache *cache = pocket_trans_query_is_cacheable (query) ?
+		trans_cache : NULL;
+
+	u64 ticket = 0;
+	if (cache && pocket_stream_cache_send (
+		cache, http_receive, user_oid, etag, &ticket
+	)) {
+		result = POCKET_STREAM_RESULT_OK;
+	}
+
+	else {
+		mongoc_cursor_t *cursor = transactions_get_all_by_user (
+			user_oid, query, trans_no_user_query_opts
+		);
+
+		if (cursor) {
+			PocketStream stream = { 0 };
+			stream.etag = etag;
+
+			TransPage page = { 0 };
+
+			if (cache) pocket_stream_capture (&stream, POCKET_CACHE_ENTRY_MAX_SIZE);
+
+			result = pocket_stream_cursor (
+				&stream, http_receive,
+				cursor, "transactions", &trans_no_user_shape,
+				pocket_trans_page_doc, &page
+			);
+
+			if (result != POCKET_STREAM_RESULT_NONE) {
+				// a full page means there might be more transactions
+				if (query->limit && (page.count == query->limit)) {
+					char next[TRANSACTIONS_CURSOR_SIZE] = { 0 };
+					transactions_cursor_encode (next, page.last_date, &page.last_oid);
+
+					pocket_stream_write_string (&stream, ", \"next\": \"");
+					pocket_stream_write_string (&stream, next);
+					pocket_stream_write_string (&stream, "\"}");
+				}
+
+				else {
+					pocket_stream_write_string (&stream, ", \"next\": null}");
+				}
+
+				result = pocket_stream_end (&stream);
+			}
+
+			if (cache) {
+				pocket_stream_capture_store (
+					&stream, result, cache, user_oid, ticket
+				);
+			}
+
+			db_cursor_destroy (cursor);
+		}
+	}
+
+	return result;
+
+}
+
+// returns the user's transactions totals by category & by month
+unsigned int pocket_trans_get_summary_by_user (
+	const bson_oid_t *user_oid, const TransactionsQuery *query,
+	const char **json, size_t *json_len
+) {
+
+	return transactions_get_summary_by_user_to_json (
+		user_oid, query,
 		json, json_len
 	);
 
@@ -162,9 +515,10 @@ Transaction *pocket_trans_get_by_id_and_user (
 	Transaction *trans = NULL;
 
 	if (trans_id) {
-		trans = (Transaction *) pool_pop (trans_pool);
+		trans = (Transaction *) pocket_pool_pop (trans_pool);
 		if (trans) {
 			bson_oid_init_from_string (&trans->oid, trans_id->str);
+			trans->arena = pocket_arena_request ();
 
 			if (transaction_get_by_oid_and_user (
 				trans,
@@ -184,7 +538,8 @@ Transaction *pocket_trans_get_by_id_and_user (
 u8 pocket_trans_get_by_id_and_user_to_json (
 	const char *trans_id, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 ) {
 
 	u8 retval = 1;
@@ -196,6 +551,7 @@ u8 pocket_trans_get_by_id_and_user_to_json (
 		retval = transaction_get_by_oid_and_user_to_json (
 			&trans_oid, user_oid,
 			query_opts,
+			shape,
 			json, json_len
 		);
 	}
@@ -204,150 +560,153 @@ u8 pocket_trans_get_by_id_and_user_to_json (
 
 }
 
-static Transaction *pocket_trans_create_actual (
-	const char *user_id,
-	const char *title,
-	const double amount,
-	const char *category_id,
-	const char *date
-) {
-
-	Transaction *trans = (Transaction *) pool_pop (trans_pool);
-	if (trans) {
-		bson_oid_init (&trans->oid, NULL);
-
-		bson_oid_init_from_string (&trans->user_oid, user_id);
+// "2020-08-05T21:30:00.000Z"
+static time_t pocket_trans_parse_date (const char *date) {
 
-		if (title) (void) strncpy (trans->title, title, TRANSACTION_TITLE_SIZE - 1);
-		trans->amount = amount;
+	int y = 0, M = 0, d = 0, h = 0, m = 0;
+	float s = 0;
+	(void) sscanf (date, "%d-%d-%dT%d:%d:%f", &y, &M, &d, &h, &m, &s);
 
-		if (category_id) {
-			bson_oid_init_from_string (&trans->category_oid, category_id);
-		}
-
-		if (date) {
-			int y = 0, M = 0, d = 0, h = 0, m = 0;
-			float s = 0;
-			(void) sscanf (date, "%d-%d-%dT%d:%d:%f", &y, &M, &d, &h, &m, &s);
-
-			struct tm date;
-			date.tm_year = y - 1900;	// Year since 1900
-			date.tm_mon = M - 1;		// 0-11
-			date.tm_mday = d;			// 1-31
-			date.tm_hour = h;			// 0-23
-			date.tm_min = m;			// 0-59
-			date.tm_sec = (int) s;		// 0-61 (0-60 in C++11)
+	struct tm tm_date = { 0 };
+	tm_date.tm_year = y - 1900;	// Year since 1900
+	tm_date.tm_mon = M - 1;		// 0-11
+	tm_date.tm_mday = d;		// 1-31
+	tm_date.tm_hour = h;		// 0-23
+	tm_date.tm_min = m;			// 0-59
+	tm_date.tm_sec = (int) s;	// 0-61 (0-60 in C++11)
 
-			trans->date = mktime (&date);
-		}
-
-		else {
-			trans->date = time (NULL);
-		}
-	}
-
-	return trans;
+	return mktime (&tm_date);
 
 }
 
-static void pocket_trans_parse_json (
-	json_t *json_body,
-	const char **title,
-	double *amount,
-	const char **category,
-	const char **place,
-	const char **date
+// sets the transaction's values from the object's members,
+// values with unexpected types are ignored like unknown keys
+// strings point to the body or to the arena if they had escapes
+static void pocket_trans_parse_input (
+	PocketInput *input, PocketArena *arena,
+	Transaction *trans, u8 *fields
 ) {
 
-	// get values from json to create a new transaction
-	const char *key = NULL;
-	json_t *value = NULL;
-	if (json_typeof (json_body) == JSON_OBJECT) {
-		json_object_foreach (json_body, key, value) {
-			if (!strcmp (key, "title")) {
-				*title = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("title: \"%s\"\n", *title);
-				#endif
-			}
+	char date[POCKET_TRANS_DATE_SIZE] = { 0 };
+
+	int key = -1;
+	PocketInputValue value = { 0 };
+	while (pocket_input_object_next (input, &trans_schema, &key, &value)) {
+		switch (key) {
+			case POCKET_TRANS_KEY_TITLE:
+				if (pocket_input_string_view (
+					&value, arena, TRANSACTION_TITLE_MAX, &trans->title
+				)) {
+					*fields |= TRANSACTION_FIELD_TITLE;
+				}
+				break;
 
-			else if (!strcmp (key, "amount")) {
-				*amount = json_real_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("amount: %f\n", *amount);
-				#endif
-			}
+			case POCKET_TRANS_KEY_AMOUNT:
+				if (value.type == POCKET_INPUT_TYPE_NUMBER) {
+					trans->amount = value.number;
+					*fields |= TRANSACTION_FIELD_AMOUNT;
+				}
+				break;
 
-			else if (!strcmp (key, "category")) {
-				*category = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("category: \"%s\"\n", *category);
-				#endif
-			}
+			case POCKET_TRANS_KEY_CATEGORY:
+				if (pocket_input_oid (&value, &trans->category_oid)) {
+					*fields |= TRANSACTION_FIELD_CATEGORY;
+				}
+				break;
 
-			else if (!strcmp (key, "place")) {
-				*place = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("place: \"%s\"\n", *place);
-				#endif
-			}
+			case POCKET_TRANS_KEY_PLACE:
+				if (pocket_input_oid (&value, &trans->place_oid)) {
+					*fields |= TRANSACTION_FIELD_PLACE;
+				}
+				break;
 
-			else if (!strcmp (key, "date")) {
-				*date = json_string_value (value);
-				#ifdef POCKET_DEBUG
-				(void) printf ("date: \"%s\"\n", *date);
-				#endif
-			}
+			// only used when the transaction is created
+			case POCKET_TRANS_KEY_DATE:
+				if (value.type == POCKET_INPUT_TYPE_STRING) {
+					(void) pocket_input_string_copy (
+						&value, date, POCKET_TRANS_DATE_SIZE
+					);
+
+					trans->date = pocket_trans_parse_date (date);
+				}
+				break;
+
+			default: break;
 		}
 	}
 
 }
 
-static PocketError pocket_trans_create_parse_json (
-	Transaction **trans,
-	const char *user_id, const String *request_body
+// creates a new transaction with the values of the object
+// that the input has just entered, a title & a category are required
+static PocketError pocket_trans_create_parse_one (
+	PocketInput *input, PocketArena *arena,
+	const bson_oid_t *user_oid, Transaction **trans
 ) {
 
 	PocketError error = POCKET_ERROR_NONE;
 
-	const char *title = NULL;
-	double amount = 0;
-	const char *category_id = NULL;
-	const char *place_id = NULL;
-	const char *date = NULL;
-
-	json_error_t json_error =  { 0 };
-	json_t *json_body = json_loads (request_body->str, 0, &json_error);
-	if (json_body) {
-		pocket_trans_parse_json (
-			json_body,
-			&title, &amount,
-			&category_id, &place_id, &date
-		);
+	Transaction *new_trans = (Transaction *) pocket_pool_pop (trans_pool);
+	if (new_trans) {
+		bson_oid_init (&new_trans->oid, NULL);
+		bson_oid_copy (user_oid, &new_trans->user_oid);
 
-		if (title && category_id) {
-			*trans = pocket_trans_create_actual (
-				user_id,
-				title, amount,
-				category_id,
-				date
-			);
+		new_trans->date = time (NULL);
+
+		u8 fields = 0;
+		pocket_trans_parse_input (input, arena, new_trans, &fields);
 
-			if (*trans == NULL) error = POCKET_ERROR_SERVER_ERROR;
+		if (input->error) {
+			error = POCKET_ERROR_BAD_REQUEST;
 		}
 
-		else {
+		else if (
+			!(fields & TRANSACTION_FIELD_TITLE)
+			|| !(fields & TRANSACTION_FIELD_CATEGORY)
+		) {
 			error = POCKET_ERROR_MISSING_VALUES;
 		}
 
-		json_decref (json_body);
+		if (error == POCKET_ERROR_NONE) {
+			*trans = new_trans;
+		}
+
+		else {
+			pocket_trans_return (new_trans);
+		}
 	}
 
 	else {
-		cerver_log_error (
-			"json_loads () - json error on line %d: %s\n",
-			json_error.line, json_error.text
+		error = POCKET_ERROR_SERVER_ERROR;
+	}
+
+	return error;
+
+}
+
+static PocketError pocket_trans_create_parse_json (
+	Transaction **trans, PocketArena *arena,
+	const User *user, const String *request_body
+) {
+
+	PocketError error = POCKET_ERROR_BAD_REQUEST;
+
+	PocketInput input = { 0 };
+	pocket_input_init (&input, request_body->str, request_body->len);
+
+	if (pocket_input_object_begin (&input)) {
+		error = pocket_trans_create_parse_one (
+			&input, arena, &user->oid, trans
 		);
+	}
+
+	if (!pocket_input_end (&input)) {
+		cerver_log_error ("pocket_trans_create () - bad request body!");
+
+		if (*trans) {
+			pocket_trans_return (*trans);
+			*trans = NULL;
+		}
 
 		error = POCKET_ERROR_BAD_REQUEST;
 	}
@@ -363,11 +722,13 @@ PocketError pocket_trans_create (
 	PocketError error = POCKET_ERROR_NONE;
 
 	if (request_body) {
+		PocketArena *arena = pocket_arena_request ();
+
 		Transaction *trans = NULL;
 
 		error = pocket_trans_create_parse_json (
-			&trans,
-			user->id, request_body
+			&trans, arena,
+			user, request_body
 		);
 
 		if (error == POCKET_ERROR_NONE) {
@@ -378,6 +739,8 @@ PocketError pocket_trans_create (
 			if (!transaction_insert_one (trans)) {
 				// update users values
 				(void) user_add_transactions (user);
+
+				pocket_trans_user_changed (&user->oid);
 			}
 
 			else {
@@ -400,41 +763,224 @@ PocketError pocket_trans_create (
 
 }
 
-static PocketError pocket_trans_update_parse_json (
-	Transaction *trans, const String *request_body
+// {"inserted": 10, "errors": [{"index": 2, "error": "Missing Values"}]}
+// the json is written in the request's arena
+static PocketError pocket_trans_create_bulk_result (
+	const size_t inserted,
+	const PocketError *items_errors, const size_t n_items,
+	const char **json, size_t *json_len
 ) {
 
-	PocketError error = POCKET_ERROR_NONE;
+	PocketError error = POCKET_ERROR_SERVER_ERROR;
+
+	size_t n_errors = 0;
+	for (size_t idx = 0; idx < n_items; idx++) {
+		if (items_errors[idx] != POCKET_ERROR_NONE) n_errors += 1;
+	}
+
+	const size_t size = POCKET_TRANS_BULK_RESULT_SIZE
+		+ (n_errors * POCKET_TRANS_BULK_ERROR_SIZE);
+
+	char *result = (char *) pocket_arena_alloc (pocket_arena_request (), size);
+	if (result) {
+		size_t len = (size_t) snprintf (
+			result, size, "{\"inserted\": %zu, \"errors\": [", inserted
+		);
+
+		bool first = true;
+		for (size_t idx = 0; idx < n_items; idx++) {
+			if (items_errors[idx] != POCKET_ERROR_NONE) {
+				len += (size_t) snprintf (
+					result + len, size - len,
+					"%s{\"index\": %zu, \"error\": \"%s\"}",
+					first ? "" : ", ",
+					idx, pocket_error_to_string (items_errors[idx])
+				);
+
+				first = false;
+			}
+		}
+
+		len += (size_t) snprintf (result + len, size - len, "]}");
+
+		*json = result;
+		*json_len = len;
+
+		error = POCKET_ERROR_NONE;
+	}
+
+	return error;
+
+}
 
-	const char *title = NULL;
-	double amount = 0;
-	const char *category_id = NULL;
-	const char *place_id = NULL;
-	const char *date = NULL;
-
-	json_error_t json_error =  { 0 };
-	json_t *json_body = json_loads (request_body->str, 0, &json_error);
-	if (json_body) {
-		pocket_trans_parse_json (
-			json_body,
-			&title, &amount,
-			&category_id, &place_id, &date
+// inserts the valid transactions with a single batch
+// and updates the user's transactions count once
+static size_t pocket_trans_create_bulk_insert (
+	const User *user,
+	Transaction **transactions, const size_t *positions, const size_t n_valid,
+	PocketError *items_errors
+) {
+
+	size_t inserted = 0;
+
+	u8 *insert_errors = (u8 *) pocket_arena_calloc (
+		pocket_arena_request (), n_valid, sizeof (u8)
+	);
+
+	if (insert_errors) {
+		inserted = transactions_insert_many (
+			(const Transaction **) transactions, n_valid,
+			insert_errors
 		);
 
-		if (title) (void) strncpy (trans->title, title, TRANSACTION_TITLE_SIZE - 1);
-		trans->amount = amount;
-		if (category_id) (void) bson_oid_init_from_string (&trans->category_oid, category_id);
-		if (place_id) (void) bson_oid_init_from_string (&trans->place_oid, place_id);
+		for (size_t idx = 0; idx < n_valid; idx++) {
+			if (insert_errors[idx]) {
+				items_errors[positions[idx]] = POCKET_ERROR_SERVER_ERROR;
+			}
+		}
+
+		if (inserted) {
+			(void) user_add_transactions_count (user, (int) inserted);
 
-		json_decref (json_body);
+			pocket_trans_user_changed (&user->oid);
+		}
 	}
 
 	else {
+		for (size_t idx = 0; idx < n_valid; idx++) {
+			items_errors[positions[idx]] = POCKET_ERROR_SERVER_ERROR;
+		}
+	}
+
+	return inserted;
+
+}
+
+// every value in the input's array is parsed into a transaction
+// without keeping the body's values, the array must have
+// from 1 to TRANS_BULK_MAX values
+static PocketError pocket_trans_create_bulk_actual (
+	const User *user, PocketInput *input, PocketArena *arena,
+	const char **json, size_t *json_len
+) {
+
+	PocketError error = POCKET_ERROR_NONE;
+
+	Transaction **transactions = (Transaction **) pocket_arena_calloc (arena, TRANS_BULK_MAX, sizeof (Transaction *));
+	size_t *positions = (size_t *) pocket_arena_calloc (arena, TRANS_BULK_MAX, sizeof (size_t));
+	PocketError *items_errors = (PocketError *) pocket_arena_calloc (arena, TRANS_BULK_MAX, sizeof (PocketError));
+
+	if (transactions && positions && items_errors) {
+		size_t n_items = 0;
+		size_t n_valid = 0;
+
+		while (
+			(error == POCKET_ERROR_NONE) && pocket_input_array_next (input)
+		) {
+			if (n_items < TRANS_BULK_MAX) {
+				if (pocket_input_object_begin (input)) {
+					items_errors[n_items] = pocket_trans_create_parse_one (
+						input, arena, &user->oid, &transactions[n_valid]
+					);
+
+					if (items_errors[n_items] == POCKET_ERROR_NONE) {
+						positions[n_valid] = n_items;
+						n_valid += 1;
+					}
+				}
+
+				else {
+					items_errors[n_items] = POCKET_ERROR_BAD_REQUEST;
+					(void) pocket_input_skip (input);
+				}
+
+				n_items += 1;
+			}
+
+			else {
+				error = POCKET_ERROR_BAD_REQUEST;
+			}
+		}
+
+		if (!n_items || !pocket_input_end (input)) {
+			error = POCKET_ERROR_BAD_REQUEST;
+		}
+
+		// every item costs as much as a single create, up to the burst
+		if (
+			(error == POCKET_ERROR_NONE)
+			&& pocket_limit_write_items (&user->oid, (unsigned int) n_items)
+		) {
+			error = POCKET_ERROR_LIMITED;
+		}
+
+		if (error == POCKET_ERROR_NONE) {
+			size_t inserted = 0;
+			if (n_valid) {
+				inserted = pocket_trans_create_bulk_insert (
+					user,
+					transactions, positions, n_valid,
+					items_errors
+				);
+			}
+
+			error = pocket_trans_create_bulk_result (
+				inserted,
+				items_errors, n_items,
+				json, json_len
+			);
+		}
+
+		for (size_t idx = 0; idx < n_valid; idx++) {
+			pocket_trans_return (transactions[idx]);
+		}
+	}
+
+	else {
+		error = POCKET_ERROR_SERVER_ERROR;
+	}
+
+	return error;
+
+}
+
+// creates all the transactions in the request's json array
+// using a single batch insert, returns a json with the result
+// {"inserted": 10, "errors": [{"index": 2, "error": "Missing Values"}]}
+PocketError pocket_trans_create_bulk (
+	const User *user, const String *request_body,
+	const char **json, size_t *json_len
+) {
+
+	PocketError error = POCKET_ERROR_NONE;
+
+	if (request_body) {
+		PocketInput input = { 0 };
+		pocket_input_init (&input, request_body->str, request_body->len);
+
+		PocketArena *arena = pocket_arena_request ();
+
+		if (pocket_input_array_begin (&input)) {
+			error = pocket_trans_create_bulk_actual (
+				user, &input, arena,
+				json, json_len
+			);
+		}
+
+		else {
+			error = POCKET_ERROR_BAD_REQUEST;
+		}
+
 		#ifdef POCKET_DEBUG
-		cerver_log_error (
-			"json_loads () - json error on line %d: %s\n",
-			json_error.line, json_error.text
-		);
+		if (error == POCKET_ERROR_BAD_REQUEST) {
+			cerver_log_error ("pocket_trans_create_bulk () - bad request body!");
+		}
+		#endif
+	}
+
+	else {
+		#ifdef POCKET_DEBUG
+		cerver_log_error ("Missing request body to create transactions!");
 		#endif
 
 		error = POCKET_ERROR_BAD_REQUEST;
@@ -444,6 +990,38 @@ static PocketError pocket_trans_update_parse_json (
 
 }
 
+static PocketError pocket_trans_update_parse_json (
+	Transaction *trans, PocketArena *arena,
+	u8 *fields, const String *request_body
+) {
+
+	PocketError error = POCKET_ERROR_BAD_REQUEST;
+
+	PocketInput input = { 0 };
+	pocket_input_init (&input, request_body->str, request_body->len);
+
+	// only the values that are present are set
+	if (pocket_input_object_begin (&input)) {
+		pocket_trans_parse_input (&input, arena, trans, fields);
+
+		if (pocket_input_end (&input)) {
+			error = *fields ?
+				POCKET_ERROR_NONE : POCKET_ERROR_MISSING_VALUES;
+		}
+	}
+
+	#ifdef POCKET_DEBUG
+	if (error == POCKET_ERROR_BAD_REQUEST) {
+		cerver_log_error ("pocket_trans_update () - bad request body!");
+	}
+	#endif
+
+	return error;
+
+}
+
+// sets only the fields present in the request
+// in the transaction that matches both the id & the user
 PocketError pocket_trans_update (
 	const User *user, const String *trans_id,
 	const String *request_body
@@ -452,29 +1030,47 @@ PocketError pocket_trans_update (
 	PocketError error = POCKET_ERROR_NONE;
 
 	if (request_body) {
-		Transaction *trans = pocket_trans_get_by_id_and_user (
-			trans_id, &user->oid
-		);
-
-		if (trans) {
-			// get update values
-			if (pocket_trans_update_parse_json (
-				trans, request_body
-			) == POCKET_ERROR_NONE) {
-				// update the transaction in the db
-				if (transaction_update_one (trans)) {
-					error = POCKET_ERROR_SERVER_ERROR;
+		if (trans_id && bson_oid_is_valid (trans_id->str, trans_id->len)) {
+			Transaction *trans = (Transaction *) pocket_pool_pop (trans_pool);
+			if (trans) {
+				bson_oid_init_from_string (&trans->oid, trans_id->str);
+				bson_oid_copy (&user->oid, &trans->user_oid);
+
+				PocketArena *arena = pocket_arena_request ();
+
+				u8 fields = 0;
+				error = pocket_trans_update_parse_json (
+					trans, arena, &fields, request_body
+				);
+
+				if (error == POCKET_ERROR_NONE) {
+					int64_t matched = 0;
+					if (transaction_update_one (trans, fields, &matched)) {
+						error = POCKET_ERROR_SERVER_ERROR;
+					}
+
+					else if (!matched) {
+						#ifdef POCKET_DEBUG
+						cerver_log_error ("Failed to get matching transaction!");
+						#endif
+
+						error = POCKET_ERROR_NOT_FOUND;
+					}
+
+					else {
+						pocket_trans_user_changed (&user->oid);
+					}
 				}
+
+				pocket_trans_return (trans);
 			}
 
-			pocket_trans_return (trans);
+			else {
+				error = POCKET_ERROR_SERVER_ERROR;
+			}
 		}
 
 		else {
-			#ifdef POCKET_DEBUG
-			cerver_log_error ("Failed to get matching transaction!");
-			#endif
-
 			error = POCKET_ERROR_NOT_FOUND;
 		}
 	}
@@ -497,15 +1093,34 @@ PocketError pocket_trans_delete (
 
 	PocketError error = POCKET_ERROR_NONE;
 
-	bson_oid_t oid = { 0 };
-	bson_oid_init_from_string (&oid, trans_id->str);
+	if (trans_id && bson_oid_is_valid (trans_id->str, trans_id->len)) {
+		bson_oid_t oid = { 0 };
+		bson_oid_init_from_string (&oid, trans_id->str);
+
+		int64_t deleted = 0;
+		if (!transaction_delete_one_by_oid_and_user (
+			&oid, &user->oid, &deleted
+		)) {
+			// the user's count is only updated
+			// if the transaction was actually removed
+			if (deleted) {
+				#ifdef POCKET_DEBUG
+				cerver_log_debug ("Deleted transaction %s", trans_id->str);
+				#endif
 
-	if (!transaction_delete_one_by_oid_and_user (
-		&oid, &user->oid
-	)) {
-		#ifdef POCKET_DEBUG
-		cerver_log_debug ("Deleted transaction %s", trans_id->str);
-		#endif
+				(void) user_remove_transaction (user);
+
+				pocket_trans_user_changed (&user->oid);
+			}
+
+			else {
+				error = POCKET_ERROR_NOT_FOUND;
+			}
+		}
+
+		else {
+			error = POCKET_ERROR_SERVER_ERROR;
+		}
 	}
 
 	else {
@@ -519,6 +1134,6 @@ PocketError pocket_trans_delete (
 void pocket_trans_return (void *trans_ptr) {
 
 	(void) memset (trans_ptr, 0, sizeof (Transaction));
-	(void) pool_push (trans_pool, trans_ptr);
+	pocket_pool_push (trans_pool, trans_ptr);
 
 }
\ No newline at end of file
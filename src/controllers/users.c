@@ -1,11 +1,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
+
+#include <time.h>
+#include <pthread.h>
 
 #include <cerver/types/string.h>
 
 #include <cerver/collections/dlist.h>
-#include <cerver/collections/pool.h>
 
 #include <cerver/handler.h>
 
@@ -19,14 +22,59 @@
 #include <cmongo/crud.h>
 #include <cmongo/select.h>
 
+#include "bloom.h"
+#include "db.h"
+#include "input.h"
+#include "metrics.h"
+#include "password.h"
 #include "pocket.h"
+#include "pool.h"
 
 #include "controllers/roles.h"
 #include "controllers/users.h"
 
 #include "models/user.h"
 
-static Pool *users_pool = NULL;
+#define POCKET_USER_KEY_MAP(XX)					\
+	XX(0,	NAME, 			name)				\
+	XX(1,	USERNAME, 		username)			\
+	XX(2,	EMAIL, 			email)				\
+	XX(3,	PASSWORD, 		password)			\
+	XX(4,	CONFIRM, 		confirm)
+
+typedef enum PocketUserKey {
+
+	#define XX(num, name, string) POCKET_USER_KEY_##name = num,
+	POCKET_USER_KEY_MAP (XX)
+	#undef XX
+
+} PocketUserKey;
+
+// the keys of the login & register bodies
+static PocketInputSchema users_schema = {
+	.keys = {
+		#define XX(num, name, string) #string,
+		POCKET_USER_KEY_MAP (XX)
+		#undef XX
+		NULL
+	}
+};
+
+static PocketPool *users_pool = NULL;
+
+// a decoded token that is valid until it expires
+typedef struct PocketUserCacheSlot {
+
+	time_t expires;
+	User user;
+
+} PocketUserCacheSlot;
+
+static PocketUserCacheSlot *users_cache = NULL;
+static pthread_mutex_t users_cache_locks[POCKET_USERS_CACHE_LOCKS];
+
+// every registered email, to skip the db check for new ones
+static PocketBloom *users_emails = NULL;
 
 const bson_t *user_login_query_opts = NULL;
 static CMongoSelect *user_login_select = NULL;
@@ -38,6 +86,9 @@ const bson_t *user_categories_query_opts = NULL;
 static CMongoSelect *user_categories_select = NULL;
 
 const bson_t *user_places_query_opts = NULL;
+
+static CMongoSelect *user_sync_select = NULL;
+const bson_t *user_sync_query_opts = NULL;
 static CMongoSelect *user_places_select = NULL;
 
 HttpResponse *users_works = NULL;
@@ -45,29 +96,186 @@ HttpResponse *missing_user_values = NULL;
 HttpResponse *wrong_password = NULL;
 HttpResponse *user_not_found = NULL;
 HttpResponse *repeated_email = NULL;
+HttpResponse *users_busy = NULL;
 
 static unsigned int pocket_users_init_pool (void) {
 
 	unsigned int retval = 1;
 
-	users_pool = pool_create (user_delete);
+	users_pool = pocket_pool_create (
+		user_new, user_delete, USERS_POOL_SIZE
+	);
+
 	if (users_pool) {
-		pool_set_create (users_pool, user_new);
-		pool_set_produce_if_empty (users_pool, true);
-		if (!pool_init (users_pool, user_new, DEFAULT_USERS_POOL_INIT)) {
-			retval = 0;
+		pocket_metrics_register_pool ("users", users_pool);
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error ("Failed to create users pool!");
+	}
+
+	return retval;
+
+}
+
+static unsigned int pocket_users_init_cache (void) {
+
+	unsigned int retval = 1;
+
+	users_cache = (PocketUserCacheSlot *) calloc (
+		POCKET_USERS_CACHE_SLOTS, sizeof (PocketUserCacheSlot)
+	);
+
+	if (users_cache) {
+		for (unsigned int idx = 0; idx < POCKET_USERS_CACHE_LOCKS; idx++) {
+			(void) pthread_mutex_init (&users_cache_locks[idx], NULL);
 		}
 
-		else {
-			cerver_log_error ("Failed to init users pool!");
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error ("Failed to create users cache!");
+	}
+
+	return retval;
+
+}
+
+static void pocket_users_end_cache (void) {
+
+	if (users_cache) {
+		for (unsigned int idx = 0; idx < POCKET_USERS_CACHE_LOCKS; idx++) {
+			(void) pthread_mutex_destroy (&users_cache_locks[idx]);
 		}
+
+		free (users_cache);
+		users_cache = NULL;
+	}
+
+}
+
+static inline unsigned int pocket_users_cache_hash (
+	const char *id, const time_t iat
+) {
+
+	// fnv-1a
+	unsigned int hash = 2166136261u;
+	for (const char *c = id; *c; c++) {
+		hash ^= (unsigned char) *c;
+		hash *= 16777619u;
+	}
+
+	hash ^= (unsigned int) iat;
+	hash *= 16777619u;
+
+	return hash & (POCKET_USERS_CACHE_SLOTS - 1);
+
+}
+
+// copies the token's cached user if it has not expired
+// returns true on a hit
+static bool pocket_users_cache_get (json_t *user_json, User *user) {
+
+	bool found = false;
+
+	const char *id = json_string_value (json_object_get (user_json, "id"));
+	json_t *iat_json = json_object_get (user_json, "iat");
+	if (id && json_is_integer (iat_json)) {
+		const time_t iat = (time_t) json_integer_value (iat_json);
+		const unsigned int hash = pocket_users_cache_hash (id, iat);
+		PocketUserCacheSlot *slot = &users_cache[hash];
+		pthread_mutex_t *lock = &users_cache_locks[hash % POCKET_USERS_CACHE_LOCKS];
+
+		(void) pthread_mutex_lock (lock);
+
+		if (
+			(slot->expires > time (NULL))
+			&& (slot->user.iat == iat)
+			&& !strcmp (slot->user.id, id)
+		) {
+			(void) memcpy (user, &slot->user, sizeof (User));
+			found = true;
+		}
+
+		(void) pthread_mutex_unlock (lock);
+	}
+
+	return found;
+
+}
+
+// the token's slot is replaced with the decoded user,
+// that is never kept after its token has expired
+static void pocket_users_cache_set (const User *user, const time_t now) {
+
+	const unsigned int hash = pocket_users_cache_hash (user->id, user->iat);
+	PocketUserCacheSlot *slot = &users_cache[hash];
+	pthread_mutex_t *lock = &users_cache_locks[hash % POCKET_USERS_CACHE_LOCKS];
+
+	time_t expires = now + POCKET_USERS_CACHE_TTL;
+	if (TOKEN_LIFETIME && ((user->iat + (time_t) TOKEN_LIFETIME) < expires)) {
+		expires = user->iat + (time_t) TOKEN_LIFETIME;
+	}
+
+	(void) pthread_mutex_lock (lock);
+
+	slot->expires = expires;
+	(void) memcpy (&slot->user, user, sizeof (User));
+
+	(void) pthread_mutex_unlock (lock);
+
+}
+
+// adds every registered email to the filter
+static unsigned int pocket_users_init_emails (void) {
+
+	unsigned int retval = 1;
+
+	uint64_t n_docs = 0;
+	mongoc_cursor_t *emails_cursor = users_get_all_emails (&n_docs);
+	if (emails_cursor) {
+		size_t n_items = (size_t) n_docs * 2;
+		if (n_items < POCKET_USERS_EMAILS_MIN) n_items = POCKET_USERS_EMAILS_MIN;
+
+		users_emails = pocket_bloom_create (n_items);
+		if (users_emails) {
+			bson_iter_t iter = { 0 };
+			const bson_t *email_doc = NULL;
+			while (db_cursor_next (emails_cursor, &email_doc)) {
+				if (
+					bson_iter_init_find (&iter, email_doc, "email")
+					&& BSON_ITER_HOLDS_UTF8 (&iter)
+				) {
+					uint32_t len = 0;
+					const char *email = bson_iter_utf8 (&iter, &len);
+					pocket_bloom_add (users_emails, email, len);
+				}
+			}
+
+			bson_error_t error = { 0 };
+			if (!mongoc_cursor_error (emails_cursor, &error)) {
+				retval = 0;
+			}
+
+			// an incomplete filter would skip existing emails
+			else {
+				cerver_log_error ("Failed to get users emails: %s", error.message);
+
+				pocket_bloom_delete (users_emails);
+				users_emails = NULL;
+			}
+		}
+
+		db_cursor_destroy (emails_cursor);
 	}
 
 	else {
-		cerver_log_error ("Failed to create users pool!");
+		cerver_log_error ("Failed to get users emails cursor!");
 	}
 
-	return retval;	
+	return retval;
 
 }
 
@@ -99,11 +307,17 @@ static unsigned int pocket_users_init_query_opts (void) {
 
 	user_places_query_opts = mongo_find_generate_opts (user_places_select);
 
+	user_sync_select = cmongo_select_new ();
+	(void) cmongo_select_insert_field (user_sync_select, "syncReset");
+
+	user_sync_query_opts = mongo_find_generate_opts (user_sync_select);
+
 	if (
 		user_login_query_opts
 		&& user_transactions_query_opts
 		&& user_categories_query_opts
 		&& user_places_query_opts
+		&& user_sync_query_opts
 	) retval = 0;
 
 	return retval;
@@ -134,9 +348,14 @@ static unsigned int pocket_users_init_responses (void) {
 		HTTP_STATUS_BAD_REQUEST, "error", "Email was already registered!"
 	);
 
+	users_busy = http_response_json_key_value (
+		HTTP_STATUS_TOO_MANY_REQUESTS, "error", "Too many requests, try again later!"
+	);
+
 	if (
 		users_works
 		&& missing_user_values && wrong_password && user_not_found
+		&& users_busy
 	) retval = 0;
 
 	return retval;
@@ -149,10 +368,16 @@ unsigned int pocket_users_init (void) {
 
 	errors |= pocket_users_init_pool ();
 
+	errors |= pocket_users_init_cache ();
+
+	errors |= pocket_users_init_emails ();
+
 	errors |= pocket_users_init_query_opts ();
 
 	errors |= pocket_users_init_responses ();
 
+	errors |= pocket_input_schema_init (&users_schema);
+
 	return errors;
 
 }
@@ -171,15 +396,24 @@ void pocket_users_end (void) {
 	cmongo_select_delete (user_places_select);
 	bson_destroy ((bson_t *) user_places_query_opts);
 
+	cmongo_select_delete (user_sync_select);
+	bson_destroy ((bson_t *) user_sync_query_opts);
+
 	http_response_delete (users_works);
 	http_response_delete (missing_user_values);
 	http_response_delete (wrong_password);
 	http_response_delete (user_not_found);
 	http_response_delete (repeated_email);
+	http_response_delete (users_busy);
 
-	pool_delete (users_pool);
+	pocket_pool_delete (users_pool);
 	users_pool = NULL;
 
+	pocket_users_end_cache ();
+
+	pocket_bloom_delete (users_emails);
+	users_emails = NULL;
+
 }
 
 User *pocket_user_create (
@@ -190,7 +424,7 @@ User *pocket_user_create (
 	const bson_oid_t *role_oid
 ) {
 
-	User *user = (User *) pool_pop (users_pool);
+	User *user = (User *) pocket_pool_pop (users_pool);
 	if (user) {
 		bson_oid_init (&user->oid, NULL);
 		bson_oid_to_string (&user->oid, user->id);
@@ -209,7 +443,7 @@ User *pocket_user_create (
 
 User *pocket_user_get (void) {
 
-	return (User *) pool_pop (users_pool);
+	return (User *) pocket_pool_pop (users_pool);
 
 }
 
@@ -217,10 +451,10 @@ User *pocket_user_get_by_email (const char *email) {
 
 	User *user = NULL;
 	if (email) {
-		user = (User *) pool_pop (users_pool);
+		user = (User *) pocket_pool_pop (users_pool);
 		if (user) {
 			if (user_get_by_email (user, email, user_login_query_opts)) {
-				(void) pool_push (users_pool, user);
+				pocket_pool_push (users_pool, user);
 				user = NULL;
 			}
 		}
@@ -230,11 +464,22 @@ User *pocket_user_get_by_email (const char *email) {
 
 }
 
+// returns true if a user with the email exists
+// the db is only queried if the email might have been registered
 u8 pocket_user_check_by_email (
 	const char *email
 ) {
 
-	return user_check_by_email (email);
+	u8 retval = 0;
+
+	if (
+		!users_emails
+		|| pocket_bloom_check (users_emails, email, strlen (email))
+	) {
+		retval = user_check_by_email (email);
+	}
+
+	return retval;
 
 }
 
@@ -250,8 +495,8 @@ void *pocket_user_parse_from_json (void *user_json_ptr) {
 
 	json_t *user_json = (json_t *) user_json_ptr;
 
-	User *user = user_new ();
-	if (user) {
+	User *user = (User *) pocket_pool_pop (users_pool);
+	if (user && !pocket_users_cache_get (user_json, user)) {
 		const char *email = NULL;
 		const char *id = NULL;
 		const char *name = NULL;
@@ -276,15 +521,32 @@ void *pocket_user_parse_from_json (void *user_json_ptr) {
 
 			bson_oid_init_from_string (&user->oid, user->id);
 
-			if (RUNTIME == RUNTIME_TYPE_DEVELOPMENT) {
-				user_print (user);
+			const time_t now = time (NULL);
+			if (
+				!TOKEN_LIFETIME
+				|| ((user->iat + (time_t) TOKEN_LIFETIME) > now)
+			) {
+				pocket_users_cache_set (user, now);
+
+				if (RUNTIME == RUNTIME_TYPE_DEVELOPMENT) {
+					user_print (user);
+				}
+			}
+
+			else {
+				#ifdef POCKET_DEBUG
+				cerver_log_debug ("user_parse_from_json () - token has expired!");
+				#endif
+
+				pocket_user_delete (user);
+				user = NULL;
 			}
 		}
 
 		else {
 			cerver_log_error ("user_parse_from_json () - json_unpack () has failed!");
 
-			(void) pool_push (users_pool, user);
+			pocket_user_delete (user);
 			user = NULL;
 		}
 	}
@@ -323,112 +585,98 @@ unsigned int pocket_user_generate_token (
 
 }
 
-static void users_input_parse_json (
-	json_t *json_body,
-	const char **name,
-	const char **username,
-	const char **email,
-	const char **password,
-	const char **confirm
+// sets the user's values from the object's members,
+// empty strings are ignored like unknown keys
+static void users_input_parse (
+	PocketInput *input, User *values, char *confirm
 ) {
 
-	// get values from json to create a new transaction
-	char *string = NULL;
-	const char *key = NULL;
-	json_t *value = NULL;
-	if (json_typeof (json_body) == JSON_OBJECT) {
-		json_object_foreach (json_body, key, value) {
-			if (!strcmp (key, "name")) {
-				string = (char *) json_string_value (value);
-				if (strlen (string)) {
-					*name = string;
-					#ifdef POCKET_DEBUG
-					(void) printf ("name: \"%s\"\n", *name);
-					#endif
-				}
+	int key = -1;
+	PocketInputValue value = { 0 };
+	while (pocket_input_object_next (input, &users_schema, &key, &value)) {
+		if ((value.type == POCKET_INPUT_TYPE_STRING) && value.len) {
+			switch (key) {
+				case POCKET_USER_KEY_NAME:
+					(void) pocket_input_string_copy (
+						&value, values->name, USER_NAME_SIZE
+					);
+					break;
+
+				case POCKET_USER_KEY_USERNAME:
+					(void) pocket_input_string_copy (
+						&value, values->username, USER_USERNAME_SIZE
+					);
+					break;
+
+				case POCKET_USER_KEY_EMAIL:
+					(void) pocket_input_string_copy (
+						&value, values->email, USER_EMAIL_SIZE
+					);
+					break;
+
+				case POCKET_USER_KEY_PASSWORD:
+					(void) pocket_input_string_copy (
+						&value, values->password, USER_PASSWORD_SIZE
+					);
+					break;
+
+				case POCKET_USER_KEY_CONFIRM:
+					(void) pocket_input_string_copy (
+						&value, confirm, USER_PASSWORD_SIZE
+					);
+					break;
+
+				default: break;
 			}
+		}
+	}
 
-			else if (!strcmp (key, "username")) {
-				string = (char *) json_string_value (value);
-				if (strlen (string)) {
-					*username = string;
-					#ifdef POCKET_DEBUG
-					(void) printf ("username: \"%s\"\n", *username);
-					#endif
-				}
-			}
+}
 
-			else if (!strcmp (key, "email")) {
-				string = (char *) json_string_value (value);
-				if (strlen (string)) {
-					*email = string;
-					#ifdef POCKET_DEBUG
-					(void) printf ("email: \"%s\"\n", *email);
-					#endif
-				}
-			}
+// returns 0 if the body is an object that was read without errors
+static unsigned int users_input_parse_json (
+	const String *request_body, User *values, char *confirm
+) {
 
-			else if (!strcmp (key, "password")) {
-				string = (char *) json_string_value (value);
-				if (strlen (string)) {
-					*password = string;
-					#ifdef POCKET_DEBUG
-					(void) printf ("password: \"%s\"\n", *password);
-					#endif
-				}
-			}
+	PocketInput input = { 0 };
+	pocket_input_init (&input, request_body->str, request_body->len);
 
-			else if (!strcmp (key, "confirm")) {
-				string = (char *) json_string_value (value);
-				if (strlen (string)) {
-					*confirm = string;
-					#ifdef POCKET_DEBUG
-					(void) printf ("confirm: \"%s\"\n", *confirm);
-					#endif
-				}
-			}
-		}
+	if (pocket_input_object_begin (&input)) {
+		users_input_parse (&input, values, confirm);
 	}
 
+	return pocket_input_end (&input) ? 0 : 1;
+
 }
 
 static PocketUserInput pocket_user_register_validate_input_internal (
-	const char *name,
-	const char *username,
-	const char *email,
-	const char *password,
-	const char *confirm
+	const User *values, const char *confirm
 ) {
 
 	PocketUserInput user_input = POCKET_USER_INPUT_NONE;
 
-	if (!name) user_input |= POCKET_USER_INPUT_NAME;
-	if (!username) user_input |= POCKET_USER_INPUT_USERNAME;
-	if (!email) user_input |= POCKET_USER_INPUT_EMAIL;
-	if (!password) user_input |= POCKET_USER_INPUT_PASSWORD;
-	if (!confirm) user_input |= POCKET_USER_INPUT_CONFIRM;
+	if (!values->name[0]) user_input |= POCKET_USER_INPUT_NAME;
+	if (!values->username[0]) user_input |= POCKET_USER_INPUT_USERNAME;
+	if (!values->email[0]) user_input |= POCKET_USER_INPUT_EMAIL;
+	if (!values->password[0]) user_input |= POCKET_USER_INPUT_PASSWORD;
+	if (!confirm[0]) user_input |= POCKET_USER_INPUT_CONFIRM;
 
 	return user_input;
 
 }
 
 static PocketUserError pocket_user_register_validate_input (
-	PocketUserInput *input,
-	const char *name,
-	const char *username,
-	const char *email,
-	const char *password,
-	const char *confirm
+	PocketUserInput *input, const User *values, const char *confirm
 ) {
 
 	PocketUserError error = POCKET_USER_ERROR_NONE;
 
 	*input = pocket_user_register_validate_input_internal (
-		name, username, email, password, confirm
+		values, confirm
 	);
 
 	if (*input == POCKET_USER_INPUT_NONE) {
-		if (strcmp (password, confirm)) {
+		if (strcmp (values->password, confirm)) {
 			*input |= POCKET_USER_INPUT_MATCH;
 			error = POCKET_USER_ERROR_BAD_REQUEST;
 		}
@@ -442,6 +690,32 @@ static PocketUserError pocket_user_register_validate_input (
 
 }
 
+static PocketUserError pocket_user_error_from_password (
+	const PocketPasswordResult result
+) {
+
+	PocketUserError error = POCKET_USER_ERROR_NONE;
+
+	switch (result) {
+		case POCKET_PASSWORD_RESULT_OK: break;
+
+		case POCKET_PASSWORD_RESULT_WRONG:
+			error = POCKET_USER_ERROR_WRONG_PSWD;
+			break;
+
+		case POCKET_PASSWORD_RESULT_BUSY:
+			error = POCKET_USER_ERROR_BUSY;
+			break;
+
+		default:
+			error = POCKET_USER_ERROR_SERVER_ERROR;
+			break;
+	}
+
+	return error;
+
+}
+
 static PocketUserError pocket_user_register_parse_json (
 	const String *request_body, PocketUserInput *input,
 	User **user
@@ -449,52 +723,52 @@ static PocketUserError pocket_user_register_parse_json (
 
 	PocketUserError error = POCKET_USER_ERROR_NONE;
 
-	const char *name = NULL;
-	const char *username = NULL;
-	const char *email = NULL;
-	const char *password = NULL;
-	const char *confirm = NULL;
-
-	json_error_t json_error =  { 0 };
-	json_t *json_body = json_loads (request_body->str, 0, &json_error);
-	if (json_body) {
-		users_input_parse_json (
-			json_body,
-			&name,
-			&username,
-			&email,
-			&password,
-			&confirm
-		);
+	User values = { 0 };
+	char confirm[USER_PASSWORD_SIZE] = { 0 };
 
+	if (!users_input_parse_json (request_body, &values, confirm)) {
 		error = pocket_user_register_validate_input (
-			input,
-			name,
-			username,
-			email,
-			password,
-			confirm
+			input, &values, confirm
 		);
 
+		// avoid hashing the password of a repeated email
 		if (error == POCKET_USER_ERROR_NONE) {
-			*user = pocket_user_create (
-				name,
-				username,
-				email,
-				password,
-				&common_role->oid
-			);
+			if (pocket_user_check_by_email (values.email)) {
+				error = POCKET_USER_ERROR_REPEATED;
+			}
 		}
 
-		json_decref (json_body);
+		if (error == POCKET_USER_ERROR_NONE) {
+			char hashed[USER_PASSWORD_SIZE] = { 0 };
+			error = pocket_user_error_from_password (
+				pocket_password_hash (values.password, hashed)
+			);
+
+			// copied from the current table as it may be swapped
+			bson_oid_t common_oid = { 0 };
+			if (
+				(error == POCKET_USER_ERROR_NONE)
+				&& pocket_role_common_get_oid (&common_oid)
+			) {
+				cerver_log_error ("pocket_user_register () - missing common role!");
+				error = POCKET_USER_ERROR_SERVER_ERROR;
+			}
+
+			if (error == POCKET_USER_ERROR_NONE) {
+				*user = pocket_user_create (
+					values.name,
+					values.username,
+					values.email,
+					hashed,
+					&common_oid
+				);
+			}
+		}
 	}
 
 	else {
 		#ifdef POCKET_DEBUG
-		cerver_log_error (
-			"json_loads () - json error on line %d: %s\n", 
-			json_error.line, json_error.text
-		);
+		cerver_log_error ("pocket_user_register () - bad request body!");
 		#endif
 
 		error = POCKET_USER_ERROR_BAD_REQUEST;
@@ -519,12 +793,23 @@ User *pocket_user_register (
 
 		if (*error == POCKET_USER_ERROR_NONE) {
 			if (user) {
-				if (!user_insert_one (user)) {
+				bool duplicated = false;
+				if (!user_insert_one (user, &duplicated)) {
+					if (users_emails) {
+						pocket_bloom_add (
+							users_emails, user->email, strlen (user->email)
+						);
+					}
+
 					retval = user;
 				}
 
+				// the unique index found a repeated email
 				else {
-					*error = POCKET_USER_ERROR_SERVER_ERROR;
+					*error = duplicated ?
+						POCKET_USER_ERROR_REPEATED : POCKET_USER_ERROR_SERVER_ERROR;
+
+					pocket_user_delete (user);
 				}
 			}
 
@@ -547,14 +832,13 @@ User *pocket_user_register (
 }
 
 static PocketUserInput pocket_user_login_validate_input_internal (
-	const char *email,
-	const char *password
+	const User *values
 ) {
 
 	PocketUserInput user_input = POCKET_USER_INPUT_NONE;
 
-	if (!email) user_input |= POCKET_USER_INPUT_EMAIL;
-	if (!password) user_input |= POCKET_USER_INPUT_PASSWORD;
+	if (!values->email[0]) user_input |= POCKET_USER_INPUT_EMAIL;
+	if (!values->password[0]) user_input |= POCKET_USER_INPUT_PASSWORD;
 
 	return user_input;
 
@@ -567,46 +851,19 @@ static PocketUserError pocket_user_login_parse_json (
 
 	PocketUserError error = POCKET_USER_ERROR_NONE;
 
-	const char *name = NULL;
-	const char *username = NULL;
-	const char *email = NULL;
-	const char *password = NULL;
-	const char *confirm = NULL;
-
-	json_error_t json_error =  { 0 };
-	json_t *json_body = json_loads (request_body->str, 0, &json_error);
-	if (json_body) {
-		users_input_parse_json (
-			json_body,
-			&name,
-			&username,
-			&email,
-			&password,
-			&confirm
-		);
+	char confirm[USER_PASSWORD_SIZE] = { 0 };
 
-		*input = pocket_user_login_validate_input_internal (
-			email, password
-		);
+	if (!users_input_parse_json (request_body, user_values, confirm)) {
+		*input = pocket_user_login_validate_input_internal (user_values);
 
-		if (*input == POCKET_USER_INPUT_NONE) {
-			(void) strncpy (user_values->email, email, USER_EMAIL_SIZE - 1);
-			(void) strncpy (user_values->password, password, USER_PASSWORD_SIZE - 1);
-		}
-
-		else {
+		if (*input != POCKET_USER_INPUT_NONE) {
 			error = POCKET_USER_ERROR_MISSING_VALUES;
 		}
-
-		json_decref (json_body);
 	}
 
 	else {
 		#ifdef POCKET_DEBUG
-		cerver_log_error (
-			"json_loads () - json error on line %d: %s\n", 
-			json_error.line, json_error.text
-		);
+		cerver_log_error ("pocket_user_login () - bad request body!");
 		#endif
 
 		error = POCKET_USER_ERROR_BAD_REQUEST;
@@ -632,21 +889,46 @@ User *pocket_user_login (
 		if (*error == POCKET_USER_ERROR_NONE) {
 			User *user = pocket_user_get_by_email (user_values.email);
 			if (user) {
-				if (!strcmp (user->password, user_values.password)) {
+				bool upgrade = false;
+				char rehashed[USER_PASSWORD_SIZE] = { 0 };
+				PocketPasswordResult result = pocket_password_verify (
+					user_values.password, user->password,
+					&upgrade, rehashed
+				);
+
+				*error = pocket_user_error_from_password (result);
+
+				if (*error == POCKET_USER_ERROR_NONE) {
 					#ifdef POCKET_DEBUG
 					cerver_log_success ("User %s login -> success", user->id);
 					#endif
 
+					// replace legacy or outdated password values
+					if (upgrade) {
+						if (!user_update_password (user, rehashed)) {
+							(void) strncpy (
+								user->password, rehashed, USER_PASSWORD_SIZE - 1
+							);
+						}
+
+						else {
+							cerver_log_error (
+								"Failed to upgrade user %s password!", user->id
+							);
+						}
+					}
+
 					retval = user;
 				}
 
 				else {
 					#ifdef POCKET_DEBUG
-					cerver_log_error ("User %s login -> wrong password", user->id);
+					cerver_log_error (
+						"User %s login -> %s", user->id,
+						pocket_password_result_to_string (result)
+					);
 					#endif
 
-					*error = POCKET_USER_ERROR_WRONG_PSWD;
-
 					pocket_user_delete (user);
 				}
 			}
@@ -657,8 +939,6 @@ User *pocket_user_login (
 				#endif
 
 				*error = POCKET_USER_ERROR_NOT_FOUND;
-
-				pocket_user_delete (user);
 			}
 		}
 	}
@@ -678,6 +958,6 @@ User *pocket_user_login (
 void pocket_user_delete (void *user_ptr) {
 
 	(void) memset (user_ptr, 0, sizeof (User));
-	(void) pool_push (users_pool, user_ptr);
+	pocket_pool_push (users_pool, user_ptr);
 
 }
\ No newline at end of file
@@ -0,0 +1,1039 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <time.h>
+
+#include <bson/bson.h>
+#include <mongoc/mongoc.h>
+
+#include <cmongo/crud.h>
+#include <cmongo/model.h>
+#include <cmongo/select.h>
+
+#include <cerver/utils/log.h>
+
+#include "arena.h"
+#include "db.h"
+#include "metrics.h"
+#include "output.h"
+
+#define DB_NAME_SIZE			128
+
+// a cursor that is timed while it is iterated
+typedef struct DbCursorTimer {
+
+	const mongoc_cursor_t *cursor;
+
+	DbTimer timer;
+
+	// nanos spent creating & iterating the cursor
+	int64_t elapsed;
+
+} DbCursorTimer;
+
+typedef struct DbFilterShape {
+
+	char *data;
+	size_t size;
+	size_t len;
+
+	bool truncated;
+
+} DbFilterShape;
+
+static mongoc_uri_t *db_uri = NULL;
+static mongoc_client_pool_t *db_pool = NULL;
+
+static char db_name[DB_NAME_SIZE] = { 0 };
+
+static unsigned int db_slow_threshold = DB_DEFAULT_SLOW_THRESHOLD;
+
+static bool db_indexes_required = false;
+
+static _Thread_local DbCursorTimer db_cursors[DB_CURSORS_MAX];
+
+const char *db_collection_to_string (const DbCollection collection) {
+
+	switch (collection) {
+		#define XX(num, name, string) case DB_COLLECTION_##name: return #string;
+		DB_COLLECTION_MAP(XX)
+		#undef XX
+
+		default: break;
+	}
+
+	return "unknown";
+
+}
+
+const char *db_operation_to_string (const DbOperation operation) {
+
+	switch (operation) {
+		#define XX(num, name, string) case DB_OPERATION_##name: return #string;
+		DB_OPERATION_MAP(XX)
+		#undef XX
+
+		default: break;
+	}
+
+	return "unknown";
+
+}
+
+unsigned int db_init (
+	const char *uri, const char *app_name, const char *name
+) {
+
+	unsigned int retval = 1;
+
+	if (uri && name) {
+		bson_error_t error = { 0 };
+		db_uri = mongoc_uri_new_with_error (uri, &error);
+		if (db_uri) {
+			db_pool = mongoc_client_pool_new (db_uri);
+			if (db_pool) {
+				(void) mongoc_client_pool_set_error_api (
+					db_pool, MONGOC_ERROR_API_VERSION_2
+				);
+
+				if (app_name) {
+					(void) mongoc_client_pool_set_appname (db_pool, app_name);
+				}
+
+				(void) strncpy (db_name, name, DB_NAME_SIZE - 1);
+
+				retval = 0;
+			}
+
+			else {
+				cerver_log_error ("db_init () - failed to create client pool!");
+			}
+		}
+
+		else {
+			cerver_log_error (
+				"db_init () - failed to parse uri: %s", error.message
+			);
+		}
+	}
+
+	return retval;
+
+}
+
+void db_end (void) {
+
+	if (db_pool) {
+		mongoc_client_pool_destroy (db_pool);
+		db_pool = NULL;
+	}
+
+	if (db_uri) {
+		mongoc_uri_destroy (db_uri);
+		db_uri = NULL;
+	}
+
+}
+
+// gets a client from the pool, must be returned with db_client_push ()
+mongoc_client_t *db_client_pop (void) {
+
+	return db_pool ? mongoc_client_pool_pop (db_pool) : NULL;
+
+}
+
+void db_client_push (mongoc_client_t *client) {
+
+	if (client) mongoc_client_pool_push (db_pool, client);
+
+}
+
+// returns a new collection handle that must be destroyed by the caller
+mongoc_collection_t *db_collection_get (
+	mongoc_client_t *client, const char *coll_name
+) {
+
+	return mongoc_client_get_collection (client, db_name, coll_name);
+
+}
+
+// returns the current time in millis, as used in date fields
+int64_t db_now (void) {
+
+	struct timespec now = { 0 };
+	(void) clock_gettime (CLOCK_REALTIME, &now);
+
+	return ((int64_t) now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+
+}
+
+// returns an empty document for a query that lives in the request's arena,
+// or in the heap outside of a request, bson_destroy () works with both
+bson_t *db_query_new (void) {
+
+	// bson_init () keeps small documents inside the struct & marks it
+	// as static, so bson_destroy () never frees the arena's memory
+	bson_t *query = (bson_t *) pocket_arena_alloc_aligned (
+		pocket_arena_request (), sizeof (bson_t), _Alignof (bson_t)
+	);
+
+	if (query) bson_init (query);
+	else query = bson_new ();
+
+	return query;
+
+}
+
+// appends the string view, an empty view is stored as ""
+void db_append_str (
+	bson_t *doc, const char *key, const PocketStr *str
+) {
+
+	(void) bson_append_utf8 (
+		doc, key, -1,
+		str->str ? str->str : "", (int) str->len
+	);
+
+}
+
+// copies a utf8 value into the arena, truncated to max_len bytes
+// returns false if the value is not a string or on error
+bool db_iter_str (
+	const bson_iter_t *iter, PocketArena *arena,
+	const size_t max_len, PocketStr *str
+) {
+
+	bool retval = false;
+
+	if (arena && BSON_ITER_HOLDS_UTF8 (iter)) {
+		uint32_t len = 0;
+		const char *value = bson_iter_utf8 (iter, &len);
+
+		// never splits a char
+		size_t truncated = (len > max_len) ? max_len : len;
+		while (
+			(truncated < len) && truncated
+			&& (((unsigned char) value[truncated] & 0xC0) == 0x80)
+		) {
+			truncated -= 1;
+		}
+
+		retval = pocket_arena_str (arena, value, truncated, str);
+	}
+
+	return retval;
+
+}
+
+// operations that take more millis are logged, 0 to disable the log
+void db_set_slow_threshold (const unsigned int millis) {
+
+	db_slow_threshold = millis;
+
+}
+
+static void db_filter_shape_append (
+	DbFilterShape *shape, const char *str, const size_t str_len
+) {
+
+	if (!shape->truncated) {
+		if ((shape->len + str_len) < shape->size) {
+			(void) memcpy (shape->data + shape->len, str, str_len);
+			shape->len += str_len;
+			shape->data[shape->len] = '\0';
+		}
+
+		else {
+			shape->truncated = true;
+		}
+	}
+
+}
+
+// field names are kept without the chars that break the log line
+static void db_filter_shape_append_key (
+	DbFilterShape *shape, const char *key
+) {
+
+	char c = 0;
+	for (const char *k = key; *k; k++) {
+		c = ((*k == '"') || (*k == '\\') || (*k < ' ')) ? '_' : *k;
+		db_filter_shape_append (shape, &c, 1);
+	}
+
+}
+
+static void db_filter_shape_internal (
+	DbFilterShape *shape, bson_iter_t *iter,
+	const bool array, const unsigned int depth
+) {
+
+	db_filter_shape_append (shape, array ? "[" : "{", 1);
+
+	bool first = true;
+	bool nested = false;
+	bson_iter_t child = { 0 };
+	while (!shape->truncated && bson_iter_next (iter)) {
+		if (!first) db_filter_shape_append (shape, ", ", 2);
+		first = false;
+
+		if (!array) {
+			db_filter_shape_append_key (shape, bson_iter_key (iter));
+			db_filter_shape_append (shape, ": ", 2);
+		}
+
+		nested = BSON_ITER_HOLDS_DOCUMENT (iter) || BSON_ITER_HOLDS_ARRAY (iter);
+		if (
+			nested
+			&& (depth < DB_FILTER_SHAPE_DEPTH)
+			&& bson_iter_recurse (iter, &child)
+		) {
+			db_filter_shape_internal (
+				shape, &child, BSON_ITER_HOLDS_ARRAY (iter), depth + 1
+			);
+		}
+
+		else {
+			db_filter_shape_append (shape, "?", 1);
+
+			// a list of values has the same shape no matter its length
+			if (array) {
+				if (bson_iter_next (iter)) {
+					db_filter_shape_append (shape, ", ...", 5);
+				}
+
+				break;
+			}
+		}
+	}
+
+	db_filter_shape_append (shape, array ? "]" : "}", 1);
+
+}
+
+// writes the filter with every value replaced by ?
+// like {user: ?, date: {$gte: ?}}
+void db_filter_shape (
+	const bson_t *filter, char *shape, const size_t shape_size
+) {
+
+	DbFilterShape filter_shape = {
+		.data = shape, .size = shape_size, .len = 0, .truncated = false
+	};
+
+	shape[0] = '\0';
+
+	bson_iter_t iter = { 0 };
+	if (filter && bson_iter_init (&iter, filter)) {
+		db_filter_shape_internal (&filter_shape, &iter, false, 0);
+	}
+
+	if (filter_shape.truncated && (shape_size > 4)) {
+		(void) strcpy (shape + (shape_size - 4), "...");
+	}
+
+}
+
+// must be called before the operation,
+// because the filter is destroyed by most of them
+void db_timer_start (
+	DbTimer *timer,
+	const DbCollection collection, const DbOperation operation,
+	const bson_t *filter
+) {
+
+	timer->collection = collection;
+	timer->operation = operation;
+
+	timer->filter[0] = '\0';
+	if (db_slow_threshold && filter) {
+		db_filter_shape (filter, timer->filter, DB_FILTER_SHAPE_SIZE);
+	}
+
+	timer->start = pocket_metrics_now ();
+
+}
+
+static void db_timer_record (const DbTimer *timer, const int64_t elapsed) {
+
+	pocket_metrics_db_record (
+		timer->collection, timer->operation, timer->start, elapsed
+	);
+
+	if (
+		db_slow_threshold
+		&& (elapsed >= ((int64_t) db_slow_threshold * 1000000))
+	) {
+		cerver_log_warning (
+			"{\"slow_db_op\": {\"collection\": \"%s\", \"op\": \"%s\", \"ms\": %.3f, \"filter\": \"%s\"}}",
+			db_collection_to_string (timer->collection),
+			db_operation_to_string (timer->operation),
+			(double) elapsed / 1e6,
+			timer->filter
+		);
+	}
+
+}
+
+// records the operation's time & logs it if it was slow
+void db_timer_end (DbTimer *timer) {
+
+	db_timer_record (timer, pocket_metrics_now () - timer->start);
+
+}
+
+// when set, a model fails to init if any of its queries
+// would need to scan the whole collection
+void db_set_indexes_required (const bool required) {
+
+	db_indexes_required = required;
+
+}
+
+static void db_index_fields_append (
+	bson_t *doc, const DbIndexField *fields
+) {
+
+	for (const DbIndexField *field = fields; field->name; field++) {
+		(void) bson_append_int32 (doc, field->name, -1, field->order);
+	}
+
+}
+
+// does nothing if an index with the same name & keys already exists
+static unsigned int db_index_create (
+	mongoc_database_t *database, const char *coll_name,
+	const DbIndex *index
+) {
+
+	unsigned int retval = 1;
+
+	bson_t command = BSON_INITIALIZER;
+	(void) bson_append_utf8 (&command, "createIndexes", -1, coll_name, -1);
+
+	bson_t indexes = BSON_INITIALIZER;
+	(void) bson_append_array_begin (&command, "indexes", -1, &indexes);
+
+	bson_t index_doc = BSON_INITIALIZER;
+	(void) bson_append_document_begin (&indexes, "0", -1, &index_doc);
+
+	bson_t keys = BSON_INITIALIZER;
+	(void) bson_append_document_begin (&index_doc, "key", -1, &keys);
+	db_index_fields_append (&keys, index->fields);
+	(void) bson_append_document_end (&index_doc, &keys);
+
+	(void) bson_append_utf8 (&index_doc, "name", -1, index->name, -1);
+	if (index->unique) (void) bson_append_bool (&index_doc, "unique", -1, true);
+	if (index->expire_seconds) {
+		(void) bson_append_int64 (
+			&index_doc, "expireAfterSeconds", -1, index->expire_seconds
+		);
+	}
+	(void) bson_append_document_end (&indexes, &index_doc);
+
+	(void) bson_append_array_end (&command, &indexes);
+
+	bson_error_t error = { 0 };
+	if (mongoc_database_write_command_with_opts (
+		database, &command, NULL, NULL, &error
+	)) {
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error (
+			"Failed to create %s index in %s: %s",
+			index->name, coll_name, error.message
+		);
+	}
+
+	bson_destroy (&command);
+
+	return retval;
+
+}
+
+// returns true if any of the plan's stages scans the collection
+static bool db_plan_has_collscan (bson_iter_t *iter) {
+
+	bool collscan = false;
+
+	bson_iter_t child = { 0 };
+	while (!collscan && bson_iter_next (iter)) {
+		if (BSON_ITER_HOLDS_UTF8 (iter)) {
+			collscan = !strcmp (bson_iter_key (iter), "stage")
+				&& !strcmp (bson_iter_utf8 (iter, NULL), "COLLSCAN");
+		}
+
+		else if (
+			(BSON_ITER_HOLDS_DOCUMENT (iter) || BSON_ITER_HOLDS_ARRAY (iter))
+			&& bson_iter_recurse (iter, &child)
+		) {
+			collscan = db_plan_has_collscan (&child);
+		}
+	}
+
+	return collscan;
+
+}
+
+// { explain: { find, filter: { field: null }, sort }, verbosity }
+// the values don't change the plan that is selected for the shape
+static bson_t *db_query_shape_explain_command (
+	const char *coll_name, const DbQueryShape *query
+) {
+
+	bson_t *command = bson_new ();
+	if (command) {
+		bson_t explain = BSON_INITIALIZER;
+		(void) bson_append_document_begin (command, "explain", -1, &explain);
+		(void) bson_append_utf8 (&explain, "find", -1, coll_name, -1);
+
+		bson_t filter = BSON_INITIALIZER;
+		(void) bson_append_document_begin (&explain, "filter", -1, &filter);
+		for (const char *const *field = query->filter; *field; field++) {
+			(void) bson_append_null (&filter, *field, -1);
+		}
+		(void) bson_append_document_end (&explain, &filter);
+
+		if (query->sort[0].name) {
+			bson_t sort = BSON_INITIALIZER;
+			(void) bson_append_document_begin (&explain, "sort", -1, &sort);
+			db_index_fields_append (&sort, query->sort);
+			(void) bson_append_document_end (&explain, &sort);
+		}
+
+		(void) bson_append_document_end (command, &explain);
+
+		(void) bson_append_utf8 (command, "verbosity", -1, "queryPlanner", -1);
+	}
+
+	return command;
+
+}
+
+// checks with the query planner that the shape uses an index
+// returns 0 on success, 1 if it scans the collection or on error
+static unsigned int db_query_shape_check (
+	mongoc_database_t *database, const char *coll_name,
+	const DbQueryShape *query
+) {
+
+	unsigned int retval = 1;
+
+	bson_t *command = db_query_shape_explain_command (coll_name, query);
+	if (command) {
+		bson_t reply = { 0 };
+		bson_error_t error = { 0 };
+		if (mongoc_database_command_simple (
+			database, command, NULL, &reply, &error
+		)) {
+			bson_iter_t iter = { 0 };
+			bson_iter_t plan = { 0 };
+			bson_iter_t stages = { 0 };
+			if (
+				bson_iter_init (&iter, &reply)
+				&& bson_iter_find_descendant (&iter, "queryPlanner.winningPlan", &plan)
+				&& BSON_ITER_HOLDS_DOCUMENT (&plan)
+				&& bson_iter_recurse (&plan, &stages)
+			) {
+				if (!db_plan_has_collscan (&stages)) {
+					retval = 0;
+				}
+
+				else if (db_indexes_required) {
+					cerver_log_error (
+						"%s %s query scans the whole collection!",
+						coll_name, query->name
+					);
+				}
+
+				else {
+					cerver_log_warning (
+						"%s %s query scans the whole collection!",
+						coll_name, query->name
+					);
+				}
+			}
+
+			else {
+				cerver_log_error (
+					"Failed to get %s %s query plan!",
+					coll_name, query->name
+				);
+			}
+		}
+
+		else {
+			cerver_log_error (
+				"Failed to explain %s %s query: %s",
+				coll_name, query->name, error.message
+			);
+		}
+
+		bson_destroy (&reply);
+		bson_destroy (command);
+	}
+
+	return retval;
+
+}
+
+// creates the model's indexes, doing nothing for the ones that
+// already exist, & then checks that every one of its query shapes
+// uses an index with mongo's query planner
+// returns 0 on success, 1 on error
+unsigned int db_indexes_init (
+	const DbCollection collection,
+	const DbIndex *indexes, const DbQueryShape *queries
+) {
+
+	unsigned int errors = 0;
+
+	const char *coll_name = db_collection_to_string (collection);
+
+	mongoc_client_t *client = db_client_pop ();
+	if (client) {
+		mongoc_database_t *database = mongoc_client_get_database (
+			client, db_name
+		);
+
+		for (const DbIndex *index = indexes; index->name; index++) {
+			errors |= db_index_create (database, coll_name, index);
+		}
+
+		// a missing index only fails in production, where a
+		// collection scan would take down the whole service
+		if (!errors) {
+			for (const DbQueryShape *query = queries; query->name; query++) {
+				if (db_query_shape_check (database, coll_name, query)) {
+					if (db_indexes_required) errors |= 1;
+				}
+			}
+		}
+
+		mongoc_database_destroy (database);
+
+		db_client_push (client);
+	}
+
+	else {
+		errors |= 1;
+	}
+
+	return errors;
+
+}
+
+// runs an insert_one with the doc, that is destroyed after the operation
+// duplicated is set if the doc breaks a unique index
+// returns 0 on success, 1 on error
+unsigned int db_insert_one (
+	const DbCollection coll, bson_t *doc, bool *duplicated
+) {
+
+	unsigned int retval = 1;
+
+	*duplicated = false;
+
+	if (doc) {
+		const char *coll_name = db_collection_to_string (coll);
+
+		DbTimer timer = { 0 };
+		db_timer_start (&timer, coll, DB_OPERATION_INSERT_ONE, NULL);
+
+		mongoc_client_t *client = db_client_pop ();
+		if (client) {
+			mongoc_collection_t *collection = db_collection_get (
+				client, coll_name
+			);
+
+			bson_error_t error = { 0 };
+			if (mongoc_collection_insert_one (
+				collection, doc, NULL, NULL, &error
+			)) {
+				retval = 0;
+			}
+
+			else if (error.code == MONGOC_ERROR_DUPLICATE_KEY) {
+				*duplicated = true;
+			}
+
+			else {
+				cerver_log_error (
+					"Failed to insert one in %s: %s",
+					coll_name, error.message
+				);
+			}
+
+			mongoc_collection_destroy (collection);
+
+			db_client_push (client);
+		}
+
+		db_timer_end (&timer);
+
+		bson_destroy (doc);
+	}
+
+	return retval;
+
+}
+
+// runs an update_one using the query & update documents,
+// that are destroyed after the operation
+// matched is set with the number of documents that matched the query
+// returns 0 on success, 1 on error
+unsigned int db_update_one (
+	const DbCollection coll,
+	bson_t *query, bson_t *update,
+	int64_t *matched
+) {
+
+	unsigned int retval = 1;
+
+	*matched = 0;
+
+	if (query && update) {
+		const char *coll_name = db_collection_to_string (coll);
+
+		DbTimer timer = { 0 };
+		db_timer_start (&timer, coll, DB_OPERATION_UPDATE_ONE, query);
+
+		mongoc_client_t *client = db_client_pop ();
+		if (client) {
+			mongoc_collection_t *collection = db_collection_get (
+				client, coll_name
+			);
+
+			bson_t reply = BSON_INITIALIZER;
+			bson_error_t error = { 0 };
+			if (mongoc_collection_update_one (
+				collection, query, update, NULL, &reply, &error
+			)) {
+				bson_iter_t iter = { 0 };
+				if (bson_iter_init_find (&iter, &reply, "matchedCount")) {
+					*matched = bson_iter_as_int64 (&iter);
+				}
+
+				retval = 0;
+			}
+
+			else {
+				cerver_log_error (
+					"Failed to update one in %s: %s",
+					coll_name, error.message
+				);
+			}
+
+			bson_destroy (&reply);
+			mongoc_collection_destroy (collection);
+
+			db_client_push (client);
+		}
+
+		db_timer_end (&timer);
+	}
+
+	if (query) bson_destroy (query);
+	if (update) bson_destroy (update);
+
+	return retval;
+
+}
+
+// runs a delete_one using the query, that is destroyed after the operation
+// deleted is set with the number of documents that were removed
+// returns 0 on success, 1 on error
+unsigned int db_delete_one (
+	const DbCollection coll, bson_t *query, int64_t *deleted
+) {
+
+	unsigned int retval = 1;
+
+	*deleted = 0;
+
+	if (query) {
+		const char *coll_name = db_collection_to_string (coll);
+
+		DbTimer timer = { 0 };
+		db_timer_start (&timer, coll, DB_OPERATION_DELETE_ONE, query);
+
+		mongoc_client_t *client = db_client_pop ();
+		if (client) {
+			mongoc_collection_t *collection = db_collection_get (
+				client, coll_name
+			);
+
+			bson_t reply = BSON_INITIALIZER;
+			bson_error_t error = { 0 };
+			if (mongoc_collection_delete_one (
+				collection, query, NULL, &reply, &error
+			)) {
+				bson_iter_t iter = { 0 };
+				if (bson_iter_init_find (&iter, &reply, "deletedCount")) {
+					*deleted = bson_iter_as_int64 (&iter);
+				}
+
+				retval = 0;
+			}
+
+			else {
+				cerver_log_error (
+					"Failed to delete one in %s: %s",
+					coll_name, error.message
+				);
+			}
+
+			bson_destroy (&reply);
+			mongoc_collection_destroy (collection);
+
+			db_client_push (client);
+		}
+
+		db_timer_end (&timer);
+
+		bson_destroy (query);
+	}
+
+	return retval;
+
+}
+
+unsigned int db_model_find_one (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const CMongoSelect *select, void *output
+) {
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_FIND_ONE, query);
+
+	unsigned int retval = mongo_find_one (model, query, select, output);
+
+	db_timer_end (&timer);
+
+	return retval;
+
+}
+
+unsigned int db_model_find_one_with_opts (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const bson_t *opts, void *output
+) {
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_FIND_ONE, query);
+
+	unsigned int retval = mongo_find_one_with_opts (
+		model, query, opts, output
+	);
+
+	db_timer_end (&timer);
+
+	return retval;
+
+}
+
+// finds the first document that matches the query & writes it
+// with the shape into the current thread's output buffer
+unsigned int db_model_find_one_with_opts_to_output (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const bson_t *opts, const PocketOutputShape *shape,
+	const char **json, size_t *json_len
+) {
+
+	unsigned int retval = 1;
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_FIND_ONE, query);
+
+	mongoc_cursor_t *cursor = mongo_find_all_cursor_with_opts (
+		model, query, opts
+	);
+
+	const bson_t *doc = NULL;
+	const bool found = cursor && mongoc_cursor_next (cursor, &doc);
+
+	db_timer_end (&timer);
+
+	if (found) {
+		*json = pocket_output_doc (shape, doc, json_len);
+		if (*json) retval = 0;
+	}
+
+	if (cursor) mongoc_cursor_destroy (cursor);
+
+	return retval;
+
+}
+
+unsigned int db_model_find_all_to_json (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const bson_t *opts, const char *array_name,
+	char **json, size_t *json_len
+) {
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_FIND_JSON, query);
+
+	unsigned int retval = mongo_find_all_to_json (
+		model, query, opts, array_name, json, json_len
+	);
+
+	db_timer_end (&timer);
+
+	return retval;
+
+}
+
+bool db_model_check (
+	const DbCollection collection, CMongoModel *model, bson_t *query
+) {
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_CHECK, query);
+
+	bool retval = mongo_check (model, query);
+
+	db_timer_end (&timer);
+
+	return retval;
+
+}
+
+unsigned int db_model_insert_one (
+	const DbCollection collection, CMongoModel *model, bson_t *doc
+) {
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_INSERT_ONE, NULL);
+
+	unsigned int retval = mongo_insert_one (model, doc);
+
+	db_timer_end (&timer);
+
+	return retval;
+
+}
+
+unsigned int db_model_update_one (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, bson_t *update
+) {
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_UPDATE_ONE, query);
+
+	unsigned int retval = mongo_update_one (model, query, update);
+
+	db_timer_end (&timer);
+
+	return retval;
+
+}
+
+// keeps the cursor's timer until it is destroyed
+// if every slot is taken, the cursor is not timed
+static void db_cursor_track (
+	const mongoc_cursor_t *cursor, const DbTimer *timer
+) {
+
+	if (cursor) {
+		for (unsigned int idx = 0; idx < DB_CURSORS_MAX; idx++) {
+			if (!db_cursors[idx].cursor) {
+				db_cursors[idx].cursor = cursor;
+				db_cursors[idx].timer = *timer;
+				db_cursors[idx].elapsed = pocket_metrics_now () - timer->start;
+				break;
+			}
+		}
+	}
+
+}
+
+static DbCursorTimer *db_cursor_timer_get (const mongoc_cursor_t *cursor) {
+
+	DbCursorTimer *cursor_timer = NULL;
+
+	for (unsigned int idx = 0; cursor && (idx < DB_CURSORS_MAX); idx++) {
+		if (db_cursors[idx].cursor == cursor) {
+			cursor_timer = &db_cursors[idx];
+			break;
+		}
+	}
+
+	return cursor_timer;
+
+}
+
+mongoc_cursor_t *db_model_find_all_cursor (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const CMongoSelect *select, uint64_t *n_docs
+) {
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_FIND, query);
+
+	mongoc_cursor_t *cursor = mongo_find_all_cursor (
+		model, query, select, n_docs
+	);
+
+	db_cursor_track (cursor, &timer);
+
+	return cursor;
+
+}
+
+mongoc_cursor_t *db_model_find_all_cursor_with_opts (
+	const DbCollection collection, CMongoModel *model,
+	bson_t *query, const bson_t *opts
+) {
+
+	DbTimer timer = { 0 };
+	db_timer_start (&timer, collection, DB_OPERATION_FIND, query);
+
+	mongoc_cursor_t *cursor = mongo_find_all_cursor_with_opts (
+		model, query, opts
+	);
+
+	db_cursor_track (cursor, &timer);
+
+	return cursor;
+
+}
+
+// gets the next document from a cursor, timing it if it was tracked
+bool db_cursor_next (mongoc_cursor_t *cursor, const bson_t **doc) {
+
+	bool next = false;
+
+	DbCursorTimer *cursor_timer = db_cursor_timer_get (cursor);
+	if (cursor_timer) {
+		const int64_t start = pocket_metrics_now ();
+		next = mongoc_cursor_next (cursor, doc);
+		cursor_timer->elapsed += pocket_metrics_now () - start;
+	}
+
+	else {
+		next = mongoc_cursor_next (cursor, doc);
+	}
+
+	return next;
+
+}
+
+// records the cursor's operation, if it was tracked, & destroys it
+void db_cursor_destroy (mongoc_cursor_t *cursor) {
+
+	if (cursor) {
+		DbCursorTimer *cursor_timer = db_cursor_timer_get (cursor);
+		if (cursor_timer) {
+			db_timer_record (&cursor_timer->timer, cursor_timer->elapsed);
+			cursor_timer->cursor = NULL;
+		}
+
+		mongoc_cursor_destroy (cursor);
+	}
+
+}
@@ -48,6 +48,10 @@ void pocket_error_send_response (
 			(void) http_response_send (server_error, http_receive);
 			break;
 
+		case POCKET_ERROR_LIMITED:
+			(void) http_response_send (too_many_requests, http_receive);
+			break;
+
 		default: break;
 	}
 
@@ -0,0 +1,212 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include <pthread.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+#include <cerver/types/string.h>
+
+#include <cerver/http/http.h>
+#include <cerver/http/request.h>
+
+#include <cerver/utils/log.h>
+
+#include "etag.h"
+
+#define POCKET_ETAG_FNV_OFFSET			14695981039346656037ULL
+#define POCKET_ETAG_FNV_PRIME			1099511628211ULL
+
+// changes with every process, so the versions given by
+// another process or before a restart are never matched
+static u32 etag_epoch = 0;
+
+static unsigned int etag_ttl = 0;
+
+static atomic_ullong etag_clock = 0;
+
+static PocketEtagShard *etag_shards = NULL;
+
+static u64 pocket_etag_hash (
+	const PocketEtagKind kind, const void *variant, const size_t variant_len
+) {
+
+	u64 hash = POCKET_ETAG_FNV_OFFSET ^ (u64) kind;
+
+	const unsigned char *bytes = (const unsigned char *) variant;
+	for (size_t idx = 0; idx < variant_len; idx++) {
+		hash = (hash ^ bytes[idx]) * POCKET_ETAG_FNV_PRIME;
+	}
+
+	return hash;
+
+}
+
+unsigned int pocket_etag_init (const unsigned int ttl) {
+
+	unsigned int retval = 1;
+
+	etag_shards = (PocketEtagShard *) calloc (
+		POCKET_ETAG_SHARDS, sizeof (PocketEtagShard)
+	);
+
+	if (etag_shards) {
+		for (unsigned int idx = 0; idx < POCKET_ETAG_SHARDS; idx++) {
+			(void) pthread_mutex_init (&etag_shards[idx].mutex, NULL);
+		}
+
+		// the oid has a random value for each process
+		bson_oid_t epoch_oid = { 0 };
+		bson_oid_init (&epoch_oid, NULL);
+		etag_epoch = bson_oid_hash (&epoch_oid);
+
+		etag_ttl = ttl;
+
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error ("Failed to create etag versions!");
+	}
+
+	return retval;
+
+}
+
+void pocket_etag_end (void) {
+
+	if (etag_shards) {
+		for (unsigned int idx = 0; idx < POCKET_ETAG_SHARDS; idx++) {
+			(void) pthread_mutex_destroy (&etag_shards[idx].mutex);
+		}
+
+		free (etag_shards);
+		etag_shards = NULL;
+	}
+
+}
+
+static inline u64 pocket_etag_clock_next (void) {
+
+	return (u64) atomic_fetch_add_explicit (
+		&etag_clock, 1, memory_order_relaxed
+	) + 1;
+
+}
+
+static PocketEtagSlot *pocket_etag_slot_get (
+	const bson_oid_t *user_oid, PocketEtagShard **shard
+) {
+
+	const u32 hash = bson_oid_hash (user_oid);
+
+	*shard = &etag_shards[hash % POCKET_ETAG_SHARDS];
+
+	return &(*shard)->slots[(hash / POCKET_ETAG_SHARDS) % POCKET_ETAG_SLOTS];
+
+}
+
+// returns the user's version of the kind
+// a user without a slot or with an expired one gets new versions
+static u64 pocket_etag_version (
+	const PocketEtagKind kind, const bson_oid_t *user_oid
+) {
+
+	PocketEtagShard *shard = NULL;
+	PocketEtagSlot *slot = pocket_etag_slot_get (user_oid, &shard);
+
+	const time_t now = time (NULL);
+
+	(void) pthread_mutex_lock (&shard->mutex);
+
+	if (
+		!slot->used
+		|| !bson_oid_equal (&slot->user_oid, user_oid)
+		|| (slot->expires && (slot->expires <= now))
+	) {
+		bson_oid_copy (user_oid, &slot->user_oid);
+		slot->used = true;
+		slot->expires = etag_ttl ? now + etag_ttl : 0;
+
+		for (unsigned int idx = 0; idx < POCKET_ETAG_KINDS; idx++) {
+			slot->versions[idx] = pocket_etag_clock_next ();
+		}
+	}
+
+	const u64 version = slot->versions[kind];
+
+	(void) pthread_mutex_unlock (&shard->mutex);
+
+	return version;
+
+}
+
+// returns the etag written to the buffer, or NULL if the versions
+// were not started & the response must be sent without an etag
+// the buffer must be at least POCKET_ETAG_SIZE bytes
+const char *pocket_etag_get (
+	const PocketEtagKind kind, const bson_oid_t *user_oid,
+	const void *variant, const size_t variant_len,
+	char *etag
+) {
+
+	const char *retval = NULL;
+
+	if (etag_shards) {
+		(void) snprintf (
+			etag, POCKET_ETAG_SIZE,
+			"\"%" PRIx32 "-%" PRIx64 "-%" PRIx64 "\"",
+			etag_epoch,
+			pocket_etag_version (kind, user_oid),
+			pocket_etag_hash (kind, variant, variant_len)
+		);
+
+		retval = etag;
+	}
+
+	return retval;
+
+}
+
+// a user without a slot gets new versions with its next etag
+void pocket_etag_changed (
+	const PocketEtagKind kind, const bson_oid_t *user_oid
+) {
+
+	if (etag_shards) {
+		PocketEtagShard *shard = NULL;
+		PocketEtagSlot *slot = pocket_etag_slot_get (user_oid, &shard);
+
+		(void) pthread_mutex_lock (&shard->mutex);
+
+		if (slot->used && bson_oid_equal (&slot->user_oid, user_oid)) {
+			slot->versions[kind] = pocket_etag_clock_next ();
+		}
+
+		(void) pthread_mutex_unlock (&shard->mutex);
+	}
+
+}
+
+// returns true if the request's If-None-Match header matches the etag
+bool pocket_etag_match (
+	const HttpRequest *request, const char *etag
+) {
+
+	bool match = false;
+
+	const String *if_none_match = request->headers[HTTP_HEADER_IF_NONE_MATCH];
+	if (etag && if_none_match && if_none_match->str) {
+		// the header can have a list of etags or be a wildcard
+		match = !strcmp (if_none_match->str, "*")
+			|| (strstr (if_none_match->str, etag) != NULL);
+	}
+
+	return match;
+
+}
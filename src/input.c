@@ -0,0 +1,857 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+
+#include "arena.h"
+#include "input.h"
+
+#define POCKET_INPUT_REPLACEMENT			0xFFFD
+
+const char *pocket_input_type_to_string (const PocketInputType type) {
+
+	switch (type) {
+		#define XX(num, name, string) case POCKET_INPUT_TYPE_##name: return #string;
+		POCKET_INPUT_TYPE_MAP(XX)
+		#undef XX
+
+		default: break;
+	}
+
+	return pocket_input_type_to_string (POCKET_INPUT_TYPE_NONE);
+
+}
+
+// fnv-1a with the seed in its offset & a final mix for the low bits
+static u32 pocket_input_hash (
+	const char *key, const size_t key_len, const u32 seed
+) {
+
+	u32 hash = 2166136261u ^ seed;
+	for (size_t idx = 0; idx < key_len; idx++) {
+		hash ^= (u8) key[idx];
+		hash *= 16777619u;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+
+	return hash;
+
+}
+
+// finds a seed that gives each of the schema's keys its own slot
+// returns 0 on success, 1 on error
+unsigned int pocket_input_schema_init (PocketInputSchema *schema) {
+
+	unsigned int retval = 1;
+
+	size_t n_keys = 0;
+	while ((n_keys < POCKET_INPUT_KEYS_MAX) && schema->keys[n_keys]) {
+		schema->lens[n_keys] = strlen (schema->keys[n_keys]);
+		n_keys += 1;
+	}
+
+	if (!schema->keys[n_keys]) {
+		bool found = false;
+		for (u32 seed = 0; !found && (seed < POCKET_INPUT_SEEDS_MAX); seed++) {
+			(void) memset (schema->table, 0, POCKET_INPUT_TABLE_SIZE);
+
+			found = true;
+			for (size_t idx = 0; found && (idx < n_keys); idx++) {
+				u32 slot = pocket_input_hash (
+					schema->keys[idx], schema->lens[idx], seed
+				) & (POCKET_INPUT_TABLE_SIZE - 1);
+
+				if (schema->table[slot]) found = false;
+				else schema->table[slot] = (u8) (idx + 1);
+			}
+
+			if (found) {
+				schema->seed = seed;
+				retval = 0;
+			}
+		}
+	}
+
+	return retval;
+
+}
+
+// returns the key's index or -1 if it is not in the schema
+// keys are compared as they are written, without unescaping them
+int pocket_input_schema_find (
+	const PocketInputSchema *schema, const char *key, const size_t key_len
+) {
+
+	int retval = -1;
+
+	u8 entry = schema->table[
+		pocket_input_hash (key, key_len, schema->seed) & (POCKET_INPUT_TABLE_SIZE - 1)
+	];
+
+	if (entry) {
+		size_t idx = entry - 1;
+		if (
+			(schema->lens[idx] == key_len)
+			&& !memcmp (schema->keys[idx], key, key_len)
+		) {
+			retval = (int) idx;
+		}
+	}
+
+	return retval;
+
+}
+
+void pocket_input_init (
+	PocketInput *input, const char *data, const size_t data_len
+) {
+
+	input->pos = data;
+	input->end = data + data_len;
+
+	input->first = true;
+	input->error = false;
+
+}
+
+static inline bool pocket_input_is_digit (const char c) {
+
+	return (c >= '0') && (c <= '9');
+
+}
+
+static inline bool pocket_input_is_hex (const char c) {
+
+	return pocket_input_is_digit (c)
+		|| ((c >= 'a') && (c <= 'f'))
+		|| ((c >= 'A') && (c <= 'F'));
+
+}
+
+static u32 pocket_input_hex4 (const char *str) {
+
+	u32 value = 0;
+	for (unsigned int idx = 0; idx < 4; idx++) {
+		const char c = str[idx];
+		value <<= 4;
+		if (pocket_input_is_digit (c)) value |= (u32) (c - '0');
+		else if ((c >= 'a') && (c <= 'f')) value |= (u32) (c - 'a' + 10);
+		else value |= (u32) (c - 'A' + 10);
+	}
+
+	return value;
+
+}
+
+// returns the next char after any whitespace or 0 at the end
+static char pocket_input_peek (PocketInput *input) {
+
+	while (
+		(input->pos < input->end)
+		&& (
+			(*input->pos == ' ') || (*input->pos == '\t')
+			|| (*input->pos == '\n') || (*input->pos == '\r')
+		)
+	) {
+		input->pos += 1;
+	}
+
+	return (input->pos < input->end) ? *input->pos : '\0';
+
+}
+
+static bool pocket_input_expect (PocketInput *input, const char c) {
+
+	bool retval = false;
+
+	if (pocket_input_peek (input) == c) {
+		input->pos += 1;
+		retval = true;
+	}
+
+	return retval;
+
+}
+
+// returns the length of the escape sequence or 0 if it is not valid
+static size_t pocket_input_escape_len (const char *str, const char *end) {
+
+	size_t len = 0;
+
+	if ((str + 1) < end) {
+		switch (str[1]) {
+			case '"': case '\\': case '/':
+			case 'b': case 'f': case 'n': case 'r': case 't':
+				len = 2;
+				break;
+
+			// \u0000 would cut the string where it is stored
+			case 'u':
+				if (
+					((str + 6) <= end)
+					&& pocket_input_is_hex (str[2]) && pocket_input_is_hex (str[3])
+					&& pocket_input_is_hex (str[4]) && pocket_input_is_hex (str[5])
+					&& pocket_input_hex4 (str + 2)
+				) {
+					len = 6;
+				}
+				break;
+
+			default: break;
+		}
+	}
+
+	return len;
+
+}
+
+// returns the length of the utf-8 sequence that starts with a byte
+// over 0x7F or 0 if it is not valid, overlong encodings, surrogates
+// & values over U+10FFFF are not valid
+static size_t pocket_input_utf8_len (const char *str, const char *end) {
+
+	size_t len = 0;
+
+	const u8 c = (u8) str[0];
+
+	// the valid range of the second byte
+	u8 min = 0x80;
+	u8 max = 0xBF;
+
+	if ((c >= 0xC2) && (c <= 0xDF)) len = 2;
+	else if (c == 0xE0) { len = 3; min = 0xA0; }
+	else if (c == 0xED) { len = 3; max = 0x9F; }
+	else if ((c >= 0xE1) && (c <= 0xEF)) len = 3;
+	else if (c == 0xF0) { len = 4; min = 0x90; }
+	else if (c == 0xF4) { len = 4; max = 0x8F; }
+	else if ((c >= 0xF1) && (c <= 0xF3)) len = 4;
+
+	if (len && ((str + len) <= end)) {
+		if (((u8) str[1] < min) || ((u8) str[1] > max)) len = 0;
+
+		for (size_t idx = 2; len && (idx < len); idx++) {
+			if (((u8) str[idx] & 0xC0) != 0x80) len = 0;
+		}
+	}
+
+	else {
+		len = 0;
+	}
+
+	return len;
+
+}
+
+// the input must be at the opening quote
+// strings with invalid utf-8 are not valid
+static unsigned int pocket_input_read_string (
+	PocketInput *input, PocketInputValue *value
+) {
+
+	unsigned int retval = 1;
+
+	input->pos += 1;
+
+	value->type = POCKET_INPUT_TYPE_STRING;
+	value->str = input->pos;
+	value->escaped = false;
+
+	bool done = false;
+	bool bad = false;
+	size_t escape_len = 0;
+	size_t utf8_len = 0;
+	while (!done && !bad && (input->pos < input->end)) {
+		if (*input->pos == '"') {
+			value->len = (size_t) (input->pos - value->str);
+			input->pos += 1;
+			done = true;
+		}
+
+		else if (*input->pos == '\\') {
+			escape_len = pocket_input_escape_len (input->pos, input->end);
+			if (escape_len) {
+				value->escaped = true;
+				input->pos += escape_len;
+			}
+
+			else {
+				bad = true;
+			}
+		}
+
+		else if ((u8) *input->pos < 0x20) {
+			bad = true;
+		}
+
+		else if ((u8) *input->pos > 0x7F) {
+			utf8_len = pocket_input_utf8_len (input->pos, input->end);
+			if (utf8_len) input->pos += utf8_len;
+			else bad = true;
+		}
+
+		else {
+			input->pos += 1;
+		}
+	}
+
+	if (done) retval = 0;
+
+	return retval;
+
+}
+
+static unsigned int pocket_input_read_digits (PocketInput *input) {
+
+	const char *start = input->pos;
+	while ((input->pos < input->end) && pocket_input_is_digit (*input->pos)) {
+		input->pos += 1;
+	}
+
+	return (input->pos > start) ? 0 : 1;
+
+}
+
+// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+static unsigned int pocket_input_read_number (
+	PocketInput *input, PocketInputValue *value
+) {
+
+	unsigned int errors = 0;
+
+	const char *start = input->pos;
+
+	if (*input->pos == '-') input->pos += 1;
+
+	if ((input->pos < input->end) && (*input->pos == '0')) input->pos += 1;
+	else errors |= pocket_input_read_digits (input);
+
+	if (!errors && (input->pos < input->end) && (*input->pos == '.')) {
+		input->pos += 1;
+		errors |= pocket_input_read_digits (input);
+	}
+
+	if (
+		!errors && (input->pos < input->end)
+		&& ((*input->pos == 'e') || (*input->pos == 'E'))
+	) {
+		input->pos += 1;
+		if (
+			(input->pos < input->end)
+			&& ((*input->pos == '+') || (*input->pos == '-'))
+		) {
+			input->pos += 1;
+		}
+
+		errors |= pocket_input_read_digits (input);
+	}
+
+	const size_t len = (size_t) (input->pos - start);
+	if (!errors && (len < POCKET_INPUT_NUMBER_SIZE)) {
+		// the body might not be terminated after the number
+		char number[POCKET_INPUT_NUMBER_SIZE] = { 0 };
+		(void) memcpy (number, start, len);
+
+		value->type = POCKET_INPUT_TYPE_NUMBER;
+		value->str = start;
+		value->len = len;
+		value->number = strtod (number, NULL);
+	}
+
+	else {
+		errors |= 1;
+	}
+
+	return errors;
+
+}
+
+static unsigned int pocket_input_read_literal (
+	PocketInput *input, PocketInputValue *value,
+	const char *literal, const size_t literal_len,
+	const PocketInputType type
+) {
+
+	unsigned int retval = 1;
+
+	if (
+		((size_t) (input->end - input->pos) >= literal_len)
+		&& !memcmp (input->pos, literal, literal_len)
+	) {
+		value->type = type;
+		value->str = input->pos;
+		value->len = literal_len;
+
+		input->pos += literal_len;
+
+		retval = 0;
+	}
+
+	return retval;
+
+}
+
+static unsigned int pocket_input_read_value (
+	PocketInput *input, PocketInputValue *value, const unsigned int depth
+);
+
+static unsigned int pocket_input_skip_object (
+	PocketInput *input, const unsigned int depth
+) {
+
+	unsigned int errors = 0;
+
+	PocketInputValue member = { 0 };
+
+	bool first = true;
+	while (!errors && !pocket_input_expect (input, '}')) {
+		if (
+			(first || pocket_input_expect (input, ','))
+			&& (pocket_input_peek (input) == '"')
+			&& !pocket_input_read_string (input, &member)
+			&& pocket_input_expect (input, ':')
+		) {
+			errors |= pocket_input_read_value (input, &member, depth);
+		}
+
+		else {
+			errors |= 1;
+		}
+
+		first = false;
+	}
+
+	return errors;
+
+}
+
+static unsigned int pocket_input_skip_array (
+	PocketInput *input, const unsigned int depth
+) {
+
+	unsigned int errors = 0;
+
+	PocketInputValue element = { 0 };
+
+	bool first = true;
+	while (!errors && !pocket_input_expect (input, ']')) {
+		if (first || pocket_input_expect (input, ',')) {
+			errors |= pocket_input_read_value (input, &element, depth);
+		}
+
+		else {
+			errors |= 1;
+		}
+
+		first = false;
+	}
+
+	return errors;
+
+}
+
+static unsigned int pocket_input_read_value (
+	PocketInput *input, PocketInputValue *value, const unsigned int depth
+) {
+
+	unsigned int retval = 1;
+
+	(void) memset (value, 0, sizeof (PocketInputValue));
+
+	const char c = pocket_input_peek (input);
+	switch (c) {
+		case '"': retval = pocket_input_read_string (input, value); break;
+
+		case '{':
+			if (depth < POCKET_INPUT_DEPTH_MAX) {
+				input->pos += 1;
+				value->type = POCKET_INPUT_TYPE_OBJECT;
+				retval = pocket_input_skip_object (input, depth + 1);
+			}
+			break;
+
+		case '[':
+			if (depth < POCKET_INPUT_DEPTH_MAX) {
+				input->pos += 1;
+				value->type = POCKET_INPUT_TYPE_ARRAY;
+				retval = pocket_input_skip_array (input, depth + 1);
+			}
+			break;
+
+		case 't':
+			retval = pocket_input_read_literal (
+				input, value, "true", 4, POCKET_INPUT_TYPE_TRUE
+			);
+			break;
+
+		case 'f':
+			retval = pocket_input_read_literal (
+				input, value, "false", 5, POCKET_INPUT_TYPE_FALSE
+			);
+			break;
+
+		case 'n':
+			retval = pocket_input_read_literal (
+				input, value, "null", 4, POCKET_INPUT_TYPE_NULL
+			);
+			break;
+
+		default:
+			if ((c == '-') || pocket_input_is_digit (c)) {
+				retval = pocket_input_read_number (input, value);
+			}
+			break;
+	}
+
+	if (retval) input->error = true;
+
+	return retval;
+
+}
+
+// returns true if the next value is an object & enters it
+bool pocket_input_object_begin (PocketInput *input) {
+
+	bool retval = false;
+
+	if (!input->error && pocket_input_expect (input, '{')) {
+		input->first = true;
+		retval = true;
+	}
+
+	return retval;
+
+}
+
+// reads the object's next member & returns true,
+// or returns false when the object ends or on error
+// key is the index of the member's key in the schema or -1
+bool pocket_input_object_next (
+	PocketInput *input, const PocketInputSchema *schema,
+	int *key, PocketInputValue *value
+) {
+
+	bool retval = false;
+
+	PocketInputValue key_value = { 0 };
+
+	if (!input->error) {
+		// the object is a value of its parent
+		if (pocket_input_expect (input, '}')) {
+			input->first = false;
+		}
+
+		else if (
+			(input->first || pocket_input_expect (input, ','))
+			&& (pocket_input_peek (input) == '"')
+			&& !pocket_input_read_string (input, &key_value)
+			&& pocket_input_expect (input, ':')
+			&& !pocket_input_read_value (input, value, 1)
+		) {
+			*key = pocket_input_schema_find (
+				schema, key_value.str, key_value.len
+			);
+
+			input->first = false;
+			retval = true;
+		}
+
+		else {
+			input->error = true;
+		}
+	}
+
+	return retval;
+
+}
+
+// returns true if the next value is an array & enters it
+bool pocket_input_array_begin (PocketInput *input) {
+
+	bool retval = false;
+
+	if (!input->error && pocket_input_expect (input, '[')) {
+		input->first = true;
+		retval = true;
+	}
+
+	return retval;
+
+}
+
+// returns true if the array has another value, that must be read
+// next with pocket_input_object_begin () or pocket_input_skip ()
+// returns false when the array ends or on error
+bool pocket_input_array_next (PocketInput *input) {
+
+	bool retval = false;
+
+	if (!input->error) {
+		if (pocket_input_expect (input, ']')) {
+			input->first = false;
+		}
+
+		else if (input->first || pocket_input_expect (input, ',')) {
+			input->first = false;
+			retval = true;
+		}
+
+		else {
+			input->error = true;
+		}
+	}
+
+	return retval;
+
+}
+
+// reads the next value without keeping it
+// returns 0 on success, 1 on error
+unsigned int pocket_input_skip (PocketInput *input) {
+
+	PocketInputValue value = { 0 };
+
+	return input->error ? 1 : pocket_input_read_value (input, &value, 1);
+
+}
+
+// returns true if the whole body was read without errors
+bool pocket_input_end (PocketInput *input) {
+
+	return !input->error
+		&& !pocket_input_peek (input)
+		&& (input->pos == input->end);
+
+}
+
+static size_t pocket_input_utf8_encode (u32 code, char *utf8) {
+
+	size_t len = 0;
+
+	if (code < 0x80) {
+		utf8[len++] = (char) code;
+	}
+
+	else if (code < 0x800) {
+		utf8[len++] = (char) (0xC0 | (code >> 6));
+		utf8[len++] = (char) (0x80 | (code & 0x3F));
+	}
+
+	else if (code < 0x10000) {
+		utf8[len++] = (char) (0xE0 | (code >> 12));
+		utf8[len++] = (char) (0x80 | ((code >> 6) & 0x3F));
+		utf8[len++] = (char) (0x80 | (code & 0x3F));
+	}
+
+	else {
+		utf8[len++] = (char) (0xF0 | (code >> 18));
+		utf8[len++] = (char) (0x80 | ((code >> 12) & 0x3F));
+		utf8[len++] = (char) (0x80 | ((code >> 6) & 0x3F));
+		utf8[len++] = (char) (0x80 | (code & 0x3F));
+	}
+
+	return len;
+
+}
+
+// decodes a \uXXXX sequence, with its low surrogate if it has one
+// lone surrogates are replaced with U+FFFD
+static u32 pocket_input_unescape_unicode (
+	const char *str, const size_t len, size_t *consumed
+) {
+
+	u32 code = pocket_input_hex4 (str + 2);
+	*consumed = 6;
+
+	if ((code >= 0xD800) && (code <= 0xDBFF)) {
+		u32 low = 0;
+		if (
+			(len >= 12) && (str[6] == '\\') && (str[7] == 'u')
+			&& ((low = pocket_input_hex4 (str + 8)) >= 0xDC00)
+			&& (low <= 0xDFFF)
+		) {
+			code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+			*consumed = 12;
+		}
+
+		else {
+			code = POCKET_INPUT_REPLACEMENT;
+		}
+	}
+
+	else if ((code >= 0xDC00) && (code <= 0xDFFF)) {
+		code = POCKET_INPUT_REPLACEMENT;
+	}
+
+	return code;
+
+}
+
+// the escapes were already checked when the string was read
+static size_t pocket_input_unescape (
+	const char *str, const size_t len, char *buffer, const size_t max
+) {
+
+	size_t copied = 0;
+
+	char utf8[4] = { 0 };
+	size_t utf8_len = 0;
+	size_t consumed = 0;
+
+	size_t idx = 0;
+	bool full = false;
+	while (!full && (idx < len)) {
+		if (str[idx] != '\\') {
+			utf8[0] = str[idx];
+			utf8_len = 1;
+			consumed = 1;
+		}
+
+		else {
+			utf8_len = 1;
+			consumed = 2;
+			switch (str[idx + 1]) {
+				case 'b': utf8[0] = '\b'; break;
+				case 'f': utf8[0] = '\f'; break;
+				case 'n': utf8[0] = '\n'; break;
+				case 'r': utf8[0] = '\r'; break;
+				case 't': utf8[0] = '\t'; break;
+
+				case 'u':
+					utf8_len = pocket_input_utf8_encode (
+						pocket_input_unescape_unicode (
+							str + idx, len - idx, &consumed
+						),
+						utf8
+					);
+					break;
+
+				default: utf8[0] = str[idx + 1]; break;
+			}
+		}
+
+		// a char is never split when the string is truncated
+		if ((copied + utf8_len) <= max) {
+			(void) memcpy (buffer + copied, utf8, utf8_len);
+			copied += utf8_len;
+			idx += consumed;
+		}
+
+		else {
+			full = true;
+		}
+	}
+
+	return copied;
+
+}
+
+// the length of the string cut to at most max bytes without splitting a char
+static size_t pocket_input_truncate (
+	const char *str, const size_t len, const size_t max
+) {
+
+	size_t truncated = len;
+
+	if (len > max) {
+		truncated = max;
+		while (truncated && (((u8) str[truncated] & 0xC0) == 0x80)) {
+			truncated -= 1;
+		}
+	}
+
+	return truncated;
+
+}
+
+// copies the unescaped string, truncated to fit in the buffer
+// returns the number of bytes that were copied
+size_t pocket_input_string_copy (
+	const PocketInputValue *value, char *buffer, const size_t buffer_size
+) {
+
+	size_t copied = 0;
+
+	if (buffer_size) {
+		if (value->type == POCKET_INPUT_TYPE_STRING) {
+			if (value->escaped) {
+				copied = pocket_input_unescape (
+					value->str, value->len, buffer, buffer_size - 1
+				);
+			}
+
+			else {
+				copied = pocket_input_truncate (
+					value->str, value->len, buffer_size - 1
+				);
+
+				(void) memcpy (buffer, value->str, copied);
+			}
+		}
+
+		buffer[copied] = '\0';
+	}
+
+	return copied;
+
+}
+
+// sets the view to the string in the body if it has no escapes,
+// or to an unescaped copy in the arena, truncated to max_len bytes
+// returns false if the value is not a string or on error
+bool pocket_input_string_view (
+	const PocketInputValue *value, PocketArena *arena,
+	const size_t max_len, PocketStr *view
+) {
+
+	bool retval = false;
+
+	if (value->type == POCKET_INPUT_TYPE_STRING) {
+		if (!value->escaped) {
+			view->str = value->str;
+			view->len = pocket_input_truncate (value->str, value->len, max_len);
+
+			retval = true;
+		}
+
+		else {
+			// an escaped string is never longer than its source
+			const size_t size = ((value->len < max_len) ? value->len : max_len) + 1;
+
+			char *copy = (char *) pocket_arena_alloc (arena, size);
+			if (copy) {
+				view->str = copy;
+				view->len = pocket_input_string_copy (value, copy, size);
+
+				retval = true;
+			}
+		}
+	}
+
+	return retval;
+
+}
+
+// returns true if the value is a valid oid string & sets the oid
+bool pocket_input_oid (
+	const PocketInputValue *value, bson_oid_t *oid
+) {
+
+	bool retval = false;
+
+	if (
+		(value->type == POCKET_INPUT_TYPE_STRING)
+		&& !value->escaped
+		&& bson_oid_is_valid (value->str, value->len)
+	) {
+		bson_oid_init_from_string (oid, value->str);
+		retval = true;
+	}
+
+	return retval;
+
+}
@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <pthread.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+
+#include <cerver/connection.h>
+#include <cerver/handler.h>
+#include <cerver/socket.h>
+
+#include <cerver/http/http.h>
+#include <cerver/http/response.h>
+
+#include <cerver/utils/log.h>
+
+#include "db.h"
+#include "limiter.h"
+#include "metrics.h"
+
+#include "controllers/service.h"
+
+#define POCKET_LIMITER_KEY_OID			1
+#define POCKET_LIMITER_KEY_ADDRESS		2
+
+static PocketLimiter *auth_limiter = NULL;
+static PocketLimiter *write_limiter = NULL;
+
+// fnv-1a with a final mix to spread keys between shards & buckets
+static u64 pocket_limiter_hash (
+	const u64 type, const unsigned char *data, const size_t data_len
+) {
+
+	u64 hash = 14695981039346656037ULL ^ type;
+	for (size_t idx = 0; idx < data_len; idx++) {
+		hash ^= data[idx];
+		hash *= 1099511628211ULL;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+
+	return hash;
+
+}
+
+// rate is in requests per minute, burst is the max tokens of a bucket
+PocketLimiter *pocket_limiter_create (
+	const unsigned int rate, const unsigned int burst
+) {
+
+	PocketLimiter *limiter = (PocketLimiter *) calloc (1, sizeof (PocketLimiter));
+	if (limiter) {
+		limiter->rate = (double) rate / (60 * 1000);
+		limiter->burst = burst ? (double) burst : 1;
+
+		for (unsigned int idx = 0; idx < POCKET_LIMITER_SHARDS; idx++) {
+			(void) pthread_mutex_init (&limiter->shards[idx].mutex, NULL);
+		}
+	}
+
+	return limiter;
+
+}
+
+void pocket_limiter_delete (PocketLimiter *limiter) {
+
+	if (limiter) {
+		for (unsigned int idx = 0; idx < POCKET_LIMITER_SHARDS; idx++) {
+			(void) pthread_mutex_destroy (&limiter->shards[idx].mutex);
+		}
+
+		free (limiter);
+	}
+
+}
+
+void pocket_limiter_get_stats (
+	PocketLimiter *limiter, PocketLimiterStats *stats
+) {
+
+	stats->allowed = 0;
+	stats->limited = 0;
+
+	PocketLimiterShard *shard = NULL;
+	for (unsigned int idx = 0; idx < POCKET_LIMITER_SHARDS; idx++) {
+		shard = &limiter->shards[idx];
+
+		(void) pthread_mutex_lock (&shard->mutex);
+
+		stats->allowed += shard->allowed;
+		stats->limited += shard->limited;
+
+		(void) pthread_mutex_unlock (&shard->mutex);
+	}
+
+}
+
+// returns the key's bucket in the set, or the least recently used one
+// that is taken for the key with its tokens refilled until now
+static PocketLimiterBucket *pocket_limiter_bucket_get (
+	PocketLimiter *limiter, PocketLimiterBucket *set,
+	const u64 key, const int64_t now
+) {
+
+	PocketLimiterBucket *bucket = NULL;
+	PocketLimiterBucket *oldest = &set[0];
+	for (unsigned int idx = 0; idx < POCKET_LIMITER_WAYS; idx++) {
+		if (set[idx].key == key) {
+			bucket = &set[idx];
+			break;
+		}
+
+		if (set[idx].updated < oldest->updated) oldest = &set[idx];
+	}
+
+	if (!bucket) {
+		bucket = oldest;
+
+		// an unused bucket starts full
+		if (!bucket->key) bucket->tokens = limiter->burst;
+
+		bucket->key = key;
+	}
+
+	bucket->tokens += (double) (now - bucket->updated) * limiter->rate;
+	if (bucket->tokens > limiter->burst) bucket->tokens = limiter->burst;
+
+	bucket->updated = now;
+
+	return bucket;
+
+}
+
+// takes cost tokens from the key's bucket, a cost bigger
+// than the limiter's burst is never allowed
+// returns true if the request is allowed
+bool pocket_limiter_take (
+	PocketLimiter *limiter, const u64 key, const unsigned int cost
+) {
+
+	bool allowed = false;
+
+	PocketLimiterShard *shard = &limiter->shards[key % POCKET_LIMITER_SHARDS];
+	PocketLimiterBucket *set = &shard->buckets[
+		((key / POCKET_LIMITER_SHARDS) % POCKET_LIMITER_SETS) * POCKET_LIMITER_WAYS
+	];
+
+	const int64_t now = db_now ();
+
+	(void) pthread_mutex_lock (&shard->mutex);
+
+	PocketLimiterBucket *bucket = pocket_limiter_bucket_get (
+		limiter, set, key, now
+	);
+
+	if (bucket->tokens >= (double) cost) {
+		bucket->tokens -= (double) cost;
+		allowed = true;
+		shard->allowed += 1;
+	}
+
+	else {
+		shard->limited += 1;
+	}
+
+	(void) pthread_mutex_unlock (&shard->mutex);
+
+	return allowed;
+
+}
+
+u64 pocket_limiter_key_oid (const bson_oid_t *oid) {
+
+	return pocket_limiter_hash (
+		POCKET_LIMITER_KEY_OID, oid->bytes, sizeof (oid->bytes)
+	);
+
+}
+
+// uses the connection's peer address
+u64 pocket_limiter_key_address (const HttpReceive *http_receive) {
+
+	u64 key = 0;
+
+	struct sockaddr_storage address = { 0 };
+	socklen_t address_len = sizeof (struct sockaddr_storage);
+	if (!getpeername (
+		http_receive->cr->connection->socket->sock_fd,
+		(struct sockaddr *) &address, &address_len
+	)) {
+		switch (address.ss_family) {
+			case AF_INET: {
+				const struct sockaddr_in *in = (const struct sockaddr_in *) &address;
+				key = pocket_limiter_hash (
+					POCKET_LIMITER_KEY_ADDRESS,
+					(const unsigned char *) &in->sin_addr, sizeof (in->sin_addr)
+				);
+			} break;
+
+			case AF_INET6: {
+				const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *) &address;
+
+				// mapped ipv4 addresses share the key of their ipv4 address
+				if (IN6_IS_ADDR_V4MAPPED (&in6->sin6_addr)) {
+					key = pocket_limiter_hash (
+						POCKET_LIMITER_KEY_ADDRESS,
+						in6->sin6_addr.s6_addr + 12, sizeof (struct in_addr)
+					);
+				}
+
+				// a client usually gets a whole /64 to pick addresses from
+				else {
+					key = pocket_limiter_hash (
+						POCKET_LIMITER_KEY_ADDRESS,
+						in6->sin6_addr.s6_addr, POCKET_LIMITER_IPV6_PREFIX
+					);
+				}
+			} break;
+
+			default: break;
+		}
+	}
+
+	return key;
+
+}
+
+// creates the auth & write limiters, a rate of 0 disables them
+// returns 0 on success, 1 on error
+unsigned int pocket_limits_init (
+	const unsigned int auth_rate, const unsigned int auth_burst,
+	const unsigned int write_rate, const unsigned int write_burst
+) {
+
+	unsigned int errors = 0;
+
+	if (auth_rate) {
+		auth_limiter = pocket_limiter_create (auth_rate, auth_burst);
+		if (auth_limiter) pocket_metrics_register_limiter ("auth", auth_limiter);
+		else errors |= 1;
+	}
+
+	if (write_rate) {
+		write_limiter = pocket_limiter_create (write_rate, write_burst);
+		if (write_limiter) pocket_metrics_register_limiter ("write", write_limiter);
+		else errors |= 1;
+	}
+
+	if (errors) {
+		cerver_log_error ("Failed to create rate limiters!");
+	}
+
+	return errors;
+
+}
+
+void pocket_limits_end (void) {
+
+	pocket_limiter_delete (auth_limiter);
+	auth_limiter = NULL;
+
+	pocket_limiter_delete (write_limiter);
+	write_limiter = NULL;
+
+}
+
+// checks the client's address before a login or register
+// sends back a 429 & returns true if the request is limited
+bool pocket_limit_auth (const HttpReceive *http_receive) {
+
+	bool limited = false;
+
+	if (auth_limiter) {
+		const u64 key = pocket_limiter_key_address (http_receive);
+		if (key && !pocket_limiter_take (auth_limiter, key, 1)) {
+			(void) http_response_send (too_many_requests, http_receive);
+			limited = true;
+		}
+	}
+
+	return limited;
+
+}
+
+// takes cost tokens from the user's bucket
+// returns true if the request is limited
+static bool pocket_limit_write_take (
+	const bson_oid_t *user_oid, const unsigned int cost
+) {
+
+	bool limited = false;
+
+	if (write_limiter && cost) {
+		limited = !pocket_limiter_take (
+			write_limiter, pocket_limiter_key_oid (user_oid), cost
+		);
+	}
+
+	return limited;
+
+}
+
+// checks the user before a write to its values
+// sends back a 429 & returns true if the request is limited
+bool pocket_limit_write (
+	const HttpReceive *http_receive, const bson_oid_t *user_oid
+) {
+
+	bool limited = false;
+
+	if (pocket_limit_write_take (user_oid, 1)) {
+		(void) http_response_send (too_many_requests, http_receive);
+		limited = true;
+	}
+
+	return limited;
+
+}
+
+// takes the tokens of the items after the first one, that was taken
+// by pocket_limit_write () before the request's body was read
+// the whole cost is capped at the burst, so any bulk can be written
+// with a full bucket
+// returns true if the request is limited
+bool pocket_limit_write_items (
+	const bson_oid_t *user_oid, const unsigned int n_items
+) {
+
+	bool limited = false;
+
+	if (write_limiter && (n_items > 1)) {
+		unsigned int cost = n_items;
+		if ((double) cost > write_limiter->burst) {
+			cost = (unsigned int) write_limiter->burst;
+		}
+
+		limited = pocket_limit_write_take (user_oid, cost - 1);
+	}
+
+	return limited;
+
+}
@@ -17,11 +17,14 @@
 #include "pocket.h"
 #include "version.h"
 
+#include "controllers/roles.h"
 #include "controllers/users.h"
 
 #include "routes/categories.h"
 #include "routes/places.h"
+#include "routes/route.h"
 #include "routes/service.h"
+#include "routes/sync.h"
 #include "routes/transactions.h"
 #include "routes/users.h"
 
@@ -46,20 +49,61 @@ void end (int dummy) {
 
 }
 
+// reloads roles & actions without a restart
+static void reload (int dummy) {
+
+	pocket_roles_refresh_request ();
+
+}
+
+// every handler runs with its request arena & is timed as its route
+POCKET_ROUTE_HANDLER (POCKET, pocket_handler)
+POCKET_ROUTE_HANDLER (VERSION, pocket_version_handler)
+POCKET_ROUTE_HANDLER (AUTH, pocket_auth_handler)
+POCKET_ROUTE_HANDLER (METRICS, pocket_metrics_handler)
+POCKET_ROUTE_HANDLER (TRANSACTIONS, pocket_transactions_handler)
+POCKET_ROUTE_HANDLER (TRANSACTION_CREATE, pocket_transaction_create_handler)
+POCKET_ROUTE_HANDLER (TRANSACTIONS_SUMMARY, pocket_transactions_summary_handler)
+POCKET_ROUTE_HANDLER (TRANSACTIONS_BULK, pocket_transactions_bulk_handler)
+POCKET_ROUTE_HANDLER (TRANSACTION_INFO, pocket_transaction_get_handler)
+POCKET_ROUTE_HANDLER (TRANSACTION_UPDATE, pocket_transaction_update_handler)
+POCKET_ROUTE_HANDLER (TRANSACTION_REMOVE, pocket_transaction_delete_handler)
+POCKET_ROUTE_HANDLER (CATEGORIES, pocket_categories_handler)
+POCKET_ROUTE_HANDLER (CATEGORY_CREATE, pocket_category_create_handler)
+POCKET_ROUTE_HANDLER (CATEGORY_INFO, pocket_category_get_handler)
+POCKET_ROUTE_HANDLER (CATEGORY_UPDATE, pocket_category_update_handler)
+POCKET_ROUTE_HANDLER (CATEGORY_REMOVE, pocket_category_delete_handler)
+POCKET_ROUTE_HANDLER (PLACES, pocket_places_handler)
+POCKET_ROUTE_HANDLER (PLACE_CREATE, pocket_place_create_handler)
+POCKET_ROUTE_HANDLER (PLACE_INFO, pocket_place_get_handler)
+POCKET_ROUTE_HANDLER (PLACE_UPDATE, pocket_place_update_handler)
+POCKET_ROUTE_HANDLER (PLACE_REMOVE, pocket_place_delete_handler)
+POCKET_ROUTE_HANDLER (SYNC, pocket_sync_handler)
+POCKET_ROUTE_HANDLER (USERS, users_handler)
+POCKET_ROUTE_HANDLER (USERS_LOGIN, users_login_handler)
+POCKET_ROUTE_HANDLER (USERS_REGISTER, users_register_handler)
+POCKET_ROUTE_HANDLER (CATCH_ALL, pocket_catch_all_handler)
+
 static void pocket_set_pocket_routes (HttpCerver *http_cerver) {
 
 	/* register top level route */
 	// GET /api/pocket
-	HttpRoute *pocket_route = http_route_create (REQUEST_METHOD_GET, "api/pocket", pocket_handler);
+	HttpRoute *pocket_route = http_route_create (REQUEST_METHOD_GET, "api/pocket", pocket_handler_route);
 	http_cerver_route_register (http_cerver, pocket_route);
 
 	/* register pocket children routes */
 	// GET api/pocket/version
-	HttpRoute *pocket_version_route = http_route_create (REQUEST_METHOD_GET, "version", pocket_version_handler);
+	HttpRoute *pocket_version_route = http_route_create (REQUEST_METHOD_GET, "version", pocket_version_handler_route);
 	http_route_child_add (pocket_route, pocket_version_route);
 
+	// GET api/pocket/metrics
+	HttpRoute *pocket_metrics_route = http_route_create (REQUEST_METHOD_GET, "metrics", pocket_metrics_handler_route);
+	http_route_set_auth (pocket_metrics_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
+	http_route_set_decode_data (pocket_metrics_route, pocket_user_parse_from_json, pocket_user_delete);
+	http_route_child_add (pocket_route, pocket_metrics_route);
+
 	// GET api/pocket/auth
-	HttpRoute *pocket_auth_route = http_route_create (REQUEST_METHOD_GET, "auth", pocket_auth_handler);
+	HttpRoute *pocket_auth_route = http_route_create (REQUEST_METHOD_GET, "auth", pocket_auth_handler_route);
 	http_route_set_auth (pocket_auth_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (pocket_auth_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, pocket_auth_route);
@@ -67,28 +111,40 @@ static void pocket_set_pocket_routes (HttpCerver *http_cerver) {
 	/*** transactions ***/
 
 	// GET api/pocket/transactions
-	HttpRoute *transactions_route = http_route_create (REQUEST_METHOD_GET, "transactions", pocket_transactions_handler);
+	HttpRoute *transactions_route = http_route_create (REQUEST_METHOD_GET, "transactions", pocket_transactions_handler_route);
 	http_route_set_auth (transactions_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (transactions_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, transactions_route);
 
 	// POST api/pocket/transactions
-	http_route_set_handler (transactions_route, REQUEST_METHOD_POST, pocket_transaction_create_handler);
+	http_route_set_handler (transactions_route, REQUEST_METHOD_POST, pocket_transaction_create_handler_route);
+
+	// GET api/pocket/transactions/summary
+	HttpRoute *trans_summary_route = http_route_create (REQUEST_METHOD_GET, "transactions/summary", pocket_transactions_summary_handler_route);
+	http_route_set_auth (trans_summary_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
+	http_route_set_decode_data (trans_summary_route, pocket_user_parse_from_json, pocket_user_delete);
+	http_route_child_add (pocket_route, trans_summary_route);
+
+	// POST api/pocket/transactions/bulk
+	HttpRoute *trans_bulk_route = http_route_create (REQUEST_METHOD_POST, "transactions/bulk", pocket_transactions_bulk_handler_route);
+	http_route_set_auth (trans_bulk_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
+	http_route_set_decode_data (trans_bulk_route, pocket_user_parse_from_json, pocket_user_delete);
+	http_route_child_add (pocket_route, trans_bulk_route);
 
 	// GET api/pocket/transactions/:id/info
-	HttpRoute *trans_info_route = http_route_create (REQUEST_METHOD_GET, "transactions/:id/info", pocket_transaction_get_handler);
+	HttpRoute *trans_info_route = http_route_create (REQUEST_METHOD_GET, "transactions/:id/info", pocket_transaction_get_handler_route);
 	http_route_set_auth (trans_info_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (trans_info_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, trans_info_route);
 
 	// PUT api/pocket/transactions/:id/update
-	HttpRoute *trans_update_route = http_route_create (REQUEST_METHOD_PUT, "transactions/:id/update", pocket_transaction_update_handler);
+	HttpRoute *trans_update_route = http_route_create (REQUEST_METHOD_PUT, "transactions/:id/update", pocket_transaction_update_handler_route);
 	http_route_set_auth (trans_update_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (trans_update_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, trans_update_route);
 
 	// DELETE api/pocket/transactions/:id/remove
-	HttpRoute *trans_delete_route = http_route_create (REQUEST_METHOD_DELETE, "transactions/:id/remove", pocket_transaction_delete_handler);
+	HttpRoute *trans_delete_route = http_route_create (REQUEST_METHOD_DELETE, "transactions/:id/remove", pocket_transaction_delete_handler_route);
 	http_route_set_auth (trans_delete_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (trans_delete_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, trans_delete_route);
@@ -96,28 +152,28 @@ static void pocket_set_pocket_routes (HttpCerver *http_cerver) {
 	/*** categories ***/
 
 	// GET api/pocket/categories
-	HttpRoute *categories_route = http_route_create (REQUEST_METHOD_GET, "categories", pocket_categories_handler);
+	HttpRoute *categories_route = http_route_create (REQUEST_METHOD_GET, "categories", pocket_categories_handler_route);
 	http_route_set_auth (categories_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (categories_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, categories_route);
 
 	// POST api/pocket/categories
-	http_route_set_handler (categories_route, REQUEST_METHOD_POST, pocket_category_create_handler);
+	http_route_set_handler (categories_route, REQUEST_METHOD_POST, pocket_category_create_handler_route);
 
 	// GET api/pocket/categories/:id/info
-	HttpRoute *category_info_route = http_route_create (REQUEST_METHOD_GET, "categories/:id/info", pocket_category_get_handler);
+	HttpRoute *category_info_route = http_route_create (REQUEST_METHOD_GET, "categories/:id/info", pocket_category_get_handler_route);
 	http_route_set_auth (category_info_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (category_info_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, category_info_route);
 
 	// PUT api/pocket/categories/:id/update
-	HttpRoute *category_update_route = http_route_create (REQUEST_METHOD_PUT, "categories/:id/update", pocket_category_update_handler);
+	HttpRoute *category_update_route = http_route_create (REQUEST_METHOD_PUT, "categories/:id/update", pocket_category_update_handler_route);
 	http_route_set_auth (category_update_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (category_update_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, category_update_route);
 	
 	// DELETE api/pocket/categories/:id/remove
-	HttpRoute *category_remove_route = http_route_create (REQUEST_METHOD_DELETE, "categories/:id/remove", pocket_category_delete_handler);
+	HttpRoute *category_remove_route = http_route_create (REQUEST_METHOD_DELETE, "categories/:id/remove", pocket_category_delete_handler_route);
 	http_route_set_auth (category_remove_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (category_remove_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, category_remove_route);
@@ -125,48 +181,56 @@ static void pocket_set_pocket_routes (HttpCerver *http_cerver) {
 	/*** places ***/
 
 	// GET api/pocket/places
-	HttpRoute *places_route = http_route_create (REQUEST_METHOD_GET, "places", pocket_places_handler);
+	HttpRoute *places_route = http_route_create (REQUEST_METHOD_GET, "places", pocket_places_handler_route);
 	http_route_set_auth (places_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (places_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, places_route);
 
 	// POST api/pocket/places
-	http_route_set_handler (places_route, REQUEST_METHOD_POST, pocket_place_create_handler);
+	http_route_set_handler (places_route, REQUEST_METHOD_POST, pocket_place_create_handler_route);
 
 	// GET api/pocket/places/:id/info
-	HttpRoute *place_info_route = http_route_create (REQUEST_METHOD_GET, "places/:id/info", pocket_place_get_handler);
+	HttpRoute *place_info_route = http_route_create (REQUEST_METHOD_GET, "places/:id/info", pocket_place_get_handler_route);
 	http_route_set_auth (place_info_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (place_info_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, place_info_route);
 
 	// PUT api/pocket/places/:id/update
-	HttpRoute *place_update_route = http_route_create (REQUEST_METHOD_PUT, "places/:id/update", pocket_place_update_handler);
+	HttpRoute *place_update_route = http_route_create (REQUEST_METHOD_PUT, "places/:id/update", pocket_place_update_handler_route);
 	http_route_set_auth (place_update_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (place_update_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, place_update_route);
 
 	// DELETE api/pocket/places/:id/remove
-	HttpRoute *place_remove_route = http_route_create (REQUEST_METHOD_DELETE, "places/:id/remove", pocket_place_delete_handler);
+	HttpRoute *place_remove_route = http_route_create (REQUEST_METHOD_DELETE, "places/:id/remove", pocket_place_delete_handler_route);
 	http_route_set_auth (place_remove_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
 	http_route_set_decode_data (place_remove_route, pocket_user_parse_from_json, pocket_user_delete);
 	http_route_child_add (pocket_route, place_remove_route);
 
+	/*** sync ***/
+
+	// GET api/pocket/sync
+	HttpRoute *sync_route = http_route_create (REQUEST_METHOD_GET, "sync", pocket_sync_handler_route);
+	http_route_set_auth (sync_route, HTTP_ROUTE_AUTH_TYPE_BEARER);
+	http_route_set_decode_data (sync_route, pocket_user_parse_from_json, pocket_user_delete);
+	http_route_child_add (pocket_route, sync_route);
+
 }
 
 static void pocket_set_users_routes (HttpCerver *http_cerver) {
 
 	/* register top level route */
 	// GET /api/users
-	HttpRoute *users_route = http_route_create (REQUEST_METHOD_GET, "api/users", users_handler);
+	HttpRoute *users_route = http_route_create (REQUEST_METHOD_GET, "api/users", users_handler_route);
 	http_cerver_route_register (http_cerver, users_route);
 
 	/* register users children routes */
 	// POST api/users/login
-	HttpRoute *users_login_route = http_route_create (REQUEST_METHOD_POST, "login", users_login_handler);
+	HttpRoute *users_login_route = http_route_create (REQUEST_METHOD_POST, "login", users_login_handler_route);
 	http_route_child_add (users_route, users_login_route);
 
 	// POST api/users/register
-	HttpRoute *users_register_route = http_route_create (REQUEST_METHOD_POST, "register", users_register_handler);
+	HttpRoute *users_register_route = http_route_create (REQUEST_METHOD_POST, "register", users_register_handler_route);
 	http_route_child_add (users_route, users_register_route);
 
 }
@@ -207,7 +271,7 @@ static void start (void) {
 		}
 
 		// add a catch all route
-		http_cerver_set_catch_all_route (http_cerver, pocket_catch_all_handler);
+		http_cerver_set_catch_all_route (http_cerver, pocket_catch_all_handler_route);
 
 		if (cerver_start (pocket_api)) {
 			cerver_log_error (
@@ -235,6 +299,9 @@ int main (int argc, char const **argv) {
 	(void) signal (SIGINT, end);
 	(void) signal (SIGTERM, end);
 
+	// register to the reload signal
+	(void) signal (SIGHUP, reload);
+
 	// to prevent SIGPIPE when writting to socket
 	(void) signal (SIGPIPE, SIG_IGN);
 
@@ -0,0 +1,774 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <stdatomic.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <cerver/types/types.h>
+
+#include <cerver/utils/log.h>
+
+#include "cache.h"
+#include "limiter.h"
+#include "metrics.h"
+#include "password.h"
+#include "pool.h"
+
+typedef struct PocketMetricsCache {
+
+	const char *name;
+	PocketCache *cache;
+
+} PocketMetricsCache;
+
+typedef struct PocketMetricsLimiter {
+
+	const char *name;
+	PocketLimiter *limiter;
+
+} PocketMetricsLimiter;
+
+typedef struct PocketMetricsPool {
+
+	const char *name;
+	PocketPool *pool;
+
+} PocketMetricsPool;
+
+static const char *routes_methods[POCKET_METRICS_ROUTES] = {
+
+	#define XX(num, name, method, path) #method,
+	POCKET_METRICS_ROUTE_MAP (XX)
+	#undef XX
+
+};
+
+static const char *routes_paths[POCKET_METRICS_ROUTES] = {
+
+	#define XX(num, name, method, path) #path,
+	POCKET_METRICS_ROUTE_MAP (XX)
+	#undef XX
+
+};
+
+static const char *phases_names[POCKET_METRICS_PHASES] = {
+
+	#define XX(num, name, string) #string,
+	POCKET_METRICS_PHASE_MAP (XX)
+	#undef XX
+
+};
+
+static PocketMetricsCache metrics_caches[POCKET_METRICS_CACHES_MAX] = { 0 };
+static unsigned int n_metrics_caches = 0;
+
+static PocketMetricsLimiter metrics_limiters[POCKET_METRICS_LIMITERS_MAX] = { 0 };
+static unsigned int n_metrics_limiters = 0;
+
+static PocketMetricsPool metrics_pools[POCKET_METRICS_POOLS_MAX] = { 0 };
+static unsigned int n_metrics_pools = 0;
+
+// threads are only added, so the list can be read without the lock
+static pthread_mutex_t metrics_threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic (PocketMetricsThread *) metrics_threads = NULL;
+static PocketMetricsThread *metrics_threads_free = NULL;
+static unsigned int n_metrics_threads = 0;
+
+static pthread_key_t metrics_thread_key;
+static bool metrics_thread_key_created = false;
+
+static _Thread_local PocketMetricsThread *metrics_thread = NULL;
+static _Thread_local PocketMetricsRequest *metrics_request = NULL;
+
+static time_t metrics_start_time = 0;
+
+// returns a monotonic time in nanos
+int64_t pocket_metrics_now (void) {
+
+	struct timespec now = { 0 };
+	(void) clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return ((int64_t) now.tv_sec * 1000000000) + (int64_t) now.tv_nsec;
+
+}
+
+static inline unsigned int pocket_metrics_bucket (const u64 micros) {
+
+	unsigned int bucket = 0;
+
+	if (micros < POCKET_METRICS_SUB_BUCKETS) {
+		bucket = (unsigned int) micros;
+	}
+
+	else {
+		unsigned int exponent = 63 - (unsigned int) __builtin_clzll (micros);
+		if (exponent > POCKET_METRICS_MAX_EXPONENT) {
+			bucket = POCKET_METRICS_BUCKETS - 1;
+		}
+
+		else {
+			bucket = ((exponent - POCKET_METRICS_SUB_BITS + 1) << POCKET_METRICS_SUB_BITS)
+				+ (unsigned int) ((micros >> (exponent - POCKET_METRICS_SUB_BITS))
+				& (POCKET_METRICS_SUB_BUCKETS - 1));
+		}
+	}
+
+	return bucket;
+
+}
+
+// the first value in micros that is over the bucket
+static inline u64 pocket_metrics_bucket_upper (const unsigned int bucket) {
+
+	u64 upper = 0;
+
+	if (bucket < POCKET_METRICS_SUB_BUCKETS) {
+		upper = bucket + 1;
+	}
+
+	else {
+		unsigned int exponent = (bucket >> POCKET_METRICS_SUB_BITS)
+			+ POCKET_METRICS_SUB_BITS - 1;
+
+		upper = (u64) (POCKET_METRICS_SUB_BUCKETS
+			+ (bucket & (POCKET_METRICS_SUB_BUCKETS - 1)) + 1)
+			<< (exponent - POCKET_METRICS_SUB_BITS);
+	}
+
+	return upper;
+
+}
+
+// only the owner thread writes, so there is no need for a locked add
+static inline void pocket_metrics_add (_Atomic u64 *counter, const u64 value) {
+
+	atomic_store_explicit (
+		counter,
+		atomic_load_explicit (counter, memory_order_relaxed) + value,
+		memory_order_relaxed
+	);
+
+}
+
+static void pocket_metrics_histogram_record (
+	PocketMetricsHistogram *histogram, const int64_t nanos
+) {
+
+	const u64 micros = nanos > 0 ? (u64) nanos / 1000 : 0;
+
+	pocket_metrics_add (&histogram->count, 1);
+	pocket_metrics_add (&histogram->sum, micros);
+	pocket_metrics_add (
+		&histogram->buckets[pocket_metrics_bucket (micros)], 1
+	);
+
+}
+
+// called when a thread exits to let a new one use its histograms
+static void pocket_metrics_thread_release (void *thread_ptr) {
+
+	PocketMetricsThread *thread = (PocketMetricsThread *) thread_ptr;
+
+	(void) pthread_mutex_lock (&metrics_threads_mutex);
+	thread->free_next = metrics_threads_free;
+	metrics_threads_free = thread;
+	(void) pthread_mutex_unlock (&metrics_threads_mutex);
+
+}
+
+static PocketMetricsThread *pocket_metrics_thread_get (void) {
+
+	if (!metrics_thread && metrics_thread_key_created) {
+		(void) pthread_mutex_lock (&metrics_threads_mutex);
+
+		if (metrics_threads_free) {
+			metrics_thread = metrics_threads_free;
+			metrics_threads_free = metrics_thread->free_next;
+		}
+
+		else {
+			metrics_thread = (PocketMetricsThread *) calloc (
+				1, sizeof (PocketMetricsThread)
+			);
+
+			if (metrics_thread) {
+				metrics_thread->next = atomic_load (&metrics_threads);
+				atomic_store (&metrics_threads, metrics_thread);
+				n_metrics_threads += 1;
+			}
+		}
+
+		(void) pthread_mutex_unlock (&metrics_threads_mutex);
+
+		if (metrics_thread) {
+			(void) pthread_setspecific (metrics_thread_key, metrics_thread);
+		}
+	}
+
+	return metrics_thread;
+
+}
+
+// returns 0 on success, 1 on error
+unsigned int pocket_metrics_init (void) {
+
+	unsigned int retval = 1;
+
+	metrics_start_time = time (NULL);
+
+	if (!pthread_key_create (
+		&metrics_thread_key, pocket_metrics_thread_release
+	)) {
+		metrics_thread_key_created = true;
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error ("Failed to create metrics thread key!");
+	}
+
+	return retval;
+
+}
+
+void pocket_metrics_end (void) {
+
+	if (metrics_thread_key_created) {
+		(void) pthread_key_delete (metrics_thread_key);
+		metrics_thread_key_created = false;
+	}
+
+	PocketMetricsThread *thread = atomic_exchange (&metrics_threads, NULL);
+	PocketMetricsThread *next = NULL;
+	while (thread) {
+		next = thread->next;
+		free (thread);
+		thread = next;
+	}
+
+	metrics_threads_free = NULL;
+	n_metrics_threads = 0;
+
+	metrics_thread = NULL;
+
+	n_metrics_caches = 0;
+	n_metrics_limiters = 0;
+	n_metrics_pools = 0;
+
+}
+
+// adds the cache's stats to the metrics with the name as a label
+void pocket_metrics_register_cache (
+	const char *name, PocketCache *cache
+) {
+
+	if (n_metrics_caches < POCKET_METRICS_CACHES_MAX) {
+		metrics_caches[n_metrics_caches].name = name;
+		metrics_caches[n_metrics_caches].cache = cache;
+		n_metrics_caches += 1;
+	}
+
+}
+
+// adds the limiter's counters to the metrics with the name as a label
+void pocket_metrics_register_limiter (
+	const char *name, PocketLimiter *limiter
+) {
+
+	if (n_metrics_limiters < POCKET_METRICS_LIMITERS_MAX) {
+		metrics_limiters[n_metrics_limiters].name = name;
+		metrics_limiters[n_metrics_limiters].limiter = limiter;
+		n_metrics_limiters += 1;
+	}
+
+}
+
+// adds the pool's occupancy & lock counters to the metrics
+// with the name as a label
+void pocket_metrics_register_pool (
+	const char *name, PocketPool *pool
+) {
+
+	if (n_metrics_pools < POCKET_METRICS_POOLS_MAX) {
+		metrics_pools[n_metrics_pools].name = name;
+		metrics_pools[n_metrics_pools].pool = pool;
+		n_metrics_pools += 1;
+	}
+
+}
+
+// starts timing a request in the current thread
+void pocket_metrics_request_start (
+	PocketMetricsRequest *request, const PocketMetricsRoute route
+) {
+
+	request->route = route;
+	request->start = pocket_metrics_now ();
+	request->first_mongo = 0;
+	request->mongo = 0;
+
+	metrics_request = request;
+
+}
+
+// records the request's phases in the current thread's histograms
+void pocket_metrics_request_end (PocketMetricsRequest *request) {
+
+	metrics_request = NULL;
+
+	PocketMetricsThread *thread = pocket_metrics_thread_get ();
+	if (thread) {
+		PocketMetricsHistogram *histograms = thread->histograms[request->route];
+
+		const int64_t total = pocket_metrics_now () - request->start;
+		pocket_metrics_histogram_record (
+			&histograms[POCKET_METRICS_PHASE_TOTAL], total
+		);
+
+		if (request->first_mongo) {
+			const int64_t parse = request->first_mongo - request->start;
+
+			pocket_metrics_histogram_record (
+				&histograms[POCKET_METRICS_PHASE_PARSE], parse
+			);
+
+			pocket_metrics_histogram_record (
+				&histograms[POCKET_METRICS_PHASE_MONGO], request->mongo
+			);
+
+			pocket_metrics_histogram_record (
+				&histograms[POCKET_METRICS_PHASE_SERIALIZE],
+				total - parse - request->mongo
+			);
+		}
+
+		else {
+			pocket_metrics_histogram_record (
+				&histograms[POCKET_METRICS_PHASE_PARSE], total
+			);
+		}
+	}
+
+}
+
+// records a db operation in the current thread's histograms
+// & adds its time to the current request, if any
+void pocket_metrics_db_record (
+	const DbCollection collection, const DbOperation operation,
+	const int64_t start, const int64_t elapsed
+) {
+
+	PocketMetricsThread *thread = pocket_metrics_thread_get ();
+	if (thread) {
+		pocket_metrics_histogram_record (
+			&thread->db[collection][operation], elapsed
+		);
+	}
+
+	if (metrics_request) {
+		if (!metrics_request->first_mongo) {
+			metrics_request->first_mongo = start;
+		}
+
+		metrics_request->mongo += elapsed;
+	}
+
+}
+
+static void pocket_metrics_histogram_merge (
+	PocketMetricsHistogram *target, const PocketMetricsHistogram *source
+) {
+
+	target->count += atomic_load_explicit (&source->count, memory_order_relaxed);
+	target->sum += atomic_load_explicit (&source->sum, memory_order_relaxed);
+
+	for (unsigned int bucket = 0; bucket < POCKET_METRICS_BUCKETS; bucket++) {
+		target->buckets[bucket] += atomic_load_explicit (
+			&source->buckets[bucket], memory_order_relaxed
+		);
+	}
+
+}
+
+// sums the histograms of every thread
+static void pocket_metrics_merge (PocketMetricsThread *merged) {
+
+	PocketMetricsThread *thread = atomic_load (&metrics_threads);
+	while (thread) {
+		for (unsigned int route = 0; route < POCKET_METRICS_ROUTES; route++) {
+			for (unsigned int phase = 0; phase < POCKET_METRICS_PHASES; phase++) {
+				pocket_metrics_histogram_merge (
+					&merged->histograms[route][phase],
+					&thread->histograms[route][phase]
+				);
+			}
+		}
+
+		for (unsigned int coll = 0; coll < DB_COLLECTIONS; coll++) {
+			for (unsigned int op = 0; op < DB_OPERATIONS; op++) {
+				pocket_metrics_histogram_merge (
+					&merged->db[coll][op], &thread->db[coll][op]
+				);
+			}
+		}
+
+		thread = thread->next;
+	}
+
+}
+
+// the upper bound in micros of the bucket with the quantile
+static u64 pocket_metrics_quantile (
+	const PocketMetricsHistogram *histogram, const double quantile
+) {
+
+	u64 value = 0;
+
+	const u64 target = (u64) ((double) histogram->count * quantile) + 1;
+
+	u64 cumulative = 0;
+	for (unsigned int bucket = 0; bucket < POCKET_METRICS_BUCKETS; bucket++) {
+		cumulative += histogram->buckets[bucket];
+		if (cumulative >= target) {
+			value = pocket_metrics_bucket_upper (bucket);
+			break;
+		}
+	}
+
+	return value;
+
+}
+
+// writes the histogram in seconds with the labels of its series
+static void pocket_metrics_export_histogram (
+	FILE *out, const char *name, const char *labels,
+	const PocketMetricsHistogram *histogram
+) {
+
+	const u64 count = histogram->count;
+
+	// buckets that end in a power of two, the last one is only +Inf
+	u64 cumulative = 0;
+	u64 upper = 0;
+	for (unsigned int bucket = 0; bucket < (POCKET_METRICS_BUCKETS - 1); bucket++) {
+		cumulative += histogram->buckets[bucket];
+
+		upper = pocket_metrics_bucket_upper (bucket);
+		if (
+			!(upper & (upper - 1))
+			&& (upper >= ((u64) 1 << POCKET_METRICS_EXPORT_MIN_EXPONENT))
+		) {
+			(void) fprintf (
+				out, "%s_bucket{%s,le=\"%.6f\"} %" PRIu64 "\n",
+				name, labels, (double) upper / 1e6, cumulative
+			);
+		}
+	}
+
+	(void) fprintf (
+		out,
+		"%s_bucket{%s,le=\"+Inf\"} %" PRIu64 "\n"
+		"%s_sum{%s} %.6f\n"
+		"%s_count{%s} %" PRIu64 "\n",
+		name, labels, count,
+		name, labels, (double) histogram->sum / 1e6,
+		name, labels, count
+	);
+
+}
+
+static void pocket_metrics_export_requests (
+	FILE *out, const PocketMetricsThread *merged
+) {
+
+	(void) fprintf (
+		out,
+		"# HELP pocket_request_duration_seconds Time spent handling requests by route & phase.\n"
+		"# TYPE pocket_request_duration_seconds histogram\n"
+	);
+
+	char labels[POCKET_METRICS_LABELS_SIZE] = { 0 };
+	const PocketMetricsHistogram *histogram = NULL;
+	for (unsigned int route = 0; route < POCKET_METRICS_ROUTES; route++) {
+		for (unsigned int phase = 0; phase < POCKET_METRICS_PHASES; phase++) {
+			histogram = &merged->histograms[route][phase];
+			if (histogram->count) {
+				(void) snprintf (
+					labels, POCKET_METRICS_LABELS_SIZE,
+					"method=\"%s\",route=\"%s\",phase=\"%s\"",
+					routes_methods[route], routes_paths[route],
+					phases_names[phase]
+				);
+
+				pocket_metrics_export_histogram (
+					out, "pocket_request_duration_seconds", labels, histogram
+				);
+			}
+		}
+	}
+
+	// quantiles use every bucket to keep their precision
+	(void) fprintf (
+		out,
+		"# HELP pocket_request_duration_quantile_seconds Request latency quantiles by route & phase.\n"
+		"# TYPE pocket_request_duration_quantile_seconds gauge\n"
+	);
+
+	static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	for (unsigned int route = 0; route < POCKET_METRICS_ROUTES; route++) {
+		for (unsigned int phase = 0; phase < POCKET_METRICS_PHASES; phase++) {
+			histogram = &merged->histograms[route][phase];
+			if (histogram->count) {
+				for (unsigned int q = 0; q < (sizeof (quantiles) / sizeof (double)); q++) {
+					(void) fprintf (
+						out,
+						"pocket_request_duration_quantile_seconds{method=\"%s\",route=\"%s\",phase=\"%s\",quantile=\"%g\"} %.6f\n",
+						routes_methods[route], routes_paths[route],
+						phases_names[phase],
+						quantiles[q],
+						(double) pocket_metrics_quantile (histogram, quantiles[q]) / 1e6
+					);
+				}
+			}
+		}
+	}
+
+}
+
+static void pocket_metrics_export_db (
+	FILE *out, const PocketMetricsThread *merged
+) {
+
+	(void) fprintf (
+		out,
+		"# HELP pocket_db_duration_seconds Time spent in db operations by collection & operation.\n"
+		"# TYPE pocket_db_duration_seconds histogram\n"
+	);
+
+	char labels[POCKET_METRICS_LABELS_SIZE] = { 0 };
+	const PocketMetricsHistogram *histogram = NULL;
+	for (unsigned int coll = 0; coll < DB_COLLECTIONS; coll++) {
+		for (unsigned int op = 0; op < DB_OPERATIONS; op++) {
+			histogram = &merged->db[coll][op];
+			if (histogram->count) {
+				(void) snprintf (
+					labels, POCKET_METRICS_LABELS_SIZE,
+					"collection=\"%s\",op=\"%s\"",
+					db_collection_to_string ((DbCollection) coll),
+					db_operation_to_string ((DbOperation) op)
+				);
+
+				pocket_metrics_export_histogram (
+					out, "pocket_db_duration_seconds", labels, histogram
+				);
+			}
+		}
+	}
+
+}
+
+static void pocket_metrics_export_caches (FILE *out) {
+
+	(void) fprintf (
+		out,
+		"# HELP pocket_cache_entries Responses in the cache.\n"
+		"# TYPE pocket_cache_entries gauge\n"
+		"# HELP pocket_cache_bytes Size of the responses in the cache.\n"
+		"# TYPE pocket_cache_bytes gauge\n"
+		"# HELP pocket_cache_hits_total Requests that were answered from the cache.\n"
+		"# TYPE pocket_cache_hits_total counter\n"
+		"# HELP pocket_cache_misses_total Requests that were not in the cache.\n"
+		"# TYPE pocket_cache_misses_total counter\n"
+		"# HELP pocket_cache_evictions_total Responses removed to make space.\n"
+		"# TYPE pocket_cache_evictions_total counter\n"
+		"# HELP pocket_cache_expired_total Responses removed after their max age.\n"
+		"# TYPE pocket_cache_expired_total counter\n"
+	);
+
+	PocketCacheStats stats = { 0 };
+	for (unsigned int idx = 0; idx < n_metrics_caches; idx++) {
+		pocket_cache_get_stats (metrics_caches[idx].cache, &stats);
+
+		(void) fprintf (
+			out,
+			"pocket_cache_entries{cache=\"%s\"} %zu\n"
+			"pocket_cache_bytes{cache=\"%s\"} %zu\n"
+			"pocket_cache_hits_total{cache=\"%s\"} %zu\n"
+			"pocket_cache_misses_total{cache=\"%s\"} %zu\n"
+			"pocket_cache_evictions_total{cache=\"%s\"} %zu\n"
+			"pocket_cache_expired_total{cache=\"%s\"} %zu\n",
+			metrics_caches[idx].name, stats.entries,
+			metrics_caches[idx].name, stats.size,
+			metrics_caches[idx].name, stats.hits,
+			metrics_caches[idx].name, stats.misses,
+			metrics_caches[idx].name, stats.evictions,
+			metrics_caches[idx].name, stats.expired
+		);
+	}
+
+}
+
+static void pocket_metrics_export_limiters (FILE *out) {
+
+	(void) fprintf (
+		out,
+		"# HELP pocket_limiter_allowed_total Requests that got a token.\n"
+		"# TYPE pocket_limiter_allowed_total counter\n"
+		"# HELP pocket_limiter_limited_total Requests that were answered with a 429.\n"
+		"# TYPE pocket_limiter_limited_total counter\n"
+	);
+
+	PocketLimiterStats stats = { 0 };
+	for (unsigned int idx = 0; idx < n_metrics_limiters; idx++) {
+		pocket_limiter_get_stats (metrics_limiters[idx].limiter, &stats);
+
+		(void) fprintf (
+			out,
+			"pocket_limiter_allowed_total{limiter=\"%s\"} %zu\n"
+			"pocket_limiter_limited_total{limiter=\"%s\"} %zu\n",
+			metrics_limiters[idx].name, stats.allowed,
+			metrics_limiters[idx].name, stats.limited
+		);
+	}
+
+}
+
+static void pocket_metrics_export_pools (FILE *out) {
+
+	(void) fprintf (
+		out,
+		"# HELP pocket_pool_objects Objects that the pool has made & not destroyed.\n"
+		"# TYPE pocket_pool_objects gauge\n"
+		"# HELP pocket_pool_available Objects in the shared pool.\n"
+		"# TYPE pocket_pool_available gauge\n"
+		"# HELP pocket_pool_cached Objects in the threads' magazines.\n"
+		"# TYPE pocket_pool_cached gauge\n"
+		"# HELP pocket_pool_in_use Objects that were taken by requests.\n"
+		"# TYPE pocket_pool_in_use gauge\n"
+		"# HELP pocket_pool_high_water Decayed max of the objects out of the shared pool.\n"
+		"# TYPE pocket_pool_high_water gauge\n"
+		"# HELP pocket_pool_magazines Threads that have a magazine.\n"
+		"# TYPE pocket_pool_magazines gauge\n"
+		"# HELP pocket_pool_refills_total Magazines filled from the shared pool.\n"
+		"# TYPE pocket_pool_refills_total counter\n"
+		"# HELP pocket_pool_spills_total Magazines moved to the shared pool.\n"
+		"# TYPE pocket_pool_spills_total counter\n"
+		"# HELP pocket_pool_trimmed_total Objects destroyed by the trims.\n"
+		"# TYPE pocket_pool_trimmed_total counter\n"
+		"# HELP pocket_pool_locks_total Times that the shared pool was locked.\n"
+		"# TYPE pocket_pool_locks_total counter\n"
+		"# HELP pocket_pool_contended_total Locks that had to wait for another thread.\n"
+		"# TYPE pocket_pool_contended_total counter\n"
+	);
+
+	PocketPoolStats stats = { 0 };
+	for (unsigned int idx = 0; idx < n_metrics_pools; idx++) {
+		pocket_pool_get_stats (metrics_pools[idx].pool, &stats);
+
+		(void) fprintf (
+			out,
+			"pocket_pool_objects{pool=\"%s\"} %zu\n"
+			"pocket_pool_available{pool=\"%s\"} %zu\n"
+			"pocket_pool_cached{pool=\"%s\"} %zu\n"
+			"pocket_pool_in_use{pool=\"%s\"} %zu\n"
+			"pocket_pool_high_water{pool=\"%s\"} %zu\n"
+			"pocket_pool_magazines{pool=\"%s\"} %u\n"
+			"pocket_pool_refills_total{pool=\"%s\"} %zu\n"
+			"pocket_pool_spills_total{pool=\"%s\"} %zu\n"
+			"pocket_pool_trimmed_total{pool=\"%s\"} %zu\n"
+			"pocket_pool_locks_total{pool=\"%s\"} %zu\n"
+			"pocket_pool_contended_total{pool=\"%s\"} %zu\n",
+			metrics_pools[idx].name, stats.objects,
+			metrics_pools[idx].name, stats.available,
+			metrics_pools[idx].name, stats.cached,
+			metrics_pools[idx].name, stats.in_use,
+			metrics_pools[idx].name, stats.high_water,
+			metrics_pools[idx].name, stats.magazines,
+			metrics_pools[idx].name, stats.refills,
+			metrics_pools[idx].name, stats.spills,
+			metrics_pools[idx].name, stats.trimmed,
+			metrics_pools[idx].name, stats.locks,
+			metrics_pools[idx].name, stats.contended
+		);
+	}
+
+}
+
+static void pocket_metrics_export_workers (FILE *out) {
+
+	PocketPasswordStats password = { 0 };
+	pocket_password_get_stats (&password);
+
+	(void) pthread_mutex_lock (&metrics_threads_mutex);
+	const unsigned int threads = n_metrics_threads;
+	(void) pthread_mutex_unlock (&metrics_threads_mutex);
+
+	(void) fprintf (
+		out,
+		"# HELP pocket_password_workers Threads that hash & verify passwords.\n"
+		"# TYPE pocket_password_workers gauge\n"
+		"pocket_password_workers %u\n"
+		"# HELP pocket_password_pending Requests waiting for a password, queued or being hashed.\n"
+		"# TYPE pocket_password_pending gauge\n"
+		"pocket_password_pending %u\n"
+		"# HELP pocket_password_queue_max Max requests that can wait for a password.\n"
+		"# TYPE pocket_password_queue_max gauge\n"
+		"pocket_password_queue_max %u\n"
+		"# HELP pocket_password_jobs_total Passwords that were hashed or verified by a worker.\n"
+		"# TYPE pocket_password_jobs_total counter\n"
+		"pocket_password_jobs_total %zu\n"
+		"# HELP pocket_password_rejected_total Passwords rejected because the queue was full.\n"
+		"# TYPE pocket_password_rejected_total counter\n"
+		"pocket_password_rejected_total %zu\n"
+		"# HELP pocket_metrics_threads Threads that have recorded requests.\n"
+		"# TYPE pocket_metrics_threads gauge\n"
+		"pocket_metrics_threads %u\n"
+		"# HELP pocket_start_time_seconds Time when the service started.\n"
+		"# TYPE pocket_start_time_seconds gauge\n"
+		"pocket_start_time_seconds %ld\n",
+		password.workers,
+		password.pending,
+		password.queue_max,
+		password.done,
+		password.rejected,
+		threads,
+		(long) metrics_start_time
+	);
+
+}
+
+// writes every metric in prometheus text format
+// returns a new string that must be freed by the caller
+char *pocket_metrics_export (size_t *len) {
+
+	char *data = NULL;
+
+	PocketMetricsThread *merged = (PocketMetricsThread *) calloc (
+		1, sizeof (PocketMetricsThread)
+	);
+
+	if (merged) {
+		pocket_metrics_merge (merged);
+
+		FILE *out = open_memstream (&data, len);
+		if (out) {
+			pocket_metrics_export_requests (out, merged);
+			pocket_metrics_export_db (out, merged);
+			pocket_metrics_export_caches (out);
+			pocket_metrics_export_limiters (out);
+			pocket_metrics_export_pools (out);
+			pocket_metrics_export_workers (out);
+
+			(void) fclose (out);
+		}
+
+		free (merged);
+	}
+
+	return data;
+
+}
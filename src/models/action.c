@@ -8,6 +8,8 @@
 #include <cmongo/crud.h>
 #include <cmongo/model.h>
 
+#include "db.h"
+
 #include "models/action.h"
 
 static CMongoModel *actions_model = NULL;
@@ -158,8 +160,8 @@ RoleAction *action_get_by_name (const char *name) {
 		bson_t *action_query = bson_new ();
 		if (action_query) {
 			(void) bson_append_utf8 (action_query, "name", -1, name, -1);
-			if (mongo_find_one (
-				actions_model,
+			if (db_model_find_one (
+				DB_COLLECTION_ACTIONS, actions_model,
 				action_query, NULL,
 				action
 			)) {
@@ -209,4 +211,15 @@ bson_t *action_bson_create_update (
 
 	return doc;
 
-}
\ No newline at end of file
+}
+
+mongoc_cursor_t *action_find_all (
+	const CMongoSelect *select, uint64_t *n_docs
+) {
+
+	return db_model_find_all_cursor (
+		DB_COLLECTION_ACTIONS, actions_model,
+		bson_new (), select, n_docs
+	);
+
+}
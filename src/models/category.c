@@ -11,7 +11,10 @@
 #include <cmongo/crud.h>
 #include <cmongo/model.h>
 
+#include "db.h"
+
 #include "models/category.h"
+#include "models/tombstone.h"
 
 static CMongoModel *categories_model = NULL;
 
@@ -19,6 +22,18 @@ static void category_doc_parse (
 	void *category_ptr, const bson_t *category_doc
 );
 
+// used to list & sync the user's categories
+static const DbIndex categories_indexes[] = {
+	{ .name = "user_updated", .fields = { { "user", 1 }, { "updated", 1 } } },
+	{ .name = NULL }
+};
+
+static const DbQueryShape categories_queries[] = {
+	{ .name = "list", .filter = { "user" } },
+	{ .name = "sync", .filter = { "user", "updated" } },
+	{ .name = NULL }
+};
+
 unsigned int categories_model_init (void) {
 
 	unsigned int retval = 1;
@@ -27,7 +42,10 @@ unsigned int categories_model_init (void) {
 	if (categories_model) {
 		cmongo_model_set_parser (categories_model, category_doc_parse);
 
-		retval = 0;
+		retval = db_indexes_init (
+			DB_COLLECTION_CATEGORIES,
+			categories_indexes, categories_queries
+		);
 	}
 
 	return retval;
@@ -64,9 +82,9 @@ void category_print (Category *category) {
 		bson_oid_to_string (&category->oid, buffer);
 		(void) printf ("id: %s\n", buffer);
 
-		(void) printf ("title: %s\n", category->title);
-		(void) printf ("description: %s\n", category->description);
-		(void) printf ("color: %s\n", category->color);
+		(void) printf ("title: %.*s\n", POCKET_STR_FORMAT (category->title));
+		(void) printf ("description: %.*s\n", POCKET_STR_FORMAT (category->description));
+		(void) printf ("color: %.*s\n", POCKET_STR_FORMAT (category->color));
 
 		(void) strftime (buffer, 128, "%d/%m/%y - %T", gmtime (&category->date));
 		(void) printf ("date: %s GMT\n", buffer);
@@ -90,34 +108,30 @@ static void category_doc_parse (
 
 			if (!strcmp (key, "_id")) {
 				bson_oid_copy (&value->value.v_oid, &category->oid);
-				bson_oid_to_string (&category->oid, category->id);
 			}
 
 			else if (!strcmp (key, "user")) {
 				bson_oid_copy (&value->value.v_oid, &category->user_oid);
 			}
 
-			else if (!strcmp (key, "title") && value->value.v_utf8.str) {
-				(void) strncpy (
-					category->title,
-					value->value.v_utf8.str,
-					CATEGORY_TITLE_SIZE - 1
+			else if (!strcmp (key, "title")) {
+				(void) db_iter_str (
+					&iter, category->arena,
+					CATEGORY_TITLE_MAX, &category->title
 				);
 			}
 
 			else if (!strcmp (key, "description")) {
-				(void) strncpy (
-					category->description,
-					value->value.v_utf8.str,
-					CATEGORY_DESCRIPTION_SIZE - 1
+				(void) db_iter_str (
+					&iter, category->arena,
+					CATEGORY_DESCRIPTION_MAX, &category->description
 				);
 			}
 
 			else if (!strcmp (key, "color")) {
-				(void) strncpy (
-					category->color,
-					value->value.v_utf8.str,
-					CATEGORY_COLOR_SIZE - 1
+				(void) db_iter_str (
+					&iter, category->arena,
+					CATEGORY_COLOR_MAX, &category->color
 				);
 			}
 
@@ -134,7 +148,7 @@ bson_t *category_query_oid (const bson_oid_t *oid) {
 	bson_t *query = NULL;
 
 	if (oid) {
-		query = bson_new ();
+		query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "_id", -1, oid);
 		}
@@ -148,7 +162,7 @@ bson_t *category_query_by_oid_and_user (
 	const bson_oid_t *oid, const bson_oid_t *user_oid
 ) {
 
-	bson_t *category_query = bson_new ();
+	bson_t *category_query = db_query_new ();
 	if (category_query) {
 		(void) bson_append_oid (category_query, "_id", -1, oid);
 		(void) bson_append_oid (category_query, "user", -1, user_oid);
@@ -165,11 +179,11 @@ u8 category_get_by_oid (
 	u8 retval = 1;
 
 	if (category && oid) {
-		bson_t *category_query = bson_new ();
+		bson_t *category_query = db_query_new ();
 		if (category_query) {
 			(void) bson_append_oid (category_query, "_id", -1, oid);
-			retval = mongo_find_one_with_opts (
-				categories_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_CATEGORIES, categories_model,
 				category_query, query_opts,
 				category
 			);
@@ -194,8 +208,8 @@ u8 category_get_by_oid_and_user (
 		);
 
 		if (category_query) {
-			retval = mongo_find_one_with_opts (
-				categories_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_CATEGORIES, categories_model,
 				category_query, query_opts,
 				category
 			);
@@ -209,7 +223,8 @@ u8 category_get_by_oid_and_user (
 u8 category_get_by_oid_and_user_to_json (
 	const bson_oid_t *oid, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 ) {
 
 	u8 retval = 1;
@@ -220,9 +235,9 @@ u8 category_get_by_oid_and_user_to_json (
 		);
 
 		if (category_query) {
-			retval = mongo_find_one_with_opts_to_json (
-				categories_model,
-				category_query, query_opts,
+			retval = db_model_find_one_with_opts_to_output (
+				DB_COLLECTION_CATEGORIES, categories_model,
+				category_query, query_opts, shape,
 				json, json_len
 			);
 		}
@@ -243,11 +258,13 @@ static bson_t *category_to_bson (const Category *category) {
 
 			(void) bson_append_oid (doc, "user", -1, &category->user_oid);
 
-			(void) bson_append_utf8 (doc, "title", -1, category->title, -1);
-			(void) bson_append_utf8 (doc, "description", -1, category->description, -1);
-			(void) bson_append_utf8 (doc, "color", -1, category->color, -1);
+			db_append_str (doc, "title", &category->title);
+			db_append_str (doc, "description", &category->description);
+			db_append_str (doc, "color", &category->color);
 
 			(void) bson_append_date_time (doc, "date", -1, category->date * 1000);
+
+			(void) bson_append_date_time (doc, "updated", -1, db_now ());
         }
     }
 
@@ -255,18 +272,29 @@ static bson_t *category_to_bson (const Category *category) {
 
 }
 
-static bson_t *category_update_bson (const Category *category) {
+static bson_t *category_update_bson (
+	const Category *category, const u8 fields
+) {
 
 	bson_t *doc = NULL;
 
-    if (category) {
+    if (category && fields) {
         doc = bson_new ();
         if (doc) {
 			bson_t set_doc = BSON_INITIALIZER;
 			(void) bson_append_document_begin (doc, "$set", -1, &set_doc);
-			(void) bson_append_utf8 (&set_doc, "title", -1, category->title, -1);
-			(void) bson_append_utf8 (&set_doc, "description", -1, category->description, -1);
-			(void) bson_append_utf8 (&set_doc, "color", -1, category->color, -1);
+
+			if (fields & CATEGORY_FIELD_TITLE)
+				db_append_str (&set_doc, "title", &category->title);
+
+			if (fields & CATEGORY_FIELD_DESCRIPTION)
+				db_append_str (&set_doc, "description", &category->description);
+
+			if (fields & CATEGORY_FIELD_COLOR)
+				db_append_str (&set_doc, "color", &category->color);
+
+			(void) bson_append_date_time (&set_doc, "updated", -1, db_now ());
+
 			(void) bson_append_document_end (doc, &set_doc);
         }
     }
@@ -283,12 +311,43 @@ mongoc_cursor_t *categories_get_all_by_user (
 	mongoc_cursor_t *retval = NULL;
 
 	if (user_oid && opts) {
-		bson_t *query = bson_new ();
+		bson_t *query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "user", -1, user_oid);
 
-			retval = mongo_find_all_cursor_with_opts (
-				categories_model,
+			retval = db_model_find_all_cursor_with_opts (
+				DB_COLLECTION_CATEGORIES, categories_model,
+				query, opts
+			);
+		}
+	}
+
+	return retval;
+
+}
+
+// get all the user's categories created or updated after since (millis)
+// a since value of 0 returns all the user's categories
+mongoc_cursor_t *categories_get_all_by_user_since (
+	const bson_oid_t *user_oid, const int64_t since, const bson_t *opts
+) {
+
+	mongoc_cursor_t *retval = NULL;
+
+	if (user_oid && opts) {
+		bson_t *query = db_query_new ();
+		if (query) {
+			(void) bson_append_oid (query, "user", -1, user_oid);
+
+			if (since) {
+				bson_t updated = BSON_INITIALIZER;
+				(void) bson_append_document_begin (query, "updated", -1, &updated);
+				(void) bson_append_date_time (&updated, "$gte", -1, since);
+				(void) bson_append_document_end (query, &updated);
+			}
+
+			retval = db_model_find_all_cursor_with_opts (
+				DB_COLLECTION_CATEGORIES, categories_model,
 				query, opts
 			);
 		}
@@ -306,12 +365,12 @@ unsigned int categories_get_all_by_user_to_json (
 	unsigned int retval = 1;
 
 	if (user_oid) {
-		bson_t *query = bson_new ();
+		bson_t *query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "user", -1, user_oid);
 
-			retval = mongo_find_all_to_json (
-				categories_model,
+			retval = db_model_find_all_to_json (
+				DB_COLLECTION_CATEGORIES, categories_model,
 				query, opts,
 				"categories",
 				json, json_len
@@ -325,37 +384,53 @@ unsigned int categories_get_all_by_user_to_json (
 
 unsigned int category_insert_one (const Category *category) {
 
-	return mongo_insert_one (
-		categories_model, category_to_bson (category)
+	return db_model_insert_one (
+		DB_COLLECTION_CATEGORIES, categories_model,
+		category_to_bson (category)
 	);
 
 }
 
-unsigned int category_update_one (const Category *category) {
+// updates only the selected fields of the user's category
+// matched is set with the number of categories that matched
+// returns 0 on success, 1 on error
+unsigned int category_update_one (
+	const Category *category, const u8 fields,
+	int64_t *matched
+) {
 
-	return mongo_update_one (
-		categories_model,
-		category_query_oid (&category->oid),
-		category_update_bson (category)
+	return db_update_one (
+		DB_COLLECTION_CATEGORIES,
+		category_query_by_oid_and_user (
+			&category->oid, &category->user_oid
+		),
+		category_update_bson (category, fields),
+		matched
 	);
 
 }
 
+// deleted is set with the number of categories that were removed
+// returns 0 on success, 1 on error
 unsigned int category_delete_one_by_oid_and_user (
-	const bson_oid_t *oid, const bson_oid_t *user_oid
+	const bson_oid_t *oid, const bson_oid_t *user_oid,
+	int64_t *deleted
 ) {
 
 	unsigned int retval = 1;
 
+	*deleted = 0;
+
 	if (oid && user_oid) {
-		bson_t *category_query = category_query_by_oid_and_user (
-			oid, user_oid
+		retval = db_delete_one (
+			DB_COLLECTION_CATEGORIES,
+			category_query_by_oid_and_user (oid, user_oid),
+			deleted
 		);
 
-		if (category_query) {
-			retval = mongo_delete_one (
-				categories_model, category_query
-			);
+		// the document is gone even if its tombstone can not be stored
+		if (!retval && *deleted) {
+			tombstone_record (TOMBSTONE_TYPE_CATEGORY, oid, user_oid);
 		}
 	}
 
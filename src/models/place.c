@@ -11,7 +11,10 @@
 #include <cmongo/crud.h>
 #include <cmongo/model.h>
 
+#include "db.h"
+
 #include "models/place.h"
+#include "models/tombstone.h"
 
 static CMongoModel *places_model = NULL;
 
@@ -19,6 +22,18 @@ static void place_doc_parse (
 	void *place_ptr, const bson_t *place_doc
 );
 
+// used to list & sync the user's places
+static const DbIndex places_indexes[] = {
+	{ .name = "user_updated", .fields = { { "user", 1 }, { "updated", 1 } } },
+	{ .name = NULL }
+};
+
+static const DbQueryShape places_queries[] = {
+	{ .name = "list", .filter = { "user" } },
+	{ .name = "sync", .filter = { "user", "updated" } },
+	{ .name = NULL }
+};
+
 unsigned int places_model_init (void) {
 
 	unsigned int retval = 1;
@@ -27,7 +42,10 @@ unsigned int places_model_init (void) {
 	if (places_model) {
 		cmongo_model_set_parser (places_model, place_doc_parse);
 
-		retval = 0;
+		retval = db_indexes_init (
+			DB_COLLECTION_PLACES,
+			places_indexes, places_queries
+		);
 	}
 
 	return retval;
@@ -96,13 +114,14 @@ void place_delete (void *place_ptr) {
 void place_print (const Place *place) {
 
 	if (place) {
-		(void) printf ("id: %s\n", place->id);
+		char buffer[128] = { 0 };
+		bson_oid_to_string (&place->oid, buffer);
+		(void) printf ("id: %s\n", buffer);
 
-		(void) printf ("name: %s\n", place->name);
-		(void) printf ("description: %s\n", place->description);
+		(void) printf ("name: %.*s\n", POCKET_STR_FORMAT (place->name));
+		(void) printf ("description: %.*s\n", POCKET_STR_FORMAT (place->description));
 		(void) printf ("type: %s\n", place_type_to_string (place->type));
 
-		char buffer[128] = { 0 };
 		(void) strftime (buffer, 128, "%d/%m/%y - %T", gmtime (&place->date));
 		(void) printf ("date: %s GMT\n", buffer);
 	}
@@ -125,25 +144,22 @@ static void place_doc_parse (
 
 			if (!strcmp (key, "_id")) {
 				bson_oid_copy (&value->value.v_oid, &place->oid);
-				bson_oid_to_string (&place->oid, place->id);
 			}
 
 			else if (!strcmp (key, "user"))
 				bson_oid_copy (&value->value.v_oid, &place->user_oid);
 
-			else if (!strcmp (key, "name") && value->value.v_utf8.str) {
-				(void) strncpy (
-					place->name,
-					value->value.v_utf8.str,
-					PLACE_NAME_SIZE - 1
+			else if (!strcmp (key, "name")) {
+				(void) db_iter_str (
+					&iter, place->arena,
+					PLACE_NAME_MAX, &place->name
 				);
 			}
 
 			else if (!strcmp (key, "description")) {
-				(void) strncpy (
-					place->description,
-					value->value.v_utf8.str,
-					PLACE_DESCRIPTION_SIZE - 1
+				(void) db_iter_str (
+					&iter, place->arena,
+					PLACE_DESCRIPTION_MAX, &place->description
 				);
 			}
 
@@ -162,7 +178,7 @@ bson_t *place_query_oid (const bson_oid_t *oid) {
 	bson_t *query = NULL;
 
 	if (oid) {
-		query = bson_new ();
+		query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "_id", -1, oid);
 		}
@@ -176,7 +192,7 @@ bson_t *place_query_by_oid_and_user (
 	const bson_oid_t *oid, const bson_oid_t *user_oid
 ) {
 
-	bson_t *place_query = bson_new ();
+	bson_t *place_query = db_query_new ();
 	if (place_query) {
 		(void) bson_append_oid (place_query, "_id", -1, oid);
 		(void) bson_append_oid (place_query, "user", -1, user_oid);
@@ -193,11 +209,11 @@ u8 place_get_by_oid (
 	u8 retval = 1;
 
 	if (place) {
-		bson_t *place_query = bson_new ();
+		bson_t *place_query = db_query_new ();
 		if (place_query) {
 			(void) bson_append_oid (place_query, "_id", -1, oid);
-			retval = mongo_find_one_with_opts (
-				places_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_PLACES, places_model,
 				place_query, query_opts,
 				place
 			);
@@ -222,8 +238,8 @@ u8 place_get_by_oid_and_user (
 		);
 
 		if (place_query) {
-			retval = mongo_find_one_with_opts (
-				places_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_PLACES, places_model,
 				place_query, query_opts,
 				place
 			);
@@ -237,7 +253,8 @@ u8 place_get_by_oid_and_user (
 u8 place_get_by_oid_and_user_to_json (
 	const bson_oid_t *oid, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 ) {
 
 	u8 retval = 1;
@@ -248,9 +265,9 @@ u8 place_get_by_oid_and_user_to_json (
 		);
 
 		if (place_query) {
-			retval = mongo_find_one_with_opts_to_json (
-				places_model,
-				place_query, query_opts,
+			retval = db_model_find_one_with_opts_to_output (
+				DB_COLLECTION_PLACES, places_model,
+				place_query, query_opts, shape,
 				json, json_len
 			);
 		}
@@ -267,9 +284,9 @@ static void place_location_to_bson (
 	bson_t location_doc = BSON_INITIALIZER;
 	(void) bson_append_document_begin (place_doc, "store", -1, &location_doc);
 
-	(void) bson_append_utf8 (&location_doc, "address", -1, location->address, -1);
-	(void) bson_append_utf8 (&location_doc, "lat", -1, location->lat, -1);
-	(void) bson_append_utf8 (&location_doc, "lon", -1, location->lon, -1);
+	db_append_str (&location_doc, "address", &location->address);
+	db_append_str (&location_doc, "lat", &location->lat);
+	db_append_str (&location_doc, "lon", &location->lon);
 
 	(void) bson_append_document_end (place_doc, &location_doc);
 
@@ -282,8 +299,8 @@ static void place_site_to_bson (
 	bson_t site_doc = BSON_INITIALIZER;
 	(void) bson_append_document_begin (place_doc, "site", -1, &site_doc);
 
-	(void) bson_append_utf8 (&site_doc, "link", -1, site->link, -1);
-	(void) bson_append_utf8 (&site_doc, "logo", -1, site->logo, -1);
+	db_append_str (&site_doc, "link", &site->link);
+	db_append_str (&site_doc, "logo", &site->logo);
 
 	(void) bson_append_document_end (place_doc, &site_doc);
 
@@ -300,8 +317,8 @@ static bson_t *place_to_bson (const Place *place) {
 
 			(void) bson_append_oid (doc, "user", -1, &place->user_oid);
 
-			(void) bson_append_utf8 (doc, "name", -1, place->name, -1);
-			(void) bson_append_utf8 (doc, "description", -1, place->description, -1);
+			db_append_str (doc, "name", &place->name);
+			db_append_str (doc, "description", &place->description);
 
 			(void) bson_append_int32 (doc, "type", -1, place->type);
 
@@ -319,9 +336,11 @@ static bson_t *place_to_bson (const Place *place) {
 				default: break;
 			}
 
-			(void) bson_append_utf8 (doc, "color", -1, place->color, -1);
+			db_append_str (doc, "color", &place->color);
 
 			(void) bson_append_date_time (doc, "date", -1, place->date * 1000);
+
+			(void) bson_append_date_time (doc, "updated", -1, db_now ());
         }
     }
 
@@ -329,19 +348,26 @@ static bson_t *place_to_bson (const Place *place) {
 
 }
 
-static bson_t *place_update_bson (const Place *place) {
+static bson_t *place_update_bson (
+	const Place *place, const u8 fields
+) {
 
 	bson_t *doc = NULL;
 
-    if (place) {
+    if (place && fields) {
         doc = bson_new ();
         if (doc) {
 			bson_t set_doc = BSON_INITIALIZER;
 			(void) bson_append_document_begin (doc, "$set", -1, &set_doc);
 
-			(void) bson_append_utf8 (&set_doc, "name", -1, place->name, -1);
-			(void) bson_append_utf8 (&set_doc, "description", -1, place->description, -1);
-			
+			if (fields & PLACE_FIELD_NAME)
+				db_append_str (&set_doc, "name", &place->name);
+
+			if (fields & PLACE_FIELD_DESCRIPTION)
+				db_append_str (&set_doc, "description", &place->description);
+
+			(void) bson_append_date_time (&set_doc, "updated", -1, db_now ());
+
 			(void) bson_append_document_end (doc, &set_doc);
         }
     }
@@ -358,12 +384,43 @@ mongoc_cursor_t *places_get_all_by_user (
 	mongoc_cursor_t *retval = NULL;
 
 	if (user_oid && opts) {
-		bson_t *query = bson_new ();
+		bson_t *query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "user", -1, user_oid);
 
-			retval = mongo_find_all_cursor_with_opts (
-				places_model,
+			retval = db_model_find_all_cursor_with_opts (
+				DB_COLLECTION_PLACES, places_model,
+				query, opts
+			);
+		}
+	}
+
+	return retval;
+
+}
+
+// get all the user's places created or updated after since (millis)
+// a since value of 0 returns all the user's places
+mongoc_cursor_t *places_get_all_by_user_since (
+	const bson_oid_t *user_oid, const int64_t since, const bson_t *opts
+) {
+
+	mongoc_cursor_t *retval = NULL;
+
+	if (user_oid && opts) {
+		bson_t *query = db_query_new ();
+		if (query) {
+			(void) bson_append_oid (query, "user", -1, user_oid);
+
+			if (since) {
+				bson_t updated = BSON_INITIALIZER;
+				(void) bson_append_document_begin (query, "updated", -1, &updated);
+				(void) bson_append_date_time (&updated, "$gte", -1, since);
+				(void) bson_append_document_end (query, &updated);
+			}
+
+			retval = db_model_find_all_cursor_with_opts (
+				DB_COLLECTION_PLACES, places_model,
 				query, opts
 			);
 		}
@@ -381,12 +438,12 @@ unsigned int places_get_all_by_user_to_json (
 	unsigned int retval = 1;
 
 	if (user_oid) {
-		bson_t *query = bson_new ();
+		bson_t *query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "user", -1, user_oid);
 
-			retval = mongo_find_all_to_json (
-				places_model,
+			retval = db_model_find_all_to_json (
+				DB_COLLECTION_PLACES, places_model,
 				query, opts,
 				"places",
 				json, json_len
@@ -400,37 +457,53 @@ unsigned int places_get_all_by_user_to_json (
 
 unsigned int place_insert_one (const Place *place) {
 
-	return mongo_insert_one (
-		places_model, place_to_bson (place)
+	return db_model_insert_one (
+		DB_COLLECTION_PLACES, places_model,
+		place_to_bson (place)
 	);
 
 }
 
-unsigned int place_update_one (const Place *place) {
+// updates only the selected fields of the user's place
+// matched is set with the number of places that matched
+// returns 0 on success, 1 on error
+unsigned int place_update_one (
+	const Place *place, const u8 fields,
+	int64_t *matched
+) {
 
-	return mongo_update_one (
-		places_model,
-		place_query_oid (&place->oid),
-		place_update_bson (place)
+	return db_update_one (
+		DB_COLLECTION_PLACES,
+		place_query_by_oid_and_user (
+			&place->oid, &place->user_oid
+		),
+		place_update_bson (place, fields),
+		matched
 	);
 
 }
 
+// deleted is set with the number of places that were removed
+// returns 0 on success, 1 on error
 unsigned int place_delete_one_by_oid_and_user (
-	const bson_oid_t *oid, const bson_oid_t *user_oid
+	const bson_oid_t *oid, const bson_oid_t *user_oid,
+	int64_t *deleted
 ) {
 
 	unsigned int retval = 1;
 
+	*deleted = 0;
+
 	if (oid && user_oid) {
-		bson_t *place_query = place_query_by_oid_and_user (
-			oid, user_oid
+		retval = db_delete_one (
+			DB_COLLECTION_PLACES,
+			place_query_by_oid_and_user (oid, user_oid),
+			deleted
 		);
 
-		if (place_query) {
-			retval = mongo_delete_one (
-				places_model, place_query
-			);
+		// the document is gone even if its tombstone can not be stored
+		if (!retval && *deleted) {
+			tombstone_record (TOMBSTONE_TYPE_PLACE, oid, user_oid);
 		}
 	}
 
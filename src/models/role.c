@@ -9,6 +9,8 @@
 #include <cmongo/model.h>
 #include <cmongo/select.h>
 
+#include "db.h"
+
 #include "models/role.h"
 
 static CMongoModel *roles_model = NULL;
@@ -134,7 +136,10 @@ static void role_doc_parse_actions (
 	if (actions_array) {
 		bson_iter_t array_iter = { 0 };
 		if (bson_iter_init (&array_iter, actions_array)) {
-			while (bson_iter_next (&array_iter)) {
+			while (
+				(role->n_actions < ROLE_ACTIONS_SIZE)
+				&& bson_iter_next (&array_iter)
+			) {
 				// const char *key = bson_iter_key (&array_iter);
 				const bson_value_t *value = bson_iter_value (&array_iter);
 
@@ -192,8 +197,8 @@ unsigned int role_get_by_oid (
 		bson_t *role_query = bson_new ();
 		if (role_query) {
 			(void) bson_append_oid (role_query, "_id", -1, oid);
-			retval = mongo_find_one_with_opts (
-				roles_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_ROLES, roles_model,
 				role_query, query_opts,
 				role
 			);
@@ -215,8 +220,8 @@ unsigned int role_get_by_cuc (
 		bson_t *role_query = bson_new ();
 		if (role_query) {
 			(void) bson_append_utf8 (role_query, "cuc", -1, cuc, -1);
-			retval = mongo_find_one_with_opts (
-				roles_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_ROLES, roles_model,
 				role_query, query_opts,
 				role
 			);
@@ -297,8 +302,9 @@ mongoc_cursor_t *role_find_all (
 	const CMongoSelect *select, uint64_t *n_docs
 ) {
 
-	return mongo_find_all_cursor (
-		roles_model, bson_new (), select, n_docs
+	return db_model_find_all_cursor (
+		DB_COLLECTION_ROLES, roles_model,
+		bson_new (), select, n_docs
 	);
 
 }
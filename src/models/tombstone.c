@@ -0,0 +1,162 @@
+#include <stdlib.h>
+
+#include <cerver/types/types.h>
+
+#include <cerver/utils/log.h>
+
+#include <cmongo/collections.h>
+#include <cmongo/crud.h>
+#include <cmongo/model.h>
+
+#include "db.h"
+#include "output.h"
+
+#include "models/tombstone.h"
+#include "models/user.h"
+
+static CMongoModel *tombstones_model = NULL;
+
+static const bson_t *tombstones_query_opts = NULL;
+
+PocketOutputShape tombstones_shape = { 0 };
+
+static const DbIndex tombstones_indexes[] = {
+	{ .name = "user_date", .fields = { { "user", 1 }, { "date", 1 } } },
+	{ .name = "date_ttl", .fields = { { "date", 1 } }, .expire_seconds = TOMBSTONES_TTL },
+	{ .name = NULL }
+};
+
+static const DbQueryShape tombstones_queries[] = {
+	{ .name = "sync", .filter = { "user", "date" } },
+	{ .name = NULL }
+};
+
+unsigned int tombstones_model_init (void) {
+
+	unsigned int retval = 1;
+
+	tombstones_model = cmongo_model_create (TOMBSTONES_COLL_NAME);
+	if (tombstones_model) {
+		// only { type, ref, date } are returned
+		tombstones_query_opts = BCON_NEW (
+			"projection", "{",
+				"_id", BCON_BOOL (false),
+				"type", BCON_BOOL (true),
+				"ref", BCON_BOOL (true),
+				"date", BCON_BOOL (true),
+			"}"
+		);
+
+		retval = pocket_output_shape_init (
+			&tombstones_shape, tombstones_query_opts
+		);
+
+		retval |= db_indexes_init (
+			DB_COLLECTION_TOMBSTONES,
+			tombstones_indexes, tombstones_queries
+		);
+	}
+
+	return retval;
+
+}
+
+void tombstones_model_end (void) {
+
+	bson_destroy ((bson_t *) tombstones_query_opts);
+	tombstones_query_opts = NULL;
+
+	cmongo_model_delete (tombstones_model);
+
+}
+
+// records that the user's document was deleted
+// { user, type, ref, date }
+unsigned int tombstone_insert_one (
+	const TombstoneType type,
+	const bson_oid_t *ref_oid, const bson_oid_t *user_oid
+) {
+
+	unsigned int retval = 1;
+
+	bson_t *doc = bson_new ();
+	if (doc) {
+		bson_oid_t oid = { 0 };
+		bson_oid_init (&oid, NULL);
+
+		(void) bson_append_oid (doc, "_id", -1, &oid);
+		(void) bson_append_oid (doc, "user", -1, user_oid);
+		(void) bson_append_int32 (doc, "type", -1, type);
+		(void) bson_append_oid (doc, "ref", -1, ref_oid);
+		(void) bson_append_date_time (doc, "date", -1, db_now ());
+
+		retval = db_model_insert_one (
+			DB_COLLECTION_TOMBSTONES, tombstones_model,
+			doc
+		);
+	}
+
+	return retval;
+
+}
+
+// stores the document's tombstone after it was deleted
+// if it can not be stored, the user's next syncs since before now
+// are full syncs, so its clients never keep the deleted document
+void tombstone_record (
+	const TombstoneType type,
+	const bson_oid_t *ref_oid, const bson_oid_t *user_oid
+) {
+
+	unsigned int tries = 0;
+	unsigned int retval = 1;
+	while (retval && (tries < TOMBSTONE_INSERT_TRIES)) {
+		retval = tombstone_insert_one (type, ref_oid, user_oid);
+		tries += 1;
+	}
+
+	if (retval) {
+		char ref_id[TOMBSTONE_ID_SIZE] = { 0 };
+		char user_id[TOMBSTONE_ID_SIZE] = { 0 };
+		bson_oid_to_string (ref_oid, ref_id);
+		bson_oid_to_string (user_oid, user_id);
+
+		cerver_log_error (
+			"Failed to insert tombstone for %d %s of user %s - requiring a full sync",
+			type, ref_id, user_id
+		);
+
+		if (user_update_sync_reset (user_oid, db_now ())) {
+			cerver_log_error (
+				"Failed to require a full sync for user %s!", user_id
+			);
+		}
+	}
+
+}
+
+// get all the user's tombstones created after since (millis)
+// as { type, ref, date }
+mongoc_cursor_t *tombstones_get_all_by_user_since (
+	const bson_oid_t *user_oid, const int64_t since
+) {
+
+	mongoc_cursor_t *retval = NULL;
+
+	if (user_oid) {
+		bson_t *query = BCON_NEW (
+			"user", BCON_OID (user_oid),
+			"date", "{", "$gte", BCON_DATE_TIME (since), "}"
+		);
+
+		if (query) {
+			retval = db_model_find_all_cursor_with_opts (
+				DB_COLLECTION_TOMBSTONES, tombstones_model,
+				query, tombstones_query_opts
+			);
+		}
+	}
+
+	return retval;
+
+}
@@ -1,5 +1,7 @@
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 
 #include <time.h>
 
@@ -11,14 +13,63 @@
 #include <cmongo/crud.h>
 #include <cmongo/model.h>
 
+#include "db.h"
+
+#include "models/tombstone.h"
 #include "models/transaction.h"
 
 static CMongoModel *transactions_model = NULL;
 
+// the summary is written with all of its fields
+static PocketOutputShape transactions_summary_shape = { 0 };
+
 static void trans_doc_parse (
 	void *trans_ptr, const bson_t *trans_doc
 );
 
+// used to list a user's transactions by pages
+// optionally filtered by category or place
+static const DbIndex transactions_indexes[] = {
+	{
+		.name = "user_date_id",
+		.fields = { { "user", 1 }, { "date", -1 }, { "_id", -1 } }
+	},
+	{
+		.name = "user_category_date_id",
+		.fields = { { "user", 1 }, { "category", 1 }, { "date", -1 }, { "_id", -1 } }
+	},
+	{
+		.name = "user_place_date_id",
+		.fields = { { "user", 1 }, { "place", 1 }, { "date", -1 }, { "_id", -1 } }
+	},
+	{
+		.name = "user_updated",
+		.fields = { { "user", 1 }, { "updated", 1 } }
+	},
+	{ .name = NULL }
+};
+
+static const DbQueryShape transactions_queries[] = {
+	{
+		.name = "list",
+		.filter = { "user" },
+		.sort = { { "date", -1 }, { "_id", -1 } }
+	},
+	{
+		.name = "list_by_category",
+		.filter = { "user", "category" },
+		.sort = { { "date", -1 }, { "_id", -1 } }
+	},
+	{
+		.name = "list_by_place",
+		.filter = { "user", "place" },
+		.sort = { { "date", -1 }, { "_id", -1 } }
+	},
+	{ .name = "summary", .filter = { "user", "date" } },
+	{ .name = "sync", .filter = { "user", "updated" } },
+	{ .name = NULL }
+};
+
 unsigned int transactions_model_init (void) {
 
 	unsigned int retval = 1;
@@ -27,7 +78,14 @@ unsigned int transactions_model_init (void) {
 	if (transactions_model) {
 		cmongo_model_set_parser (transactions_model, trans_doc_parse);
 
-		retval = 0;
+		retval = db_indexes_init (
+			DB_COLLECTION_TRANSACTIONS,
+			transactions_indexes, transactions_queries
+		);
+
+		retval |= pocket_output_shape_init (
+			&transactions_summary_shape, NULL
+		);
 	}
 
 	return retval;
@@ -76,7 +134,7 @@ void transaction_print (Transaction *transaction) {
 		bson_oid_to_string (&transaction->oid, buffer);
 		(void) printf ("id: %s\n", buffer);
 
-		(void) printf ("title: %s\n", transaction->title);
+		(void) printf ("title: %.*s\n", POCKET_STR_FORMAT (transaction->title));
 		(void) printf ("amount: %.4f\n", transaction->amount);
 
 		(void) strftime (buffer, 128, "%d/%m/%y - %T", gmtime (&transaction->date));
@@ -101,7 +159,6 @@ static void trans_doc_parse (
 
 			if (!strcmp (key, "_id")) {
 				bson_oid_copy (&value->value.v_oid, &trans->oid);
-				bson_oid_to_string (&trans->oid, trans->id);
 			}
 
 			else if (!strcmp (key, "user"))
@@ -119,11 +176,10 @@ static void trans_doc_parse (
 			else if (!strcmp (key, "currency"))
 				bson_oid_copy (&value->value.v_oid, &trans->currency_oid);
 
-			else if (!strcmp (key, "title") && value->value.v_utf8.str) {
-				(void) strncpy (
-					trans->title,
-					value->value.v_utf8.str,
-					TRANSACTION_TITLE_SIZE - 1
+			else if (!strcmp (key, "title")) {
+				(void) db_iter_str (
+					&iter, trans->arena,
+					TRANSACTION_TITLE_MAX, &trans->title
 				);
 			}
 
@@ -140,12 +196,55 @@ static void trans_doc_parse (
 
 }
 
+// encodes the transaction's sort values into an opaque cursor string
+// that can be used to request the next page
+void transactions_cursor_encode (
+	char *cursor, const int64_t date, const bson_oid_t *oid
+) {
+
+	char oid_string[TRANSACTION_ID_SIZE] = { 0 };
+	bson_oid_to_string (oid, oid_string);
+
+	(void) snprintf (
+		cursor, TRANSACTIONS_CURSOR_SIZE,
+		"%016" PRIx64 "%s", (uint64_t) date, oid_string
+	);
+
+}
+
+// decodes a cursor string into the query's after values
+// returns 0 on success, 1 on invalid cursor
+unsigned int transactions_cursor_decode (
+	TransactionsQuery *query, const char *cursor
+) {
+
+	unsigned int retval = 1;
+
+	if (query && cursor && (strlen (cursor) == 40)) {
+		char date_string[17] = { 0 };
+		(void) memcpy (date_string, cursor, 16);
+
+		char *end = NULL;
+		uint64_t date = strtoull (date_string, &end, 16);
+		if (end && (*end == '\0') && bson_oid_is_valid (cursor + 16, 24)) {
+			query->after = true;
+			query->after_date = (int64_t) date;
+			bson_oid_init_from_string (&query->after_oid, cursor + 16);
+
+			retval = 0;
+		}
+	}
+
+	return retval;
+
+}
+
 bson_t *transaction_query_oid (const bson_oid_t *oid) {
 
 	bson_t *query = NULL;
 
 	if (oid) {
-		query = bson_new ();
+		query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "_id", -1, oid);
 		}
@@ -159,7 +258,7 @@ bson_t *transaction_query_by_oid_and_user (
 	const bson_oid_t *oid, const bson_oid_t *user_oid
 ) {
 
-	bson_t *transaction_query = bson_new ();
+	bson_t *transaction_query = db_query_new ();
 	if (transaction_query) {
 		(void) bson_append_oid (transaction_query, "_id", -1, oid);
 		(void) bson_append_oid (transaction_query, "user", -1, user_oid);
@@ -176,11 +275,11 @@ u8 transaction_get_by_oid (
 	u8 retval = 1;
 
 	if (trans && oid) {
-		bson_t *trans_query = bson_new ();
+		bson_t *trans_query = db_query_new ();
 		if (trans_query) {
 			(void) bson_append_oid (trans_query, "_id", -1, oid);
-			retval = mongo_find_one_with_opts (
-				transactions_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_TRANSACTIONS, transactions_model,
 				trans_query, query_opts,
 				trans
 			);
@@ -205,8 +304,8 @@ u8 transaction_get_by_oid_and_user (
 		);
 
 		if (trans_query) {
-			retval = mongo_find_one_with_opts (
-				transactions_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_TRANSACTIONS, transactions_model,
 				trans_query, query_opts,
 				trans
 			);
@@ -220,7 +319,8 @@ u8 transaction_get_by_oid_and_user (
 u8 transaction_get_by_oid_and_user_to_json (
 	const bson_oid_t *oid, const bson_oid_t *user_oid,
 	const bson_t *query_opts,
-	char **json, size_t *json_len
+	const PocketOutputShape *shape,
+	const char **json, size_t *json_len
 ) {
 
 	u8 retval = 1;
@@ -231,9 +331,9 @@ u8 transaction_get_by_oid_and_user_to_json (
 		);
 
 		if (trans_query) {
-			retval = mongo_find_one_with_opts_to_json (
-				transactions_model,
-				trans_query, query_opts,
+			retval = db_model_find_one_with_opts_to_output (
+				DB_COLLECTION_TRANSACTIONS, transactions_model,
+				trans_query, query_opts, shape,
 				json, json_len
 			);
 		}
@@ -257,11 +357,13 @@ static bson_t *transaction_to_bson (const Transaction *trans) {
 			(void) bson_append_oid (doc, "category", -1, &trans->category_oid);
 			(void) bson_append_oid (doc, "place", -1, &trans->place_oid);
 
-			(void) bson_append_utf8 (doc, "title", -1, trans->title, -1);
+			db_append_str (doc, "title", &trans->title);
 			(void) bson_append_double (doc, "amount", -1, trans->amount);
 			(void) bson_append_date_time (doc, "date", -1, trans->date * 1000);
 
 			(void) bson_append_int32 (doc, "type", -1, trans->type);
+
+			(void) bson_append_date_time (doc, "updated", -1, db_now ());
 		}
 	}
 
@@ -269,23 +371,32 @@ static bson_t *transaction_to_bson (const Transaction *trans) {
 
 }
 
-static bson_t *transaction_update_bson (const Transaction *trans) {
+static bson_t *transaction_update_bson (
+	const Transaction *trans, const u8 fields
+) {
 
 	bson_t *doc = NULL;
 
-	if (trans) {
+	if (trans && fields) {
 		doc = bson_new ();
 		if (doc) {
 			bson_t set_doc = BSON_INITIALIZER;
 			(void) bson_append_document_begin (doc, "$set", -1, &set_doc);
-			(void) bson_append_utf8 (&set_doc, "title", -1, trans->title, -1);
-			(void) bson_append_double (&set_doc, "amount", -1, trans->amount);
 
-			(void) bson_append_oid (&set_doc, "category", -1, &trans->category_oid);
+			if (fields & TRANSACTION_FIELD_TITLE)
+				db_append_str (&set_doc, "title", &trans->title);
+
+			if (fields & TRANSACTION_FIELD_AMOUNT)
+				(void) bson_append_double (&set_doc, "amount", -1, trans->amount);
 
-			(void) bson_append_oid (&set_doc, "place", -1, &trans->place_oid);
+			if (fields & TRANSACTION_FIELD_CATEGORY)
+				(void) bson_append_oid (&set_doc, "category", -1, &trans->category_oid);
+
+			if (fields & TRANSACTION_FIELD_PLACE)
+				(void) bson_append_oid (&set_doc, "place", -1, &trans->place_oid);
+
+			(void) bson_append_date_time (&set_doc, "updated", -1, db_now ());
 
-			// (void) bson_append_date_time (&set_doc, "date", -1, trans->date * 1000);
 			(void) bson_append_document_end (doc, &set_doc);
 		}
 	}
@@ -294,20 +405,165 @@ static bson_t *transaction_update_bson (const Transaction *trans) {
 
 }
 
+// { user, $or: [ { date < after }, { date == after, _id < after } ] }
+static void transactions_query_append_after (
+	bson_t *query, const TransactionsQuery *trans_query
+) {
+
+	bson_t or_array = BSON_INITIALIZER;
+	(void) bson_append_array_begin (query, "$or", -1, &or_array);
+
+	bson_t before_date = BSON_INITIALIZER;
+	(void) bson_append_document_begin (&or_array, "0", -1, &before_date);
+	bson_t date_lt = BSON_INITIALIZER;
+	(void) bson_append_document_begin (&before_date, "date", -1, &date_lt);
+	(void) bson_append_date_time (&date_lt, "$lt", -1, trans_query->after_date);
+	(void) bson_append_document_end (&before_date, &date_lt);
+	(void) bson_append_document_end (&or_array, &before_date);
+
+	bson_t same_date = BSON_INITIALIZER;
+	(void) bson_append_document_begin (&or_array, "1", -1, &same_date);
+	(void) bson_append_date_time (&same_date, "date", -1, trans_query->after_date);
+	bson_t id_lt = BSON_INITIALIZER;
+	(void) bson_append_document_begin (&same_date, "_id", -1, &id_lt);
+	(void) bson_append_oid (&id_lt, "$lt", -1, &trans_query->after_oid);
+	(void) bson_append_document_end (&same_date, &id_lt);
+	(void) bson_append_document_end (&or_array, &same_date);
+
+	(void) bson_append_array_end (query, &or_array);
+
+}
+
+// { date: { $gte: from, $lt: to }, category, place, amount: { $gte: min, $lte: max } }
+static void transactions_query_append_filters (
+	bson_t *query, const TransactionsQuery *trans_query
+) {
+
+	if (trans_query->from || trans_query->to) {
+		bson_t date_range = BSON_INITIALIZER;
+		(void) bson_append_document_begin (query, "date", -1, &date_range);
+		if (trans_query->from) (void) bson_append_date_time (&date_range, "$gte", -1, trans_query->from_date);
+		if (trans_query->to) (void) bson_append_date_time (&date_range, "$lt", -1, trans_query->to_date);
+		(void) bson_append_document_end (query, &date_range);
+	}
+
+	if (trans_query->category) {
+		(void) bson_append_oid (query, "category", -1, &trans_query->category_oid);
+	}
+
+	if (trans_query->place) {
+		(void) bson_append_oid (query, "place", -1, &trans_query->place_oid);
+	}
+
+	if (trans_query->min || trans_query->max) {
+		bson_t amount_range = BSON_INITIALIZER;
+		(void) bson_append_document_begin (query, "amount", -1, &amount_range);
+		if (trans_query->min) (void) bson_append_double (&amount_range, "$gte", -1, trans_query->min_amount);
+		if (trans_query->max) (void) bson_append_double (&amount_range, "$lte", -1, trans_query->max_amount);
+		(void) bson_append_document_end (query, &amount_range);
+	}
+
+}
+
+// adds the sort & limit values required by the query
+// to a copy of the original find opts
+static bson_t *transactions_query_opts (
+	const TransactionsQuery *trans_query, const bson_t *opts
+) {
+
+	bson_t *query_opts = bson_copy (opts);
+	if (query_opts) {
+		bson_t sort = BSON_INITIALIZER;
+		(void) bson_append_document_begin (query_opts, "sort", -1, &sort);
+		(void) bson_append_int32 (&sort, "date", -1, -1);
+		(void) bson_append_int32 (&sort, "_id", -1, -1);
+		(void) bson_append_document_end (query_opts, &sort);
+
+		if (trans_query->limit) {
+			(void) bson_append_int64 (
+				query_opts, "limit", -1, (int64_t) trans_query->limit
+			);
+		}
+	}
+
+	return query_opts;
+
+}
+
 // get all the transactions that are related to a user
+// if a query is set, only the matching page is returned
 mongoc_cursor_t *transactions_get_all_by_user (
-	const bson_oid_t *user_oid, const bson_t *opts
+	const bson_oid_t *user_oid,
+	const TransactionsQuery *trans_query, const bson_t *opts
+) {
+
+	mongoc_cursor_t *retval = NULL;
+
+	if (user_oid && opts) {
+		bson_t *query = db_query_new ();
+		if (query) {
+			(void) bson_append_oid (query, "user", -1, user_oid);
+
+			if (trans_query) {
+				transactions_query_append_filters (query, trans_query);
+
+				if (trans_query->after) {
+					transactions_query_append_after (query, trans_query);
+				}
+
+				bson_t *query_opts = transactions_query_opts (
+					trans_query, opts
+				);
+
+				if (query_opts) {
+					retval = db_model_find_all_cursor_with_opts (
+						DB_COLLECTION_TRANSACTIONS, transactions_model,
+						query, query_opts
+					);
+
+					bson_destroy (query_opts);
+				}
+
+				else {
+					bson_destroy (query);
+				}
+			}
+
+			else {
+				retval = db_model_find_all_cursor_with_opts (
+					DB_COLLECTION_TRANSACTIONS, transactions_model,
+					query, opts
+				);
+			}
+		}
+	}
+
+	return retval;
+
+}
+
+// get all the user's transactions created or updated after since (millis)
+// a since value of 0 returns all the user's transactions
+mongoc_cursor_t *transactions_get_all_by_user_since (
+	const bson_oid_t *user_oid, const int64_t since, const bson_t *opts
 ) {
 
 	mongoc_cursor_t *retval = NULL;
 
 	if (user_oid && opts) {
-		bson_t *query = bson_new ();
+		bson_t *query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "user", -1, user_oid);
 
-			retval = mongo_find_all_cursor_with_opts (
-				transactions_model,
+			if (since) {
+				bson_t updated = BSON_INITIALIZER;
+				(void) bson_append_document_begin (query, "updated", -1, &updated);
+				(void) bson_append_date_time (&updated, "$gte", -1, since);
+				(void) bson_append_document_end (query, &updated);
+			}
+
+			retval = db_model_find_all_cursor_with_opts (
+				DB_COLLECTION_TRANSACTIONS, transactions_model,
 				query, opts
 			);
 		}
@@ -325,12 +581,12 @@ unsigned int transactions_get_all_by_user_to_json (
 	unsigned int retval = 1;
 
 	if (user_oid) {
-		bson_t *query = bson_new ();
+		bson_t *query = db_query_new ();
 		if (query) {
 			(void) bson_append_oid (query, "user", -1, user_oid);
 
-			retval = mongo_find_all_to_json (
-				transactions_model,
+			retval = db_model_find_all_to_json (
+				DB_COLLECTION_TRANSACTIONS, transactions_model,
 				query, opts,
 				"transactions",
 				json, json_len
@@ -342,39 +598,265 @@ unsigned int transactions_get_all_by_user_to_json (
 
 }
 
+static bson_t *transactions_summary_pipeline (const bson_t *match) {
+
+	return BCON_NEW (
+		"pipeline", "[",
+			"{", "$match", BCON_DOCUMENT (match), "}",
+			"{", "$facet", "{",
+				"categories", "[",
+					"{", "$group", "{",
+						"_id", BCON_UTF8 ("$category"),
+						"total", "{", "$sum", BCON_UTF8 ("$amount"), "}",
+						"count", "{", "$sum", BCON_INT32 (1), "}",
+					"}", "}",
+					"{", "$sort", "{", "total", BCON_INT32 (-1), "}", "}",
+				"]",
+				"months", "[",
+					"{", "$group", "{",
+						"_id", "{",
+							"year", "{", "$year", BCON_UTF8 ("$date"), "}",
+							"month", "{", "$month", BCON_UTF8 ("$date"), "}",
+						"}",
+						"total", "{", "$sum", BCON_UTF8 ("$amount"), "}",
+						"count", "{", "$sum", BCON_INT32 (1), "}",
+					"}", "}",
+					"{", "$sort", "{", "_id.year", BCON_INT32 (1), "_id.month", BCON_INT32 (1), "}", "}",
+				"]",
+			"}", "}",
+		"]"
+	);
+
+}
+
+// sums the user's transactions amounts by category & by month
+// {"categories": [ { _id, total, count } ], "months": [ { _id: { year, month }, total, count } ]}
+// only the query's date range, category & place filters are used
+unsigned int transactions_get_summary_by_user_to_json (
+	const bson_oid_t *user_oid, const TransactionsQuery *trans_query,
+	const char **json, size_t *json_len
+) {
+
+	unsigned int retval = 1;
+
+	if (user_oid && trans_query) {
+		bson_t match = BSON_INITIALIZER;
+		(void) bson_append_oid (&match, "user", -1, user_oid);
+		transactions_query_append_filters (&match, trans_query);
+
+		bson_t *pipeline = transactions_summary_pipeline (&match);
+
+		DbTimer timer = { 0 };
+		db_timer_start (
+			&timer, DB_COLLECTION_TRANSACTIONS, DB_OPERATION_AGGREGATE, pipeline
+		);
+
+		mongoc_client_t *client = db_client_pop ();
+		if (client) {
+			mongoc_collection_t *collection = db_collection_get (
+				client, TRANSACTIONS_COLL_NAME
+			);
+
+			mongoc_cursor_t *cursor = mongoc_collection_aggregate (
+				collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL
+			);
+
+			// $facet always outputs a single document
+			const bson_t *summary_doc = NULL;
+			if (mongoc_cursor_next (cursor, &summary_doc)) {
+				*json = pocket_output_doc (
+					&transactions_summary_shape, summary_doc, json_len
+				);
+
+				if (*json) retval = 0;
+			}
+
+			else {
+				bson_error_t error = { 0 };
+				if (mongoc_cursor_error (cursor, &error)) {
+					cerver_log_error (
+						"transactions_get_summary_by_user_to_json () - %s",
+						error.message
+					);
+				}
+			}
+
+			mongoc_cursor_destroy (cursor);
+			mongoc_collection_destroy (collection);
+
+			db_client_push (client);
+		}
+
+		db_timer_end (&timer);
+
+		bson_destroy (pipeline);
+		bson_destroy (&match);
+	}
+
+	return retval;
+
+}
+
 unsigned int transaction_insert_one (const Transaction *transaction) {
 
-	return mongo_insert_one (
-		transactions_model, transaction_to_bson (transaction)
+	return db_model_insert_one (
+		DB_COLLECTION_TRANSACTIONS, transactions_model,
+		transaction_to_bson (transaction)
 	);
 
 }
 
-unsigned int transaction_update_one (const Transaction *transaction) {
+// marks the transactions that were reported in the reply's write errors
+static void transactions_insert_many_errors (
+	const bson_t *reply, const size_t n_transactions, u8 *errors
+) {
+
+	bson_iter_t iter = { 0 };
+	bson_iter_t write_errors = { 0 };
+	bson_iter_t write_error = { 0 };
+	if (
+		bson_iter_init_find (&iter, reply, "writeErrors")
+		&& BSON_ITER_HOLDS_ARRAY (&iter)
+		&& bson_iter_recurse (&iter, &write_errors)
+	) {
+		while (bson_iter_next (&write_errors)) {
+			if (
+				bson_iter_recurse (&write_errors, &write_error)
+				&& bson_iter_find (&write_error, "index")
+			) {
+				int64_t index = bson_iter_as_int64 (&write_error);
+				if ((index >= 0) && ((size_t) index < n_transactions)) {
+					errors[index] = 1;
+				}
+			}
+		}
+	}
+
+}
+
+// inserts all the transactions using a single unordered batch
+// the errors array is set to 1 for every transaction that failed
+// returns the number of inserted transactions
+size_t transactions_insert_many (
+	const Transaction **transactions, const size_t n_transactions,
+	u8 *errors
+) {
+
+	size_t inserted = 0;
+
+	bson_t **docs = (bson_t **) calloc (n_transactions, sizeof (bson_t *));
+	if (docs) {
+		for (size_t idx = 0; idx < n_transactions; idx++) {
+			docs[idx] = transaction_to_bson (transactions[idx]);
+		}
+
+		DbTimer timer = { 0 };
+		db_timer_start (
+			&timer, DB_COLLECTION_TRANSACTIONS, DB_OPERATION_INSERT_MANY, NULL
+		);
+
+		mongoc_client_t *client = db_client_pop ();
+		if (client) {
+			mongoc_collection_t *collection = db_collection_get (
+				client, TRANSACTIONS_COLL_NAME
+			);
+
+			bson_t opts = BSON_INITIALIZER;
+			(void) bson_append_bool (&opts, "ordered", -1, false);
+
+			bson_t reply = BSON_INITIALIZER;
+			bson_error_t error = { 0 };
+			bool success = mongoc_collection_insert_many (
+				collection,
+				(const bson_t **) docs, n_transactions,
+				&opts, &reply, &error
+			);
+
+			bson_iter_t iter = { 0 };
+			if (bson_iter_init_find (&iter, &reply, "insertedCount")) {
+				inserted = (size_t) bson_iter_as_int64 (&iter);
+			}
+
+			if (!success) {
+				#ifdef POCKET_DEBUG
+				cerver_log_error ("transactions_insert_many () - %s", error.message);
+				#endif
+
+				if (bson_has_field (&reply, "writeErrors")) {
+					transactions_insert_many_errors (&reply, n_transactions, errors);
+				}
+
+				// the whole batch failed
+				else {
+					(void) memset (errors, 1, n_transactions);
+					inserted = 0;
+				}
+			}
+
+			bson_destroy (&reply);
+			bson_destroy (&opts);
+			mongoc_collection_destroy (collection);
+
+			db_client_push (client);
+		}
+
+		else {
+			(void) memset (errors, 1, n_transactions);
+		}
+
+		db_timer_end (&timer);
+
+		for (size_t idx = 0; idx < n_transactions; idx++) {
+			bson_destroy (docs[idx]);
+		}
+
+		free (docs);
+	}
+
+	return inserted;
+
+}
+
+// updates only the selected fields of the user's transaction
+// matched is set with the number of transactions that matched
+// returns 0 on success, 1 on error
+unsigned int transaction_update_one (
+	const Transaction *transaction, const u8 fields,
+	int64_t *matched
+) {
 
-	return mongo_update_one (
-		transactions_model,
-		transaction_query_oid (&transaction->oid),
-		transaction_update_bson (transaction)
+	return db_update_one (
+		DB_COLLECTION_TRANSACTIONS,
+		transaction_query_by_oid_and_user (
+			&transaction->oid, &transaction->user_oid
+		),
+		transaction_update_bson (transaction, fields),
+		matched
 	);
 
 }
 
+// deleted is set with the number of transactions that were removed
+// returns 0 on success, 1 on error
 unsigned int transaction_delete_one_by_oid_and_user (
-	const bson_oid_t *oid, const bson_oid_t *user_oid
+	const bson_oid_t *oid, const bson_oid_t *user_oid,
+	int64_t *deleted
 ) {
 
 	unsigned int retval = 1;
 
+	*deleted = 0;
+
 	if (oid && user_oid) {
-		bson_t *transaction_query = transaction_query_by_oid_and_user (
-			oid, user_oid
+		retval = db_delete_one (
+			DB_COLLECTION_TRANSACTIONS,
+			transaction_query_by_oid_and_user (oid, user_oid),
+			deleted
 		);
 
-		if (transaction_query) {
-			retval = mongo_delete_one (
-				transactions_model, transaction_query
-			);
+		// the document is gone even if its tombstone can not be stored
+		if (!retval && *deleted) {
+			tombstone_record (TOMBSTONE_TYPE_TRANSACTION, oid, user_oid);
 		}
 	}
 
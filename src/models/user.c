@@ -10,6 +10,9 @@
 #include <cmongo/collections.h>
 #include <cmongo/crud.h>
 #include <cmongo/model.h>
+#include <cmongo/select.h>
+
+#include "db.h"
 
 #include "models/user.h"
 
@@ -19,6 +22,17 @@ static void user_doc_parse (
 	void *user_ptr, const bson_t *user_doc
 );
 
+// emails must be unique, even if two registers race
+static const DbIndex users_indexes[] = {
+	{ .name = "email_unique", .fields = { { "email", 1 } }, .unique = true },
+	{ .name = NULL }
+};
+
+static const DbQueryShape users_queries[] = {
+	{ .name = "login", .filter = { "email" } },
+	{ .name = NULL }
+};
+
 unsigned int users_model_init (void) {
 
 	unsigned int retval = 1;
@@ -27,7 +41,9 @@ unsigned int users_model_init (void) {
 	if (users_model) {
 		cmongo_model_set_parser (users_model, user_doc_parse);
 
-		retval = 0;
+		retval = db_indexes_init (
+			DB_COLLECTION_USERS, users_indexes, users_queries
+		);
 	}
 
 	return retval;
@@ -137,6 +153,10 @@ static void user_doc_parse (
 			else if (!strcmp (key, "placesCount")) {
 				user->places_count = value->value.v_int32;
 			}
+
+			else if (!strcmp (key, "syncReset") && BSON_ITER_HOLDS_DATE_TIME (&iter)) {
+				user->sync_reset = bson_iter_date_time (&iter);
+			}
 		}
 	}
 
@@ -147,7 +167,7 @@ bson_t *user_query_id (const char *id) {
 	bson_t *query = NULL;
 
 	if (id) {
-		query = bson_new ();
+		query = db_query_new ();
 		if (query) {
 			bson_oid_t oid = { 0 };
 			bson_oid_init_from_string (&oid, id);
@@ -164,7 +184,7 @@ bson_t *user_query_email (const char *email) {
 	bson_t *query = NULL;
 
 	if (email) {
-		query = bson_new ();
+		query = db_query_new ();
 		if (query) {
 			(void) bson_append_utf8 (query, "email", -1, email, -1);
 		}
@@ -184,11 +204,33 @@ u8 user_get_by_id (
 		bson_oid_t oid = { 0 };
 		bson_oid_init_from_string (&oid, id);
 
-		bson_t *user_query = bson_new ();
+		bson_t *user_query = db_query_new ();
 		if (user_query) {
 			(void) bson_append_oid (user_query, "_id", -1, &oid);
-			retval = mongo_find_one_with_opts (
-				users_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_USERS, users_model,
+				user_query, query_opts,
+				user
+			);
+		}
+	}
+
+	return retval;
+
+}
+
+u8 user_get_by_oid (
+	User *user, const bson_oid_t *oid, const bson_t *query_opts
+) {
+
+	u8 retval = 1;
+
+	if (user && oid) {
+		bson_t *user_query = db_query_new ();
+		if (user_query) {
+			(void) bson_append_oid (user_query, "_id", -1, oid);
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_USERS, users_model,
 				user_query, query_opts,
 				user
 			);
@@ -201,7 +243,27 @@ u8 user_get_by_id (
 
 u8 user_check_by_email (const char *email) {
 
-	return mongo_check (users_model, user_query_email (email));
+	return db_model_check (
+		DB_COLLECTION_USERS, users_model,
+		user_query_email (email)
+	);
+
+}
+
+// returns a cursor with every user's { _id, email }
+mongoc_cursor_t *users_get_all_emails (uint64_t *n_docs) {
+
+	CMongoSelect *select = cmongo_select_new ();
+	(void) cmongo_select_insert_field (select, "email");
+
+	mongoc_cursor_t *cursor = db_model_find_all_cursor (
+		DB_COLLECTION_USERS, users_model,
+		db_query_new (), select, n_docs
+	);
+
+	cmongo_select_delete (select);
+
+	return cursor;
 
 }
 
@@ -213,11 +275,11 @@ u8 user_get_by_email (
 	u8 retval = 1;
 
 	if (user && email) {
-		bson_t *user_query = bson_new ();
+		bson_t *user_query = db_query_new ();
 		if (user_query) {
 			(void) bson_append_utf8 (user_query, "email", -1, email, -1);
-			retval = mongo_find_one_with_opts (
-				users_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_USERS, users_model,
 				user_query, query_opts,
 				user
 			);
@@ -236,11 +298,11 @@ u8 user_get_by_username (
 	u8 retval = 1;
 
 	if (user && username) {
-		bson_t *user_query = bson_new ();
+		bson_t *user_query = db_query_new ();
 		if (user_query) {
 			(void) bson_append_utf8 (user_query, "username", -1, username->str, username->len);
-			retval = mongo_find_one_with_opts (
-				users_model,
+			retval = db_model_find_one_with_opts (
+				DB_COLLECTION_USERS, users_model,
 				user_query, query_opts,
 				user
 			);
@@ -276,11 +338,18 @@ bson_t *user_bson_create (const User *user) {
 // adds one to user's transactions count
 bson_t *user_create_update_pocket_transactions (void) {
 
+	return user_create_update_pocket_transactions_count (1);
+
+}
+
+// adds count to user's transactions count
+bson_t *user_create_update_pocket_transactions_count (const int count) {
+
 	bson_t *doc = bson_new ();
 	if (doc) {
 		bson_t inc_doc = BSON_INITIALIZER;
 		(void) bson_append_document_begin (doc, "$inc", -1, &inc_doc);
-		(void) bson_append_int32 (&inc_doc, "transCount", -1, 1);
+		(void) bson_append_int32 (&inc_doc, "transCount", -1, count);
 		(void) bson_append_document_end (doc, &inc_doc);
 	}
 
@@ -291,11 +360,18 @@ bson_t *user_create_update_pocket_transactions (void) {
 // adds one to user's categories count
 bson_t *user_create_update_pocket_categories (void) {
 
+	return user_create_update_pocket_categories_count (1);
+
+}
+
+// adds count to user's categories count
+bson_t *user_create_update_pocket_categories_count (const int count) {
+
 	bson_t *doc = bson_new ();
 	if (doc) {
 		bson_t inc_doc = BSON_INITIALIZER;
 		(void) bson_append_document_begin (doc, "$inc", -1, &inc_doc);
-		(void) bson_append_int32 (&inc_doc, "categoriesCount", -1, 1);
+		(void) bson_append_int32 (&inc_doc, "categoriesCount", -1, count);
 		(void) bson_append_document_end (doc, &inc_doc);
 	}
 
@@ -306,11 +382,18 @@ bson_t *user_create_update_pocket_categories (void) {
 // adds one to user's places count
 bson_t *user_create_update_pocket_places (void) {
 
+	return user_create_update_pocket_places_count (1);
+
+}
+
+// adds count to user's places count
+bson_t *user_create_update_pocket_places_count (const int count) {
+
 	bson_t *doc = bson_new ();
 	if (doc) {
 		bson_t inc_doc = BSON_INITIALIZER;
 		(void) bson_append_document_begin (doc, "$inc", -1, &inc_doc);
-		(void) bson_append_int32 (&inc_doc, "placesCount", -1, 1);
+		(void) bson_append_int32 (&inc_doc, "placesCount", -1, count);
 		(void) bson_append_document_end (doc, &inc_doc);
 	}
 
@@ -318,41 +401,144 @@ bson_t *user_create_update_pocket_places (void) {
 
 }
 
-unsigned int user_insert_one (const User *user) {
+// duplicated is set if the email was already registered
+unsigned int user_insert_one (const User *user, bool *duplicated) {
 
-	return mongo_insert_one (
-		users_model,
-		user_bson_create (user)
+	return db_insert_one (
+		DB_COLLECTION_USERS, user_bson_create (user), duplicated
 	);
 
 }
 
 unsigned int user_add_transactions (const User *user) {
 
-	return mongo_update_one (
-		users_model,
+	return user_add_transactions_count (user, 1);
+
+}
+
+unsigned int user_add_transactions_count (
+	const User *user, const int count
+) {
+
+	return db_model_update_one (
+		DB_COLLECTION_USERS, users_model,
 		user_query_id (user->id),
-		user_create_update_pocket_transactions ()
+		user_create_update_pocket_transactions_count (count)
 	);
 
 }
 
+// removes one from user's transactions count
+unsigned int user_remove_transaction (const User *user) {
+
+	return user_add_transactions_count (user, -1);
+
+}
+
 unsigned int user_add_category (const User *user) {
 
-	return mongo_update_one (
-		users_model,
+	return user_add_categories_count (user, 1);
+
+}
+
+unsigned int user_add_categories_count (
+	const User *user, const int count
+) {
+
+	return db_model_update_one (
+		DB_COLLECTION_USERS, users_model,
 		user_query_id (user->id),
-		user_create_update_pocket_categories ()
+		user_create_update_pocket_categories_count (count)
 	);
 
 }
 
+// removes one from user's categories count
+unsigned int user_remove_category (const User *user) {
+
+	return user_add_categories_count (user, -1);
+
+}
+
 unsigned int user_add_place (const User *user) {
 
-	return mongo_update_one (
-		users_model,
+	return user_add_places_count (user, 1);
+
+}
+
+unsigned int user_add_places_count (
+	const User *user, const int count
+) {
+
+	return db_model_update_one (
+		DB_COLLECTION_USERS, users_model,
+		user_query_id (user->id),
+		user_create_update_pocket_places_count (count)
+	);
+
+}
+
+// removes one from user's places count
+unsigned int user_remove_place (const User *user) {
+
+	return user_add_places_count (user, -1);
+
+}
+
+// a later reset is never replaced by an older one
+static bson_t *user_create_update_sync_reset (const int64_t date) {
+
+	bson_t *doc = bson_new ();
+	if (doc) {
+		bson_t max_doc = BSON_INITIALIZER;
+		(void) bson_append_document_begin (doc, "$max", -1, &max_doc);
+		(void) bson_append_date_time (&max_doc, "syncReset", -1, date);
+		(void) bson_append_document_end (doc, &max_doc);
+	}
+
+	return doc;
+
+}
+
+// makes the user's syncs since before date (millis) full syncs
+unsigned int user_update_sync_reset (
+	const bson_oid_t *user_oid, const int64_t date
+) {
+
+	char id[USER_ID_SIZE] = { 0 };
+	bson_oid_to_string (user_oid, id);
+
+	return db_model_update_one (
+		DB_COLLECTION_USERS, users_model,
+		user_query_id (id),
+		user_create_update_sync_reset (date)
+	);
+
+}
+
+static bson_t *user_create_update_password (const char *password) {
+
+	bson_t *doc = bson_new ();
+	if (doc) {
+		bson_t set_doc = BSON_INITIALIZER;
+		(void) bson_append_document_begin (doc, "$set", -1, &set_doc);
+		(void) bson_append_utf8 (&set_doc, "password", -1, password, -1);
+		(void) bson_append_document_end (doc, &set_doc);
+	}
+
+	return doc;
+
+}
+
+// replaces the user's stored password hash
+unsigned int user_update_password (
+	const User *user, const char *password
+) {
+
+	return db_model_update_one (
+		DB_COLLECTION_USERS, users_model,
 		user_query_id (user->id),
-		user_create_update_pocket_places ()
+		user_create_update_password (password)
 	);
 
-}
\ No newline at end of file
+}
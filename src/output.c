@@ -0,0 +1,500 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include <time.h>
+#include <pthread.h>
+
+#include <bson/bson.h>
+
+#include <cerver/types/types.h>
+
+#include <cerver/utils/log.h>
+
+#include "input.h"
+#include "output.h"
+
+// the thread's buffer never shrinks under this size
+#define POCKET_OUTPUT_BUFFER_MIN			1024
+
+// a json writer that only counts the bytes if it has no buffer
+typedef struct PocketOutputWriter {
+
+	char *out;
+	size_t len;
+
+} PocketOutputWriter;
+
+typedef struct PocketOutputBuffer {
+
+	char *data;
+	size_t size;
+
+} PocketOutputBuffer;
+
+static pthread_key_t output_buffer_key;
+static bool output_buffer_key_created = false;
+
+static _Thread_local PocketOutputBuffer output_buffer = { 0 };
+
+static const char output_hex[] = "0123456789abcdef";
+
+static void pocket_output_value (
+	PocketOutputWriter *writer, const bson_iter_t *iter
+);
+
+static void pocket_output_buffer_release (void *data) {
+
+	free (data);
+
+}
+
+// returns 0 on success, 1 on error
+unsigned int pocket_output_init (void) {
+
+	unsigned int retval = 1;
+
+	if (!pthread_key_create (
+		&output_buffer_key, pocket_output_buffer_release
+	)) {
+		output_buffer_key_created = true;
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error ("Failed to create output buffer key!");
+	}
+
+	return retval;
+
+}
+
+void pocket_output_end (void) {
+
+	if (output_buffer_key_created) {
+		(void) pthread_setspecific (output_buffer_key, NULL);
+		(void) pthread_key_delete (output_buffer_key);
+		output_buffer_key_created = false;
+	}
+
+	free (output_buffer.data);
+	output_buffer.data = NULL;
+	output_buffer.size = 0;
+
+}
+
+static unsigned int pocket_output_shape_add (
+	PocketOutputShape *shape, size_t *n_keys, const char *key
+) {
+
+	unsigned int retval = 1;
+
+	size_t key_len = strlen (key);
+	if ((*n_keys < POCKET_INPUT_KEYS_MAX) && (key_len < POCKET_OUTPUT_KEY_SIZE)) {
+		(void) memcpy (shape->keys[*n_keys], key, key_len + 1);
+		shape->schema.keys[*n_keys] = shape->keys[*n_keys];
+		*n_keys += 1;
+
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error ("Output shape can't have the field %s", key);
+	}
+
+	return retval;
+
+}
+
+// takes the fields from the opts' projection, _id is added
+// unless it is excluded like mongo does
+// returns 0 on success, 1 on error
+unsigned int pocket_output_shape_init (
+	PocketOutputShape *shape, const bson_t *opts
+) {
+
+	unsigned int errors = 0;
+
+	(void) memset (shape, 0, sizeof (PocketOutputShape));
+
+	// without a projection every field is written
+	shape->exclude = true;
+
+	bson_iter_t iter = { 0 };
+	bson_iter_t projection = { 0 };
+	if (
+		opts
+		&& bson_iter_init_find (&iter, opts, "projection")
+		&& BSON_ITER_HOLDS_DOCUMENT (&iter)
+		&& bson_iter_recurse (&iter, &projection)
+	) {
+		// mongo only allows a projection to exclude _id
+		// if the other fields are included
+		bool id = true;
+		bool include = false;
+
+		size_t n_keys = 0;
+		const char *key = NULL;
+		while (bson_iter_next (&projection)) {
+			key = bson_iter_key (&projection);
+			if (!strcmp (key, "_id")) {
+				id = bson_iter_as_bool (&projection);
+			}
+
+			else {
+				include = bson_iter_as_bool (&projection);
+				errors |= pocket_output_shape_add (shape, &n_keys, key);
+			}
+		}
+
+		if (include) {
+			shape->exclude = false;
+			if (id) errors |= pocket_output_shape_add (shape, &n_keys, "_id");
+		}
+
+		else if (!id) {
+			errors |= pocket_output_shape_add (shape, &n_keys, "_id");
+		}
+	}
+
+	errors |= pocket_input_schema_init (&shape->schema);
+
+	return errors;
+
+}
+
+static inline void pocket_output_put (
+	PocketOutputWriter *writer, const char *data, const size_t data_len
+) {
+
+	if (writer->out) (void) memcpy (writer->out + writer->len, data, data_len);
+	writer->len += data_len;
+
+}
+
+static inline void pocket_output_put_char (
+	PocketOutputWriter *writer, const char c
+) {
+
+	if (writer->out) writer->out[writer->len] = c;
+	writer->len += 1;
+
+}
+
+static void pocket_output_escape (
+	PocketOutputWriter *writer, const u8 c
+) {
+
+	char escaped[6] = { '\\', 'u', '0', '0', 0, 0 };
+
+	switch (c) {
+		case '"': pocket_output_put (writer, "\\\"", 2); break;
+		case '\\': pocket_output_put (writer, "\\\\", 2); break;
+		case '\b': pocket_output_put (writer, "\\b", 2); break;
+		case '\f': pocket_output_put (writer, "\\f", 2); break;
+		case '\n': pocket_output_put (writer, "\\n", 2); break;
+		case '\r': pocket_output_put (writer, "\\r", 2); break;
+		case '\t': pocket_output_put (writer, "\\t", 2); break;
+
+		default:
+			escaped[4] = output_hex[c >> 4];
+			escaped[5] = output_hex[c & 0x0F];
+			pocket_output_put (writer, escaped, 6);
+			break;
+	}
+
+}
+
+// writes the quoted string, copying the runs without escapes at once
+static void pocket_output_string (
+	PocketOutputWriter *writer, const char *str, const size_t len
+) {
+
+	pocket_output_put_char (writer, '"');
+
+	size_t run = 0;
+	u8 c = 0;
+	for (size_t idx = 0; idx < len; idx++) {
+		c = (u8) str[idx];
+		if ((c < 0x20) || (c == '"') || (c == '\\')) {
+			pocket_output_put (writer, str + run, idx - run);
+			pocket_output_escape (writer, c);
+			run = idx + 1;
+		}
+	}
+
+	pocket_output_put (writer, str + run, len - run);
+
+	pocket_output_put_char (writer, '"');
+
+}
+
+// the shortest representation that reads back as the same double
+static void pocket_output_double (
+	PocketOutputWriter *writer, const double value
+) {
+
+	char number[POCKET_OUTPUT_NUMBER_SIZE] = { 0 };
+
+	// json has no nan or infinity
+	if (!isfinite (value)) {
+		pocket_output_put (writer, "null", 4);
+	}
+
+	else {
+		int len = snprintf (number, POCKET_OUTPUT_NUMBER_SIZE, "%.15g", value);
+		const double read = strtod (number, NULL);
+		if ((read < value) || (read > value)) {
+			len = snprintf (number, POCKET_OUTPUT_NUMBER_SIZE, "%.17g", value);
+		}
+
+		pocket_output_put (writer, number, (size_t) len);
+	}
+
+}
+
+static void pocket_output_int64 (
+	PocketOutputWriter *writer, const int64_t value
+) {
+
+	char number[POCKET_OUTPUT_NUMBER_SIZE] = { 0 };
+	int len = snprintf (number, POCKET_OUTPUT_NUMBER_SIZE, "%" PRId64, value);
+
+	pocket_output_put (writer, number, (size_t) len);
+
+}
+
+// dates before 1970 or after 9999 are written as millis
+static void pocket_output_date (
+	PocketOutputWriter *writer, const int64_t millis
+) {
+
+	char date[POCKET_OUTPUT_DATE_SIZE] = { 0 };
+
+	struct tm tm = { 0 };
+	const time_t seconds = (time_t) (millis / 1000);
+	if (
+		(millis >= 0)
+		&& gmtime_r (&seconds, &tm)
+		&& (tm.tm_year < (10000 - 1900))
+	) {
+		int len = snprintf (
+			date, POCKET_OUTPUT_DATE_SIZE,
+			"\"%04d-%02d-%02dT%02d:%02d:%02d.%03dZ\"",
+			tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+			tm.tm_hour, tm.tm_min, tm.tm_sec,
+			(int) (millis % 1000)
+		);
+
+		pocket_output_put (writer, date, (size_t) len);
+	}
+
+	else {
+		pocket_output_int64 (writer, millis);
+	}
+
+}
+
+static void pocket_output_oid (
+	PocketOutputWriter *writer, const bson_oid_t *oid
+) {
+
+	char oid_string[25] = { 0 };
+
+	if (writer->out) {
+		bson_oid_to_string (oid, oid_string);
+		pocket_output_put_char (writer, '"');
+		pocket_output_put (writer, oid_string, 24);
+		pocket_output_put_char (writer, '"');
+	}
+
+	else {
+		writer->len += 26;
+	}
+
+}
+
+// writes every member of a nested document or array
+static void pocket_output_nested (
+	PocketOutputWriter *writer, const bson_iter_t *iter, const bool array
+) {
+
+	bson_iter_t child = { 0 };
+	if (bson_iter_recurse (iter, &child)) {
+		pocket_output_put_char (writer, array ? '[' : '{');
+
+		bool first = true;
+		const char *key = NULL;
+		while (bson_iter_next (&child)) {
+			if (!first) pocket_output_put_char (writer, ',');
+
+			if (!array) {
+				key = bson_iter_key (&child);
+				pocket_output_string (writer, key, strlen (key));
+				pocket_output_put_char (writer, ':');
+			}
+
+			pocket_output_value (writer, &child);
+			first = false;
+		}
+
+		pocket_output_put_char (writer, array ? ']' : '}');
+	}
+
+	else {
+		pocket_output_put (writer, "null", 4);
+	}
+
+}
+
+// types that the models don't use are written as null
+static void pocket_output_value (
+	PocketOutputWriter *writer, const bson_iter_t *iter
+) {
+
+	uint32_t len = 0;
+	const char *str = NULL;
+
+	switch (bson_iter_type (iter)) {
+		case BSON_TYPE_UTF8:
+			str = bson_iter_utf8 (iter, &len);
+			pocket_output_string (writer, str, len);
+			break;
+
+		case BSON_TYPE_OID:
+			pocket_output_oid (writer, bson_iter_oid (iter));
+			break;
+
+		case BSON_TYPE_DATE_TIME:
+			pocket_output_date (writer, bson_iter_date_time (iter));
+			break;
+
+		case BSON_TYPE_DOUBLE:
+			pocket_output_double (writer, bson_iter_double (iter));
+			break;
+
+		case BSON_TYPE_INT32:
+			pocket_output_int64 (writer, bson_iter_int32 (iter));
+			break;
+
+		case BSON_TYPE_INT64:
+			pocket_output_int64 (writer, bson_iter_int64 (iter));
+			break;
+
+		case BSON_TYPE_BOOL:
+			if (bson_iter_bool (iter)) pocket_output_put (writer, "true", 4);
+			else pocket_output_put (writer, "false", 5);
+			break;
+
+		case BSON_TYPE_DOCUMENT:
+			pocket_output_nested (writer, iter, false);
+			break;
+
+		case BSON_TYPE_ARRAY:
+			pocket_output_nested (writer, iter, true);
+			break;
+
+		default:
+			pocket_output_put (writer, "null", 4);
+			break;
+	}
+
+}
+
+static void pocket_output_doc_internal (
+	PocketOutputWriter *writer,
+	const PocketOutputShape *shape, const bson_t *doc
+) {
+
+	pocket_output_put_char (writer, '{');
+
+	bson_iter_t iter = { 0 };
+	if (bson_iter_init (&iter, doc)) {
+		bool first = true;
+		const char *key = NULL;
+		size_t key_len = 0;
+		bool found = false;
+		while (bson_iter_next (&iter)) {
+			key = bson_iter_key (&iter);
+			key_len = strlen (key);
+
+			found = (pocket_input_schema_find (&shape->schema, key, key_len) >= 0);
+			if (found != shape->exclude) {
+				if (!first) pocket_output_put_char (writer, ',');
+
+				pocket_output_string (writer, key, key_len);
+				pocket_output_put_char (writer, ':');
+
+				pocket_output_value (writer, &iter);
+				first = false;
+			}
+		}
+	}
+
+	pocket_output_put_char (writer, '}');
+
+}
+
+// returns the exact size of the document as json
+size_t pocket_output_doc_size (
+	const PocketOutputShape *shape, const bson_t *doc
+) {
+
+	PocketOutputWriter writer = { .out = NULL, .len = 0 };
+	pocket_output_doc_internal (&writer, shape, doc);
+
+	return writer.len;
+
+}
+
+// writes the document as json into a buffer
+// that has at least pocket_output_doc_size () bytes
+size_t pocket_output_doc_write (
+	const PocketOutputShape *shape, const bson_t *doc, char *buffer
+) {
+
+	PocketOutputWriter writer = { .out = buffer, .len = 0 };
+	pocket_output_doc_internal (&writer, shape, doc);
+
+	return writer.len;
+
+}
+
+static char *pocket_output_buffer_get (const size_t size) {
+
+	if (size > output_buffer.size) {
+		size_t new_size = POCKET_OUTPUT_BUFFER_MIN;
+		while (new_size < size) new_size *= 2;
+
+		char *data = (char *) realloc (output_buffer.data, new_size);
+		if (data) {
+			output_buffer.data = data;
+			output_buffer.size = new_size;
+
+			if (output_buffer_key_created) {
+				(void) pthread_setspecific (output_buffer_key, data);
+			}
+		}
+	}
+
+	return (size <= output_buffer.size) ? output_buffer.data : NULL;
+
+}
+
+// writes the document as json into the current thread's buffer
+const char *pocket_output_doc (
+	const PocketOutputShape *shape, const bson_t *doc, size_t *json_len
+) {
+
+	const size_t size = pocket_output_doc_size (shape, doc);
+
+	char *json = pocket_output_buffer_get (size);
+	if (json) {
+		*json_len = pocket_output_doc_write (shape, doc, json);
+	}
+
+	return json;
+
+}
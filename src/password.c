@@ -0,0 +1,493 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <cerver/utils/log.h>
+
+#include "password.h"
+
+typedef enum PocketPasswordJobType {
+
+	POCKET_PASSWORD_JOB_HASH		= 0,
+	POCKET_PASSWORD_JOB_VERIFY		= 1,
+
+} PocketPasswordJobType;
+
+// a request that lives in the caller's stack
+// until a worker posts its done semaphore
+typedef struct PocketPasswordJob {
+
+	PocketPasswordJobType type;
+
+	const char *password;
+	const char *stored;
+
+	char *hashed;
+	bool upgrade;
+
+	PocketPasswordResult result;
+
+	sem_t done;
+
+	struct PocketPasswordJob *next;
+
+} PocketPasswordJob;
+
+static pthread_mutex_t jobs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobs_cond = PTHREAD_COND_INITIALIZER;
+
+static PocketPasswordJob *jobs_head = NULL;
+static PocketPasswordJob *jobs_tail = NULL;
+// requests waiting for their job, queued or running
+static unsigned int jobs_pending = 0;
+static unsigned int jobs_max = 1;
+static size_t jobs_done = 0;
+static size_t jobs_rejected = 0;
+
+static bool workers_running = false;
+static pthread_t *workers = NULL;
+static unsigned int n_workers = 0;
+
+static unsigned int password_cost = POCKET_PASSWORD_DEFAULT_COST;
+
+const char *pocket_password_result_to_string (
+	const PocketPasswordResult result
+) {
+
+	switch (result) {
+		#define XX(num, name, string) case POCKET_PASSWORD_RESULT_##name: return #string;
+		POCKET_PASSWORD_RESULT_MAP(XX)
+		#undef XX
+	}
+
+	return pocket_password_result_to_string (POCKET_PASSWORD_RESULT_ERROR);
+
+}
+
+static void pocket_password_hex_encode (
+	const unsigned char *data, const size_t len, char *hex
+) {
+
+	static const char digits[] = "0123456789abcdef";
+
+	for (size_t idx = 0; idx < len; idx++) {
+		hex[idx * 2] = digits[data[idx] >> 4];
+		hex[(idx * 2) + 1] = digits[data[idx] & 0x0f];
+	}
+
+	hex[len * 2] = '\0';
+
+}
+
+static unsigned int pocket_password_hex_decode (
+	const char *hex, unsigned char *data, const size_t len
+) {
+
+	unsigned int retval = 0;
+
+	unsigned int byte = 0;
+	for (size_t idx = 0; idx < len; idx++) {
+		if (sscanf (&hex[idx * 2], "%2x", &byte) == 1) {
+			data[idx] = (unsigned char) byte;
+		}
+
+		else {
+			retval = 1;
+			break;
+		}
+	}
+
+	return retval;
+
+}
+
+static unsigned int pocket_password_derive (
+	const char *password,
+	const unsigned char *salt,
+	const unsigned int cost, const unsigned int r, const unsigned int p,
+	unsigned char *key
+) {
+
+	const uint64_t n = (uint64_t) 1 << cost;
+
+	// the memory that scrypt needs for these parameters
+	const uint64_t max_mem = (uint64_t) 128 * r * (n + 2 + p);
+
+	return EVP_PBE_scrypt (
+		password, strlen (password),
+		salt, POCKET_PASSWORD_SALT_SIZE,
+		n, r, p, max_mem,
+		key, POCKET_PASSWORD_KEY_SIZE
+	) ? 0 : 1;
+
+}
+
+// hashes the password in the caller's thread
+// hashed must be at least POCKET_PASSWORD_HASH_SIZE bytes
+// returns 0 on success, 1 on error
+unsigned int pocket_password_hash_sync (
+	const char *password, const unsigned int cost, char *hashed
+) {
+
+	unsigned int retval = 1;
+
+	unsigned char salt[POCKET_PASSWORD_SALT_SIZE] = { 0 };
+	unsigned char key[POCKET_PASSWORD_KEY_SIZE] = { 0 };
+
+	if (RAND_bytes (salt, POCKET_PASSWORD_SALT_SIZE) == 1) {
+		if (!pocket_password_derive (
+			password, salt,
+			cost, POCKET_PASSWORD_BLOCK_SIZE, POCKET_PASSWORD_PARALLEL,
+			key
+		)) {
+			char salt_hex[(POCKET_PASSWORD_SALT_SIZE * 2) + 1] = { 0 };
+			char key_hex[(POCKET_PASSWORD_KEY_SIZE * 2) + 1] = { 0 };
+			pocket_password_hex_encode (salt, POCKET_PASSWORD_SALT_SIZE, salt_hex);
+			pocket_password_hex_encode (key, POCKET_PASSWORD_KEY_SIZE, key_hex);
+
+			(void) snprintf (
+				hashed, POCKET_PASSWORD_HASH_SIZE,
+				"$scrypt$%u$%u$%u$%s$%s",
+				cost,
+				(unsigned int) POCKET_PASSWORD_BLOCK_SIZE,
+				(unsigned int) POCKET_PASSWORD_PARALLEL,
+				salt_hex, key_hex
+			);
+
+			retval = 0;
+		}
+
+		OPENSSL_cleanse (key, POCKET_PASSWORD_KEY_SIZE);
+	}
+
+	return retval;
+
+}
+
+static PocketPasswordResult pocket_password_verify_hash (
+	const char *password, const char *stored,
+	const unsigned int cost, bool *upgrade
+) {
+
+	PocketPasswordResult result = POCKET_PASSWORD_RESULT_ERROR;
+
+	unsigned int stored_cost = 0;
+	unsigned int r = 0;
+	unsigned int p = 0;
+	char salt_hex[(POCKET_PASSWORD_SALT_SIZE * 2) + 1] = { 0 };
+	char key_hex[(POCKET_PASSWORD_KEY_SIZE * 2) + 1] = { 0 };
+
+	unsigned char salt[POCKET_PASSWORD_SALT_SIZE] = { 0 };
+	unsigned char stored_key[POCKET_PASSWORD_KEY_SIZE] = { 0 };
+	unsigned char key[POCKET_PASSWORD_KEY_SIZE] = { 0 };
+
+	if (
+		(sscanf (
+			stored, "$scrypt$%u$%u$%u$%32[0-9a-f]$%64[0-9a-f]",
+			&stored_cost, &r, &p, salt_hex, key_hex
+		) == 5)
+		&& (stored_cost >= POCKET_PASSWORD_MIN_COST)
+		&& (stored_cost <= POCKET_PASSWORD_MAX_COST)
+		&& !pocket_password_hex_decode (salt_hex, salt, POCKET_PASSWORD_SALT_SIZE)
+		&& !pocket_password_hex_decode (key_hex, stored_key, POCKET_PASSWORD_KEY_SIZE)
+		&& !pocket_password_derive (password, salt, stored_cost, r, p, key)
+	) {
+		if (!CRYPTO_memcmp (key, stored_key, POCKET_PASSWORD_KEY_SIZE)) {
+			*upgrade = (stored_cost != cost)
+				|| (r != POCKET_PASSWORD_BLOCK_SIZE)
+				|| (p != POCKET_PASSWORD_PARALLEL);
+
+			result = POCKET_PASSWORD_RESULT_OK;
+		}
+
+		else {
+			result = POCKET_PASSWORD_RESULT_WRONG;
+		}
+	}
+
+	OPENSSL_cleanse (key, POCKET_PASSWORD_KEY_SIZE);
+
+	return result;
+
+}
+
+// checks the password against a stored hash in the caller's thread
+// legacy plain text values are also accepted
+// upgrade is set if the stored value should be replaced
+// with a new hash that uses the current cost
+PocketPasswordResult pocket_password_verify_sync (
+	const char *password, const char *stored,
+	const unsigned int cost, bool *upgrade
+) {
+
+	PocketPasswordResult result = POCKET_PASSWORD_RESULT_WRONG;
+
+	*upgrade = false;
+
+	if (!strncmp (stored, POCKET_PASSWORD_PREFIX, strlen (POCKET_PASSWORD_PREFIX))) {
+		result = pocket_password_verify_hash (password, stored, cost, upgrade);
+	}
+
+	// legacy plain text password that must be replaced
+	else {
+		const size_t len = strlen (password);
+		if (
+			(len == strlen (stored))
+			&& !CRYPTO_memcmp (password, stored, len)
+		) {
+			*upgrade = true;
+			result = POCKET_PASSWORD_RESULT_OK;
+		}
+	}
+
+	return result;
+
+}
+
+static void pocket_password_job_run (PocketPasswordJob *job) {
+
+	switch (job->type) {
+		case POCKET_PASSWORD_JOB_HASH:
+			job->result = pocket_password_hash_sync (
+				job->password, password_cost, job->hashed
+			) ? POCKET_PASSWORD_RESULT_ERROR : POCKET_PASSWORD_RESULT_OK;
+			break;
+
+		case POCKET_PASSWORD_JOB_VERIFY:
+			job->result = pocket_password_verify_sync (
+				job->password, job->stored, password_cost, &job->upgrade
+			);
+
+			// the new hash is generated by the same worker
+			if ((job->result == POCKET_PASSWORD_RESULT_OK) && job->upgrade) {
+				if (pocket_password_hash_sync (
+					job->password, password_cost, job->hashed
+				)) {
+					job->upgrade = false;
+				}
+			}
+			break;
+
+		default: break;
+	}
+
+}
+
+static void *pocket_password_worker (void *args) {
+
+	(void) args;
+
+	PocketPasswordJob *job = NULL;
+	for (;;) {
+		(void) pthread_mutex_lock (&jobs_mutex);
+
+		while (workers_running && !jobs_head) {
+			(void) pthread_cond_wait (&jobs_cond, &jobs_mutex);
+		}
+
+		job = jobs_head;
+		if (job) {
+			jobs_head = job->next;
+			if (!jobs_head) jobs_tail = NULL;
+		}
+
+		(void) pthread_mutex_unlock (&jobs_mutex);
+
+		if (!job) break;
+
+		pocket_password_job_run (job);
+
+		// the caller is waiting until the job is done
+		(void) pthread_mutex_lock (&jobs_mutex);
+		jobs_pending -= 1;
+		jobs_done += 1;
+		(void) pthread_mutex_unlock (&jobs_mutex);
+
+		(void) sem_post (&job->done);
+	}
+
+	return NULL;
+
+}
+
+unsigned int pocket_password_queue_default (
+	const unsigned int threads
+) {
+
+	return (threads > 1) ? threads - 1 : 1;
+
+}
+
+// starts the workers that hash & verify passwords
+// requests are rejected when queue_max are already waiting
+// for a password, including the ones that are being hashed
+// returns 0 on success, 1 on error
+unsigned int pocket_password_init (
+	const unsigned int workers_count, const unsigned int queue_max,
+	const unsigned int cost
+) {
+
+	unsigned int retval = 1;
+
+	if (
+		workers_count && queue_max
+		&& (cost >= POCKET_PASSWORD_MIN_COST) && (cost <= POCKET_PASSWORD_MAX_COST)
+	) {
+		workers = (pthread_t *) calloc (workers_count, sizeof (pthread_t));
+		if (workers) {
+			jobs_max = queue_max;
+			password_cost = cost;
+			workers_running = true;
+
+			retval = 0;
+			for (unsigned int idx = 0; idx < workers_count; idx++) {
+				if (!pthread_create (
+					&workers[idx], NULL, pocket_password_worker, NULL
+				)) {
+					n_workers += 1;
+				}
+
+				else {
+					cerver_log_error ("Failed to create password worker!");
+					retval = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	else {
+		cerver_log_error ("Invalid password workers, queue or cost values!");
+	}
+
+	return retval;
+
+}
+
+void pocket_password_end (void) {
+
+	(void) pthread_mutex_lock (&jobs_mutex);
+	workers_running = false;
+	(void) pthread_cond_broadcast (&jobs_cond);
+	(void) pthread_mutex_unlock (&jobs_mutex);
+
+	// pending jobs are completed before the workers exit
+	for (unsigned int idx = 0; idx < n_workers; idx++) {
+		(void) pthread_join (workers[idx], NULL);
+	}
+
+	free (workers);
+	workers = NULL;
+	n_workers = 0;
+
+}
+
+void pocket_password_get_stats (PocketPasswordStats *stats) {
+
+	(void) pthread_mutex_lock (&jobs_mutex);
+
+	stats->workers = n_workers;
+	stats->pending = jobs_pending;
+	stats->queue_max = jobs_max;
+	stats->done = jobs_done;
+	stats->rejected = jobs_rejected;
+
+	(void) pthread_mutex_unlock (&jobs_mutex);
+
+}
+
+// adds the job to the queue & waits for a worker to run it
+static PocketPasswordResult pocket_password_job_submit (
+	PocketPasswordJob *job
+) {
+
+	PocketPasswordResult result = POCKET_PASSWORD_RESULT_BUSY;
+
+	if (!sem_init (&job->done, 0, 0)) {
+		bool queued = false;
+
+		(void) pthread_mutex_lock (&jobs_mutex);
+
+		if (workers_running && (jobs_pending < jobs_max)) {
+			job->next = NULL;
+			if (jobs_tail) jobs_tail->next = job;
+			else jobs_head = job;
+			jobs_tail = job;
+
+			jobs_pending += 1;
+			queued = true;
+
+			(void) pthread_cond_signal (&jobs_cond);
+		}
+
+		else {
+			jobs_rejected += 1;
+		}
+
+		(void) pthread_mutex_unlock (&jobs_mutex);
+
+		if (queued) {
+			while (sem_wait (&job->done));
+			result = job->result;
+		}
+
+		(void) sem_destroy (&job->done);
+	}
+
+	else {
+		result = POCKET_PASSWORD_RESULT_ERROR;
+	}
+
+	return result;
+
+}
+
+// hashes the password using the workers
+// the caller waits until its request is done
+// returns POCKET_PASSWORD_RESULT_BUSY if the queue is full
+PocketPasswordResult pocket_password_hash (
+	const char *password, char *hashed
+) {
+
+	PocketPasswordJob job = {
+		.type = POCKET_PASSWORD_JOB_HASH,
+		.password = password,
+		.hashed = hashed,
+		.result = POCKET_PASSWORD_RESULT_ERROR
+	};
+
+	return pocket_password_job_submit (&job);
+
+}
+
+// verifies the password using the workers
+// if the stored value needs to be upgraded,
+// upgrade is set & rehashed is set with a new hash
+PocketPasswordResult pocket_password_verify (
+	const char *password, const char *stored,
+	bool *upgrade, char *rehashed
+) {
+
+	PocketPasswordJob job = {
+		.type = POCKET_PASSWORD_JOB_VERIFY,
+		.password = password,
+		.stored = stored,
+		.hashed = rehashed,
+		.result = POCKET_PASSWORD_RESULT_ERROR
+	};
+
+	PocketPasswordResult result = pocket_password_job_submit (&job);
+
+	*upgrade = job.upgrade;
+
+	return result;
+
+}
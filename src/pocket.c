@@ -18,7 +18,16 @@
 
 #include <cmongo/mongo.h>
 
+#include "arena.h"
+#include "cache.h"
+#include "db.h"
+#include "etag.h"
+#include "limiter.h"
+#include "metrics.h"
+#include "output.h"
+#include "password.h"
 #include "pocket.h"
+#include "pool.h"
 #include "runtime.h"
 #include "version.h"
 
@@ -26,6 +35,7 @@
 #include "models/category.h"
 #include "models/place.h"
 #include "models/role.h"
+#include "models/tombstone.h"
 #include "models/user.h"
 
 #include "controllers/categories.h"
@@ -50,8 +60,33 @@ static const String *MONGO_DB = NULL;
 const String *PRIV_KEY = NULL;
 const String *PUB_KEY = NULL;
 
+unsigned int TOKEN_LIFETIME = 0;
+
 bool ENABLE_USERS_ROUTES = false;
 
+size_t CACHE_SIZE = POCKET_CACHE_DEFAULT_SIZE;
+unsigned int CACHE_TTL = POCKET_CACHE_DEFAULT_TTL;
+
+unsigned int ROLES_REFRESH_INTERVAL = POCKET_ROLES_DEFAULT_REFRESH;
+
+unsigned int PASSWORD_WORKERS = POCKET_PASSWORD_DEFAULT_WORKERS;
+unsigned int PASSWORD_QUEUE = 0;
+unsigned int PASSWORD_COST = POCKET_PASSWORD_DEFAULT_COST;
+
+unsigned int RATE_LIMIT_AUTH = POCKET_LIMITER_DEFAULT_AUTH_RATE;
+unsigned int RATE_LIMIT_AUTH_BURST = POCKET_LIMITER_DEFAULT_AUTH_BURST;
+unsigned int RATE_LIMIT_WRITE = POCKET_LIMITER_DEFAULT_WRITE_RATE;
+unsigned int RATE_LIMIT_WRITE_BURST = POCKET_LIMITER_DEFAULT_WRITE_BURST;
+
+unsigned int DB_SLOW_THRESHOLD = DB_DEFAULT_SLOW_THRESHOLD;
+
+unsigned int TRANS_POOL_SIZE = 0;
+unsigned int CATEGORIES_POOL_SIZE = 0;
+unsigned int PLACES_POOL_SIZE = 0;
+unsigned int USERS_POOL_SIZE = 0;
+
+unsigned int POOL_TRIM_INTERVAL = POCKET_POOL_DEFAULT_TRIM_INTERVAL;
+
 static void pocket_env_get_runtime (void) {
 
 	char *runtime_env = getenv ("RUNTIME");
@@ -234,6 +269,23 @@ static unsigned int pocket_env_get_public_key (void) {
 
 }
 
+static void pocket_env_get_token_lifetime (void) {
+
+	char *token_lifetime = getenv ("TOKEN_LIFETIME");
+	if (token_lifetime) {
+		TOKEN_LIFETIME = (unsigned int) strtoul (token_lifetime, NULL, 10);
+		cerver_log_success ("TOKEN_LIFETIME -> %u", TOKEN_LIFETIME);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get TOKEN_LIFETIME from env - using default %u!",
+			TOKEN_LIFETIME
+		);
+	}
+
+}
+
 static void pocket_env_get_enable_users_routes (void) {
 
 	char *enable_users = getenv ("ENABLE_USERS_ROUTES");
@@ -257,6 +309,262 @@ static void pocket_env_get_enable_users_routes (void) {
 
 }
 
+static void pocket_env_get_cache_size (void) {
+
+	char *cache_size = getenv ("CACHE_SIZE");
+	if (cache_size) {
+		CACHE_SIZE = (size_t) strtoul (cache_size, NULL, 10);
+		cerver_log_success ("CACHE_SIZE -> %zu", CACHE_SIZE);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get CACHE_SIZE from env - using default %zu!",
+			CACHE_SIZE
+		);
+	}
+
+}
+
+static void pocket_env_get_cache_ttl (void) {
+
+	char *cache_ttl = getenv ("CACHE_TTL");
+	if (cache_ttl) {
+		CACHE_TTL = (unsigned int) strtoul (cache_ttl, NULL, 10);
+		cerver_log_success ("CACHE_TTL -> %u", CACHE_TTL);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get CACHE_TTL from env - using default %u!",
+			CACHE_TTL
+		);
+	}
+
+}
+
+static void pocket_env_get_roles_refresh_interval (void) {
+
+	char *refresh_interval = getenv ("ROLES_REFRESH_INTERVAL");
+	if (refresh_interval) {
+		ROLES_REFRESH_INTERVAL = (unsigned int) atoi (refresh_interval);
+		cerver_log_success ("ROLES_REFRESH_INTERVAL -> %u", ROLES_REFRESH_INTERVAL);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get ROLES_REFRESH_INTERVAL from env - using default %u!",
+			ROLES_REFRESH_INTERVAL
+		);
+	}
+
+}
+
+static void pocket_env_get_password_workers (void) {
+
+	char *password_workers = getenv ("PASSWORD_WORKERS");
+	if (password_workers) {
+		PASSWORD_WORKERS = (unsigned int) atoi (password_workers);
+		cerver_log_success ("PASSWORD_WORKERS -> %u", PASSWORD_WORKERS);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get PASSWORD_WORKERS from env - using default %u!",
+			PASSWORD_WORKERS
+		);
+	}
+
+}
+
+static void pocket_env_get_password_queue (void) {
+
+	char *password_queue = getenv ("PASSWORD_QUEUE");
+	if (password_queue && (atoi (password_queue) > 0)) {
+		PASSWORD_QUEUE = (unsigned int) atoi (password_queue);
+		cerver_log_success ("PASSWORD_QUEUE -> %u", PASSWORD_QUEUE);
+	}
+
+	// an empty queue would reject every login & register
+	else if (password_queue) {
+		cerver_log_warning (
+			"Invalid PASSWORD_QUEUE %s - using default!", password_queue
+		);
+	}
+
+	else {
+		cerver_log_warning ("Failed to get PASSWORD_QUEUE from env - using default!");
+	}
+
+}
+
+// the requests waiting for a password block their threads,
+// so the queue must leave a thread free to answer 429
+static unsigned int pocket_env_check_password_queue (void) {
+
+	unsigned int retval = 0;
+
+	const unsigned int queue_max = pocket_password_queue_default (CERVER_TH_THREADS);
+	if (!PASSWORD_QUEUE) {
+		PASSWORD_QUEUE = queue_max;
+		cerver_log_success ("PASSWORD_QUEUE -> %u", PASSWORD_QUEUE);
+	}
+
+	else if (PASSWORD_QUEUE > queue_max) {
+		cerver_log_error (
+			"PASSWORD_QUEUE %u must be less than CERVER_TH_THREADS %u!",
+			PASSWORD_QUEUE, CERVER_TH_THREADS
+		);
+
+		retval = 1;
+	}
+
+	return retval;
+
+}
+
+static void pocket_env_get_password_cost (void) {
+
+	char *password_cost = getenv ("PASSWORD_COST");
+	if (password_cost) {
+		PASSWORD_COST = (unsigned int) atoi (password_cost);
+		cerver_log_success ("PASSWORD_COST -> %u", PASSWORD_COST);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get PASSWORD_COST from env - using default %u!",
+			PASSWORD_COST
+		);
+	}
+
+}
+
+static void pocket_env_get_rate_limit_auth (void) {
+
+	char *rate_limit_auth = getenv ("RATE_LIMIT_AUTH");
+	if (rate_limit_auth) {
+		RATE_LIMIT_AUTH = (unsigned int) atoi (rate_limit_auth);
+		cerver_log_success ("RATE_LIMIT_AUTH -> %u", RATE_LIMIT_AUTH);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get RATE_LIMIT_AUTH from env - using default %u!",
+			RATE_LIMIT_AUTH
+		);
+	}
+
+}
+
+static void pocket_env_get_rate_limit_auth_burst (void) {
+
+	char *rate_limit_auth_burst = getenv ("RATE_LIMIT_AUTH_BURST");
+	if (rate_limit_auth_burst) {
+		RATE_LIMIT_AUTH_BURST = (unsigned int) atoi (rate_limit_auth_burst);
+		cerver_log_success ("RATE_LIMIT_AUTH_BURST -> %u", RATE_LIMIT_AUTH_BURST);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get RATE_LIMIT_AUTH_BURST from env - using default %u!",
+			RATE_LIMIT_AUTH_BURST
+		);
+	}
+
+}
+
+static void pocket_env_get_rate_limit_write (void) {
+
+	char *rate_limit_write = getenv ("RATE_LIMIT_WRITE");
+	if (rate_limit_write) {
+		RATE_LIMIT_WRITE = (unsigned int) atoi (rate_limit_write);
+		cerver_log_success ("RATE_LIMIT_WRITE -> %u", RATE_LIMIT_WRITE);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get RATE_LIMIT_WRITE from env - using default %u!",
+			RATE_LIMIT_WRITE
+		);
+	}
+
+}
+
+static void pocket_env_get_rate_limit_write_burst (void) {
+
+	char *rate_limit_write_burst = getenv ("RATE_LIMIT_WRITE_BURST");
+	if (rate_limit_write_burst) {
+		RATE_LIMIT_WRITE_BURST = (unsigned int) atoi (rate_limit_write_burst);
+		cerver_log_success ("RATE_LIMIT_WRITE_BURST -> %u", RATE_LIMIT_WRITE_BURST);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get RATE_LIMIT_WRITE_BURST from env - using default %u!",
+			RATE_LIMIT_WRITE_BURST
+		);
+	}
+
+}
+
+static void pocket_env_get_db_slow_threshold (void) {
+
+	char *db_slow_threshold = getenv ("DB_SLOW_THRESHOLD");
+	if (db_slow_threshold) {
+		DB_SLOW_THRESHOLD = (unsigned int) atoi (db_slow_threshold);
+		cerver_log_success ("DB_SLOW_THRESHOLD -> %u", DB_SLOW_THRESHOLD);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get DB_SLOW_THRESHOLD from env - using default %u!",
+			DB_SLOW_THRESHOLD
+		);
+	}
+
+}
+
+// by default every worker thread gets a batch of objects
+static void pocket_env_get_pool_size (
+	const char *name, unsigned int *pool_size
+) {
+
+	char *pool_size_env = getenv (name);
+	if (pool_size_env) {
+		*pool_size = (unsigned int) atoi (pool_size_env);
+		cerver_log_success ("%s -> %u", name, *pool_size);
+	}
+
+	else {
+		*pool_size = (CERVER_TH_THREADS ? CERVER_TH_THREADS : 1)
+			* POCKET_POOL_THREAD_OBJECTS;
+
+		cerver_log_warning (
+			"Failed to get %s from env - using default %u!",
+			name, *pool_size
+		);
+	}
+
+}
+
+static void pocket_env_get_pool_trim_interval (void) {
+
+	char *pool_trim_interval = getenv ("POOL_TRIM_INTERVAL");
+	if (pool_trim_interval) {
+		POOL_TRIM_INTERVAL = (unsigned int) atoi (pool_trim_interval);
+		cerver_log_success ("POOL_TRIM_INTERVAL -> %u", POOL_TRIM_INTERVAL);
+	}
+
+	else {
+		cerver_log_warning (
+			"Failed to get POOL_TRIM_INTERVAL from env - using default %u!",
+			POOL_TRIM_INTERVAL
+		);
+	}
+
+}
+
 static unsigned int pocket_init_env (void) {
 
 	unsigned int errors = 0;
@@ -281,8 +589,46 @@ static unsigned int pocket_init_env (void) {
 
 	errors |= pocket_env_get_public_key ();
 
+	pocket_env_get_token_lifetime ();
+
 	pocket_env_get_enable_users_routes ();
 
+	pocket_env_get_cache_size ();
+
+	pocket_env_get_cache_ttl ();
+
+	pocket_env_get_roles_refresh_interval ();
+
+	pocket_env_get_password_workers ();
+
+	pocket_env_get_password_queue ();
+
+	pocket_env_get_password_cost ();
+
+	// after the threads, that limit the queue
+	errors |= pocket_env_check_password_queue ();
+
+	pocket_env_get_rate_limit_auth ();
+
+	pocket_env_get_rate_limit_auth_burst ();
+
+	pocket_env_get_rate_limit_write ();
+
+	pocket_env_get_rate_limit_write_burst ();
+
+	pocket_env_get_db_slow_threshold ();
+
+	// after the threads, that are used for the default sizes
+	pocket_env_get_pool_size ("TRANS_POOL_SIZE", &TRANS_POOL_SIZE);
+
+	pocket_env_get_pool_size ("CATEGORIES_POOL_SIZE", &CATEGORIES_POOL_SIZE);
+
+	pocket_env_get_pool_size ("PLACES_POOL_SIZE", &PLACES_POOL_SIZE);
+
+	pocket_env_get_pool_size ("USERS_POOL_SIZE", &USERS_POOL_SIZE);
+
+	pocket_env_get_pool_trim_interval ();
+
 	return errors;
 
 }
@@ -302,6 +648,15 @@ static unsigned int pocket_mongo_connect (void) {
 		if (!mongo_ping_db ()) {
 			cerver_log_success ("Connected to Mongo DB!");
 
+			db_set_slow_threshold (DB_SLOW_THRESHOLD);
+
+			// a query without an index must not reach production
+			db_set_indexes_required (RUNTIME == RUNTIME_TYPE_PRODUCTION);
+
+			errors |= db_init (
+				MONGO_URI->str, MONGO_APP_NAME->str, MONGO_DB->str
+			);
+
 			errors |= actions_model_init ();
 
 			errors |= categories_model_init ();
@@ -310,6 +665,8 @@ static unsigned int pocket_mongo_connect (void) {
 
 			errors |= roles_model_init ();
 
+			errors |= tombstones_model_init ();
+
 			errors |= transactions_model_init ();
 
 			errors |= users_model_init ();
@@ -333,7 +690,7 @@ static unsigned int pocket_mongo_init (void) {
 
 	if (!pocket_mongo_connect ()) {
 		if (!pocket_roles_init ()) {
-			retval = 0;
+			retval = pocket_roles_refresher_start (ROLES_REFRESH_INTERVAL);
 		}
 
 		else {
@@ -353,10 +710,27 @@ unsigned int pocket_init (void) {
 	if (!pocket_init_env ()) {
 		unsigned int errors = 0;
 
+		errors |= pocket_metrics_init ();
+
+		errors |= pocket_output_init ();
+
+		errors |= pocket_arena_request_init ();
+
 		errors |= pocket_mongo_init ();
 
+		errors |= pocket_password_init (
+			PASSWORD_WORKERS, PASSWORD_QUEUE, PASSWORD_COST
+		);
+
 		errors |= pocket_service_init ();
 
+		errors |= pocket_limits_init (
+			RATE_LIMIT_AUTH, RATE_LIMIT_AUTH_BURST,
+			RATE_LIMIT_WRITE, RATE_LIMIT_WRITE_BURST
+		);
+
+		errors |= pocket_etag_init (CACHE_TTL);
+
 		errors |= pocket_users_init ();
 
 		errors |= pocket_categories_init ();
@@ -365,6 +739,8 @@ unsigned int pocket_init (void) {
 
 		errors |= pocket_trans_init ();
 
+		errors |= pocket_pool_trimmer_start (POOL_TRIM_INTERVAL);
+
 		retval = errors;
 	}
 
@@ -383,10 +759,14 @@ static unsigned int pocket_mongo_end (void) {
 
 		roles_model_end ();
 
+		tombstones_model_end ();
+
 		transactions_model_end ();
 
 		users_model_end ();
 
+		db_end ();
+
 		mongo_disconnect ();
 	}
 
@@ -399,10 +779,16 @@ unsigned int pocket_end (void) {
 
 	unsigned int errors = 0;
 
+	pocket_roles_refresher_stop ();
+
+	pocket_pool_trimmer_stop ();
+
 	errors |= pocket_mongo_end ();
 
 	pocket_roles_end ();
 
+	pocket_password_end ();
+
 	pocket_users_end ();
 
 	pocket_categories_end ();
@@ -411,8 +797,18 @@ unsigned int pocket_end (void) {
 
 	pocket_trans_end ();
 
+	pocket_limits_end ();
+
+	pocket_etag_end ();
+
 	pocket_service_end ();
 
+	pocket_metrics_end ();
+
+	pocket_output_end ();
+
+	pocket_arena_request_end ();
+
 	str_delete ((String *) MONGO_URI);
 	str_delete ((String *) MONGO_APP_NAME);
 	str_delete ((String *) MONGO_DB);
@@ -0,0 +1,539 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <cerver/collections/pool.h>
+
+#include <cerver/utils/log.h>
+
+#include "pool.h"
+
+// every pool that has been created, so the trimmer can reach them
+static pthread_mutex_t pools_mutex = PTHREAD_MUTEX_INITIALIZER;
+static PocketPool *pools = NULL;
+
+static pthread_t trimmer_thread = 0;
+static sem_t trimmer_sem;
+static atomic_bool trimmer_running = false;
+static unsigned int trimmer_interval = 0;
+
+// counts the times that another thread was holding the lock
+static inline void pocket_pool_lock (PocketPool *pool) {
+
+	if (pthread_mutex_trylock (&pool->mutex)) {
+		(void) pthread_mutex_lock (&pool->mutex);
+		pool->contended += 1;
+	}
+
+	pool->locks += 1;
+
+}
+
+static inline void pocket_pool_unlock (PocketPool *pool) {
+
+	(void) pthread_mutex_unlock (&pool->mutex);
+
+}
+
+// takes an object from the shared pool, that makes a new one if it is empty
+// must be called with the lock
+static inline void *pocket_pool_take (PocketPool *pool) {
+
+	void *object = pool_pop (pool->pool);
+	if (object) {
+		if (pool->available) pool->available -= 1;
+		else pool->total += 1;
+
+		if ((pool->total - pool->available) > pool->peak) {
+			pool->peak = pool->total - pool->available;
+		}
+	}
+
+	return object;
+
+}
+
+// must be called with the lock
+static inline void pocket_pool_give (PocketPool *pool, void *object) {
+
+	(void) pool_push (pool->pool, object);
+	pool->available += 1;
+
+}
+
+// returns the objects of an exited thread to the shared pool
+// & leaves its magazine for the next thread
+static void pocket_pool_magazine_release (void *magazine_ptr) {
+
+	PocketPoolMagazine *magazine = (PocketPoolMagazine *) magazine_ptr;
+	PocketPool *pool = magazine->pool;
+
+	pocket_pool_lock (pool);
+
+	unsigned int count = atomic_load_explicit (
+		&magazine->count, memory_order_relaxed
+	);
+
+	while (count) {
+		count -= 1;
+		pocket_pool_give (pool, magazine->objects[count]);
+	}
+
+	atomic_store_explicit (&magazine->count, 0, memory_order_relaxed);
+	magazine->active = false;
+
+	pocket_pool_unlock (pool);
+
+}
+
+// returns a new pool with n objects or NULL on error,
+// more objects are made with create when it is empty
+// & the extra ones are destroyed by the trims
+PocketPool *pocket_pool_create (
+	void *(*create) (void), void (*destroy) (void *),
+	const unsigned int n
+) {
+
+	PocketPool *pool = (PocketPool *) calloc (1, sizeof (PocketPool));
+	if (pool) {
+		bool key_created = false;
+
+		pool->pool = pool_create (destroy);
+		if (pool->pool) {
+			pool_set_create (pool->pool, create);
+			pool_set_produce_if_empty (pool->pool, true);
+
+			if (!pool_init (pool->pool, create, n)) {
+				pool->destroy = destroy;
+
+				pool->available = n;
+				pool->total = n;
+
+				pool->min = n;
+				pool->high_water = n;
+
+				key_created = !pthread_key_create (
+					&pool->key, pocket_pool_magazine_release
+				);
+			}
+		}
+
+		if (key_created) {
+			(void) pthread_mutex_init (&pool->mutex, NULL);
+
+			(void) pthread_mutex_lock (&pools_mutex);
+			pool->next = pools;
+			pools = pool;
+			(void) pthread_mutex_unlock (&pools_mutex);
+		}
+
+		else {
+			if (pool->pool) pool_delete (pool->pool);
+			free (pool);
+			pool = NULL;
+		}
+	}
+
+	return pool;
+
+}
+
+// must be called after every thread has stopped using the pool
+void pocket_pool_delete (PocketPool *pool) {
+
+	if (pool) {
+		(void) pthread_mutex_lock (&pools_mutex);
+		PocketPool **ptr = &pools;
+		while (*ptr && (*ptr != pool)) ptr = &(*ptr)->next;
+		if (*ptr) *ptr = pool->next;
+		(void) pthread_mutex_unlock (&pools_mutex);
+
+		(void) pthread_key_delete (pool->key);
+
+		// the objects go back to the shared pool to be destroyed with it
+		PocketPoolMagazine *magazine = pool->magazines;
+		PocketPoolMagazine *next = NULL;
+		while (magazine) {
+			next = magazine->next;
+
+			unsigned int count = atomic_load (&magazine->count);
+			while (count) {
+				count -= 1;
+				(void) pool_push (pool->pool, magazine->objects[count]);
+			}
+
+			free (magazine);
+			magazine = next;
+		}
+
+		pool_delete (pool->pool);
+
+		(void) pthread_mutex_destroy (&pool->mutex);
+
+		free (pool);
+	}
+
+}
+
+// returns the thread's magazine, it is created the first time
+// that the thread uses the pool, NULL on error
+static PocketPoolMagazine *pocket_pool_magazine (PocketPool *pool) {
+
+	PocketPoolMagazine *magazine = (PocketPoolMagazine *) pthread_getspecific (
+		pool->key
+	);
+
+	if (!magazine) {
+		pocket_pool_lock (pool);
+
+		magazine = pool->magazines;
+		while (magazine && magazine->active) magazine = magazine->next;
+
+		if (!magazine) {
+			magazine = (PocketPoolMagazine *) aligned_alloc (
+				_Alignof (PocketPoolMagazine), sizeof (PocketPoolMagazine)
+			);
+
+			if (magazine) {
+				(void) memset (magazine, 0, sizeof (PocketPoolMagazine));
+				magazine->pool = pool;
+
+				magazine->next = pool->magazines;
+				pool->magazines = magazine;
+			}
+		}
+
+		if (magazine) magazine->active = true;
+
+		pocket_pool_unlock (pool);
+
+		if (magazine) (void) pthread_setspecific (pool->key, magazine);
+	}
+
+	return magazine;
+
+}
+
+// fills half of the empty magazine with a single lock
+static unsigned int pocket_pool_refill (
+	PocketPool *pool, PocketPoolMagazine *magazine
+) {
+
+	unsigned int count = 0;
+
+	pocket_pool_lock (pool);
+
+	void *object = NULL;
+	while (
+		(count < POCKET_POOL_BATCH)
+		&& (object = pocket_pool_take (pool))
+	) {
+		magazine->objects[count] = object;
+		count += 1;
+	}
+
+	atomic_store_explicit (&magazine->count, count, memory_order_relaxed);
+
+	pool->refills += 1;
+
+	pocket_pool_unlock (pool);
+
+	return count;
+
+}
+
+// moves the oldest half of the full magazine to the shared pool,
+// so the objects that were used last stay in the thread
+static unsigned int pocket_pool_spill (
+	PocketPool *pool, PocketPoolMagazine *magazine
+) {
+
+	pocket_pool_lock (pool);
+
+	for (unsigned int idx = 0; idx < POCKET_POOL_BATCH; idx++) {
+		pocket_pool_give (pool, magazine->objects[idx]);
+	}
+
+	(void) memmove (
+		magazine->objects, magazine->objects + POCKET_POOL_BATCH,
+		(POCKET_POOL_MAGAZINE_SIZE - POCKET_POOL_BATCH) * sizeof (void *)
+	);
+
+	atomic_store_explicit (
+		&magazine->count,
+		POCKET_POOL_MAGAZINE_SIZE - POCKET_POOL_BATCH,
+		memory_order_relaxed
+	);
+
+	pool->spills += 1;
+
+	pocket_pool_unlock (pool);
+
+	return POCKET_POOL_MAGAZINE_SIZE - POCKET_POOL_BATCH;
+
+}
+
+// returns an object from the thread's magazine,
+// refilled from the shared pool when it is empty
+void *pocket_pool_pop (PocketPool *pool) {
+
+	void *object = NULL;
+
+	PocketPoolMagazine *magazine = pocket_pool_magazine (pool);
+	if (magazine) {
+		unsigned int count = atomic_load_explicit (
+			&magazine->count, memory_order_relaxed
+		);
+
+		if (!count) count = pocket_pool_refill (pool, magazine);
+
+		if (count) {
+			count -= 1;
+			object = magazine->objects[count];
+
+			atomic_store_explicit (
+				&magazine->count, count, memory_order_relaxed
+			);
+		}
+	}
+
+	else {
+		pocket_pool_lock (pool);
+		object = pocket_pool_take (pool);
+		pocket_pool_unlock (pool);
+	}
+
+	return object;
+
+}
+
+// returns the object to the thread's magazine,
+// half of it is moved to the shared pool when it is full
+void pocket_pool_push (PocketPool *pool, void *object) {
+
+	PocketPoolMagazine *magazine = pocket_pool_magazine (pool);
+	if (magazine) {
+		unsigned int count = atomic_load_explicit (
+			&magazine->count, memory_order_relaxed
+		);
+
+		if (count == POCKET_POOL_MAGAZINE_SIZE) {
+			count = pocket_pool_spill (pool, magazine);
+		}
+
+		magazine->objects[count] = object;
+
+		atomic_store_explicit (
+			&magazine->count, count + 1, memory_order_relaxed
+		);
+	}
+
+	else {
+		pocket_pool_lock (pool);
+		pocket_pool_give (pool, object);
+		pocket_pool_unlock (pool);
+	}
+
+}
+
+void pocket_pool_get_stats (
+	PocketPool *pool, PocketPoolStats *stats
+) {
+
+	(void) memset (stats, 0, sizeof (PocketPoolStats));
+
+	// not counted, so reading the metrics does not change them
+	(void) pthread_mutex_lock (&pool->mutex);
+
+	for (
+		PocketPoolMagazine *magazine = pool->magazines;
+		magazine; magazine = magazine->next
+	) {
+		stats->cached += atomic_load_explicit (
+			&magazine->count, memory_order_relaxed
+		);
+
+		if (magazine->active) stats->magazines += 1;
+	}
+
+	stats->objects = pool->total;
+	stats->available = pool->available;
+
+	// the magazines are read without their threads,
+	// so the sum can be briefly over the total
+	if (pool->total > (stats->available + stats->cached)) {
+		stats->in_use = pool->total - stats->available - stats->cached;
+	}
+
+	stats->high_water = (size_t) pool->high_water;
+
+	stats->refills = pool->refills;
+	stats->spills = pool->spills;
+	stats->trimmed = pool->trimmed;
+
+	stats->locks = pool->locks;
+	stats->contended = pool->contended;
+
+	(void) pthread_mutex_unlock (&pool->mutex);
+
+}
+
+// decays the high water mark & returns the objects that the pool keeps
+// must be called with the lock
+static size_t pocket_pool_trim_target (PocketPool *pool) {
+
+	pool->high_water *= POCKET_POOL_TRIM_DECAY;
+	if ((double) pool->peak > pool->high_water) {
+		pool->high_water = (double) pool->peak;
+	}
+
+	// the next peak starts with the objects that are out right now
+	pool->peak = pool->total - pool->available;
+
+	size_t target = (size_t) pool->high_water;
+	if (target < pool->min) target = pool->min;
+
+	return target;
+
+}
+
+// destroys the shared objects that are over the decayed high water mark
+// & over the pool's start size, returns the number of destroyed objects
+size_t pocket_pool_trim (PocketPool *pool) {
+
+	size_t trimmed = 0;
+
+	pocket_pool_lock (pool);
+	size_t target = pocket_pool_trim_target (pool);
+	pocket_pool_unlock (pool);
+
+	// the lock is released between batches, so the requests
+	// can take objects while the extra ones are destroyed
+	void *objects[POCKET_POOL_TRIM_BATCH] = { 0 };
+	unsigned int count = 0;
+	do {
+		count = 0;
+
+		pocket_pool_lock (pool);
+
+		void *object = NULL;
+		while (
+			(count < POCKET_POOL_TRIM_BATCH)
+			&& pool->available && (pool->total > target)
+			&& (object = pool_pop (pool->pool))
+		) {
+			objects[count] = object;
+			count += 1;
+
+			pool->available -= 1;
+			pool->total -= 1;
+		}
+
+		pool->trimmed += count;
+
+		pocket_pool_unlock (pool);
+
+		for (unsigned int idx = 0; idx < count; idx++) {
+			pool->destroy (objects[idx]);
+		}
+
+		trimmed += count;
+	} while (count == POCKET_POOL_TRIM_BATCH);
+
+	return trimmed;
+
+}
+
+static void pocket_pool_trim_all (void) {
+
+	size_t trimmed = 0;
+
+	(void) pthread_mutex_lock (&pools_mutex);
+
+	for (PocketPool *pool = pools; pool; pool = pool->next) {
+		trimmed += pocket_pool_trim (pool);
+	}
+
+	(void) pthread_mutex_unlock (&pools_mutex);
+
+	#ifdef POCKET_DEBUG
+	if (trimmed) cerver_log_debug ("Trimmed %zu pooled objects", trimmed);
+	#else
+	(void) trimmed;
+	#endif
+
+}
+
+static void *pocket_pool_trimmer (void *args) {
+
+	(void) args;
+
+	struct timespec timeout = { 0 };
+	int result = 0;
+	while (atomic_load (&trimmer_running)) {
+		(void) clock_gettime (CLOCK_REALTIME, &timeout);
+		timeout.tv_sec += trimmer_interval;
+
+		result = sem_timedwait (&trimmer_sem, &timeout);
+		if ((result < 0) && (errno == EINTR)) continue;
+
+		if (atomic_load (&trimmer_running)) {
+			pocket_pool_trim_all ();
+		}
+	}
+
+	return NULL;
+
+}
+
+// starts a thread that trims every pool each interval seconds,
+// 0 to never trim them
+// returns 0 on success, 1 on error
+unsigned int pocket_pool_trimmer_start (
+	const unsigned int interval
+) {
+
+	unsigned int retval = 1;
+
+	if (!interval) {
+		retval = 0;
+	}
+
+	else if (!sem_init (&trimmer_sem, 0, 0)) {
+		trimmer_interval = interval;
+		atomic_store (&trimmer_running, true);
+
+		if (!pthread_create (
+			&trimmer_thread, NULL, pocket_pool_trimmer, NULL
+		)) {
+			retval = 0;
+		}
+
+		else {
+			cerver_log_error ("Failed to create pools trimmer thread!");
+
+			atomic_store (&trimmer_running, false);
+			(void) sem_destroy (&trimmer_sem);
+		}
+	}
+
+	return retval;
+
+}
+
+void pocket_pool_trimmer_stop (void) {
+
+	if (atomic_exchange (&trimmer_running, false)) {
+		(void) sem_post (&trimmer_sem);
+		(void) pthread_join (trimmer_thread, NULL);
+
+		(void) sem_destroy (&trimmer_sem);
+	}
+
+}
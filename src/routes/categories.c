@@ -14,7 +14,10 @@
 #include <cerver/utils/utils.h>
 #include <cerver/utils/log.h>
 
+#include "etag.h"
+#include "limiter.h"
 #include "pocket.h"
+#include "stream.h"
 
 #include "controllers/categories.h"
 #include "controllers/users.h"
@@ -28,29 +31,19 @@ void pocket_categories_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		size_t json_len = 0;
-		char *json = NULL;
-
-		if (!pocket_categories_get_all_by_user (
-			&user->oid,
-			&json, &json_len
-		)) {
-			if (json) {
-				(void) http_response_json_custom_reference_send (
-					http_receive,
-					HTTP_STATUS_OK,
-					json, json_len
-				);
-
-				free (json);
-			}
+		char etag_buffer[POCKET_ETAG_SIZE] = { 0 };
+		const char *etag = pocket_etag_get (
+			POCKET_ETAG_KIND_CATEGORIES, &user->oid,
+			NULL, 0, etag_buffer
+		);
 
-			else {
-				(void) http_response_send (no_user_categories, http_receive);
-			}
+		if (pocket_etag_match (request, etag)) {
+			(void) pocket_stream_send_not_modified (http_receive, etag);
 		}
 
-		else {
+		else if (pocket_categories_send_all_by_user (
+			http_receive, etag, &user->oid
+		) == POCKET_STREAM_RESULT_NONE) {
 			(void) http_response_send (no_user_categories, http_receive);
 		}
 	}
@@ -70,22 +63,24 @@ void pocket_category_create_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		PocketError error = pocket_category_create (
-			user, request->body
-		);
+		if (!pocket_limit_write (http_receive, &user->oid)) {
+			PocketError error = pocket_category_create (
+				user, request->body
+			);
+
+			switch (error) {
+				case POCKET_ERROR_NONE: {
+					// return success to user
+					(void) http_response_send (
+						category_created_success,
+						http_receive
+					);
+				} break;
 
-		switch (error) {
-			case POCKET_ERROR_NONE: {
-				// return success to user
-				(void) http_response_send (
-					category_created_success,
-					http_receive
-				);
-			} break;
-
-			default: {
-				pocket_error_send_response (error, http_receive);
-			} break;
+				default: {
+					pocket_error_send_response (error, http_receive);
+				} break;
+			}
 		}
 	}
 
@@ -106,21 +101,30 @@ void pocket_category_get_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		if (category_id) {
+		char etag_buffer[POCKET_ETAG_SIZE] = { 0 };
+		const char *etag = category_id ? pocket_etag_get (
+			POCKET_ETAG_KIND_CATEGORIES, &user->oid,
+			category_id->str, category_id->len, etag_buffer
+		) : NULL;
+
+		if (category_id && pocket_etag_match (request, etag)) {
+			(void) pocket_stream_send_not_modified (http_receive, etag);
+		}
+
+		else if (category_id) {
 			size_t json_len = 0;
-			char *json = NULL;
+			const char *json = NULL;
 
 			if (!pocket_category_get_by_id_and_user_to_json (
 				category_id->str, &user->oid,
 				category_no_user_query_opts,
+				&category_no_user_shape,
 				&json, &json_len
 			)) {
 				if (json) {
-					(void) http_response_json_custom_reference_send (
-						http_receive, HTTP_STATUS_OK, json, json_len
+					(void) pocket_stream_send_json (
+						http_receive, etag, json, json_len
 					);
-					
-					free (json);
 				}
 
 				else {
@@ -149,18 +153,20 @@ void pocket_category_update_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		PocketError error = pocket_category_update (
-			user, request->params[0], request->body
-		);
-
-		switch (error) {
-			case POCKET_ERROR_NONE: {
-				(void) http_response_send (oki_doki, http_receive);
-			} break;
-
-			default: {
-				pocket_error_send_response (error, http_receive);
-			} break;
+		if (!pocket_limit_write (http_receive, &user->oid)) {
+			PocketError error = pocket_category_update (
+				user, request->params[0], request->body
+			);
+
+			switch (error) {
+				case POCKET_ERROR_NONE: {
+					(void) http_response_send (oki_doki, http_receive);
+				} break;
+
+				default: {
+					pocket_error_send_response (error, http_receive);
+				} break;
+			}
 		}
 	}
 
@@ -181,14 +187,20 @@ void pocket_category_delete_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		switch (pocket_category_delete (user, category_id)) {
+		PocketError error = pocket_category_delete (user, category_id);
+
+		switch (error) {
 			case POCKET_ERROR_NONE:
 				(void) http_response_send (category_deleted_success, http_receive);
 				break;
 
-			default:
+			case POCKET_ERROR_BAD_REQUEST:
 				(void) http_response_send (category_deleted_bad, http_receive);
 				break;
+
+			default:
+				pocket_error_send_response (error, http_receive);
+				break;
 		}
 	}
 
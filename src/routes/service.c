@@ -11,10 +11,13 @@
 #include <cerver/utils/utils.h>
 #include <cerver/utils/log.h>
 
+#include "metrics.h"
 #include "pocket.h"
+#include "stream.h"
 
 #include "models/user.h"
 
+#include "controllers/roles.h"
 #include "controllers/service.h"
 
 // GET /api/pocket
@@ -37,6 +40,51 @@ void pocket_version_handler (
 
 }
 
+static void pocket_metrics_send (const HttpReceive *http_receive) {
+
+	size_t metrics_len = 0;
+	char *metrics = pocket_metrics_export (&metrics_len);
+	if (metrics) {
+		(void) pocket_stream_send_body (
+			http_receive, POCKET_METRICS_CONTENT_TYPE, NULL,
+			metrics, metrics_len
+		);
+
+		free (metrics);
+	}
+
+	else {
+		(void) http_response_send (server_error, http_receive);
+	}
+
+}
+
+// GET /api/pocket/metrics
+// only for the roles with the metrics action
+void pocket_metrics_handler (
+	const HttpReceive *http_receive,
+	const HttpRequest *request
+) {
+
+	User *user = (User *) request->decoded_data;
+
+	if (user) {
+		const Role *role = pocket_role_get_by_name (user->role);
+		if (role && pocket_role_can (role, pocket_role_metrics_action_get ())) {
+			pocket_metrics_send (http_receive);
+		}
+
+		else {
+			(void) http_response_send (not_allowed, http_receive);
+		}
+	}
+
+	else {
+		(void) http_response_send (bad_user_error, http_receive);
+	}
+
+}
+
 // GET /api/pocket/auth
 void pocket_auth_handler (
 	const HttpReceive *http_receive,
@@ -0,0 +1,50 @@
+#include <stdlib.h>
+
+#include <cerver/types/types.h>
+#include <cerver/types/string.h>
+
+#include <cerver/http/http.h>
+#include <cerver/http/route.h>
+#include <cerver/http/request.h>
+#include <cerver/http/response.h>
+
+#include <cerver/utils/log.h>
+
+#include "errors.h"
+#include "pocket.h"
+
+#include "controllers/sync.h"
+#include "controllers/users.h"
+
+#include "models/user.h"
+
+// GET /api/pocket/sync?since=1620000000000
+// returns the user's values that changed after since
+void pocket_sync_handler (
+	const HttpReceive *http_receive,
+	const HttpRequest *request
+) {
+
+	User *user = (User *) request->decoded_data;
+	if (user) {
+		int64_t since = 0;
+		if (pocket_sync_query_init (
+			&since, request->query_params
+		) == POCKET_ERROR_NONE) {
+			if (pocket_sync_send_by_user (
+				http_receive, &user->oid, since
+			) == POCKET_STREAM_RESULT_NONE) {
+				(void) http_response_send (server_error, http_receive);
+			}
+		}
+
+		else {
+			(void) http_response_send (bad_request_error, http_receive);
+		}
+	}
+
+	else {
+		(void) http_response_send (bad_user_error, http_receive);
+	}
+
+}
@@ -15,7 +15,10 @@
 #include <cerver/utils/log.h>
 
 #include "errors.h"
+#include "etag.h"
+#include "limiter.h"
 #include "pocket.h"
+#include "stream.h"
 
 #include "controllers/categories.h"
 #include "controllers/transactions.h"
@@ -24,8 +27,8 @@
 #include "models/category.h"
 #include "models/user.h"
 
-// GET /api/pocket/transactions
-// get all the authenticated user's transactions
+// GET /api/pocket/transactions?limit=50&after=cursor&from=2021-05-01&to=2021-06-01
+// get a page of the authenticated user's transactions
 void pocket_transactions_handler (
 	const HttpReceive *http_receive,
 	const HttpRequest *request
@@ -33,21 +36,64 @@ void pocket_transactions_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		size_t json_len = 0;
-		char *json = NULL;
-
-		if (!pocket_trans_get_all_by_user (
-			&user->oid,
-			&json, &json_len
-		)) {
-			if (json) {
+		TransactionsQuery query = { 0 };
+		if (pocket_trans_query_init (
+			&query, request->query_params
+		) == POCKET_ERROR_NONE) {
+			// the parsed query is the variant, as its unused values are zeroed
+			char etag_buffer[POCKET_ETAG_SIZE] = { 0 };
+			const char *etag = pocket_etag_get (
+				POCKET_ETAG_KIND_TRANSACTIONS, &user->oid,
+				&query, sizeof (TransactionsQuery), etag_buffer
+			);
+
+			if (pocket_etag_match (request, etag)) {
+				(void) pocket_stream_send_not_modified (http_receive, etag);
+			}
+
+			else if (pocket_trans_send_all_by_user (
+				http_receive, etag, &user->oid, &query
+			) == POCKET_STREAM_RESULT_NONE) {
+				(void) http_response_send (no_user_trans, http_receive);
+			}
+		}
+
+		else {
+			(void) http_response_send (bad_request_error, http_receive);
+		}
+	}
+
+	else {
+		(void) http_response_send (bad_user_error, http_receive);
+	}
+
+}
+
+// GET /api/pocket/transactions/summary?from=2021-01-01&to=2022-01-01
+// returns the user's transactions totals by category & by month
+void pocket_transactions_summary_handler (
+	const HttpReceive *http_receive,
+	const HttpRequest *request
+) {
+
+	User *user = (User *) request->decoded_data;
+	if (user) {
+		TransactionsQuery query = { 0 };
+		if (pocket_trans_query_init (
+			&query, request->query_params
+		) == POCKET_ERROR_NONE) {
+			size_t json_len = 0;
+			const char *json = NULL;
+
+			if (!pocket_trans_get_summary_by_user (
+				&user->oid, &query,
+				&json, &json_len
+			)) {
 				(void) http_response_json_custom_reference_send (
 					http_receive,
 					HTTP_STATUS_OK,
 					json, json_len
 				);
-
-				free (json);
 			}
 
 			else {
@@ -56,7 +102,7 @@ void pocket_transactions_handler (
 		}
 
 		else {
-			(void) http_response_send (no_user_trans, http_receive);
+			(void) http_response_send (bad_request_error, http_receive);
 		}
 	}
 
@@ -75,22 +121,65 @@ void pocket_transaction_create_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		PocketError error = pocket_trans_create (
-			user, request->body
-		);
+		if (!pocket_limit_write (http_receive, &user->oid)) {
+			PocketError error = pocket_trans_create (
+				user, request->body
+			);
+
+			switch (error) {
+				case POCKET_ERROR_NONE: {
+					// return success to user
+					(void) http_response_send (
+						trans_created_success,
+						http_receive
+					);
+				} break;
 
-		switch (error) {
-			case POCKET_ERROR_NONE: {
-				// return success to user
-				(void) http_response_send (
-					trans_created_success,
-					http_receive
-				);
-			} break;
+				default: {
+					pocket_error_send_response (error, http_receive);
+				} break;
+			}
+		}
+	}
 
-			default: {
-				pocket_error_send_response (error, http_receive);
-			} break;
+	else {
+		(void) http_response_send (bad_user_error, http_receive);
+	}
+
+}
+
+// POST /api/pocket/transactions/bulk
+// a user has requested to create multiple transactions at once
+void pocket_transactions_bulk_handler (
+	const HttpReceive *http_receive,
+	const HttpRequest *request
+) {
+
+	User *user = (User *) request->decoded_data;
+	if (user) {
+		// the rest of the items are limited once they are counted
+		if (!pocket_limit_write (http_receive, &user->oid)) {
+			size_t json_len = 0;
+			const char *json = NULL;
+
+			PocketError error = pocket_trans_create_bulk (
+				user, request->body,
+				&json, &json_len
+			);
+
+			switch (error) {
+				case POCKET_ERROR_NONE: {
+					(void) http_response_json_custom_reference_send (
+						http_receive,
+						HTTP_STATUS_OK,
+						json, json_len
+					);
+				} break;
+
+				default: {
+					pocket_error_send_response (error, http_receive);
+				} break;
+			}
 		}
 	}
 
@@ -111,21 +200,30 @@ void pocket_transaction_get_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		if (trans_id) {
+		char etag_buffer[POCKET_ETAG_SIZE] = { 0 };
+		const char *etag = trans_id ? pocket_etag_get (
+			POCKET_ETAG_KIND_TRANSACTIONS, &user->oid,
+			trans_id->str, trans_id->len, etag_buffer
+		) : NULL;
+
+		if (trans_id && pocket_etag_match (request, etag)) {
+			(void) pocket_stream_send_not_modified (http_receive, etag);
+		}
+
+		else if (trans_id) {
 			size_t json_len = 0;
-			char *json = NULL;
+			const char *json = NULL;
 
 			if (!pocket_trans_get_by_id_and_user_to_json (
 				trans_id->str, &user->oid,
 				trans_no_user_query_opts,
+				&trans_no_user_shape,
 				&json, &json_len
 			)) {
 				if (json) {
-					(void) http_response_json_custom_reference_send (
-						http_receive, HTTP_STATUS_OK, json, json_len
+					(void) pocket_stream_send_json (
+						http_receive, etag, json, json_len
 					);
-
-					free (json);
 				}
 
 				else {
@@ -154,18 +252,20 @@ void pocket_transaction_update_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		PocketError error = pocket_trans_update (
-			user, request->params[0], request->body
-		);
-
-		switch (error) {
-			case POCKET_ERROR_NONE: {
-				(void) http_response_send (oki_doki, http_receive);
-			} break;
-
-			default: {
-				pocket_error_send_response (error, http_receive);
-			} break;
+		if (!pocket_limit_write (http_receive, &user->oid)) {
+			PocketError error = pocket_trans_update (
+				user, request->params[0], request->body
+			);
+
+			switch (error) {
+				case POCKET_ERROR_NONE: {
+					(void) http_response_send (oki_doki, http_receive);
+				} break;
+
+				default: {
+					pocket_error_send_response (error, http_receive);
+				} break;
+			}
 		}
 	}
 
@@ -186,14 +286,20 @@ void pocket_transaction_delete_handler (
 
 	User *user = (User *) request->decoded_data;
 	if (user) {
-		switch (pocket_trans_delete (user, trans_id)) {
+		PocketError error = pocket_trans_delete (user, trans_id);
+
+		switch (error) {
 			case POCKET_ERROR_NONE:
 				(void) http_response_send (trans_deleted_success, http_receive);
 				break;
 
-			default:
+			case POCKET_ERROR_BAD_REQUEST:
 				(void) http_response_send (trans_deleted_bad, http_receive);
 				break;
+
+			default:
+				pocket_error_send_response (error, http_receive);
+				break;
 		}
 	}
 
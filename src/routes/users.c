@@ -14,6 +14,7 @@
 #include <cerver/utils/utils.h>
 #include <cerver/utils/log.h>
 
+#include "limiter.h"
 #include "pocket.h"
 
 #include "controllers/roles.h"
@@ -92,46 +93,54 @@ void users_register_handler (
 	const HttpRequest *request
 ) {
 
-	PocketUserError error = POCKET_USER_ERROR_NONE;
-	PocketUserInput input = POCKET_USER_INPUT_NONE;
-
-	char token[HTTP_JWT_TOKEN_SIZE] = { 0 };
-	size_t token_size = 0;
-
-	User *user = pocket_user_register (
-		request->body, &error, &input
-	);
-
-	// TODO: handle errors
-	switch (error) {
-		case POCKET_USER_ERROR_NONE: {
-			(void) pocket_user_generate_token (
-				user, token, &token_size
-			);
-
-			// return token back to the user
-			(void) http_response_render_json (
-				http_receive, HTTP_STATUS_OK,
-				token, token_size
-			);
-
-			pocket_user_delete (user);
-		} break;
-
-		case POCKET_USER_ERROR_BAD_REQUEST:
-			users_send_input_error (http_receive, input);
-			break;
-
-		case POCKET_USER_ERROR_MISSING_VALUES:
-			users_send_input_error (http_receive, input);
-			break;
-
-		case POCKET_USER_ERROR_REPEATED: break;
-		case POCKET_USER_ERROR_NOT_FOUND: break;
-		case POCKET_USER_ERROR_WRONG_PSWD: break;
-		case POCKET_USER_ERROR_SERVER_ERROR: break;
-
-		default: break;
+	if (!pocket_limit_auth (http_receive)) {
+		PocketUserError error = POCKET_USER_ERROR_NONE;
+		PocketUserInput input = POCKET_USER_INPUT_NONE;
+
+		char token[HTTP_JWT_TOKEN_SIZE] = { 0 };
+		size_t token_size = 0;
+
+		User *user = pocket_user_register (
+			request->body, &error, &input
+		);
+
+		// TODO: handle errors
+		switch (error) {
+			case POCKET_USER_ERROR_NONE: {
+				(void) pocket_user_generate_token (
+					user, token, &token_size
+				);
+
+				// return token back to the user
+				(void) http_response_render_json (
+					http_receive, HTTP_STATUS_OK,
+					token, token_size
+				);
+
+				pocket_user_delete (user);
+			} break;
+
+			case POCKET_USER_ERROR_BAD_REQUEST:
+				users_send_input_error (http_receive, input);
+				break;
+
+			case POCKET_USER_ERROR_MISSING_VALUES:
+				users_send_input_error (http_receive, input);
+				break;
+
+			case POCKET_USER_ERROR_REPEATED:
+				(void) http_response_send (repeated_email, http_receive);
+				break;
+			case POCKET_USER_ERROR_NOT_FOUND: break;
+			case POCKET_USER_ERROR_WRONG_PSWD: break;
+			case POCKET_USER_ERROR_SERVER_ERROR: break;
+
+			case POCKET_USER_ERROR_BUSY:
+				(void) http_response_send (users_busy, http_receive);
+				break;
+
+			default: break;
+		}
 	}
 
 }
@@ -142,45 +151,51 @@ void users_login_handler (
 	const HttpRequest *request
 ) {
 
-	PocketUserError error = POCKET_USER_ERROR_NONE;
-	PocketUserInput input = POCKET_USER_INPUT_NONE;
+	if (!pocket_limit_auth (http_receive)) {
+		PocketUserError error = POCKET_USER_ERROR_NONE;
+		PocketUserInput input = POCKET_USER_INPUT_NONE;
 
-	char token[HTTP_JWT_TOKEN_SIZE] = { 0 };
-	size_t token_size = 0;
+		char token[HTTP_JWT_TOKEN_SIZE] = { 0 };
+		size_t token_size = 0;
 
-	User *user = pocket_user_login (
-		request->body, &error, &input
-	);
+		User *user = pocket_user_login (
+			request->body, &error, &input
+		);
+
+		// TODO: handle errors
+		switch (error) {
+			case POCKET_USER_ERROR_NONE: {
+				(void) pocket_user_generate_token (
+					user, token, &token_size
+				);
 
-	// TODO: handle errors
-	switch (error) {
-		case POCKET_USER_ERROR_NONE: {
-			(void) pocket_user_generate_token (
-				user, token, &token_size
-			);
+				// return token back to the user
+				(void) http_response_render_json (
+					http_receive, HTTP_STATUS_OK,
+					token, token_size
+				);
 
-			// return token back to the user
-			(void) http_response_render_json (
-				http_receive, HTTP_STATUS_OK,
-				token, token_size
-			);
+				pocket_user_delete (user);
+			} break;
 
-			pocket_user_delete (user);
-		} break;
+			case POCKET_USER_ERROR_BAD_REQUEST:
+				users_send_input_error (http_receive, input);
+				break;
 
-		case POCKET_USER_ERROR_BAD_REQUEST:
-			users_send_input_error (http_receive, input);
-			break;
+			case POCKET_USER_ERROR_MISSING_VALUES:
+				users_send_input_error (http_receive, input);
+				break;
 
-		case POCKET_USER_ERROR_MISSING_VALUES:
-			users_send_input_error (http_receive, input);
-			break;
+			case POCKET_USER_ERROR_NOT_FOUND: break;
+			case POCKET_USER_ERROR_WRONG_PSWD: break;
+			case POCKET_USER_ERROR_SERVER_ERROR: break;
 
-		case POCKET_USER_ERROR_NOT_FOUND: break;
-		case POCKET_USER_ERROR_WRONG_PSWD: break;
-		case POCKET_USER_ERROR_SERVER_ERROR: break;
+			case POCKET_USER_ERROR_BUSY:
+				(void) http_response_send (users_busy, http_receive);
+				break;
 
-		default: break;
+			default: break;
+		}
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,502 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <errno.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <bson/bson.h>
+#include <mongoc/mongoc.h>
+
+#include <cerver/connection.h>
+#include <cerver/handler.h>
+#include <cerver/socket.h>
+
+#include <cerver/http/http.h>
+
+#include <cerver/utils/log.h>
+
+#include "cache.h"
+#include "db.h"
+#include "output.h"
+#include "stream.h"
+
+#define POCKET_STREAM_CHUNK_HEADER_SIZE		16
+#define POCKET_STREAM_HEADERS_SIZE			256
+
+static const char stream_headers[] = {
+	"HTTP/1.1 200 OK\r\n"
+	"Content-Type: application/json\r\n"
+	"Transfer-Encoding: chunked\r\n"
+};
+
+static const char not_modified_headers[] = {
+	"HTTP/1.1 304 Not Modified\r\n"
+	"Content-Length: 0\r\n"
+};
+
+static const char stream_last_chunk[] = { "0\r\n\r\n" };
+
+// writes all the data to the socket
+static unsigned int pocket_stream_send (
+	PocketStream *stream, const char *data, size_t data_len
+) {
+
+	ssize_t sent = 0;
+	while (data_len && !stream->error) {
+		sent = send (stream->sock_fd, data, data_len, MSG_NOSIGNAL);
+		if (sent > 0) {
+			data += sent;
+			data_len -= (size_t) sent;
+		}
+
+		else if ((sent < 0) && (errno == EINTR)) {
+			continue;
+		}
+
+		else {
+			#ifdef POCKET_DEBUG
+			cerver_log_error (
+				"pocket_stream_send () - send () failed on sock fd %d",
+				stream->sock_fd
+			);
+			#endif
+
+			stream->error = true;
+		}
+	}
+
+	return stream->error ? 1 : 0;
+
+}
+
+// sends the buffered data as a single chunk
+static void pocket_stream_flush (PocketStream *stream) {
+
+	if (stream->len && !stream->error) {
+		char chunk_header[POCKET_STREAM_CHUNK_HEADER_SIZE] = { 0 };
+		int header_len = snprintf (
+			chunk_header, POCKET_STREAM_CHUNK_HEADER_SIZE,
+			"%zx\r\n", stream->len
+		);
+
+		(void) pocket_stream_send (stream, chunk_header, (size_t) header_len);
+		(void) pocket_stream_send (stream, stream->buffer, stream->len);
+		(void) pocket_stream_send (stream, "\r\n", 2);
+	}
+
+	stream->len = 0;
+
+}
+
+// ends the headers with the stream's etag
+static unsigned int pocket_stream_send_headers_end (PocketStream *stream) {
+
+	char headers[POCKET_STREAM_HEADERS_SIZE] = { 0 };
+	int headers_len = 0;
+
+	if (stream->etag) {
+		headers_len = snprintf (
+			headers, POCKET_STREAM_HEADERS_SIZE,
+			"ETag: %s\r\n\r\n", stream->etag
+		);
+	}
+
+	else {
+		headers_len = snprintf (
+			headers, POCKET_STREAM_HEADERS_SIZE, "\r\n"
+		);
+	}
+
+	return pocket_stream_send (stream, headers, (size_t) headers_len);
+
+}
+
+static void pocket_stream_init (
+	PocketStream *stream, const HttpReceive *http_receive
+) {
+
+	stream->sock_fd = http_receive->cr->connection->socket->sock_fd;
+
+	stream->started = true;
+	stream->error = false;
+	stream->len = 0;
+
+}
+
+// sends a complete body with its content type & etag if it is set
+// returns 0 on success, 1 on error
+unsigned int pocket_stream_send_body (
+	const HttpReceive *http_receive,
+	const char *content_type, const char *etag,
+	const char *body, const size_t body_len
+) {
+
+	PocketStream stream = { 0 };
+	pocket_stream_init (&stream, http_receive);
+	stream.etag = etag;
+
+	char headers[POCKET_STREAM_HEADERS_SIZE] = { 0 };
+	int headers_len = snprintf (
+		headers, POCKET_STREAM_HEADERS_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: %s\r\n"
+		"Content-Length: %zu\r\n",
+		content_type, body_len
+	);
+
+	(void) pocket_stream_send (&stream, headers, (size_t) headers_len);
+	(void) pocket_stream_send_headers_end (&stream);
+	(void) pocket_stream_send (&stream, body, body_len);
+
+	return stream.error ? 1 : 0;
+
+}
+
+// sends a complete json body, with its etag if it is set
+// returns 0 on success, 1 on error
+unsigned int pocket_stream_send_json (
+	const HttpReceive *http_receive, const char *etag,
+	const char *json, const size_t json_len
+) {
+
+	return pocket_stream_send_body (
+		http_receive, "application/json", etag, json, json_len
+	);
+
+}
+
+// lets the client know that its copy matches the etag
+// returns 0 on success, 1 on error
+unsigned int pocket_stream_send_not_modified (
+	const HttpReceive *http_receive, const char *etag
+) {
+
+	PocketStream stream = { 0 };
+	pocket_stream_init (&stream, http_receive);
+	stream.etag = etag;
+
+	(void) pocket_stream_send (
+		&stream, not_modified_headers, sizeof (not_modified_headers) - 1
+	);
+
+	(void) pocket_stream_send_headers_end (&stream);
+
+	return stream.error ? 1 : 0;
+
+}
+
+// sends the key's cached json response if it exists with the same etag
+// returns true if the response was sent,
+// if not, ticket is set like in pocket_cache_get ()
+bool pocket_stream_cache_send (
+	PocketCache *cache, const HttpReceive *http_receive,
+	const bson_oid_t *key, const char *etag, u64 *ticket
+) {
+
+	bool sent = false;
+
+	size_t json_len = 0;
+	char *json = NULL;
+	if (pocket_cache_get (cache, key, etag, &json, &json_len, ticket)) {
+		(void) pocket_stream_send_json (
+			http_receive, etag, json, json_len
+		);
+
+		free (json);
+
+		sent = true;
+	}
+
+	return sent;
+
+}
+
+// sends the response headers with a chunked body
+// returns 0 on success, 1 on error
+unsigned int pocket_stream_start (
+	PocketStream *stream, const HttpReceive *http_receive
+) {
+
+	pocket_stream_init (stream, http_receive);
+
+	(void) pocket_stream_send (
+		stream, stream_headers, sizeof (stream_headers) - 1
+	);
+
+	return pocket_stream_send_headers_end (stream);
+
+}
+
+// keeps a copy of the body, up to max size, as it is written
+// must be released with pocket_stream_capture_free ()
+void pocket_stream_capture (
+	PocketStream *stream, const size_t max_size
+) {
+
+	stream->capture = true;
+	stream->capture_data = NULL;
+	stream->capture_len = 0;
+	stream->capture_size = 0;
+	stream->capture_max = max_size;
+
+}
+
+void pocket_stream_capture_free (PocketStream *stream) {
+
+	free (stream->capture_data);
+
+	stream->capture = false;
+	stream->capture_data = NULL;
+	stream->capture_len = 0;
+	stream->capture_size = 0;
+
+}
+
+// stores the captured body in the cache with the stream's etag
+// if the stream was sent and releases the captured data
+void pocket_stream_capture_store (
+	PocketStream *stream, const PocketStreamResult result,
+	PocketCache *cache, const bson_oid_t *key, const u64 ticket
+) {
+
+	if (
+		(result == POCKET_STREAM_RESULT_OK)
+		&& stream->capture && stream->capture_data
+	) {
+		pocket_cache_set (
+			cache, key, ticket, stream->etag,
+			stream->capture_data, stream->capture_len
+		);
+	}
+
+	pocket_stream_capture_free (stream);
+
+}
+
+static void pocket_stream_capture_write (
+	PocketStream *stream, const char *data, const size_t data_len
+) {
+
+	const size_t needed = stream->capture_len + data_len;
+	if (needed > stream->capture_max) {
+		pocket_stream_capture_free (stream);
+		return;
+	}
+
+	if (needed > stream->capture_size) {
+		size_t new_size = stream->capture_size ?
+			stream->capture_size : POCKET_STREAM_BUFFER_SIZE;
+
+		while (new_size < needed) new_size *= 2;
+		if (new_size > stream->capture_max) new_size = stream->capture_max;
+
+		char *new_data = (char *) realloc (stream->capture_data, new_size);
+		if (!new_data) {
+			pocket_stream_capture_free (stream);
+			return;
+		}
+
+		stream->capture_data = new_data;
+		stream->capture_size = new_size;
+	}
+
+	(void) memcpy (stream->capture_data + stream->capture_len, data, data_len);
+	stream->capture_len = needed;
+
+}
+
+// adds data to the stream, sends chunks as the buffer fills up
+void pocket_stream_write (
+	PocketStream *stream, const char *data, size_t data_len
+) {
+
+	if (stream->capture) {
+		pocket_stream_capture_write (stream, data, data_len);
+	}
+
+	size_t available = 0;
+	while (data_len && !stream->error) {
+		available = POCKET_STREAM_BUFFER_SIZE - stream->len;
+		if (data_len < available) available = data_len;
+
+		(void) memcpy (stream->buffer + stream->len, data, available);
+		stream->len += available;
+		data += available;
+		data_len -= available;
+
+		if (stream->len == POCKET_STREAM_BUFFER_SIZE) {
+			pocket_stream_flush (stream);
+		}
+	}
+
+}
+
+void pocket_stream_write_string (
+	PocketStream *stream, const char *string
+) {
+
+	pocket_stream_write (stream, string, strlen (string));
+
+}
+
+// sends any pending data & terminates the chunked body
+// if the stream had an error, the connection is aborted instead
+// to let the client know that the response is incomplete
+PocketStreamResult pocket_stream_end (PocketStream *stream) {
+
+	PocketStreamResult result = POCKET_STREAM_RESULT_NONE;
+
+	if (stream->started) {
+		pocket_stream_flush (stream);
+
+		(void) pocket_stream_send (
+			stream, stream_last_chunk, sizeof (stream_last_chunk) - 1
+		);
+
+		if (stream->error) {
+			(void) shutdown (stream->sock_fd, SHUT_RDWR);
+			result = POCKET_STREAM_RESULT_BROKEN;
+		}
+
+		else {
+			result = POCKET_STREAM_RESULT_OK;
+		}
+	}
+
+	return result;
+
+}
+
+// writes "key": [ ... ] with every document in the cursor
+// starting with the one that was already requested
+static void pocket_stream_cursor_write (
+	PocketStream *stream,
+	mongoc_cursor_t *cursor, const char *key,
+	const PocketOutputShape *shape,
+	const bson_t *doc, bool next,
+	pocket_stream_doc_cb doc_cb, void *doc_cb_args
+) {
+
+	pocket_stream_write (stream, "\"", 1);
+	pocket_stream_write_string (stream, key);
+	pocket_stream_write_string (stream, "\": [");
+
+	bool first = true;
+	size_t doc_json_len = 0;
+	const char *doc_json = NULL;
+	while (next && !stream->error) {
+		doc_json = pocket_output_doc (shape, doc, &doc_json_len);
+		if (doc_json) {
+			if (!first) pocket_stream_write (stream, ",", 1);
+			pocket_stream_write (stream, doc_json, doc_json_len);
+
+			if (doc_cb) doc_cb (doc, doc_cb_args);
+			first = false;
+		}
+
+		next = db_cursor_next (cursor, &doc);
+	}
+
+	pocket_stream_write (stream, "]", 1);
+
+	// the cursor failed in the middle of the stream
+	if (mongoc_cursor_error (cursor, NULL)) {
+		stream->error = true;
+	}
+
+}
+
+// starts a stream with every document in the cursor as {"key": [ ... ]
+// the first document is requested before sending any headers,
+// so nothing is written if the query fails
+// the json object is left open for the caller to end it
+PocketStreamResult pocket_stream_cursor (
+	PocketStream *stream, const HttpReceive *http_receive,
+	mongoc_cursor_t *cursor, const char *key,
+	const PocketOutputShape *shape,
+	pocket_stream_doc_cb doc_cb, void *doc_cb_args
+) {
+
+	PocketStreamResult result = POCKET_STREAM_RESULT_NONE;
+
+	const bson_t *doc = NULL;
+	bool next = db_cursor_next (cursor, &doc);
+	if (next || !mongoc_cursor_error (cursor, NULL)) {
+		if (!pocket_stream_start (stream, http_receive)) {
+			pocket_stream_write (stream, "{", 1);
+
+			pocket_stream_cursor_write (
+				stream, cursor, key, shape,
+				doc, next,
+				doc_cb, doc_cb_args
+			);
+		}
+
+		result = stream->error ?
+			POCKET_STREAM_RESULT_BROKEN : POCKET_STREAM_RESULT_OK;
+	}
+
+	return result;
+
+}
+
+// adds , "key": [ ... ] with every document in the cursor
+// to a stream that was started with pocket_stream_cursor ()
+void pocket_stream_cursor_append (
+	PocketStream *stream,
+	mongoc_cursor_t *cursor, const char *key,
+	const PocketOutputShape *shape
+) {
+
+	if (!stream->error) {
+		const bson_t *doc = NULL;
+		bool next = db_cursor_next (cursor, &doc);
+
+		pocket_stream_write (stream, ", ", 2);
+
+		pocket_stream_cursor_write (
+			stream, cursor, key, shape,
+			doc, next,
+			NULL, NULL
+		);
+	}
+
+}
+
+// streams every document in the cursor as {"key": [ ... ]}
+// and ends the stream
+// if a cache is set, the body is stored using the cache key & ticket
+PocketStreamResult pocket_stream_cursor_send (
+	const HttpReceive *http_receive, const char *etag,
+	mongoc_cursor_t *cursor, const char *key,
+	const PocketOutputShape *shape,
+	PocketCache *cache, const bson_oid_t *cache_key, const u64 ticket
+) {
+
+	PocketStream stream = { 0 };
+	stream.etag = etag;
+	if (cache) pocket_stream_capture (&stream, POCKET_CACHE_ENTRY_MAX_SIZE);
+
+	PocketStreamResult result = pocket_stream_cursor (
+		&stream, http_receive,
+		cursor, key, shape,
+		NULL, NULL
+	);
+
+	if (result != POCKET_STREAM_RESULT_NONE) {
+		pocket_stream_write (&stream, "}", 1);
+		result = pocket_stream_end (&stream);
+	}
+
+	if (cache) {
+		pocket_stream_capture_store (
+			&stream, result, cache, cache_key, ticket
+		);
+	}
+
+	return result;
+
+}
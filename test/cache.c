@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <unistd.h>
+
+#include <bson/bson.h>
+
+#include "cache.h"
+
+#include "test.h"
+
+#define CACHE_TEST_SIZE			(POCKET_CACHE_SHARDS * 256)
+
+static const char *body = { "{\"transactions\": [], \"next\": null}" };
+
+static const char *tag = { "\"1-a\"" };
+
+static PocketCache *cache_test_create (const unsigned int ttl) {
+
+	PocketCache *cache = pocket_cache_create (CACHE_TEST_SIZE, ttl);
+	test_check_ptr_ne (cache, NULL);
+
+	return cache;
+
+}
+
+// returns true if the key is in the cache with the test's body
+static bool cache_test_get (
+	PocketCache *cache, const bson_oid_t *key, u64 *ticket
+) {
+
+	char *data = NULL;
+	size_t data_len = 0;
+
+	bool found = pocket_cache_get (cache, key, tag, &data, &data_len, ticket);
+	if (found) {
+		test_check (data_len == strlen (body), NULL);
+		test_check (!memcmp (data, body, data_len), NULL);
+		free (data);
+	}
+
+	return found;
+
+}
+
+static void cache_test_set_get (void) {
+
+	PocketCache *cache = cache_test_create (0);
+
+	bson_oid_t key = { 0 };
+	bson_oid_init (&key, NULL);
+
+	u64 ticket = 0;
+	test_check (!cache_test_get (cache, &key, &ticket), NULL);
+
+	pocket_cache_set (cache, &key, ticket, tag, body, strlen (body));
+	test_check (cache_test_get (cache, &key, &ticket), NULL);
+
+	PocketCacheStats stats = { 0 };
+	pocket_cache_get_stats (cache, &stats);
+	test_check_unsigned_eq (stats.entries, 1, NULL);
+	test_check_unsigned_eq (stats.hits, 1, NULL);
+	test_check_unsigned_eq (stats.misses, 1, NULL);
+
+	pocket_cache_delete (cache);
+
+}
+
+// an invalidation removes the entry & discards
+// the values that were read with an older ticket
+static void cache_test_invalidate (void) {
+
+	PocketCache *cache = cache_test_create (0);
+
+	bson_oid_t key = { 0 };
+	bson_oid_init (&key, NULL);
+
+	u64 ticket = 0;
+	test_check (!cache_test_get (cache, &key, &ticket), NULL);
+
+	pocket_cache_invalidate (cache, &key);
+
+	pocket_cache_set (cache, &key, ticket, tag, body, strlen (body));
+	test_check (!cache_test_get (cache, &key, &ticket), NULL);
+
+	pocket_cache_set (cache, &key, ticket, tag, body, strlen (body));
+	test_check (cache_test_get (cache, &key, &ticket), NULL);
+
+	pocket_cache_invalidate (cache, &key);
+	test_check (!cache_test_get (cache, &key, &ticket), NULL);
+
+	pocket_cache_delete (cache);
+
+}
+
+// an entry made from other values is never returned
+static void cache_test_tag (void) {
+
+	PocketCache *cache = cache_test_create (0);
+
+	bson_oid_t key = { 0 };
+	bson_oid_init (&key, NULL);
+
+	u64 ticket = 0;
+	(void) cache_test_get (cache, &key, &ticket);
+	pocket_cache_set (cache, &key, ticket, tag, body, strlen (body));
+
+	char *data = NULL;
+	size_t data_len = 0;
+	test_check (!pocket_cache_get (cache, &key, "\"2-a\"", &data, &data_len, &ticket), NULL);
+	test_check (!cache_test_get (cache, &key, &ticket), NULL);
+
+	pocket_cache_set (cache, &key, ticket, NULL, body, strlen (body));
+	test_check (!cache_test_get (cache, &key, &ticket), NULL);
+
+	pocket_cache_delete (cache);
+
+}
+
+static void cache_test_ttl (void) {
+
+	PocketCache *cache = cache_test_create (1);
+
+	bson_oid_t key = { 0 };
+	bson_oid_init (&key, NULL);
+
+	u64 ticket = 0;
+	(void) cache_test_get (cache, &key, &ticket);
+	pocket_cache_set (cache, &key, ticket, tag, body, strlen (body));
+	test_check (cache_test_get (cache, &key, &ticket), NULL);
+
+	(void) sleep (2);
+
+	test_check (!cache_test_get (cache, &key, &ticket), NULL);
+
+	PocketCacheStats stats = { 0 };
+	pocket_cache_get_stats (cache, &stats);
+	test_check_unsigned_eq (stats.entries, 0, NULL);
+	test_check_unsigned_eq (stats.size, 0, NULL);
+	test_check_unsigned_eq (stats.expired, 1, NULL);
+
+	pocket_cache_delete (cache);
+
+}
+
+// the shard keeps its size by evicting
+// its least recently used entries
+static void cache_test_evict (void) {
+
+	PocketCache *cache = cache_test_create (0);
+
+	bson_oid_t keys[64] = { 0 };
+	u64 ticket = 0;
+	for (unsigned int idx = 0; idx < 64; idx++) {
+		bson_oid_init (&keys[idx], NULL);
+		(void) cache_test_get (cache, &keys[idx], &ticket);
+		pocket_cache_set (cache, &keys[idx], ticket, tag, body, strlen (body));
+	}
+
+	PocketCacheStats stats = { 0 };
+	pocket_cache_get_stats (cache, &stats);
+	test_check (stats.size <= CACHE_TEST_SIZE, NULL);
+	test_check_unsigned_eq (stats.entries + stats.evictions, 64, NULL);
+	test_check_unsigned_gt (stats.evictions, 0);
+
+	// too big to be stored
+	char *big = (char *) calloc (1, POCKET_CACHE_ENTRY_MAX_SIZE + 1);
+	test_check_ptr_ne (big, NULL);
+
+	(void) cache_test_get (cache, &keys[0], &ticket);
+	pocket_cache_set (cache, &keys[0], ticket, tag, big, POCKET_CACHE_ENTRY_MAX_SIZE + 1);
+
+	free (big);
+
+	PocketCacheStats after = { 0 };
+	pocket_cache_get_stats (cache, &after);
+	test_check (after.size <= stats.size, NULL);
+
+	pocket_cache_delete (cache);
+
+}
+
+int main (int argc, char **argv) {
+
+	(void) argc;
+	(void) argv;
+
+	(void) printf ("Testing cache...\n");
+
+	cache_test_set_get ();
+
+	cache_test_invalidate ();
+
+	cache_test_tag ();
+
+	cache_test_ttl ();
+
+	cache_test_evict ();
+
+	(void) printf ("Done!\n");
+
+	return 0;
+
+}
@@ -420,4 +420,66 @@ unsigned int curl_upload_file_with_extra_value (
 
 	return retval;
 
-}
\ No newline at end of file
+}
+
+// performs a request with a json body & a custom Authorization header,
+// the response's body is handled by the write cb
+// & its status code is set in status
+// returns 0 on success, 1 on error
+unsigned int curl_json_with_auth (
+	CURL *curl, const char *address, const char *method,
+	const char *json, const size_t json_len,
+	const char *authorization,
+	curl_write_data_cb write_cb, void *storage,
+	long *status
+) {
+
+	unsigned int retval = 1;
+
+	struct curl_slist *headers = NULL;
+	char auth_header[AUTH_HEADER_SIZE] = { 0 };
+	(void) snprintf (
+		auth_header, AUTH_HEADER_SIZE - 1,
+		"Authorization: %s", authorization
+	);
+
+	headers = curl_slist_append (headers, auth_header);
+	headers = curl_slist_append (headers, "Content-Type: application/json");
+
+	curl_easy_setopt (curl, CURLOPT_URL, address);
+	curl_easy_setopt (curl, CURLOPT_CUSTOMREQUEST, method);
+	curl_easy_setopt (curl, CURLOPT_HTTPHEADER, headers);
+
+	if (json) {
+		curl_easy_setopt (curl, CURLOPT_POSTFIELDS, json);
+		curl_easy_setopt (curl, CURLOPT_POSTFIELDSIZE, (long) json_len);
+	}
+
+	else {
+		curl_easy_setopt (curl, CURLOPT_HTTPGET, 1L);
+	}
+
+	curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, write_cb);
+	curl_easy_setopt (curl, CURLOPT_WRITEDATA, storage);
+
+	// perfrom the request
+	CURLcode res = curl_easy_perform (curl);
+	if (res == CURLE_OK) {
+		(void) curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, status);
+		retval = 0;
+	}
+
+	else {
+		cerver_log_error (
+			"curl_json_with_auth () failed: %s\n",
+			curl_easy_strerror (res)
+		);
+	}
+
+	curl_easy_setopt (curl, CURLOPT_POSTFIELDS, NULL);
+	curl_easy_setopt (curl, CURLOPT_HTTPHEADER, NULL);
+	curl_slist_free_all (headers);
+
+	return retval;
+
+}
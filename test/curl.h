@@ -93,4 +93,16 @@ extern unsigned int curl_upload_file_with_extra_value (
 	const char *key, const char *value
 );
 
+// performs a request with a json body & a custom Authorization header,
+// the response's body is handled by the write cb
+// & its status code is set in status
+// returns 0 on success, 1 on error
+extern unsigned int curl_json_with_auth (
+	CURL *curl, const char *address, const char *method,
+	const char *json, const size_t json_len,
+	const char *authorization,
+	curl_write_data_cb write_cb, void *storage,
+	long *status
+);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <unistd.h>
+
+#include <bson/bson.h>
+
+#include "etag.h"
+
+#include "test.h"
+
+static const char *variant = { "limit=10" };
+
+// returns true if both etags are the same
+static bool etag_test_equal (
+	const PocketEtagKind kind, const bson_oid_t *user_oid,
+	const char *variant_value, const char *etag
+) {
+
+	char current[POCKET_ETAG_SIZE] = { 0 };
+	const char *result = pocket_etag_get (
+		kind, user_oid, variant_value, strlen (variant_value), current
+	);
+
+	test_check_ptr_ne (result, NULL);
+
+	return !strcmp (current, etag);
+
+}
+
+static void etag_test_changed (void) {
+
+	unsigned int errors = pocket_etag_init (0);
+	test_check_unsigned_eq (errors, 0, NULL);
+
+	bson_oid_t user_oid = { 0 };
+	bson_oid_init (&user_oid, NULL);
+
+	char trans[POCKET_ETAG_SIZE] = { 0 };
+	char places[POCKET_ETAG_SIZE] = { 0 };
+	(void) pocket_etag_get (POCKET_ETAG_KIND_TRANSACTIONS, &user_oid, variant, strlen (variant), trans);
+	(void) pocket_etag_get (POCKET_ETAG_KIND_PLACES, &user_oid, variant, strlen (variant), places);
+
+	// the same values keep their etag
+	test_check (etag_test_equal (POCKET_ETAG_KIND_TRANSACTIONS, &user_oid, variant, trans), NULL);
+
+	// other variants, kinds & users get their own etags
+	test_check (!etag_test_equal (POCKET_ETAG_KIND_TRANSACTIONS, &user_oid, "limit=20", trans), NULL);
+	test_check (strcmp (trans, places), NULL);
+
+	bson_oid_t other_oid = { 0 };
+	bson_oid_init (&other_oid, NULL);
+	test_check (!etag_test_equal (POCKET_ETAG_KIND_TRANSACTIONS, &other_oid, variant, trans), NULL);
+
+	// a write only changes the etags of its kind
+	pocket_etag_changed (POCKET_ETAG_KIND_TRANSACTIONS, &user_oid);
+	test_check (!etag_test_equal (POCKET_ETAG_KIND_TRANSACTIONS, &user_oid, variant, trans), NULL);
+	test_check (etag_test_equal (POCKET_ETAG_KIND_PLACES, &user_oid, variant, places), NULL);
+
+	pocket_etag_end ();
+
+	// a restart never gives the old etags
+	errors = pocket_etag_init (0);
+	test_check_unsigned_eq (errors, 0, NULL);
+
+	test_check (!etag_test_equal (POCKET_ETAG_KIND_PLACES, &user_oid, variant, places), NULL);
+
+	pocket_etag_end ();
+
+}
+
+// the versions are replaced after the ttl,
+// so writes made by other instances are seen
+static void etag_test_expired (void) {
+
+	unsigned int errors = pocket_etag_init (1);
+	test_check_unsigned_eq (errors, 0, NULL);
+
+	bson_oid_t user_oid = { 0 };
+	bson_oid_init (&user_oid, NULL);
+
+	char etag[POCKET_ETAG_SIZE] = { 0 };
+	(void) pocket_etag_get (POCKET_ETAG_KIND_CATEGORIES, &user_oid, NULL, 0, etag);
+	test_check (etag_test_equal (POCKET_ETAG_KIND_CATEGORIES, &user_oid, "", etag), NULL);
+
+	(void) sleep (2);
+
+	test_check (!etag_test_equal (POCKET_ETAG_KIND_CATEGORIES, &user_oid, "", etag), NULL);
+
+	pocket_etag_end ();
+
+}
+
+int main (int argc, char **argv) {
+
+	(void) argc;
+	(void) argv;
+
+	(void) printf ("Testing etag...\n");
+
+	etag_test_changed ();
+
+	etag_test_expired ();
+
+	(void) printf ("Done!\n");
+
+	return 0;
+
+}
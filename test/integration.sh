@@ -32,6 +32,15 @@ sleep 2
 
 sudo docker inspect pocket --format='{{.State.ExitCode}}' || { exit 1; }
 
+# cache
+./test/bin/cache || { exit 1; }
+
+# etag
+./test/bin/etag || { exit 1; }
+
+# password
+./test/bin/password || { exit 1; }
+
 # users
 ./test/bin/users || { exit 1; }
 
@@ -43,3 +52,6 @@ sudo docker inspect pocket --format='{{.State.ExitCode}}' || { exit 1; }
 
 # transactions
 ./test/bin/transactions || { exit 1; }
+
+# sync
+./test/bin/sync || { exit 1; }
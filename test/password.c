@@ -0,0 +1,285 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+
+#include "password.h"
+
+#include "test.h"
+
+// the cheapest cost, so each hash is fast
+#define PASSWORD_TEST_COST			POCKET_PASSWORD_MIN_COST
+
+// slow enough to keep the worker busy while the others submit
+#define PASSWORD_TEST_SLOW_COST		16
+
+#define PASSWORD_TEST_THREADS		8
+
+// the CERVER_TH_THREADS used by the integration tests
+#define PASSWORD_TEST_CERVER_THREADS	4
+
+// rounds of concurrent requests until one is rejected
+#define PASSWORD_TEST_ROUNDS			8
+
+static const char *password = { "super-secret-password" };
+
+static pthread_barrier_t password_barrier;
+
+static void password_test_round_trip (void) {
+
+	char hashed[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+	unsigned int errors = pocket_password_hash_sync (
+		password, PASSWORD_TEST_COST, hashed
+	);
+
+	test_check_unsigned_eq (errors, 0, NULL);
+	test_check (!strncmp (hashed, POCKET_PASSWORD_PREFIX, strlen (POCKET_PASSWORD_PREFIX)), NULL);
+	test_check (strcmp (hashed, password), NULL);
+
+	// a new salt is used every time
+	char other[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+	errors = pocket_password_hash_sync (password, PASSWORD_TEST_COST, other);
+	test_check_unsigned_eq (errors, 0, NULL);
+	test_check (strcmp (hashed, other), NULL);
+
+	bool upgrade = true;
+	PocketPasswordResult result = pocket_password_verify_sync (
+		password, hashed, PASSWORD_TEST_COST, &upgrade
+	);
+
+	test_check_int_eq (result, POCKET_PASSWORD_RESULT_OK, NULL);
+	test_check_false (upgrade);
+
+	result = pocket_password_verify_sync (
+		"wrong-password", hashed, PASSWORD_TEST_COST, &upgrade
+	);
+
+	test_check_int_eq (result, POCKET_PASSWORD_RESULT_WRONG, NULL);
+	test_check_false (upgrade);
+
+	// a hash with an outdated cost is still valid but must be replaced
+	result = pocket_password_verify_sync (
+		password, hashed, PASSWORD_TEST_COST + 1, &upgrade
+	);
+
+	test_check_int_eq (result, POCKET_PASSWORD_RESULT_OK, NULL);
+	test_check_true (upgrade);
+
+	// a broken hash is never accepted
+	hashed[strlen (hashed) - 1] = '\0';
+	result = pocket_password_verify_sync (
+		password, hashed, PASSWORD_TEST_COST, &upgrade
+	);
+
+	test_check_int_ne (result, POCKET_PASSWORD_RESULT_OK);
+
+}
+
+// plain text values are accepted once & replaced with a new hash
+static void password_test_legacy (void) {
+
+	bool upgrade = false;
+	PocketPasswordResult result = pocket_password_verify_sync (
+		password, password, PASSWORD_TEST_COST, &upgrade
+	);
+
+	test_check_int_eq (result, POCKET_PASSWORD_RESULT_OK, NULL);
+	test_check_true (upgrade);
+
+	result = pocket_password_verify_sync (
+		"wrong-password", password, PASSWORD_TEST_COST, &upgrade
+	);
+
+	test_check_int_eq (result, POCKET_PASSWORD_RESULT_WRONG, NULL);
+	test_check_false (upgrade);
+
+	unsigned int errors = pocket_password_init (1, 1, PASSWORD_TEST_COST);
+	test_check_unsigned_eq (errors, 0, NULL);
+
+	char rehashed[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+	result = pocket_password_verify (password, password, &upgrade, rehashed);
+
+	test_check_int_eq (result, POCKET_PASSWORD_RESULT_OK, NULL);
+	test_check_true (upgrade);
+	test_check (!strncmp (rehashed, POCKET_PASSWORD_PREFIX, strlen (POCKET_PASSWORD_PREFIX)), NULL);
+
+	// the new hash needs no other upgrade
+	char other[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+	result = pocket_password_verify (password, rehashed, &upgrade, other);
+
+	test_check_int_eq (result, POCKET_PASSWORD_RESULT_OK, NULL);
+	test_check_false (upgrade);
+
+	pocket_password_end ();
+
+}
+
+static void *password_test_busy_worker (void *result_ptr) {
+
+	PocketPasswordResult *result = (PocketPasswordResult *) result_ptr;
+
+	char hashed[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+
+	(void) pthread_barrier_wait (&password_barrier);
+
+	*result = pocket_password_hash (password, hashed);
+
+	return NULL;
+
+}
+
+// with a single worker & a queue of one, requests that arrive
+// while the worker is busy & the queue is full are rejected
+static void password_test_busy (void) {
+
+	unsigned int errors = pocket_password_init (1, 1, PASSWORD_TEST_SLOW_COST);
+	test_check_unsigned_eq (errors, 0, NULL);
+
+	pthread_t threads[PASSWORD_TEST_THREADS] = { 0 };
+	PocketPasswordResult results[PASSWORD_TEST_THREADS] = { 0 };
+
+	(void) pthread_barrier_init (&password_barrier, NULL, PASSWORD_TEST_THREADS);
+	for (unsigned int idx = 0; idx < PASSWORD_TEST_THREADS; idx++) {
+		if (pthread_create (&threads[idx], NULL, password_test_busy_worker, &results[idx])) {
+			fail ("Failed to create password test thread!");
+		}
+	}
+
+	unsigned int ok = 0;
+	unsigned int busy = 0;
+	for (unsigned int idx = 0; idx < PASSWORD_TEST_THREADS; idx++) {
+		(void) pthread_join (threads[idx], NULL);
+
+		if (results[idx] == POCKET_PASSWORD_RESULT_OK) ok += 1;
+		else if (results[idx] == POCKET_PASSWORD_RESULT_BUSY) busy += 1;
+	}
+
+	(void) pthread_barrier_destroy (&password_barrier);
+
+	test_check_unsigned_eq (ok + busy, PASSWORD_TEST_THREADS, NULL);
+	test_check_unsigned_gt (ok, 0);
+	test_check_unsigned_gt (busy, 0);
+
+	PocketPasswordStats stats = { 0 };
+	pocket_password_get_stats (&stats);
+
+	const unsigned int rejected = (unsigned int) stats.rejected;
+	test_check_unsigned_eq (rejected, busy, NULL);
+	test_check_unsigned_eq (stats.pending, 0, NULL);
+
+	pocket_password_end ();
+
+}
+
+static void password_test_queue_default (void) {
+
+	unsigned int queue_max = pocket_password_queue_default (0);
+	test_check_unsigned_eq (queue_max, 1, NULL);
+
+	queue_max = pocket_password_queue_default (1);
+	test_check_unsigned_eq (queue_max, 1, NULL);
+
+	queue_max = pocket_password_queue_default (PASSWORD_TEST_CERVER_THREADS);
+	test_check_unsigned_eq (queue_max, PASSWORD_TEST_CERVER_THREADS - 1, NULL);
+
+}
+
+static void *password_test_default_worker (void *result_ptr) {
+
+	PocketPasswordResult *results = (PocketPasswordResult *) result_ptr;
+
+	char hashed[POCKET_PASSWORD_HASH_SIZE] = { 0 };
+
+	for (unsigned int round = 0; round < PASSWORD_TEST_ROUNDS; round++) {
+		(void) pthread_barrier_wait (&password_barrier);
+
+		results[round] = pocket_password_hash (password, hashed);
+	}
+
+	return NULL;
+
+}
+
+// with the default values, every cerver thread can be waiting
+// for a password at the same time, the one over the queue is rejected
+// instead of blocking, so a 429 is answered while the others hash
+static void password_test_default (void) {
+
+	const unsigned int queue_max = pocket_password_queue_default (
+		PASSWORD_TEST_CERVER_THREADS
+	);
+
+	unsigned int errors = pocket_password_init (
+		POCKET_PASSWORD_DEFAULT_WORKERS, queue_max, POCKET_PASSWORD_DEFAULT_COST
+	);
+
+	test_check_unsigned_eq (errors, 0, NULL);
+
+	pthread_t threads[PASSWORD_TEST_CERVER_THREADS] = { 0 };
+	PocketPasswordResult results[PASSWORD_TEST_CERVER_THREADS][PASSWORD_TEST_ROUNDS] = { 0 };
+
+	(void) pthread_barrier_init (&password_barrier, NULL, PASSWORD_TEST_CERVER_THREADS);
+	for (unsigned int idx = 0; idx < PASSWORD_TEST_CERVER_THREADS; idx++) {
+		if (pthread_create (&threads[idx], NULL, password_test_default_worker, results[idx])) {
+			fail ("Failed to create password test thread!");
+		}
+	}
+
+	for (unsigned int idx = 0; idx < PASSWORD_TEST_CERVER_THREADS; idx++) {
+		(void) pthread_join (threads[idx], NULL);
+	}
+
+	(void) pthread_barrier_destroy (&password_barrier);
+
+	unsigned int ok = 0;
+	unsigned int busy = 0;
+	for (unsigned int round = 0; round < PASSWORD_TEST_ROUNDS; round++) {
+		unsigned int round_ok = 0;
+		for (unsigned int idx = 0; idx < PASSWORD_TEST_CERVER_THREADS; idx++) {
+			if (results[idx][round] == POCKET_PASSWORD_RESULT_OK) round_ok += 1;
+			else if (results[idx][round] == POCKET_PASSWORD_RESULT_BUSY) busy += 1;
+		}
+
+		// there is always room for the queue's requests
+		test_check_unsigned_gt (round_ok, 0);
+
+		ok += round_ok;
+	}
+
+	test_check_unsigned_eq (ok + busy, PASSWORD_TEST_CERVER_THREADS * PASSWORD_TEST_ROUNDS, NULL);
+	test_check_unsigned_gt (busy, 0);
+
+	PocketPasswordStats stats = { 0 };
+	pocket_password_get_stats (&stats);
+
+	test_check_unsigned_eq (stats.queue_max, queue_max, NULL);
+	test_check_unsigned_eq (stats.pending, 0, NULL);
+
+	pocket_password_end ();
+
+}
+
+int main (int argc, char **argv) {
+
+	(void) argc;
+	(void) argv;
+
+	(void) printf ("Testing password...\n");
+
+	password_test_round_trip ();
+
+	password_test_legacy ();
+
+	password_test_busy ();
+
+	password_test_queue_default ();
+
+	password_test_default ();
+
+	(void) printf ("Done!\n");
+
+	return 0;
+
+}
@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include <cerver/http/json/json.h>
+
+#include "curl.h"
+#include "pocket.h"
+#include "test.h"
+
+#define ADDRESS_SIZE		128
+#define TITLE_SIZE			64
+
+#define TOMBSTONE_TYPE_TRANSACTION		1
+
+static const char *address = { "127.0.0.1:5000/api/pocket" };
+
+static const char *category = { "5fc5494d954f1728c65018f4" };
+
+typedef struct SyncResponse {
+
+	char *data;
+	size_t len;
+
+} SyncResponse;
+
+// keeps the whole response body, as a sync
+// does not fit in a fixed buffer
+static size_t sync_response_handler (
+	void *contents, size_t size, size_t nmemb, void *storage
+) {
+
+	SyncResponse *response = (SyncResponse *) storage;
+
+	char *data = (char *) realloc (response->data, response->len + (size * nmemb) + 1);
+	if (data) {
+		(void) memcpy (data + response->len, contents, size * nmemb);
+		response->len += size * nmemb;
+		data[response->len] = '\0';
+
+		response->data = data;
+	}
+
+	return data ? size * nmemb : 0;
+
+}
+
+static unsigned int sync_request_json (
+	CURL *curl, const char *actual_address, const char *method,
+	const char *json, SyncResponse *response
+) {
+
+	long status = 0;
+
+	free (response->data);
+	response->data = NULL;
+	response->len = 0;
+
+	unsigned int result = curl_json_with_auth (
+		curl, actual_address, method,
+		json, json ? strlen (json) : 0,
+		token,
+		sync_response_handler, response,
+		&status
+	);
+
+	test_check_unsigned_eq (result, 0, NULL);
+
+	return (unsigned int) status;
+
+}
+
+// GET api/pocket/sync?since=
+// returns the sync's json that must be released by the caller
+static json_t *sync_request (
+	CURL *curl, const long long since, SyncResponse *response
+) {
+
+	char actual_address[ADDRESS_SIZE] = { 0 };
+	if (since) {
+		(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s/sync?since=%lld", address, since);
+	}
+
+	else {
+		(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s/sync", address);
+	}
+
+	unsigned int status = sync_request_json (curl, actual_address, "GET", NULL, response);
+	test_check_unsigned_eq (status, 200, "GET api/pocket/sync failed!");
+
+	json_error_t json_error = { 0 };
+	json_t *json = json_loads (response->data ? response->data : "", 0, &json_error);
+	test_check_ptr_ne (json, NULL);
+
+	test_check (json_is_array (json_object_get (json, "transactions")), NULL);
+	test_check (json_is_array (json_object_get (json, "categories")), NULL);
+	test_check (json_is_array (json_object_get (json, "places")), NULL);
+	test_check (json_is_array (json_object_get (json, "deleted")), NULL);
+	test_check (json_is_integer (json_object_get (json, "next")), NULL);
+
+	return json;
+
+}
+
+static long long sync_next (const json_t *json) {
+
+	return (long long) json_integer_value (json_object_get (json, "next"));
+
+}
+
+static bool sync_full (const json_t *json) {
+
+	return json_is_true (json_object_get (json, "full"));
+
+}
+
+// returns the sync's transaction with the title or NULL
+static json_t *sync_transaction_by_title (
+	const json_t *json, const char *title
+) {
+
+	json_t *found = NULL;
+
+	size_t idx = 0;
+	json_t *trans = NULL;
+	json_array_foreach (json_object_get (json, "transactions"), idx, trans) {
+		const char *trans_title = json_string_value (json_object_get (trans, "title"));
+		if (trans_title && !strcmp (trans_title, title)) {
+			found = trans;
+			break;
+		}
+	}
+
+	return found;
+
+}
+
+// returns true if the sync has the transaction's tombstone
+static bool sync_deleted_has (const json_t *json, const char *id) {
+
+	bool found = false;
+
+	size_t idx = 0;
+	json_t *deleted = NULL;
+	json_array_foreach (json_object_get (json, "deleted"), idx, deleted) {
+		const char *ref = json_string_value (json_object_get (deleted, "ref"));
+		if (
+			ref && !strcmp (ref, id)
+			&& (json_integer_value (json_object_get (deleted, "type")) == TOMBSTONE_TYPE_TRANSACTION)
+		) {
+			found = true;
+			break;
+		}
+	}
+
+	return found;
+
+}
+
+static void sync_request_perform (void) {
+
+	char actual_address[ADDRESS_SIZE] = { 0 };
+	char body[ADDRESS_SIZE * 2] = { 0 };
+
+	char title[TITLE_SIZE] = { 0 };
+	char updated_title[TITLE_SIZE] = { 0 };
+	(void) snprintf (title, TITLE_SIZE - 1, "Sync test %ld", (long) time (NULL));
+	(void) snprintf (updated_title, TITLE_SIZE - 1, "%s updated", title);
+
+	SyncResponse response = { 0 };
+
+	CURL *curl = curl_easy_init ();
+
+	// a request without since is a full sync
+	json_t *json = sync_request (curl, 0, &response);
+	test_check (sync_full (json), NULL);
+	test_check (json_array_size (json_object_get (json, "deleted")) == 0, NULL);
+
+	long long next = sync_next (json);
+	json_decref (json);
+
+	// a since older than the tombstones is also a full sync
+	json = sync_request (curl, 1, &response);
+	test_check (sync_full (json), NULL);
+	json_decref (json);
+
+	// POST api/pocket/transactions
+	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s/transactions", address);
+	(void) snprintf (
+		body, sizeof (body) - 1,
+		"{\"title\": \"%s\", \"amount\": 10, \"category\": \"%s\"}",
+		title, category
+	);
+
+	unsigned int status = sync_request_json (curl, actual_address, "POST", body, &response);
+	test_check_unsigned_eq (status, 200, "Failed to create transaction!");
+
+	// the delta has the new transaction
+	json = sync_request (curl, next, &response);
+	test_check (!sync_full (json), NULL);
+
+	json_t *trans = sync_transaction_by_title (json, title);
+	test_check_ptr_ne (trans, NULL);
+
+	char id[ADDRESS_SIZE] = { 0 };
+	const char *trans_id = json_string_value (json_object_get (trans, "_id"));
+	test_check_ptr_ne (trans_id, NULL);
+	(void) strncpy (id, trans_id, ADDRESS_SIZE - 1);
+
+	next = sync_next (json);
+	json_decref (json);
+
+	// PUT api/pocket/transactions/:id/update
+	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s/transactions/%s/update", address, id);
+	(void) snprintf (body, sizeof (body) - 1, "{\"title\": \"%s\"}", updated_title);
+
+	status = sync_request_json (curl, actual_address, "PUT", body, &response);
+	test_check_unsigned_eq (status, 200, "Failed to update transaction!");
+
+	// the delta has the updated values
+	json = sync_request (curl, next, &response);
+	test_check (!sync_full (json), NULL);
+	test_check_ptr_ne (sync_transaction_by_title (json, updated_title), NULL);
+	test_check_ptr_eq (sync_transaction_by_title (json, title), NULL);
+	test_check (!sync_deleted_has (json, id), NULL);
+	json_decref (json);
+
+	// DELETE api/pocket/transactions/:id/remove
+	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s/transactions/%s/remove", address, id);
+
+	status = sync_request_json (curl, actual_address, "DELETE", NULL, &response);
+	test_check_unsigned_eq (status, 200, "Failed to delete transaction!");
+
+	// the delta has its tombstone & not the transaction
+	json = sync_request (curl, next, &response);
+	test_check (!sync_full (json), NULL);
+	test_check_ptr_eq (sync_transaction_by_title (json, updated_title), NULL);
+	test_check (sync_deleted_has (json, id), NULL);
+	json_decref (json);
+
+	free (response.data);
+
+	curl_easy_cleanup (curl);
+
+}
+
+int main (int argc, char **argv) {
+
+	(void) argc;
+	(void) argv;
+
+	(void) printf ("Requesting sync...\n");
+
+	sync_request_perform ();
+
+	(void) printf ("Done!\n");
+
+	return 0;
+
+}
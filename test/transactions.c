@@ -3,12 +3,43 @@
 #include <string.h>
 #include <stdbool.h>
 
+#include <unistd.h>
+
+#include <cerver/http/json/json.h>
+
 #include "curl.h"
 #include "pocket.h"
 #include "test.h"
 
 #define ADDRESS_SIZE		128
 
+#define BULK_MAX			500
+
+// a bulk takes up to the whole write burst, so a limited one
+// is retried until the user's bucket has been refilled
+#define BULK_RETRIES		10
+#define BULK_RETRY_WAIT		5
+
+#define BULK_ITEM			"{\"title\": \"Bulk\", \"amount\": 1.5, \"category\": \"5fc5494d954f1728c65018f4\"}"
+
+// items 1, 2 & 4 are rejected by their values
+static const char *bulk_mixed = {
+	"["
+	BULK_ITEM ", "
+	"{\"amount\": 10, \"category\": \"5fc5494d954f1728c65018f4\"}, "
+	"{\"title\": \"Bad category\", \"amount\": 10, \"category\": \"abc\"}, "
+	BULK_ITEM ", "
+	"5"
+	"]"
+};
+
+typedef struct TransResponse {
+
+	char *data;
+	size_t len;
+
+} TransResponse;
+
 static const char *address = { "127.0.0.1:5000/api/pocket/transactions" };
 
 static size_t transactions_request_data_handler (
@@ -21,6 +52,184 @@ static size_t transactions_request_data_handler (
 
 }
 
+// keeps the whole response body, as a full list
+// does not fit in a fixed buffer
+static size_t transactions_response_handler (
+	void *contents, size_t size, size_t nmemb, void *storage
+) {
+
+	TransResponse *response = (TransResponse *) storage;
+
+	char *data = (char *) realloc (response->data, response->len + (size * nmemb) + 1);
+	if (data) {
+		(void) memcpy (data + response->len, contents, size * nmemb);
+		response->len += size * nmemb;
+		data[response->len] = '\0';
+
+		response->data = data;
+	}
+
+	return data ? size * nmemb : 0;
+
+}
+
+static unsigned int transactions_request_json (
+	CURL *curl, const char *actual_address, const char *method,
+	const char *json, TransResponse *response
+) {
+
+	long status = 0;
+
+	free (response->data);
+	response->data = NULL;
+	response->len = 0;
+
+	unsigned int result = curl_json_with_auth (
+		curl, actual_address, method,
+		json, json ? strlen (json) : 0,
+		token,
+		transactions_response_handler, response,
+		&status
+	);
+
+	test_check_unsigned_eq (result, 0, NULL);
+
+	return (unsigned int) status;
+
+}
+
+static json_t *transactions_response_json (const TransResponse *response) {
+
+	json_error_t json_error = { 0 };
+	json_t *json = json_loads (response->data ? response->data : "", 0, &json_error);
+	test_check_ptr_ne (json, NULL);
+
+	return json;
+
+}
+
+// returns the number of transactions in the user's whole list
+static unsigned int transactions_request_count (
+	CURL *curl, TransResponse *response
+) {
+
+	unsigned int status = transactions_request_json (curl, address, "GET", NULL, response);
+	test_check_unsigned_eq (status, 200, "GET api/pocket/transactions failed!");
+
+	json_t *json = transactions_response_json (response);
+	json_t *list = json_object_get (json, "transactions");
+	test_check (json_is_array (list), NULL);
+	test_check (json_is_null (json_object_get (json, "next")), NULL);
+
+	unsigned int count = (unsigned int) json_array_size (list);
+
+	json_decref (json);
+
+	return count;
+
+}
+
+// returns a json array with n valid transactions
+static char *transactions_bulk_create (const size_t n) {
+
+	const size_t item_len = strlen (BULK_ITEM) + 2;
+	char *json = (char *) calloc (1, (n * item_len) + 3);
+	if (json) {
+		char *end = json;
+		*end++ = '[';
+		for (size_t idx = 0; idx < n; idx++) {
+			end += sprintf (end, "%s%s", idx ? ", " : "", BULK_ITEM);
+		}
+
+		*end++ = ']';
+	}
+
+	return json;
+
+}
+
+// POST api/pocket/transactions/bulk
+// with valid & invalid items, the whole limit & over the limit
+static void transactions_request_bulk (CURL *curl) {
+
+	char actual_address[ADDRESS_SIZE] = { 0 };
+	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s/bulk", address);
+
+	TransResponse response = { 0 };
+
+	// transCount is not sent by any route,
+	// so it is checked against the user's list
+	unsigned int count = transactions_request_count (curl, &response);
+
+	// mixed valid & invalid items
+	unsigned int status = transactions_request_json (curl, actual_address, "POST", bulk_mixed, &response);
+	test_check_unsigned_eq (status, 200, "Mixed bulk create failed!");
+
+	json_t *json = transactions_response_json (&response);
+	unsigned int inserted = (unsigned int) json_integer_value (json_object_get (json, "inserted"));
+	test_check_unsigned_eq (inserted, 2, NULL);
+
+	const unsigned int expected_errors[] = { 1, 2, 4 };
+	json_t *errors = json_object_get (json, "errors");
+	unsigned int n_errors = (unsigned int) json_array_size (errors);
+	test_check_unsigned_eq (n_errors, 3, NULL);
+	for (unsigned int idx = 0; idx < 3; idx++) {
+		json_t *item_error = json_array_get (errors, idx);
+		unsigned int index = (unsigned int) json_integer_value (json_object_get (item_error, "index"));
+		test_check_unsigned_eq (index, expected_errors[idx], NULL);
+
+		test_check (json_is_string (json_object_get (item_error, "error")), NULL);
+	}
+
+	json_decref (json);
+
+	count += 2;
+	unsigned int actual = transactions_request_count (curl, &response);
+	test_check_unsigned_eq (actual, count, NULL);
+
+	// over the limit, nothing is inserted
+	char *over_limit = transactions_bulk_create (BULK_MAX + 1);
+	test_check_ptr_ne (over_limit, NULL);
+	status = transactions_request_json (curl, actual_address, "POST", over_limit, &response);
+	test_check_unsigned_eq (status, 400, "Bulk create over the limit was not rejected!");
+
+	free (over_limit);
+
+	actual = transactions_request_count (curl, &response);
+	test_check_unsigned_eq (actual, count, NULL);
+
+	// the whole limit, with the default write limits
+	char *limit = transactions_bulk_create (BULK_MAX);
+	test_check_ptr_ne (limit, NULL);
+	status = transactions_request_json (curl, actual_address, "POST", limit, &response);
+	for (unsigned int retry = 0; (status == 429) && (retry < BULK_RETRIES); retry++) {
+		// nothing is inserted by a limited bulk
+		actual = transactions_request_count (curl, &response);
+		test_check_unsigned_eq (actual, count, NULL);
+
+		(void) sleep (BULK_RETRY_WAIT);
+		status = transactions_request_json (curl, actual_address, "POST", limit, &response);
+	}
+
+	test_check_unsigned_eq (status, 200, "Bulk create with the max items failed!");
+
+	free (limit);
+
+	json = transactions_response_json (&response);
+	inserted = (unsigned int) json_integer_value (json_object_get (json, "inserted"));
+	test_check_unsigned_eq (inserted, BULK_MAX, NULL);
+	n_errors = (unsigned int) json_array_size (json_object_get (json, "errors"));
+	test_check_unsigned_eq (n_errors, 0, NULL);
+	json_decref (json);
+
+	count += BULK_MAX;
+	actual = transactions_request_count (curl, &response);
+	test_check_unsigned_eq (actual, count, NULL);
+
+	free (response.data);
+
+}
+
 // GET api/pocket/transactions
 static unsigned int transactions_request_all (
 	CURL *curl, const char *actual_address
@@ -44,6 +253,20 @@ static void transactions_request_perform (void) {
 	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s", address);
 	test_check_unsigned_eq (transactions_request_all (curl, actual_address), 0, NULL);
 
+	// GET api/pocket/transactions?limit=10
+	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s?limit=10", address);
+	test_check_unsigned_eq (transactions_request_all (curl, actual_address), 0, NULL);
+
+	// GET api/pocket/transactions?from=2021-05-01&to=2021-06-01
+	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s?from=2021-05-01&to=2021-06-01", address);
+	test_check_unsigned_eq (transactions_request_all (curl, actual_address), 0, NULL);
+
+	// GET api/pocket/transactions/summary
+	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s/summary", address);
+	test_check_unsigned_eq (transactions_request_all (curl, actual_address), 0, NULL);
+
+	transactions_request_bulk (curl);
+
 	curl_easy_cleanup (curl);
 
 }
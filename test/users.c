@@ -3,6 +3,8 @@
 #include <string.h>
 #include <stdbool.h>
 
+#include <pthread.h>
+
 #include <cerver/http/json/json.h>
 
 #include "curl.h"
@@ -10,6 +12,10 @@
 
 #define ADDRESS_SIZE		128
 
+// more than the integration's CERVER_TH_THREADS
+// & less than the default RATE_LIMIT_AUTH_BURST
+#define USERS_LOGIN_CLIENTS		6
+
 static const char *address = { "127.0.0.1:5000/api/users" };
 
 static const char *name = { "Erick Salas" };
@@ -112,6 +118,89 @@ static unsigned int users_request_login_complete (
 
 }
 
+static pthread_barrier_t users_login_barrier;
+
+static size_t users_login_discard (
+	void *contents, size_t size, size_t nmemb, void *storage
+) {
+
+	(void) contents;
+	(void) storage;
+
+	return size * nmemb;
+
+}
+
+static void *users_login_client (void *status_ptr) {
+
+	long *status = (long *) status_ptr;
+
+	char actual_address[ADDRESS_SIZE] = { 0 };
+	(void) snprintf (actual_address, ADDRESS_SIZE - 1, "%s/login", address);
+
+	CURL *curl = curl_easy_init ();
+	char *json = users_login_create_complete ();
+	if (curl && json) {
+		struct curl_slist *headers = curl_slist_append (NULL, "Content-Type: application/json");
+
+		curl_easy_setopt (curl, CURLOPT_URL, actual_address);
+		curl_easy_setopt (curl, CURLOPT_HTTPHEADER, headers);
+		curl_easy_setopt (curl, CURLOPT_POSTFIELDS, json);
+		curl_easy_setopt (curl, CURLOPT_POSTFIELDSIZE, (long) strlen (json));
+		curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, users_login_discard);
+
+		(void) pthread_barrier_wait (&users_login_barrier);
+
+		if (curl_easy_perform (curl) == CURLE_OK) {
+			(void) curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, status);
+		}
+
+		curl_slist_free_all (headers);
+	}
+
+	else {
+		(void) pthread_barrier_wait (&users_login_barrier);
+	}
+
+	free (json);
+	curl_easy_cleanup (curl);
+
+	return NULL;
+
+}
+
+// POST api/users/login from more clients than threads at the same time,
+// with the default PASSWORD_QUEUE the ones over it are answered
+// with a 429 instead of waiting for a password worker
+static void users_request_login_busy (void) {
+
+	pthread_t threads[USERS_LOGIN_CLIENTS] = { 0 };
+	long status[USERS_LOGIN_CLIENTS] = { 0 };
+
+	(void) pthread_barrier_init (&users_login_barrier, NULL, USERS_LOGIN_CLIENTS);
+	for (unsigned int idx = 0; idx < USERS_LOGIN_CLIENTS; idx++) {
+		if (pthread_create (&threads[idx], NULL, users_login_client, &status[idx])) {
+			fail ("Failed to create login client thread!");
+		}
+	}
+
+	unsigned int ok = 0;
+	unsigned int busy = 0;
+	for (unsigned int idx = 0; idx < USERS_LOGIN_CLIENTS; idx++) {
+		(void) pthread_join (threads[idx], NULL);
+
+		if (status[idx] == 200) ok += 1;
+		else if (status[idx] == 429) busy += 1;
+	}
+
+	(void) pthread_barrier_destroy (&users_login_barrier);
+
+	test_check_unsigned_eq (ok + busy, USERS_LOGIN_CLIENTS, NULL);
+	test_check_unsigned_gt (ok, 0);
+	test_check_unsigned_gt (busy, 0);
+
+}
+
 static void users_request_perform (void) {
 
 	char data_buffer[4096] = { 0 };
@@ -129,6 +218,8 @@ static void users_request_perform (void) {
 
 	curl_easy_cleanup (curl);
 
+	users_request_login_busy ();
+
 }
 
 int main (int argc, char **argv) {